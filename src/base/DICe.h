@@ -150,6 +150,10 @@ const char* const compute_laplacian_image = "compute_laplacian_image";
 /// String parameter name
 const char* const initialization_method = "initialization_method";
 /// String parameter name
+const char* const image_registration_pyramid_level = "image_registration_pyramid_level";
+/// String parameter name
+const char* const phase_correlation_window_size = "phase_correlation_window_size";
+/// String parameter name
 const char* const optimization_method = "optimization_method";
 /// String parameter name
 const char* const projection_method = "projection_method";
@@ -311,6 +315,22 @@ const char* const global_element_type = "global_element_type";
 const char* const use_fixed_point_iterations = "use_fixed_point_iterations";
 /// String parameter name, only for global DIC
 const char* const write_exodus_output = "write_exodus_output";
+/// String parameter name
+const char* const exodus_output_queue_size = "exodus_output_queue_size";
+/// String parameter name
+const char* const motion_test_decimation = "motion_test_decimation";
+/// String parameter name
+const char* const coarse_to_fine_levels = "coarse_to_fine_levels";
+/// String parameter name
+const char* const compact_intensity_storage = "compact_intensity_storage";
+/// String parameter name
+const char* const subset_partition_method = "subset_partition_method";
+/// String parameter name
+const char* const rebalance_interval = "rebalance_interval";
+/// String parameter name
+const char* const rebalance_threshold = "rebalance_threshold";
+/// String parameter name
+const char* const estimate_resolution_error_num_threads = "estimate_resolution_error_num_threads";
 
 
 /// enums:
@@ -395,6 +415,7 @@ enum Initialization_Method {
   USE_ZEROS,
   USE_FEATURE_MATCHING,
   USE_IMAGE_REGISTRATION,
+  USE_SUBSET_PHASE_CORRELATION,
   INITIALIZATION_METHOD_NOT_APPLICABLE,
   // DON'T ADD ANY BELOW MAX
   MAX_INITIALIZATION_METHOD,
@@ -410,9 +431,26 @@ const static char * initializationMethodStrings[] = {
   "USE_ZEROS",
   "USE_FEATURE_MATCHING",
   "USE_IMAGE_REGISTRATION",
+  "USE_SUBSET_PHASE_CORRELATION",
   "INITIALIZATION_METHOD_NOT_APPLICABLE"
 };
 
+/// Method used to split the subsets among processors
+enum Subset_Partition_Method {
+  EVEN_SPLIT_PARTITION=0,
+  RECURSIVE_COORDINATE_BISECTION,
+  HILBERT_CURVE_PARTITION,
+  // DON'T ADD ANY BELOW MAX
+  MAX_SUBSET_PARTITION_METHOD,
+  NO_SUCH_SUBSET_PARTITION_METHOD
+};
+
+const static char * subsetPartitionMethodStrings[] = {
+  "EVEN_SPLIT_PARTITION",
+  "RECURSIVE_COORDINATE_BISECTION",
+  "HILBERT_CURVE_PARTITION"
+};
+
 /// Shape function type
 enum Shape_Function_Type {
   AFFINE_SF=0,
@@ -481,6 +519,13 @@ const static char * gradientMethodStrings[] = {
   "CONVOLUTION_5_POINT"
 };
 
+/// Storage type of the image intensities
+enum Intensity_Storage {
+  FULL_INTENSITY_STORAGE=0,
+  UINT8_INTENSITY_STORAGE,
+  UINT16_INTENSITY_STORAGE
+};
+
 
 /// Correlation routine (determines how the correlation steps are executed).
 /// Can be customized for a particular application
@@ -902,6 +947,18 @@ const Correlation_Parameter initialization_method_param(initialization_method,
   initializationMethodStrings,
   MAX_INITIALIZATION_METHOD);
 /// Correlation parameter and properties
+const Correlation_Parameter image_registration_pyramid_level_param(image_registration_pyramid_level,
+  SIZE_PARAM,
+  true,
+  "Number of times the images are downsampled by a factor of two before computing the image registration"
+  " for the USE_IMAGE_REGISTRATION initialization method (0 uses the full resolution images)");
+/// Correlation parameter and properties
+const Correlation_Parameter phase_correlation_window_size_param(phase_correlation_window_size,
+  SIZE_PARAM,
+  true,
+  "Size of the square window (in pixels) around each subset used by the USE_SUBSET_PHASE_CORRELATION"
+  " initialization method, displacements up to half the window size can be captured (0 uses twice the subset size)");
+/// Correlation parameter and properties
 const Correlation_Parameter optimization_method_param(optimization_method,
   STRING_PARAM,
   true,
@@ -1071,6 +1128,55 @@ const Correlation_Parameter write_exodus_output_param(write_exodus_output,
   "Used when DICE_ENABLE_GLOBAL is true, writes an exodus output file."
 );
 /// Correlation parameter and properties
+const Correlation_Parameter exodus_output_queue_size_param(exodus_output_queue_size,
+  SIZE_PARAM,
+  true,
+  "Used when DICE_ENABLE_GLOBAL is true, number of frames that can wait to be written to the exodus output"
+  " file by the background I/O thread (0 writes each frame before the next one is processed)");
+/// Correlation parameter and properties
+const Correlation_Parameter motion_test_decimation_param(motion_test_decimation,
+  SIZE_PARAM,
+  true,
+  "Only every n-th row and column of a motion window are used to test for motion (1 uses all of the pixels)");
+/// Correlation parameter and properties
+const Correlation_Parameter coarse_to_fine_levels_param(coarse_to_fine_levels,
+  SIZE_PARAM,
+  true,
+  "Number of image pyramid levels used to estimate the subset translation before the gradient based solve"
+  " (useful for large motions, 0 means the solve starts at full resolution)");
+/// Correlation parameter and properties
+const Correlation_Parameter compact_intensity_storage_param(compact_intensity_storage,
+  BOOL_PARAM,
+  true,
+  "Images read from 8 or 16 bit files are stored as integers rather than floating point values to reduce"
+  " memory traffic (ignored if the images are gauss filtered)");
+/// Correlation parameter and properties
+const Correlation_Parameter subset_partition_method_param(subset_partition_method,
+  STRING_PARAM,
+  true,
+  "Determines how the subsets are split among processors, the geometric methods give each processor a compact"
+  " region of the image (obstruction and seed dependencies take precedence)",
+  subsetPartitionMethodStrings,
+  MAX_SUBSET_PARTITION_METHOD);
+/// Correlation parameter and properties
+const Correlation_Parameter rebalance_interval_param(rebalance_interval,
+  SIZE_PARAM,
+  true,
+  "Number of frames between checks of the load balance among processors, if the subsets on one processor take"
+  " much longer than the others, the subsets are redistributed by their measured cost (0 turns rebalancing off)");
+/// Correlation parameter and properties
+const Correlation_Parameter rebalance_threshold_param(rebalance_threshold,
+  SCALAR_PARAM,
+  true,
+  "Relative load imbalance (slowest processor time over the average minus one) below which the subsets are not"
+  " redistributed (default 0.1)");
+/// Correlation parameter and properties
+const Correlation_Parameter estimate_resolution_error_num_threads_param(estimate_resolution_error_num_threads,
+  SIZE_PARAM,
+  true,
+  "Number of threads that generate the synthetic images for the estimation of resolution error while the"
+  " previous cases are being correlated (default 1)");
+/// Correlation parameter and properties
 const Correlation_Parameter global_element_type_param(global_element_type,
   STRING_PARAM,
   true,
@@ -1159,7 +1265,7 @@ const Correlation_Parameter filter_failed_cine_pixels_param(filter_failed_cine_p
 // TODO don't forget to update this when adding a new one
 /// The total number of valid correlation parameters
 /// Vector of valid parameter names
-const int_t num_valid_correlation_params = 86;
+const int_t num_valid_correlation_params = 96;
 /// Vector oIf valid parameter names
 const Correlation_Parameter valid_correlation_params[num_valid_correlation_params] = {
   correlation_routine_param,
@@ -1248,11 +1354,21 @@ const Correlation_Parameter valid_correlation_params[num_valid_correlation_param
   use_fixed_point_iterations_param,
   compute_laplacian_image_param,
   write_exodus_output_param,
+  image_registration_pyramid_level_param,
+  phase_correlation_window_size_param,
+  exodus_output_queue_size_param,
+  motion_test_decimation_param,
+  coarse_to_fine_levels_param,
+  compact_intensity_storage_param,
+  subset_partition_method_param,
+  rebalance_interval_param,
+  rebalance_threshold_param,
+  estimate_resolution_error_num_threads_param,
 };
 
 // TODO don't forget to update this when adding a new one
 /// The total number of valid correlation parameters
-const int_t num_valid_global_correlation_params = 31;
+const int_t num_valid_global_correlation_params = 32;
 /// Vector of valid parameter names
 const Correlation_Parameter valid_global_correlation_params[num_valid_global_correlation_params] = {
   use_global_dic_param,
@@ -1274,6 +1390,7 @@ const Correlation_Parameter valid_global_correlation_params[num_valid_global_cor
   estimate_resolution_error_amplitude_step_param,
   estimate_resolution_error_speckle_size_param,
   estimate_resolution_error_noise_percent_param,
+  estimate_resolution_error_num_threads_param,
   use_incremental_formulation_param,
   use_nonlinear_projection_param,
   sort_txt_output_param,
@@ -49,9 +49,136 @@
 #include <Teuchos_ParameterList.hpp>
 
 #include <cassert>
+#include <algorithm>
 
 namespace DICe {
 
+namespace {
+
+/// deallocator for the buffers handed out by the pool, marks the buffer free instead of deleting it
+template <typename T>
+class Pool_Deallocator{
+public:
+  typedef T ptr_t;
+  /// constructor
+  Pool_Deallocator(const std::shared_ptr<std::mutex> & mutex,
+    const std::shared_ptr<Image_Pool_Buffer<T> > & buffer):
+    mutex_(mutex),
+    buffer_(buffer){};
+  /// called by the last ArrayRCP that references the buffer, on whichever thread releases it
+  void free(T *){
+    std::lock_guard<std::mutex> lock(*mutex_);
+    buffer_->in_use = false;
+  }
+private:
+  std::shared_ptr<std::mutex> mutex_;
+  std::shared_ptr<Image_Pool_Buffer<T> > buffer_;
+};
+
+/// returns a free buffer from the list, or a new one (the pool mutex must be held)
+template <typename T>
+Teuchos::ArrayRCP<T>
+acquire_buffer(std::vector<std::shared_ptr<Image_Pool_Buffer<T> > > & buffers,
+  const std::shared_ptr<std::mutex> & mutex,
+  const int_t size,
+  const T value,
+  const bool keep){
+  if(!keep) return Teuchos::ArrayRCP<T>(size,value);
+  std::shared_ptr<Image_Pool_Buffer<T> > buffer;
+  for(size_t i=0;i<buffers.size();++i){
+    if(!buffers[i]->in_use&&(int_t)buffers[i]->values.size()==size){
+      buffer = buffers[i];
+      std::fill(buffer->values.begin(),buffer->values.end(),value);
+      break;
+    }
+  }
+  if(!buffer){
+    buffer = std::make_shared<Image_Pool_Buffer<T> >(size,value);
+    buffers.push_back(buffer);
+  }
+  buffer->in_use = true;
+  return Teuchos::arcp(&buffer->values[0],0,size,Pool_Deallocator<T>(mutex,buffer),true);
+}
+
+/// returns the number of bytes in the buffers that are not handed out (the pool mutex must be held)
+template <typename T>
+size_t
+free_bytes(const std::vector<std::shared_ptr<Image_Pool_Buffer<T> > > & buffers){
+  size_t num_bytes = 0;
+  for(size_t i=0;i<buffers.size();++i)
+    if(!buffers[i]->in_use)
+      num_bytes += buffers[i]->values.size()*sizeof(T);
+  return num_bytes;
+}
+
+/// drop the oldest free buffer from the list, returns false if there are none (the pool mutex must be held)
+template <typename T>
+bool
+release_free_buffer(std::vector<std::shared_ptr<Image_Pool_Buffer<T> > > & buffers){
+  for(size_t i=0;i<buffers.size();++i){
+    if(!buffers[i]->in_use){
+      buffers.erase(buffers.begin()+i);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // end anonymous namespace
+
+Image_Buffer_Pool &
+Image_Buffer_Pool::instance(){
+  static Image_Buffer_Pool pool;
+  return pool;
+}
+
+Teuchos::ArrayRCP<intensity_t>
+Image_Buffer_Pool::intensity_buffer(const int_t size,
+  const intensity_t value){
+  TEUCHOS_TEST_FOR_EXCEPTION(size<=0,std::runtime_error,"Error, invalid buffer size " << size);
+  std::lock_guard<std::mutex> lock(*mutex_);
+  trim();
+  return acquire_buffer(intensity_buffers_,mutex_,size,value,memory_budget_>0);
+}
+
+Teuchos::ArrayRCP<scalar_t>
+Image_Buffer_Pool::scalar_buffer(const int_t size,
+  const scalar_t value){
+  TEUCHOS_TEST_FOR_EXCEPTION(size<=0,std::runtime_error,"Error, invalid buffer size " << size);
+  std::lock_guard<std::mutex> lock(*mutex_);
+  trim();
+  return acquire_buffer(scalar_buffers_,mutex_,size,value,memory_budget_>0);
+}
+
+void
+Image_Buffer_Pool::set_memory_budget(const size_t num_bytes){
+  std::lock_guard<std::mutex> lock(*mutex_);
+  DEBUG_MSG("Image_Buffer_Pool::set_memory_budget(): " << num_bytes << " bytes");
+  memory_budget_ = num_bytes;
+  trim();
+}
+
+size_t
+Image_Buffer_Pool::num_free_bytes(){
+  std::lock_guard<std::mutex> lock(*mutex_);
+  return free_bytes(intensity_buffers_) + free_bytes(scalar_buffers_);
+}
+
+void
+Image_Buffer_Pool::clear(){
+  std::lock_guard<std::mutex> lock(*mutex_);
+  intensity_buffers_.clear();
+  scalar_buffers_.clear();
+}
+
+void
+Image_Buffer_Pool::trim(){
+  // buffers that are still in use stay in the lists so they can be reused once they are released
+  while(free_bytes(intensity_buffers_) + free_bytes(scalar_buffers_) > memory_budget_){
+    if(!release_free_buffer(intensity_buffers_)&&!release_free_buffer(scalar_buffers_)) break;
+  }
+}
+
 Image::Image(intensity_t * intensities,
   const int_t width,
   const int_t height,
@@ -115,7 +242,8 @@ Image::post_allocation_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params
     compute_gradients(image_grad_use_hierarchical_parallelism,image_grad_team_size);
   if(params->isParameter(DICe::compute_laplacian_image)){
     if(params->get<bool>(DICe::compute_laplacian_image)==true){
-      TEUCHOS_TEST_FOR_EXCEPTION(laplacian_==Teuchos::null,std::runtime_error,"");
+      if(laplacian_==Teuchos::null)
+        laplacian_ = Image_Buffer_Pool::instance().scalar_buffer(width_*height_);
       TEUCHOS_TEST_FOR_EXCEPTION(laplacian_.size()!=width_*height_,std::runtime_error,"");
       Teuchos::RCP<Teuchos::ParameterList> imgParams = Teuchos::rcp(new Teuchos::ParameterList());
       imgParams->set(DICe::compute_image_gradients,true); // automatically compute the gradients if the ref image is changed
@@ -193,6 +321,7 @@ Image::normalize(const Teuchos::RCP<Teuchos::ParameterList> & params){
 void
 Image::replace_intensities(Teuchos::ArrayRCP<intensity_t> intensities){
   assert(intensities.size()==width_*height_);
+  clear_pyramid();
   intensity_rcp_ = intensities; // copy the pointer so the arrayRCP doesn't get deallocated;
   // automatically re-compute the image gradients:
   Teuchos::RCP<Teuchos::ParameterList> params = rcp(new Teuchos::ParameterList());
@@ -217,7 +346,9 @@ void
 Image::write(const std::string & file_name,
   const bool scale_to_8_bit){
   try{
-    utils::write_image(file_name.c_str(),width_,height_,intensities().getRawPtr(),default_is_layout_right(),scale_to_8_bit);
+    // writing the image does not change its storage (write_image only reads the values)
+    Teuchos::ArrayRCP<const intensity_t> values = intensity_values();
+    utils::write_image(file_name.c_str(),width_,height_,const_cast<intensity_t*>(values.getRawPtr()),default_is_layout_right(),scale_to_8_bit);
   }
   catch(std::exception &e){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write image failure.");
@@ -229,7 +360,10 @@ Image::write_overlap_image(const std::string & file_name,
   Teuchos::RCP<Image> top_img){
   TEUCHOS_TEST_FOR_EXCEPTION(top_img->height()!=height_||top_img->width()!=width_,std::runtime_error,"Error, dimensions must match for top and bottom image");
   try{
-    utils::write_color_overlap_image(file_name.c_str(),width_,height_,intensities().getRawPtr(),top_img->intensities().getRawPtr());
+    Teuchos::ArrayRCP<const intensity_t> bottom_values = intensity_values();
+    Teuchos::ArrayRCP<const intensity_t> top_values = top_img->intensity_values();
+    utils::write_color_overlap_image(file_name.c_str(),width_,height_,
+      const_cast<intensity_t*>(bottom_values.getRawPtr()),const_cast<intensity_t*>(top_values.getRawPtr()));
   }
   catch(std::exception &e){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write color overlap image failure.");
@@ -260,6 +394,58 @@ Image::write_grad_y(const std::string & file_name){
 }
 #endif
 
+Teuchos::RCP<Image>
+Image::pyramid_level(const int_t level){
+  TEUCHOS_TEST_FOR_EXCEPTION(level<0,std::runtime_error,"Error, invalid pyramid level " << level);
+  if(level==0) return Teuchos::rcp(this,false);
+  if(level<=(int_t)pyramid_.size()) return pyramid_[level-1];
+  Teuchos::RCP<Image> fine = pyramid_level(level-1);
+  // the first sample is taken from an even global coordinate so that the coarse
+  // global coordinates are exactly half of the fine ones
+  const int_t start_x = fine->offset_x() % 2 == 0 ? 0 : 1;
+  const int_t start_y = fine->offset_y() % 2 == 0 ? 0 : 1;
+  const int_t fine_w = fine->width();
+  const int_t fine_h = fine->height();
+  const int_t coarse_w = (fine_w - start_x + 1)/2;
+  const int_t coarse_h = (fine_h - start_y + 1)/2;
+  TEUCHOS_TEST_FOR_EXCEPTION(coarse_w<4||coarse_h<4,std::runtime_error,
+    "Error, the image is too small for pyramid level " << level << " (" << fine_w << "x" << fine_h << " at level " << level-1 << ")");
+  DEBUG_MSG("Image::pyramid_level(): building level " << level << " width " << coarse_w << " height " << coarse_h);
+  // separable 5 point binomial filter evaluated only at the sampled pixels (edges are clamped)
+  static const scalar_t coeffs[5] = {1.0/16.0,4.0/16.0,6.0/16.0,4.0/16.0,1.0/16.0};
+  std::vector<scalar_t> rows(fine_h*coarse_w,0.0);
+  for(int_t y=0;y<fine_h;++y){
+    for(int_t i=0;i<coarse_w;++i){
+      const int_t x = start_x + 2*i;
+      scalar_t value = 0.0;
+      for(int_t k=-2;k<=2;++k){
+        const int_t xk = std::min(std::max(x+k,0),fine_w-1);
+        value += coeffs[k+2]*(*fine)(xk,y);
+      }
+      rows[y*coarse_w+i] = value;
+    }
+  }
+  Teuchos::ArrayRCP<intensity_t> coarse_intensities(coarse_w*coarse_h,0.0);
+  for(int_t j=0;j<coarse_h;++j){
+    const int_t y = start_y + 2*j;
+    for(int_t i=0;i<coarse_w;++i){
+      scalar_t value = 0.0;
+      for(int_t k=-2;k<=2;++k){
+        const int_t yk = std::min(std::max(y+k,0),fine_h-1);
+        value += coeffs[k+2]*rows[yk*coarse_w+i];
+      }
+      coarse_intensities[j*coarse_w+i] = value;
+    }
+  }
+  Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
+  params->set(DICe::compute_image_gradients,true);
+  params->set(DICe::gradient_method,gradient_method_);
+  Teuchos::RCP<Image> coarse = Teuchos::rcp(new Image(coarse_w,coarse_h,coarse_intensities,params,
+    (fine->offset_x()+start_x)/2,(fine->offset_y()+start_y)/2));
+  pyramid_.push_back(coarse);
+  return coarse;
+}
+
 Teuchos::RCP<Image>
 Image::apply_rotation(const Rotation_Value rotation,
   const Teuchos::RCP<Teuchos::ParameterList> & params){
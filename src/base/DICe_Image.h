@@ -46,12 +46,95 @@
   #include <DICe_Kokkos.h>
 #endif
 #include <Teuchos_ParameterList.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace DICe {
 
 /// forward declaration of the conformal_area_def
 class Conformal_Area_Def;
 class Local_Shape_Function;
 
+/// \brief Storage for a buffer held by the Image_Buffer_Pool
+template <typename T>
+struct Image_Pool_Buffer{
+  /// constructor
+  /// \param size number of values
+  /// \param value initial value
+  Image_Pool_Buffer(const int_t size,
+    const T value):
+    values(size,value),
+    in_use(false){};
+  /// the values
+  std::vector<T> values;
+  /// true while the buffer is handed out (guarded by the pool mutex)
+  bool in_use;
+};
+
+/// \class DICe::Image_Buffer_Pool
+/// \brief Pool of pixel buffers shared by all of the images in a process
+///
+/// The pool keeps each buffer it hands out. A buffer is free to be handed out again once the
+/// last reference to it is released, for example when the reference image of an incremental or
+/// stereo run is replaced and the old image is destroyed. The ArrayRCP handed out has a deallocator
+/// that marks the buffer free under the pool mutex, so images can be created and destroyed on any
+/// thread (the reference counts of the ArrayRCPs are never read by the pool). Free buffers are kept for
+/// reuse as long as their total size is within the memory budget. With a budget of zero (the default)
+/// the pool is a pass through and every buffer is a new allocation.
+class DICE_LIB_DLL_EXPORT
+Image_Buffer_Pool {
+public:
+  /// returns the pool for this process
+  static Image_Buffer_Pool & instance();
+
+  /// \brief returns a buffer of intensity values
+  /// \param size number of values in the buffer
+  /// \param value the buffer is filled with this value
+  Teuchos::ArrayRCP<intensity_t> intensity_buffer(const int_t size,
+    const intensity_t value=0.0);
+
+  /// \brief returns a buffer of scalar values
+  /// \param size number of values in the buffer
+  /// \param value the buffer is filled with this value
+  Teuchos::ArrayRCP<scalar_t> scalar_buffer(const int_t size,
+    const scalar_t value=0.0);
+
+  /// \brief set the total size of the free buffers that can be kept for reuse
+  /// \param num_bytes the budget in bytes (0 disables the reuse)
+  void set_memory_budget(const size_t num_bytes);
+
+  /// returns the memory budget in bytes
+  size_t memory_budget()const{
+    return memory_budget_;
+  }
+
+  /// returns the total size in bytes of the buffers that are waiting to be reused
+  size_t num_free_bytes();
+
+  /// release all the buffers held by the pool (buffers still in use are not affected)
+  void clear();
+
+private:
+  /// constructor is private, use instance()
+  Image_Buffer_Pool():
+    memory_budget_(0),
+    mutex_(new std::mutex()){};
+  /// release the free buffers until the free bytes are within the budget
+  void trim();
+  /// memory budget in bytes
+  size_t memory_budget_;
+  /// intensity buffers handed out or waiting to be reused
+  std::vector<std::shared_ptr<Image_Pool_Buffer<intensity_t> > > intensity_buffers_;
+  /// scalar buffers handed out or waiting to be reused
+  std::vector<std::shared_ptr<Image_Pool_Buffer<scalar_t> > > scalar_buffers_;
+  /// guards the buffer lists and the in_use flags (shared with the deallocators of the buffers
+  /// handed out, which can outlive the pool)
+  std::shared_ptr<std::mutex> mutex_;
+};
+
 /// \class DICe::Image
 /// A container class to hold the pixel intensity information and provide some basic methods
 /// Note: the coordinates are from the top left corner (positive right for x and positive down for y)
@@ -234,18 +317,41 @@ public:
   /// intensity accessors:
   /// note the internal arrays are stored as (row,column) so the indices have to be switched from coordinates x,y to y,x
   /// y is row, x is column
+  /// the value is returned by copy since the intensities may be stored as integers (see compact_intensities())
   /// \param x image coordinate x
   /// \param y image coordinate y
-  const intensity_t& operator()(const int_t x, const int_t y) const;
+  intensity_t operator()(const int_t x, const int_t y) const;
 
   /// intensity accessors:
   /// note the internal arrays are stored as (row,column) so the indices have to be switched from coordinates x,y to y,x
   /// y is row, x is column
   /// \param i pixel index
-  const intensity_t& operator()(const int_t i) const;
+  intensity_t operator()(const int_t i) const;
 
   /// returns a copy of the intenisity values as an array
-  Teuchos::ArrayRCP<intensity_t> intensities()const;
+  /// (if the intensities are stored compactly they are expanded to full precision first,
+  /// use intensity_values() to read the values without modifying the image)
+  Teuchos::ArrayRCP<intensity_t> intensities();
+
+  /// \brief returns the intensity values at full precision without modifying the image
+  ///
+  /// If the intensities are stored compactly the values are expanded into a separate array, otherwise
+  /// the pixel container is returned. Safe to call while other threads interpolate the image.
+  Teuchos::ArrayRCP<const intensity_t> intensity_values()const;
+
+  /// \brief store the intensities as 8 or 16 bit integers rather than intensity_t values
+  ///
+  /// The intensities are only compacted if every value is an integer that fits in the smaller
+  /// type (for example an image read from an 8 or 16 bit tiff file), so no information is lost.
+  /// Gradients are not affected. Operations that modify the intensities expand the storage
+  /// back to full precision first. Returns true if the intensities were compacted.
+  bool compact_intensities();
+
+  /// convert compactly stored intensities back to intensity_t values (no-op if they are not compact)
+  void expand_intensities();
+
+  /// returns the current storage type of the intensities
+  Intensity_Storage intensity_storage()const;
 
   /// returns a copy of the grad_x values as an array
   Teuchos::ArrayRCP<scalar_t> grad_x_array()const;
@@ -481,6 +587,25 @@ public:
     return gauss_filter_mask_size_;
   }
 
+  /// returns the image at the given level of the Gaussian pyramid (level 0 is this image)
+  /// Each level is smoothed with a 5 point binomial filter and downsampled by a factor of two
+  /// from the level below it. The levels are built the first time they are requested and cached
+  /// until the intensity values of this image change. The gradients are computed for each level.
+  /// The offsets of a level are set so that its global coordinates are exactly half the global
+  /// coordinates of the level below it, (x,y) at level n is (2^n x, 2^n y) in this image
+  /// \param level the pyramid level
+  Teuchos::RCP<Image> pyramid_level(const int_t level);
+
+  /// returns the number of pyramid levels that have been built (not including level 0)
+  int_t num_pyramid_levels()const{
+    return pyramid_.size();
+  }
+
+  /// remove the cached pyramid levels (called whenever the intensity values change)
+  void clear_pyramid(){
+    pyramid_.clear();
+  }
+
 #if DICE_KOKKOS
   /// tag
   struct Init_Mask_Tag {};
@@ -552,17 +677,68 @@ private:
   /// image laplacian container
   scalar_dual_view_2d laplacian_;
 #else
-  /// pixel container
+  /// allocate the mask (all zeros) if it has not been used yet
+  void allocate_mask();
+  /// bilinear interpolation of the intensity for the given storage type
+  template <typename T>
+  intensity_t bilinear_kernel(const T * intens,
+    const scalar_t & local_x,
+    const scalar_t & local_y)const;
+  /// bilinear interpolation of the intensity and gradients for the given storage type
+  template <typename T>
+  void bilinear_all_kernel(const T * intens,
+    intensity_t& intensity_val,
+    scalar_t& grad_x_val,
+    scalar_t& grad_y_val,
+    const bool compute_gradient,
+    const scalar_t& local_x,
+    const scalar_t& local_y)const;
+  /// bicubic interpolation of the intensity for the given storage type
+  template <typename T>
+  intensity_t bicubic_kernel(const T * intens,
+    const scalar_t & local_x,
+    const scalar_t & local_y);
+  /// bicubic interpolation of the intensity and gradients for the given storage type
+  template <typename T>
+  void bicubic_all_kernel(const T * intens,
+    intensity_t& intensity_val,
+    scalar_t& grad_x_val,
+    scalar_t& grad_y_val,
+    const bool compute_gradient,
+    const scalar_t& local_x,
+    const scalar_t& local_y);
+  /// keys fourth order interpolation of the intensity for the given storage type
+  template <typename T>
+  intensity_t keys_fourth_kernel(const T * intens,
+    const scalar_t & local_x,
+    const scalar_t & local_y);
+  /// keys fourth order interpolation of the intensity and gradients for the given storage type
+  template <typename T>
+  void keys_fourth_all_kernel(const T * intens,
+    intensity_t& intensity_val,
+    scalar_t& grad_x_val,
+    scalar_t& grad_y_val,
+    const bool compute_gradient,
+    const scalar_t& local_x,
+    const scalar_t& local_y);
+  /// finite difference gradients for the given storage type
+  template <typename T>
+  void gradients_finite_difference_kernel(const T * intens);
+  /// pixel container (null while the intensities are stored compactly)
   Teuchos::ArrayRCP<intensity_t> intensities_;
-  /// device intensity work array
-  Teuchos::ArrayRCP<intensity_t> intensities_temp_;
-  /// mask coefficients
+  /// pixel container used for 8 bit compact storage
+  Teuchos::ArrayRCP<uint8_t> intensities_8_;
+  /// pixel container used for 16 bit compact storage
+  Teuchos::ArrayRCP<uint16_t> intensities_16_;
+  /// storage type of the intensities
+  Intensity_Storage intensity_storage_;
+  /// mask coefficients (only allocated once a mask is used)
   Teuchos::ArrayRCP<scalar_t> mask_;
   /// image gradient x container
   Teuchos::ArrayRCP<scalar_t> grad_x_;
   /// image gradient y container
   Teuchos::ArrayRCP<scalar_t> grad_y_;
-  /// image gradient y container
+  /// image laplacian container (only allocated if the laplacian is computed)
   Teuchos::ArrayRCP<scalar_t> laplacian_;
 #endif
   /// flag that the gradients have been computed
@@ -585,6 +761,8 @@ private:
   bool has_file_name_;
   /// gradient method
   Gradient_Method gradient_method_;
+  /// cached levels of the Gaussian pyramid, pyramid_[i] is level i+1
+  std::vector<Teuchos::RCP<Image> > pyramid_;
 };
 
 }// End DICe Namespace
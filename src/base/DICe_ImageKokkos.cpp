@@ -276,12 +276,12 @@ Image::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & pa
   post_allocation_tasks(params);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t x, const int_t y) const {
   return intensities_.h_view(y,x);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t i) const {
   const int_t y = i / width_;
   const int_t x = i - y*width_;
@@ -319,11 +319,31 @@ Image::grad_y_array()const{
 }
 
 Teuchos::ArrayRCP<intensity_t>
-Image::intensities()const{
+Image::intensities(){
   Teuchos::ArrayRCP<intensity_t> array(intensities_.h_view.ptr_on_device(),0,width_*height_,false);
   return array;
 }
 
+Teuchos::ArrayRCP<const intensity_t>
+Image::intensity_values()const{
+  Teuchos::ArrayRCP<const intensity_t> array(intensities_.h_view.ptr_on_device(),0,width_*height_,false);
+  return array;
+}
+
+bool
+Image::compact_intensities(){
+  // the dual views always hold full precision intensities
+  return false;
+}
+
+void
+Image::expand_intensities(){}
+
+Intensity_Storage
+Image::intensity_storage()const{
+  return FULL_INTENSITY_STORAGE;
+}
+
 intensity_t
 Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
   TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, method not implemented yet.");
@@ -399,6 +419,7 @@ Image::compute_gradients(const bool use_hierarchical_parallelism, const int_t te
 void
 Image::apply_mask(const Conformal_Area_Def & area_def,
   const bool smooth_edges){
+  clear_pyramid();
   // first create the mask:
   create_mask(area_def,smooth_edges);
   // then apply it to the image intensity values
@@ -410,6 +431,7 @@ Image::apply_mask(const Conformal_Area_Def & area_def,
 
 void
 Image::apply_mask(const bool smooth_edges){
+  clear_pyramid();
   // make sure the mask is synced from host to device
   mask_.modify<host_space>();
   mask_.sync<device_space>();
@@ -481,6 +503,7 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   const int_t cy,
   const bool apply_in_place){
 
+  if(apply_in_place) clear_pyramid();
   assert(shape_function->num_params()==6);
   Teuchos::RCP<std::vector<scalar_t> > deformation = shape_function->rcp();
 
@@ -522,6 +545,7 @@ Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelis
   const int_t team_size){
 
   if(mask_size>0) gauss_filter_mask_size_ = mask_size;
+  clear_pyramid();
 
   std::vector<scalar_t> coeffs(13,0.0);
 
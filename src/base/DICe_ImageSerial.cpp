@@ -44,8 +44,10 @@
 #include <DICe_LocalShapeFunction.h>
 #include <DICe_ImageIO.h>
 #include <DICe_Shape.h>
+#include <DICe_Profiler.h>
 
 #include <cassert>
+#include <cmath>
 
 namespace DICe {
 
@@ -77,10 +79,11 @@ Image::Image(const char * file_name,
     convert_to_8_bit = params->get<bool>(DICe::convert_cine_to_8_bit,true);
   }
   try{
+    DICE_PROFILE_SCOPE(PROFILE_IMAGE_LOAD);
     utils::read_image_dimensions(file_name,width_,height_);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0,std::runtime_error,"");
-    intensities_ = Teuchos::ArrayRCP<intensity_t>(width_*height_,0.0);
+    intensities_ = Image_Buffer_Pool::instance().intensity_buffer(width_*height_);
     utils::read_image(file_name,intensities_.getRawPtr(),true,convert_to_8_bit,filter_failed);
   }
   catch(std::exception & e){
@@ -117,11 +120,12 @@ Image::Image(const char * file_name,
   int_t img_width = 0;
   int_t img_height = 0;
   try{
+    DICE_PROFILE_SCOPE(PROFILE_IMAGE_LOAD);
     utils::read_image_dimensions(file_name,img_width,img_height);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0||offset_x_+width_>img_width,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0||offset_y_+height_>img_height,std::runtime_error,"");
     // initialize the pixel containers
-    intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
+    intensities_ = Image_Buffer_Pool::instance().intensity_buffer(height_*width_);
     // read in the image
     utils::read_image(file_name,
       offset_x,offset_y,
@@ -152,7 +156,7 @@ Image::Image(const int_t width,
 {
   assert(height_>0);
   assert(width_>0);
-  intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,intensity);
+  intensities_ = Image_Buffer_Pool::instance().intensity_buffer(height_*width_,intensity);
   default_constructor_tasks(Teuchos::null);
 }
 
@@ -183,13 +187,15 @@ Image::Image(Teuchos::RCP<Image> img,
   assert(height_>0);
   const int_t src_width = img->width();
   const int_t src_height = img->height();
+  intensity_storage_ = FULL_INTENSITY_STORAGE;
 
   // initialize the pixel containers
-  intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  intensities_temp_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  grad_x_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  grad_y_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  mask_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
+  intensities_ = Image_Buffer_Pool::instance().intensity_buffer(height_*width_);
+  grad_x_ = Image_Buffer_Pool::instance().scalar_buffer(height_*width_);
+  grad_y_ = Image_Buffer_Pool::instance().scalar_buffer(height_*width_);
+  // the mask is only needed if the source image has one or if part of this image is outside the source
+  if(img->mask_!=Teuchos::null||offset_x_+width_>src_width||offset_y_+height_>src_height)
+    allocate_mask();
   // deep copy values over
   int_t src_y=0, src_x=0;
   for(int_t y=0;y<height_;++y){
@@ -200,7 +206,8 @@ Image::Image(Teuchos::RCP<Image> img,
         intensities_[y*width_+x] = (*img)(src_x,src_y);
         grad_x_[y*width_+x] = img->grad_x(src_x,src_y);
         grad_y_[y*width_+x] = img->grad_y(src_x,src_y);
-        mask_[y*width_+x] = img->mask(src_x,src_y);
+        if(mask_!=Teuchos::null)
+          mask_[y*width_+x] = img->mask(src_x,src_y);
       }
       else{
         intensities_[y*width_+x] = 0.0;
@@ -244,37 +251,49 @@ Image::initialize_array_image(intensity_t * intensities){
   assert(width_>0);
   assert(height_>0);
   intensities_ = Teuchos::ArrayRCP<intensity_t>(intensities,0,width_*height_,false);
+  intensities_8_ = Teuchos::null;
+  intensities_16_ = Teuchos::null;
+  intensity_storage_ = FULL_INTENSITY_STORAGE;
 }
 
 void
 Image::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params){
-  grad_x_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  grad_y_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  intensities_temp_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  mask_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  if(params!=Teuchos::null){
-    if(params->isParameter(DICe::compute_laplacian_image)){
-      if(params->get<bool>(DICe::compute_laplacian_image)==true){
-        laplacian_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-      }
-    }
-  }
+  grad_x_ = Image_Buffer_Pool::instance().scalar_buffer(height_*width_);
+  grad_y_ = Image_Buffer_Pool::instance().scalar_buffer(height_*width_);
+  // the mask and laplacian are allocated when they are first used
+  mask_ = Teuchos::null;
+  laplacian_ = Teuchos::null;
   // image gradient coefficients
   grad_c1_ = 1.0/12.0;
   grad_c2_ = -8.0/12.0;
+  intensities_8_ = Teuchos::null;
+  intensities_16_ = Teuchos::null;
+  intensity_storage_ = FULL_INTENSITY_STORAGE;
   post_allocation_tasks(params);
+  // only images read from file hold integer counts, filtered or array images stay in full precision
+  if(params!=Teuchos::null&&params->get<bool>(DICe::compact_intensity_storage,false)
+      &&has_file_name_&&!has_gauss_filter_){
+    compact_intensities();
+  }
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t x, const int_t y) const {
   TEUCHOS_TEST_FOR_EXCEPTION(x<0||x>=width_,std::runtime_error,"");
   TEUCHOS_TEST_FOR_EXCEPTION(y<0||y>=height_,std::runtime_error,"");
-  return intensities_[y*width_+x];
+  return (*this)(y*width_+x);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t i) const {
-  return intensities_[i];
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    return intensities_8_[i];
+  case UINT16_INTENSITY_STORAGE:
+    return intensities_16_[i];
+  default:
+    return intensities_[i];
+  }
 }
 
 const scalar_t&
@@ -302,24 +321,108 @@ Image::grad_y(const int_t x,
 const scalar_t&
 Image::mask(const int_t x,
   const int_t y) const {
+  // the mask is zero until it has been created
+  static const scalar_t zero = 0.0;
+  if(mask_==Teuchos::null) return zero;
   return mask_[y*width_+x];
 }
 
 const scalar_t&
 Image::laplacian(const int_t x,
   const int_t y) const {
+  static const scalar_t zero = 0.0;
+  if(laplacian_==Teuchos::null) return zero;
   return laplacian_[y*width_+x];
 }
 
+void
+Image::allocate_mask(){
+  if(mask_==Teuchos::null)
+    mask_ = Image_Buffer_Pool::instance().scalar_buffer(height_*width_);
+}
+
 Teuchos::ArrayRCP<intensity_t>
-Image::intensities()const{
+Image::intensities(){
+  // callers may write through the returned array so it has to be the pixel container
+  expand_intensities();
   return intensities_;
 }
 
-void 
-Image::interpolate_bilinear_all(intensity_t& intensity_val, 
+Teuchos::ArrayRCP<const intensity_t>
+Image::intensity_values()const{
+  if(intensity_storage_==FULL_INTENSITY_STORAGE)
+    return intensities_.getConst();
+  // the compact containers stay in place since other threads may be interpolating the image
+  const int_t num_px = width_*height_;
+  Teuchos::ArrayRCP<intensity_t> values(num_px);
+  for(int_t i=0;i<num_px;++i)
+    values[i] = (*this)(i);
+  return values.getConst();
+}
+
+bool
+Image::compact_intensities(){
+  if(intensity_storage_!=FULL_INTENSITY_STORAGE) return true;
+  const int_t num_px = width_*height_;
+  intensity_t max_intensity = 0.0;
+  for(int_t i=0;i<num_px;++i){
+    const intensity_t value = intensities_[i];
+    // the values have to be non-negative integers to be stored without loss
+    if(value<0.0||value>65535.0||value!=std::floor(value)){
+      DEBUG_MSG("Image::compact_intensities(): intensities are not integer counts, storage not compacted");
+      return false;
+    }
+    if(value>max_intensity) max_intensity = value;
+  }
+  if(max_intensity<=255.0){
+    intensities_8_ = Teuchos::ArrayRCP<uint8_t>(num_px);
+    for(int_t i=0;i<num_px;++i)
+      intensities_8_[i] = static_cast<uint8_t>(intensities_[i]);
+    intensity_storage_ = UINT8_INTENSITY_STORAGE;
+  }
+  else{
+    intensities_16_ = Teuchos::ArrayRCP<uint16_t>(num_px);
+    for(int_t i=0;i<num_px;++i)
+      intensities_16_[i] = static_cast<uint16_t>(intensities_[i]);
+    intensity_storage_ = UINT16_INTENSITY_STORAGE;
+  }
+  DEBUG_MSG("Image::compact_intensities(): intensities stored as " << (intensity_storage_==UINT8_INTENSITY_STORAGE ? 8 : 16) << " bit integers");
+  // releasing the rcps returns the full precision buffer to the pool
+  intensities_ = Teuchos::null;
+  intensity_rcp_ = Teuchos::null;
+  return true;
+}
+
+void
+Image::expand_intensities(){
+  if(intensity_storage_==FULL_INTENSITY_STORAGE) return;
+  DEBUG_MSG("Image::expand_intensities(): expanding compact intensities to full precision");
+  const int_t num_px = width_*height_;
+  intensities_ = Image_Buffer_Pool::instance().intensity_buffer(num_px);
+  if(intensity_storage_==UINT8_INTENSITY_STORAGE){
+    for(int_t i=0;i<num_px;++i)
+      intensities_[i] = intensities_8_[i];
+  }
+  else{
+    for(int_t i=0;i<num_px;++i)
+      intensities_[i] = intensities_16_[i];
+  }
+  intensities_8_ = Teuchos::null;
+  intensities_16_ = Teuchos::null;
+  intensity_storage_ = FULL_INTENSITY_STORAGE;
+}
+
+Intensity_Storage
+Image::intensity_storage()const{
+  return intensity_storage_;
+}
+
+template <typename T>
+void
+Image::bilinear_all_kernel(const T * intens,
+  intensity_t& intensity_val, 
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
-       const scalar_t& local_x, const scalar_t& local_y) {
+       const scalar_t& local_x, const scalar_t& local_y)const {
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) {
     intensity_val = 0.0;
     if (compute_gradient) {
@@ -332,10 +435,10 @@ Image::interpolate_bilinear_all(intensity_t& intensity_val,
     const int_t x2 = x1+1;
     const int_t y1 = (int_t)local_y;
     const int_t y2  = y1+1;
-    intensity_val = intensities_[y1*width_+x1]*(x2-local_x)*(y2-local_y)
-      +intensities_[y1*width_+x2]*(local_x-x1)*(y2-local_y)
-      +intensities_[y2*width_+x2]*(local_x-x1)*(local_y-y1)
-      +intensities_[y2*width_+x1]*(x2-local_x)*(local_y-y1);
+    intensity_val = intens[y1*width_+x1]*(x2-local_x)*(y2-local_y)
+      +intens[y1*width_+x2]*(local_x-x1)*(y2-local_y)
+      +intens[y2*width_+x2]*(local_x-x1)*(local_y-y1)
+      +intens[y2*width_+x1]*(x2-local_x)*(local_y-y1);
     if (compute_gradient) {
       grad_x_val = grad_x_[y1*width_+x1]*(x2-local_x)*(y2-local_y)
         +grad_x_[y1*width_+x2]*(local_x-x1)*(y2-local_y)
@@ -350,18 +453,49 @@ Image::interpolate_bilinear_all(intensity_t& intensity_val,
   }
 }
 
+void
+Image::interpolate_bilinear_all(intensity_t& intensity_val, 
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    bilinear_all_kernel(intensities_8_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  case UINT16_INTENSITY_STORAGE:
+    bilinear_all_kernel(intensities_16_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  default:
+    bilinear_all_kernel(intensities_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  }
+}
+
+template <typename T>
 intensity_t
-Image::interpolate_bilinear(const scalar_t & local_x, const scalar_t & local_y){
+Image::bilinear_kernel(const T * intens,
+  const scalar_t & local_x, const scalar_t & local_y)const {
 
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) return 0.0;
   const int_t x1 = (int_t)local_x;
   const int_t x2 = x1+1;
   const int_t y1 = (int_t)local_y;
   const int_t y2  = y1+1;
-  return intensities_[y1*width_+x1]*(x2-local_x)*(y2-local_y)
-      +intensities_[y1*width_+x2]*(local_x-x1)*(y2-local_y)
-      +intensities_[y2*width_+x2]*(local_x-x1)*(local_y-y1)
-      +intensities_[y2*width_+x1]*(x2-local_x)*(local_y-y1);
+  return intens[y1*width_+x1]*(x2-local_x)*(y2-local_y)
+      +intens[y1*width_+x2]*(local_x-x1)*(y2-local_y)
+      +intens[y2*width_+x2]*(local_x-x1)*(local_y-y1)
+      +intens[y2*width_+x1]*(x2-local_x)*(local_y-y1);
+}
+
+intensity_t
+Image::interpolate_bilinear(const scalar_t & local_x, const scalar_t & local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    return bilinear_kernel(intensities_8_.getRawPtr(),local_x,local_y);
+  case UINT16_INTENSITY_STORAGE:
+    return bilinear_kernel(intensities_16_.getRawPtr(),local_x,local_y);
+  default:
+    return bilinear_kernel(intensities_.getRawPtr(),local_x,local_y);
+  }
 }
 
 scalar_t
@@ -391,8 +525,10 @@ Image::interpolate_grad_y_bilinear(const scalar_t & local_x, const scalar_t & lo
       +grad_y_[y2*width_+x1]*(x2-local_x)*(local_y-y1);
 }
 
+template <typename T>
 void
-Image::interpolate_bicubic_all(intensity_t& intensity_val, 
+Image::bicubic_all_kernel(const T * intens,
+  intensity_t& intensity_val, 
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
        const scalar_t& local_x, const scalar_t& local_y) {
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) {
@@ -417,22 +553,22 @@ Image::interpolate_bicubic_all(intensity_t& intensity_val,
   const scalar_t y_2 = y * y;
   const scalar_t y_3 = y_2 * y;
   // intensity
-  const intensity_t fm10  = intensities_[y0*width_+xm1];
-  const intensity_t f00   = intensities_[y0*width_+x0];
-  const intensity_t f10   = intensities_[y0*width_+x1];
-  const intensity_t f20   = intensities_[y0*width_+x2];
-  const intensity_t fm11  = intensities_[y1*width_+xm1];
-  const intensity_t f01   = intensities_[y1*width_+x0];
-  const intensity_t f11   = intensities_[y1*width_+x1];
-  const intensity_t f21   = intensities_[y1*width_+x2];
-  const intensity_t fm12  = intensities_[y2*width_+xm1];
-  const intensity_t f02   = intensities_[y2*width_+x0];
-  const intensity_t f12   = intensities_[y2*width_+x1];
-  const intensity_t f22   = intensities_[y2*width_+x2];
-  const intensity_t fm1m1 = intensities_[ym1*width_+xm1];
-  const intensity_t f0m1  = intensities_[ym1*width_+x0];
-  const intensity_t f1m1  = intensities_[ym1*width_+x1];
-  const intensity_t f2m1  = intensities_[ym1*width_+x2];
+  const intensity_t fm10  = intens[y0*width_+xm1];
+  const intensity_t f00   = intens[y0*width_+x0];
+  const intensity_t f10   = intens[y0*width_+x1];
+  const intensity_t f20   = intens[y0*width_+x2];
+  const intensity_t fm11  = intens[y1*width_+xm1];
+  const intensity_t f01   = intens[y1*width_+x0];
+  const intensity_t f11   = intens[y1*width_+x1];
+  const intensity_t f21   = intens[y1*width_+x2];
+  const intensity_t fm12  = intens[y2*width_+xm1];
+  const intensity_t f02   = intens[y2*width_+x0];
+  const intensity_t f12   = intens[y2*width_+x1];
+  const intensity_t f22   = intens[y2*width_+x2];
+  const intensity_t fm1m1 = intens[ym1*width_+xm1];
+  const intensity_t f0m1  = intens[ym1*width_+x0];
+  const intensity_t f1m1  = intens[ym1*width_+x1];
+  const intensity_t f2m1  = intens[ym1*width_+x2];
   #ifdef DICE_USE_DOUBLE
     intensity_val = f00 + (-0.5*f0m1 + .5*f01)*y + (f0m1 - 2.5*f00 + 2.0*f01 - .5*f02)*y_2 + (-0.5*f0m1 + 1.5*f00 - 1.5*f01 + .5*f02)*y_3
       + ((-0.5*fm10 + .5*f10) + (0.25*fm1m1 - .25*fm11 - .25*f1m1 + .25*f11)*y + (-0.5*fm1m1 + 1.25*fm10 - fm11 + .25*fm12 +
@@ -537,8 +673,27 @@ Image::interpolate_bicubic_all(intensity_t& intensity_val,
 
 }
 
+void
+Image::interpolate_bicubic_all(intensity_t& intensity_val, 
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    bicubic_all_kernel(intensities_8_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  case UINT16_INTENSITY_STORAGE:
+    bicubic_all_kernel(intensities_16_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  default:
+    bicubic_all_kernel(intensities_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  }
+}
+
+template <typename T>
 intensity_t
-Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
+Image::bicubic_kernel(const T * intens,
+  const scalar_t & local_x, const scalar_t & local_y) {
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) return this->interpolate_bilinear(local_x,local_y);
 
   const int_t x0  = (int_t)local_x;
@@ -555,22 +710,22 @@ Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
   const scalar_t x_3 = x_2 * x;
   const scalar_t y_2 = y * y;
   const scalar_t y_3 = y_2 * y;
-  const intensity_t fm10  = intensities_[y0*width_+xm1];
-  const intensity_t f00   = intensities_[y0*width_+x0];
-  const intensity_t f10   = intensities_[y0*width_+x1];
-  const intensity_t f20   = intensities_[y0*width_+x2];
-  const intensity_t fm11  = intensities_[y1*width_+xm1];
-  const intensity_t f01   = intensities_[y1*width_+x0];
-  const intensity_t f11   = intensities_[y1*width_+x1];
-  const intensity_t f21   = intensities_[y1*width_+x2];
-  const intensity_t fm12  = intensities_[y2*width_+xm1];
-  const intensity_t f02   = intensities_[y2*width_+x0];
-  const intensity_t f12   = intensities_[y2*width_+x1];
-  const intensity_t f22   = intensities_[y2*width_+x2];
-  const intensity_t fm1m1 = intensities_[ym1*width_+xm1];
-  const intensity_t f0m1  = intensities_[ym1*width_+x0];
-  const intensity_t f1m1  = intensities_[ym1*width_+x1];
-  const intensity_t f2m1  = intensities_[ym1*width_+x2];
+  const intensity_t fm10  = intens[y0*width_+xm1];
+  const intensity_t f00   = intens[y0*width_+x0];
+  const intensity_t f10   = intens[y0*width_+x1];
+  const intensity_t f20   = intens[y0*width_+x2];
+  const intensity_t fm11  = intens[y1*width_+xm1];
+  const intensity_t f01   = intens[y1*width_+x0];
+  const intensity_t f11   = intens[y1*width_+x1];
+  const intensity_t f21   = intens[y1*width_+x2];
+  const intensity_t fm12  = intens[y2*width_+xm1];
+  const intensity_t f02   = intens[y2*width_+x0];
+  const intensity_t f12   = intens[y2*width_+x1];
+  const intensity_t f22   = intens[y2*width_+x2];
+  const intensity_t fm1m1 = intens[ym1*width_+xm1];
+  const intensity_t f0m1  = intens[ym1*width_+x0];
+  const intensity_t f1m1  = intens[ym1*width_+x1];
+  const intensity_t f2m1  = intens[ym1*width_+x2];
 #ifdef DICE_USE_DOUBLE
   return f00 + (-0.5*f0m1 + .5*f01)*y + (f0m1 - 2.5*f00 + 2*f01 - .5*f02)*y_2 + (-0.5*f0m1 + 1.5*f00 - 1.5*f01 + .5*f02)*y_3
       + ((-0.5*fm10 + .5*f10) + (0.25*fm1m1 - .25*fm11 - .25*f1m1 + .25*f11)*y + (-0.5*fm1m1 + 1.25*fm10 - fm11 + .25*fm12 +
@@ -594,6 +749,18 @@ Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
 #endif
 }
 
+intensity_t
+Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    return bicubic_kernel(intensities_8_.getRawPtr(),local_x,local_y);
+  case UINT16_INTENSITY_STORAGE:
+    return bicubic_kernel(intensities_16_.getRawPtr(),local_x,local_y);
+  default:
+    return bicubic_kernel(intensities_.getRawPtr(),local_x,local_y);
+  }
+}
+
 scalar_t
 Image::interpolate_grad_x_bicubic(const scalar_t & local_x, const scalar_t & local_y){
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) return this->interpolate_grad_x_bilinear(local_x,local_y);
@@ -708,8 +875,10 @@ Image::interpolate_grad_y_bicubic(const scalar_t & local_x, const scalar_t & loc
 #endif
 }
 
+template <typename T>
 void
-Image::interpolate_keys_fourth_all(intensity_t& intensity_val, 
+Image::keys_fourth_all_kernel(const T * intens,
+  intensity_t& intensity_val, 
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
        const scalar_t& local_x, const scalar_t& local_y) {
   intensity_val = 0.0;
@@ -717,13 +886,13 @@ Image::interpolate_keys_fourth_all(intensity_t& intensity_val,
     grad_x_val = 0.0;
     grad_y_val = 0.0;
   }
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  scalar_t dx = 0.0;
+  scalar_t dy = 0.0;
+  int_t ix=0,iy=0;
   //static intensity_t value=0.0;
-  static intensity_t cc = 0.0;
+  intensity_t cc = 0.0;
   ix = (int_t)local_x;
   iy = (int_t)local_y;
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5) {
@@ -751,7 +920,7 @@ Image::interpolate_keys_fourth_all(intensity_t& intensity_val,
   for(int_t m=0;m<6;++m){
     for(int_t n=0;n<6;++n){
       cc = coeffs_y[m]*coeffs_x[n];
-      intensity_val += cc*intensities_[(iy-2+m)*width_ + ix-2+n];
+      intensity_val += cc*intens[(iy-2+m)*width_ + ix-2+n];
       if (compute_gradient) {
         grad_x_val += cc*grad_x_[(iy-2+m)*width_ + ix-2+n];
         grad_y_val += cc*grad_y_[(iy-2+m)*width_ + ix-2+n];
@@ -760,15 +929,34 @@ Image::interpolate_keys_fourth_all(intensity_t& intensity_val,
   }
 }
 
+void
+Image::interpolate_keys_fourth_all(intensity_t& intensity_val, 
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    keys_fourth_all_kernel(intensities_8_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  case UINT16_INTENSITY_STORAGE:
+    keys_fourth_all_kernel(intensities_16_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  default:
+    keys_fourth_all_kernel(intensities_.getRawPtr(),intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    break;
+  }
+}
+
 
+template <typename T>
 intensity_t
-Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
+Image::keys_fourth_kernel(const T * intens,
+  const scalar_t & local_x, const scalar_t & local_y) {
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  scalar_t dx = 0.0;
+  scalar_t dy = 0.0;
+  int_t ix=0,iy=0;
+  intensity_t value=0.0;
   ix = (int_t)local_x;
   iy = (int_t)local_y;
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
@@ -790,20 +978,32 @@ Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_
   value = 0.0;
   for(int_t m=0;m<6;++m){
     for(int_t n=0;n<6;++n){
-      value += coeffs_y[m]*coeffs_x[n]*intensities_[(iy-2+m)*width_ + ix-2+n];
+      value += coeffs_y[m]*coeffs_x[n]*intens[(iy-2+m)*width_ + ix-2+n];
     }
   }
   return value;
 }
 
+intensity_t
+Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    return keys_fourth_kernel(intensities_8_.getRawPtr(),local_x,local_y);
+  case UINT16_INTENSITY_STORAGE:
+    return keys_fourth_kernel(intensities_16_.getRawPtr(),local_x,local_y);
+  default:
+    return keys_fourth_kernel(intensities_.getRawPtr(),local_x,local_y);
+  }
+}
+
 scalar_t
 Image::interpolate_grad_x_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  scalar_t dx = 0.0;
+  scalar_t dy = 0.0;
+  int_t ix=0,iy=0;
+  intensity_t value=0.0;
   ix = (int_t)local_x;
   iy = (int_t)local_y;
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
@@ -833,12 +1033,12 @@ Image::interpolate_grad_x_keys_fourth(const scalar_t & local_x, const scalar_t &
 
 scalar_t
 Image::interpolate_grad_y_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  scalar_t dx = 0.0;
+  scalar_t dy = 0.0;
+  int_t ix=0,iy=0;
+  intensity_t value=0.0;
   ix = (int_t)local_x;
   iy = (int_t)local_y;
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
@@ -868,6 +1068,7 @@ Image::interpolate_grad_y_keys_fourth(const scalar_t & local_x, const scalar_t &
 
 void
 Image::compute_gradients(const bool use_hierarchical_parallelism, const int_t team_size){
+  DICE_PROFILE_SCOPE(PROFILE_IMAGE_GRADIENTS);
   if(gradient_method_==FINITE_DIFFERENCE){
     DEBUG_MSG("Image::compute_gradients(): using FINITE_DIFFERENCE");
     compute_gradients_finite_difference();
@@ -911,48 +1112,69 @@ Image::smooth_gradients_convolution_5_point(){
   }
 }
 
+template <typename T>
 void
-Image::compute_gradients_finite_difference(){
+Image::gradients_finite_difference_kernel(const T * intens) {
   for(int_t y=0;y<height_;++y){
     for(int_t x=0;x<width_;++x){
       if(x<2){
-        grad_x_[y*width_+x] = intensities_[y*width_+x+1] - intensities_[y*width_+x];
+        grad_x_[y*width_+x] = intens[y*width_+x+1] - intens[y*width_+x];
       }
       /// check if this pixel is near the right edge
       else if(x>=width_-2){
-        grad_x_[y*width_+x] = intensities_[y*width_+x] - intensities_[y*width_+x-1];
+        grad_x_[y*width_+x] = intens[y*width_+x] - intens[y*width_+x-1];
       }
       else{
-        grad_x_[y*width_+x] = grad_c1_*intensities_[y*width_+x-2] + grad_c2_*intensities_[y*width_+x-1]
-            - grad_c2_*intensities_[y*width_+x+1] - grad_c1_*intensities_[y*width_+x+2];
+        grad_x_[y*width_+x] = grad_c1_*intens[y*width_+x-2] + grad_c2_*intens[y*width_+x-1]
+            - grad_c2_*intens[y*width_+x+1] - grad_c1_*intens[y*width_+x+2];
       }
       /// check if this pixel is near the top edge
       if(y<2){
-        grad_y_[y*width_+x] = intensities_[(y+1)*width_+x] - intensities_[y*width_+x];
+        grad_y_[y*width_+x] = intens[(y+1)*width_+x] - intens[y*width_+x];
       }
       /// check if this pixel is near the bottom edge
       else if(y>=height_-2){
-        grad_y_[y*width_+x] = intensities_[y*width_+x] - intensities_[(y-1)*width_+x];
+        grad_y_[y*width_+x] = intens[y*width_+x] - intens[(y-1)*width_+x];
       }
       else{
-        grad_y_[y*width_+x] = grad_c1_*intensities_[(y-2)*width_+x] + grad_c2_*intensities_[(y-1)*width_+x]
-            - grad_c2_*intensities_[(y+1)*width_+x] - grad_c1_*intensities_[(y+2)*width_+x];
+        grad_y_[y*width_+x] = grad_c1_*intens[(y-2)*width_+x] + grad_c2_*intens[(y-1)*width_+x]
+            - grad_c2_*intens[(y+1)*width_+x] - grad_c1_*intens[(y+2)*width_+x];
       }
     }
   }
 }
 
+void
+Image::compute_gradients_finite_difference(){
+  switch(intensity_storage_){
+  case UINT8_INTENSITY_STORAGE:
+    gradients_finite_difference_kernel(intensities_8_.getRawPtr());
+    break;
+  case UINT16_INTENSITY_STORAGE:
+    gradients_finite_difference_kernel(intensities_16_.getRawPtr());
+    break;
+  default:
+    gradients_finite_difference_kernel(intensities_.getRawPtr());
+    break;
+  }
+}
+
 void
 Image::apply_mask(const Conformal_Area_Def & area_def,
   const bool smooth_edges){
+  clear_pyramid();
   // first create the mask:
   create_mask(area_def,smooth_edges);
+  expand_intensities();
   for(int_t i=0;i<num_pixels();++i)
     intensities_[i] = mask_[i]*intensities_[i];
 }
 
 void
 Image::apply_mask(const bool smooth_edges){
+  clear_pyramid();
+  expand_intensities();
+  allocate_mask();
   if(smooth_edges){
     static scalar_t smoothing_coeffs[5][5];
     std::vector<scalar_t> coeffs(5,0.0);
@@ -991,27 +1213,19 @@ void
 Image::create_mask(const Conformal_Area_Def & area_def,
   const bool smooth_edges){
   assert(area_def.has_boundary());
-  std::set<std::pair<int_t,int_t> > coords;
-  for(size_t i=0;i<area_def.boundary()->size();++i){
-    std::set<std::pair<int_t,int_t> > shapeCoords = (*area_def.boundary())[i]->get_owned_pixels();
-    coords.insert(shapeCoords.begin(),shapeCoords.end());
-  }
+  allocate_mask();
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(*area_def.boundary(),spans);
   // now remove any excluded regions:
-  // now set the inactive bit for the second set of multishapes if they exist.
-  if(area_def.has_excluded_area()){
-    for(size_t i=0;i<area_def.excluded_area()->size();++i){
-      std::set<std::pair<int_t,int_t> > removeCoords = (*area_def.excluded_area())[i]->get_owned_pixels();
-      std::set<std::pair<int_t,int_t> >::iterator it = removeCoords.begin();
-      for(;it!=removeCoords.end();++it){
-        if(coords.find(*it)!=coords.end())
-          coords.erase(*it);
-      } // end removeCoords loop
-    } // end excluded_area loop
-  } // end has excluded area
-  // NOTE: the pairs are (y,x) not (x,y) so that the ordering is correct in the set
-  std::set<std::pair<int_t,int_t> >::iterator set_it = coords.begin();
-  for( ; set_it!=coords.end();++set_it){
-    mask_[(set_it->first - offset_y_)*width_+set_it->second - offset_x_] = 1.0;
+  std::vector<Pixel_Span> excluded_spans;
+  if(area_def.has_excluded_area())
+    get_owned_spans(*area_def.excluded_area(),excluded_spans);
+  for(size_t i=0;i<spans.size();++i){
+    const int_t y = spans[i].y;
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x){
+      if(!excluded_spans.empty()&&spans_contain(excluded_spans,x,y)) continue;
+      mask_[(y - offset_y_)*width_+x - offset_x_] = 1.0;
+    }
   }
   if(smooth_edges){
     static scalar_t smoothing_coeffs[5][5];
@@ -1050,8 +1264,10 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   const int_t cx,
   const int_t cy,
   const bool apply_in_place){
+  if(apply_in_place) clear_pyramid();
   Teuchos::RCP<Image> this_img = Teuchos::rcp(this,false);
   if(apply_in_place){
+    expand_intensities();
     Teuchos::RCP<Image> temp_img = Teuchos::rcp(new Image(this_img));
     apply_transform(temp_img,this_img,cx,cy,shape_function);
     return Teuchos::null;
@@ -1067,6 +1283,9 @@ void
 Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelism,
   const int_t team_size){
   DEBUG_MSG("Image::gauss_filter: mask_size " << gauss_filter_mask_size_);
+  DICE_PROFILE_SCOPE(PROFILE_IMAGE_FILTER);
+  clear_pyramid();
+  expand_intensities();
 
   if(mask_size>0){
     gauss_filter_mask_size_=mask_size;
@@ -1110,9 +1329,10 @@ Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelis
   TEUCHOS_TEST_FOR_EXCEPTION(width_<gauss_filter_mask_size_||height_<gauss_filter_mask_size_,std::runtime_error,
     "Error, image too small (" << width_ << " x " << height_ << ") for gauss filtering with mask size " << gauss_filter_mask_size_);
 
-  // copy over the old intensities
+  // copy over the old intensities (the scratch buffer goes back to the pool when the filter is done)
+  Teuchos::ArrayRCP<intensity_t> intensities_temp = Image_Buffer_Pool::instance().intensity_buffer(num_pixels());
   for(int_t i=0;i<num_pixels();++i)
-    intensities_temp_[i] = intensities_[i];
+    intensities_temp[i] = intensities_[i];
 
   for(int_t j=0;j<gauss_filter_mask_size_;++j){
     for(int_t i=0;i<gauss_filter_mask_size_;++i){
@@ -1125,8 +1345,8 @@ Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelis
         intensity_t value = 0.0;
         for(int_t i=0;i<gauss_filter_mask_size_;++i){
           for(int_t j=0;j<gauss_filter_mask_size_;++j){
-            // assumes intensity values have already been deep copied into intensities_temp_
-            value += gauss_filter_coeffs_[i][j]*intensities_temp_[(y+(j-gauss_filter_half_mask_+1))*width_+x+(i-gauss_filter_half_mask_+1)];
+            // assumes intensity values have already been deep copied into intensities_temp
+            value += gauss_filter_coeffs_[i][j]*intensities_temp[(y+(j-gauss_filter_half_mask_+1))*width_+x+(i-gauss_filter_half_mask_+1)];
           } //j
         } //i
         intensities_[y*width_+x] = value;
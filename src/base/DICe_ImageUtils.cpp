@@ -43,7 +43,9 @@
 #include <DICe_Image.h>
 #include <DICe_LocalShapeFunction.h>
 
+#include <algorithm>
 #include <random>
+#include <sstream>
 
 namespace DICe {
 
@@ -75,6 +77,189 @@ void apply_transform(Teuchos::RCP<Image> image_in,
   shape_function->insert_motion(u,v);
 }
 
+Summed_Area_Table::Summed_Area_Table(Teuchos::RCP<Image> image,
+  const Summed_Area_Quantity quantity):
+  width_(0),
+  height_(0),
+  quantity_(quantity){
+  TEUCHOS_TEST_FOR_EXCEPTION(image==Teuchos::null,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(quantity==SUMMED_GRADIENT_MAGNITUDE_SQUARED&&!image->has_gradients(),std::runtime_error,
+    "Error, summed area table of the gradient magnitude requested, but image gradients have not been computed");
+  width_ = image->width();
+  height_ = image->height();
+  const int_t stride = width_ + 1;
+  table_.assign(stride*(height_+1),0.0);
+  for(int_t y=0;y<height_;++y){
+    double row_sum = 0.0;
+    for(int_t x=0;x<width_;++x){
+      double value = 0.0;
+      if(quantity_==SUMMED_INTENSITY)
+        value = (*image)(x,y);
+      else if(quantity_==SUMMED_INTENSITY_SQUARED)
+        value = (double)(*image)(x,y)*(*image)(x,y);
+      else
+        value = (double)image->grad_x(x,y)*image->grad_x(x,y) + (double)image->grad_y(x,y)*image->grad_y(x,y);
+      row_sum += value;
+      table_[(y+1)*stride+x+1] = table_[y*stride+x+1] + row_sum;
+    }
+  }
+}
+
+scalar_t
+Summed_Area_Table::window_sum(const int_t x_begin,
+  const int_t y_begin,
+  const int_t x_end,
+  const int_t y_end)const{
+  const int_t x0 = std::max(x_begin,0);
+  const int_t y0 = std::max(y_begin,0);
+  const int_t x1 = std::min(x_end,width_);
+  const int_t y1 = std::min(y_end,height_);
+  if(x1<=x0||y1<=y0) return 0.0;
+  const int_t stride = width_ + 1;
+  return table_[y1*stride+x1] - table_[y0*stride+x1] - table_[y1*stride+x0] + table_[y0*stride+x0];
+}
+
+scalar_t
+Summed_Area_Table::window_mean(const int_t x_begin,
+  const int_t y_begin,
+  const int_t x_end,
+  const int_t y_end)const{
+  const int_t x0 = std::max(x_begin,0);
+  const int_t y0 = std::max(y_begin,0);
+  const int_t x1 = std::min(x_end,width_);
+  const int_t y1 = std::min(y_end,height_);
+  if(x1<=x0||y1<=y0) return 0.0;
+  return window_sum(x0,y0,x1,y1)/((x1-x0)*(y1-y0));
+}
+
+Synthetic_Image_Generator::Synthetic_Image_Generator(Teuchos::RCP<Image> ref_image,
+  const std::vector<scalar_t> & periods,
+  const std::vector<scalar_t> & amplitudes,
+  const std::vector<std::string> & file_names,
+  const scalar_t & noise_percent,
+  const int_t gauss_filter_mask_size,
+  const bool compute_gradients,
+  const int_t num_threads):
+  ref_image_(ref_image.get()),
+  periods_(periods),
+  amplitudes_(amplitudes),
+  file_names_(file_names),
+  noise_percent_(noise_percent),
+  gauss_filter_mask_size_(gauss_filter_mask_size),
+  compute_gradients_(compute_gradients),
+  max_ahead_(2*(num_threads > 0 ? num_threads : 1)),
+  results_(periods.size()),
+  next_to_generate_(0),
+  next_to_consume_(0),
+  shutdown_(false){
+  TEUCHOS_TEST_FOR_EXCEPTION(ref_image==Teuchos::null,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(periods.size()!=amplitudes.size(),std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(!file_names.empty()&&file_names.size()!=periods.size(),std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(num_threads<=0,std::runtime_error,"Error, invalid number of threads " << num_threads);
+  // the reference count of a Teuchos::RCP is not atomic and the node tracing of a debug build adds every
+  // new RCP to a global table without a lock, and the Kokkos kernels are not meant to be launched from other threads,
+  // in either case the images are generated on the calling thread in next()
+  bool use_worker_threads = !Teuchos::RCPNodeTracer::isTracingActiveRCPNodes();
+#if DICE_KOKKOS
+  use_worker_threads = false;
+#endif
+  if(!use_worker_threads){
+    DEBUG_MSG("Synthetic_Image_Generator::Synthetic_Image_Generator(): generating " << periods.size() << " images on the calling thread");
+    return;
+  }
+  DEBUG_MSG("Synthetic_Image_Generator::Synthetic_Image_Generator(): generating " << periods.size() << " images on " << num_threads << " thread(s)");
+  for(int_t i=0;i<num_threads;++i)
+    threads_.push_back(std::thread(&Synthetic_Image_Generator::generate_loop,this));
+}
+
+Synthetic_Image_Generator::~Synthetic_Image_Generator(){
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    cond_.notify_all();
+  }
+  for(size_t i=0;i<threads_.size();++i)
+    threads_[i].join();
+}
+
+void
+Synthetic_Image_Generator::generate_loop(){
+  // each thread has its own non-owning handle to the reference image so that
+  // the reference count of the caller's handle is never touched from this thread
+  Teuchos::RCP<Image> ref_image = Teuchos::rcp(ref_image_,false);
+  while(true){
+    int_t case_id = -1;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock,[this]{return shutdown_||!error_msg_.empty()||next_to_generate_>=num_cases()||
+        next_to_generate_<next_to_consume_+max_ahead_;});
+      if(shutdown_||!error_msg_.empty()||next_to_generate_>=num_cases()) break;
+      case_id = next_to_generate_++;
+    }
+    Case_Result result;
+    try{
+      // the worker threads already use the cores, so the rows of each image are not split over an OpenMP team
+      generate_case(case_id,ref_image,false,result);
+    }
+    catch(std::exception & e){
+      std::unique_lock<std::mutex> lock(mutex_);
+      std::stringstream msg;
+      msg << "period " << periods_[case_id] << " amplitude " << amplitudes_[case_id] << ": " << e.what();
+      error_msg_ = msg.str();
+      cond_.notify_all();
+      break;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    results_[case_id] = result;
+    // drop this thread's references while holding the lock, the caller takes over the image from here
+    result = Case_Result();
+    cond_.notify_all();
+  }
+}
+
+void
+Synthetic_Image_Generator::generate_case(const int_t case_id,
+  Teuchos::RCP<Image> ref_image,
+  const bool use_threads,
+  Case_Result & result){
+  result.deformer = Teuchos::rcp(new SinCos_Image_Deformer(periods_[case_id],amplitudes_[case_id]));
+  result.image = result.deformer->deform_image(ref_image,use_threads);
+  if(noise_percent_ > 0.0)
+    add_noise_to_image(result.image,noise_percent_);
+  if(!file_names_.empty())
+    result.image->write(file_names_[case_id]);
+  if(gauss_filter_mask_size_ > 0)
+    result.image->gauss_filter(gauss_filter_mask_size_);
+  if(compute_gradients_)
+    result.image->compute_gradients();
+  result.ready = true;
+}
+
+Teuchos::RCP<Image>
+Synthetic_Image_Generator::next(Teuchos::RCP<Image_Deformer> & deformer){
+  std::unique_lock<std::mutex> lock(mutex_);
+  TEUCHOS_TEST_FOR_EXCEPTION(next_to_consume_>=num_cases(),std::runtime_error,"Error, all the synthetic images have been used");
+  if(threads_.empty()){
+    // no worker threads (see the constructor), generate the case here
+    Case_Result result;
+    generate_case(next_to_consume_,Teuchos::rcp(ref_image_,false),true,result);
+    next_to_consume_++;
+    deformer = result.deformer;
+    return result.image;
+  }
+  const int_t case_id = next_to_consume_;
+  cond_.wait(lock,[this,case_id]{return results_[case_id].ready||!error_msg_.empty();});
+  TEUCHOS_TEST_FOR_EXCEPTION(!results_[case_id].ready,std::runtime_error,
+    "Error, generating a synthetic image failed for " << error_msg_);
+  Teuchos::RCP<Image> image = results_[case_id].image;
+  deformer = results_[case_id].deformer;
+  // release the case so the memory can be reclaimed
+  results_[case_id] = Case_Result();
+  next_to_consume_++;
+  cond_.notify_all();
+  return image;
+}
+
 void SinCos_Image_Deformer::compute_deformation(const scalar_t & coord_x,
   const scalar_t & coord_y,
   scalar_t & bx,
@@ -84,6 +269,21 @@ void SinCos_Image_Deformer::compute_deformation(const scalar_t & coord_x,
   by = 0.5*amplitude_ - cos(beta*coord_x)*sin(beta*coord_y)*0.5*amplitude_;
 }
 
+void SinCos_Image_Deformer::compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+  const std::vector<scalar_t> & coords_y,
+  std::vector<scalar_t> & bx,
+  std::vector<scalar_t> & by){
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  bx.resize(num_points);
+  by.resize(num_points);
+  const scalar_t beta = period_==0.0 ? 0.0 : DICE_TWOPI*(1.0/period_);
+  for(int_t i=0;i<num_points;++i){
+    bx[i] = 0.5*amplitude_ + sin(beta*coords_x[i])*cos(beta*coords_y[i])*0.5*amplitude_;
+    by[i] = 0.5*amplitude_ - cos(beta*coords_x[i])*sin(beta*coords_y[i])*0.5*amplitude_;
+  }
+}
+
 void SinCos_Image_Deformer::compute_deriv_deformation(const scalar_t & coord_x,
   const scalar_t & coord_y,
   scalar_t & bxx,
@@ -112,6 +312,18 @@ void DICChallenge14_Image_Deformer::compute_deformation(const scalar_t & coord_x
   by = 0.0;
 }
 
+void DICChallenge14_Image_Deformer::compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+  const std::vector<scalar_t> & coords_y,
+  std::vector<scalar_t> & bx,
+  std::vector<scalar_t> & by){
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  bx.resize(num_points);
+  by.assign(num_points,0.0);
+  for(int_t i=0;i<num_points;++i)
+    bx[i] = coords_x[i] < 100.0 ? 0.0 : 0.1*std::sin(coeff_*(coords_x[i]-100.0)*(coords_x[i]-100.0));
+}
+
 void DICChallenge14_Image_Deformer::compute_deriv_deformation(const scalar_t & coord_x,
   const scalar_t & coord_y,
   scalar_t & bxx,
@@ -202,70 +414,61 @@ void Image_Deformer::compute_lagrange_strain_error(const scalar_t & coord_x,
   }
 }
 
+void
+Image_Deformer::compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+  const std::vector<scalar_t> & coords_y,
+  std::vector<scalar_t> & bx,
+  std::vector<scalar_t> & by){
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  bx.resize(num_points);
+  by.resize(num_points);
+  for(int_t i=0;i<num_points;++i)
+    compute_deformation(coords_x[i],coords_y[i],bx[i],by[i]);
+}
+
 Teuchos::RCP<Image>
-Image_Deformer::deform_image(Teuchos::RCP<Image> ref_image){
+Image_Deformer::deform_image(Teuchos::RCP<Image> ref_image,
+  const bool use_threads){
   const int_t w = ref_image->width();
   const int_t h = ref_image->height();
   const int_t ox = ref_image->offset_x();
   const int_t oy = ref_image->offset_y();
-//  // Note: uses 5 x 5 point sampling grid to evaluate the deformed intensity
-//  const int_t num_pts = 5;
-//  static scalar_t coeffs[5] = {0.0014,0.1574,0.62825,0.1574,0.0014};
-//  // Note: uses 11 x 11 point sampling grid to evaluate the deformed intensity
-////  static scalar_t coeffs[11] =
-////  {0.0001,0.0017,0.0168,0.0870,
-////    0.2328,0.3231,0.2328,
-////    0.0870,0.0168,0.0017,0.0001};
-//  Teuchos::ArrayRCP<intensity_t> def_intens(w*h,0.0);
-//  scalar_t bx=0.0,by=0.0;
-//  for(int_t j=0;j<h;++j){
-//    for(int_t i=0;i<w;++i){
-//      scalar_t avg_intens = 0.0;
-//      for(int_t oy=0;oy<num_pts;++oy){
-//        const scalar_t sample_y = j - 0.5*(num_pts-1)/num_pts + oy/num_pts;
-//        for(int_t ox=0;ox<num_pts;++ox){
-//          const scalar_t sample_x = i - 0.5*(num_pts-1)/num_pts + ox/num_pts;
-//          const scalar_t weight = coeffs[ox]*coeffs[oy];
-//          compute_deformation(sample_x,sample_y,bx,by);
-//          scalar_t intens = ref_image->interpolate_keys_fourth(sample_x-bx,sample_y-by);
-//          avg_intens += weight*intens;
-//        } // end super pixel ox
-//      } // end super pixel oy
-//      def_intens[j*w+i] = avg_intens;
-//    } // end pixel i
-//  } // ens pixel j
-
-
-  // Note: uses 5 x 5 point sampling grid to evaluate the deformed intensity
+  Image * ref = ref_image.get();
+  // Note: uses 5 point sampling (center and corners of the pixel) to evaluate the deformed intensity
   const int_t num_pts = 5;
-  static scalar_t offsets_x[5] = {0.0,-0.5,0.5,0.5,-0.5};
-  static scalar_t offsets_y[5] = {0.0,-0.5,-0.5,0.5,0.5};
+  static const scalar_t offsets_x[5] = {0.0,-0.5,0.5,0.5,-0.5};
+  static const scalar_t offsets_y[5] = {0.0,-0.5,-0.5,0.5,0.5};
   Teuchos::ArrayRCP<intensity_t> def_intens(w*h,0.0);
-  scalar_t bx=0.0,by=0.0;
-  for(int_t j=0;j<h;++j){
-    for(int_t i=0;i<w;++i){
-      scalar_t avg_intens = 0.0;
-      for(int_t pt=0;pt<num_pts;++pt){
-        const scalar_t sample_x = i - offsets_x[pt];
-        const scalar_t sample_y = j - offsets_y[pt];
-        compute_deformation(sample_x+ox,sample_y+oy,bx,by);
-        scalar_t intens = ref_image->interpolate_keys_fourth(sample_x-bx,sample_y-by);
-        avg_intens += intens;
-      } // end avg points
-      def_intens[j*w+i] = num_pts==0.0?0.0:avg_intens/num_pts;
-    } // end pixel i
-  } // ens pixel j
-
-  // no weighted average ...
-//  Teuchos::ArrayRCP<intensity_t> def_intens(w*h,0.0);
-//  scalar_t bx=0.0,by=0.0;
-//  for(int_t j=0;j<h;++j){
-//    for(int_t i=0;i<w;++i){
-//      compute_deformation(i,j,bx,by);
-//      scalar_t intens = ref_image->interpolate_keys_fourth(i-bx,j-by);
-//      def_intens[j*w+i] = intens;
-//    } // end pixel i
-//  } // ens pixel j
+  intensity_t * def_values = def_intens.getRawPtr();
+  // each row is independent, the sample points of a row are stored point by point
+  // so that the displacements for the whole row come from one batched evaluation
+#pragma omp parallel if(use_threads)
+  {
+    std::vector<scalar_t> sample_x(num_pts*w,0.0);
+    std::vector<scalar_t> sample_y(num_pts*w,0.0);
+    std::vector<scalar_t> bx(num_pts*w,0.0);
+    std::vector<scalar_t> by(num_pts*w,0.0);
+#pragma omp for schedule(dynamic,4)
+    for(int_t j=0;j<h;++j){
+      for(int_t i=0;i<w;++i){
+        for(int_t pt=0;pt<num_pts;++pt){
+          sample_x[i*num_pts+pt] = i - offsets_x[pt] + ox;
+          sample_y[i*num_pts+pt] = j - offsets_y[pt] + oy;
+        }
+      }
+      compute_deformation_batch(sample_x,sample_y,bx,by);
+      for(int_t i=0;i<w;++i){
+        scalar_t avg_intens = 0.0;
+        for(int_t pt=0;pt<num_pts;++pt){
+          const scalar_t sample_x_local = i - offsets_x[pt];
+          const scalar_t sample_y_local = j - offsets_y[pt];
+          avg_intens += ref->interpolate_keys_fourth(sample_x_local-bx[i*num_pts+pt],sample_y_local-by[i*num_pts+pt]);
+        } // end avg points
+        def_values[j*w+i] = num_pts==0.0?0.0:avg_intens/num_pts;
+      } // end pixel i
+    } // end pixel j
+  } // end parallel region
   Teuchos::RCP<Image> def_img = Teuchos::rcp(new Image(w,h,def_intens,Teuchos::null,ox,oy));
   return def_img;
 }
@@ -51,6 +51,10 @@
 
 #include <Teuchos_ParameterList.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 /*!
  *  \namespace DICe
  *  @{
@@ -137,6 +141,83 @@ DICE_LIB_DLL_EXPORT
 int_t compute_speckle_stats(const std::string & output_dir,
   Teuchos::RCP<Image> & image);
 
+/// quantities that can be accumulated in a summed area table
+enum Summed_Area_Quantity{
+  /// image intensity
+  SUMMED_INTENSITY=0,
+  /// image intensity squared
+  SUMMED_INTENSITY_SQUARED,
+  /// squared magnitude of the image gradient, grad_x^2 + grad_y^2 (used for SSSIG)
+  SUMMED_GRADIENT_MAGNITUDE_SQUARED
+};
+
+/// \class Summed_Area_Table
+/// \brief integral image of a pixel quantity so that the sum of the quantity over any rectangular
+/// window can be computed with four lookups regardless of the window size
+///
+/// The table is built once in one pass over the image. Pairs of tables (for example intensity and
+/// intensity squared) can be used to get windowed statistics like the local contrast or noise level.
+class
+DICE_LIB_DLL_EXPORT
+Summed_Area_Table{
+public:
+  /// constructor
+  /// \param image the image to accumulate the quantity from
+  /// \param quantity the quantity to sum
+  Summed_Area_Table(Teuchos::RCP<Image> image,
+    const Summed_Area_Quantity quantity);
+
+  /// destructor
+  virtual ~Summed_Area_Table(){};
+
+  /// returns the width of the table (same as the image)
+  int_t width()const{
+    return width_;
+  }
+
+  /// returns the height of the table (same as the image)
+  int_t height()const{
+    return height_;
+  }
+
+  /// returns the quantity that was accumulated
+  Summed_Area_Quantity quantity()const{
+    return quantity_;
+  }
+
+  /// returns the sum of the quantity over the pixels x_begin <= x < x_end and y_begin <= y < y_end
+  /// the window is clipped to the image extents, coordinates are local to the image
+  /// \param x_begin left edge of the window
+  /// \param y_begin top edge of the window
+  /// \param x_end one past the right edge of the window
+  /// \param y_end one past the bottom edge of the window
+  scalar_t window_sum(const int_t x_begin,
+    const int_t y_begin,
+    const int_t x_end,
+    const int_t y_end)const;
+
+  /// returns the mean of the quantity over a window, the divisor is the clipped window area
+  /// \param x_begin left edge of the window
+  /// \param y_begin top edge of the window
+  /// \param x_end one past the right edge of the window
+  /// \param y_end one past the bottom edge of the window
+  scalar_t window_mean(const int_t x_begin,
+    const int_t y_begin,
+    const int_t x_end,
+    const int_t y_end)const;
+
+private:
+  /// width of the image
+  int_t width_;
+  /// height of the image
+  int_t height_;
+  /// quantity accumulated in the table
+  Summed_Area_Quantity quantity_;
+  /// the table is (width_+1)x(height_+1) with a leading row and column of zeros,
+  /// the sums are kept in double precision so that differences of large sums stay accurate
+  std::vector<double> table_;
+};
+
 /// \class Image_Deformer
 /// \brief base class that deformes an input image according to an analytical function
 class
@@ -161,6 +242,18 @@ public:
     scalar_t & bx,
     scalar_t & by){TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Cannot call this base class method")};
 
+  /// compute the analytical displacement at a batch of coordinates, the default calls compute_deformation()
+  /// for each point, derived classes can override this with a loop free of virtual calls that the compiler
+  /// can vectorize. This is called from several threads at once by deform_image() so it must not modify the deformer.
+  /// \param coords_x the x-coordinates of the evaluation locations
+  /// \param coords_y the y-coordinates
+  /// \param bx [out] the x displacements (resized to the number of coordinates)
+  /// \param by [out] the y displacements
+  virtual void compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+    const std::vector<scalar_t> & coords_y,
+    std::vector<scalar_t> & bx,
+    std::vector<scalar_t> & by);
+
   /// compute the analytical derivatives at the given coordinates
   /// \param coord_x the x-coordinate for the evaluation location
   /// \param coord_y the y-coordinate
@@ -177,8 +270,13 @@ public:
 
   /// perform deformation on the image
   /// returns a pointer to the deformed image
+  /// the rows of the image are deformed in parallel (if OpenMP is enabled) and the displacements
+  /// of all the sample points in a row are evaluated with one call to compute_deformation_batch()
   /// \param ref_image the reference image
-  Teuchos::RCP<Image> deform_image(Teuchos::RCP<Image> ref_image);
+  /// \param use_threads false if the rows should not be split over an OpenMP team (for example when
+  /// this is called from several threads at once)
+  Teuchos::RCP<Image> deform_image(Teuchos::RCP<Image> ref_image,
+    const bool use_threads=true);
 
   /// compute the error of a given solution at the given coords
   /// \param coord_x the x coordinate
@@ -281,6 +379,16 @@ public:
     scalar_t & bx,
     scalar_t & by);
 
+  /// compute the analytical displacement at a batch of coordinates
+  /// \param coords_x the x-coordinates of the evaluation locations
+  /// \param coords_y the y-coordinates
+  /// \param bx [out] the x displacements (resized to the number of coordinates)
+  /// \param by [out] the y displacements
+  virtual void compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+    const std::vector<scalar_t> & coords_y,
+    std::vector<scalar_t> & bx,
+    std::vector<scalar_t> & by);
+
   /// compute the analytical derivatives at the given coordinates
   /// \param coord_x the x-coordinate for the evaluation location
   /// \param coord_y the y-coordinate
@@ -339,6 +447,16 @@ public:
     scalar_t & bx,
     scalar_t & by);
 
+  /// compute the analytical displacement at a batch of coordinates
+  /// \param coords_x the x-coordinates of the evaluation locations
+  /// \param coords_y the y-coordinates
+  /// \param bx [out] the x displacements (resized to the number of coordinates)
+  /// \param by [out] the y displacements
+  virtual void compute_deformation_batch(const std::vector<scalar_t> & coords_x,
+    const std::vector<scalar_t> & coords_y,
+    std::vector<scalar_t> & bx,
+    std::vector<scalar_t> & by);
+
   /// compute the analytical derivatives at the given coordinates
   /// \param coord_x the x-coordinate for the evaluation location
   /// \param coord_y the y-coordinate
@@ -425,6 +543,104 @@ private:
   scalar_t value_y_;
 };
 
+/// \class Synthetic_Image_Generator
+/// \brief generates the sin()*cos() deformed images for a sweep of motion periods and amplitudes on
+/// background threads so that the images for the next cases are ready while the current case is analyzed
+///
+/// The reference image is shared read-only by all the threads, it must not be changed while the generator
+/// exists. The cases are handed out in order and at most two cases per thread are generated ahead of the
+/// case being analyzed to bound the memory used. Each thread deforms its image serially (no nested OpenMP team).
+///
+/// The threads create Teuchos::RCPs, which is not safe if the RCP node tracing of a Teuchos debug build is
+/// active, and the Kokkos kernels are not meant to be launched from other threads. In those cases no threads are
+/// started and next() generates each image on the calling thread.
+class
+DICE_LIB_DLL_EXPORT
+Synthetic_Image_Generator{
+public:
+  /// constructor, the threads start generating images right away
+  /// \param ref_image the reference image to deform
+  /// \param periods the period of the motion for each case
+  /// \param amplitudes the amplitude of the motion for each case
+  /// \param file_names if not empty, the name of the file to write each deformed image to
+  /// \param noise_percent amount of noise to add to the deformed images (no noise if <= 0)
+  /// \param gauss_filter_mask_size if > 0 the deformed images are gauss filtered with this mask size
+  /// \param compute_gradients true if the gradients of the deformed images should be computed
+  /// \param num_threads the number of threads that generate images
+  Synthetic_Image_Generator(Teuchos::RCP<Image> ref_image,
+    const std::vector<scalar_t> & periods,
+    const std::vector<scalar_t> & amplitudes,
+    const std::vector<std::string> & file_names,
+    const scalar_t & noise_percent,
+    const int_t gauss_filter_mask_size,
+    const bool compute_gradients,
+    const int_t num_threads=1);
+
+  /// destructor, stops and joins the threads
+  virtual ~Synthetic_Image_Generator();
+
+  /// returns the number of cases
+  int_t num_cases()const{
+    return periods_.size();
+  }
+
+  /// returns the deformed image for the next case, waits for it if it has not been generated yet
+  /// \param deformer [out] the image deformer for the case (used to compute the exact solution)
+  Teuchos::RCP<Image> next(Teuchos::RCP<Image_Deformer> & deformer);
+
+private:
+  /// loop run by each thread
+  void generate_loop();
+  /// generated image and deformer for a case
+  struct Case_Result{
+    Case_Result():ready(false){};
+    bool ready;
+    Teuchos::RCP<Image> image;
+    Teuchos::RCP<Image_Deformer> deformer;
+  };
+  /// deform, add noise to, write, filter and compute the gradients of the image for a case
+  /// \param case_id the case
+  /// \param ref_image the reference image
+  /// \param use_threads true if the image can be deformed by an OpenMP team
+  /// \param result [out] the image and deformer for the case
+  void generate_case(const int_t case_id,
+    Teuchos::RCP<Image> ref_image,
+    const bool use_threads,
+    Case_Result & result);
+  /// the reference image (held by the caller for the life of the generator)
+  Image * ref_image_;
+  /// period for each case
+  std::vector<scalar_t> periods_;
+  /// amplitude for each case
+  std::vector<scalar_t> amplitudes_;
+  /// output file name for each case
+  std::vector<std::string> file_names_;
+  /// noise to add in percent of the max intensity
+  scalar_t noise_percent_;
+  /// gauss filter mask size
+  int_t gauss_filter_mask_size_;
+  /// true if the gradients should be computed
+  bool compute_gradients_;
+  /// maximum number of cases generated ahead of the one being consumed
+  int_t max_ahead_;
+  /// results for each case
+  std::vector<Case_Result> results_;
+  /// next case to be generated
+  int_t next_to_generate_;
+  /// next case to be handed out
+  int_t next_to_consume_;
+  /// true when the threads should exit
+  bool shutdown_;
+  /// error message set by a thread if generating an image failed
+  std::string error_msg_;
+  /// guards the shared state above
+  std::mutex mutex_;
+  /// signals a new result or a consumed case
+  std::condition_variable cond_;
+  /// the generating threads
+  std::vector<std::thread> threads_;
+};
+
 
 
 
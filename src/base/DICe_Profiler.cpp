@@ -0,0 +1,208 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_Profiler.h>
+
+#include <Teuchos_TestForException.hpp>
+
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+
+namespace DICe {
+
+Profiler &
+Profiler::instance(){
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Frame_Record &
+Profiler::current_frame(){
+  if(frames_.empty())
+    frames_.push_back(Frame_Record(0));
+  return frames_.back();
+}
+
+void
+Profiler::begin_frame(const int_t frame_id){
+  std::lock_guard<std::mutex> lock(mutex_);
+  frames_.push_back(Frame_Record(frame_id));
+}
+
+void
+Profiler::add_time(const Profile_Stage stage,
+  const double seconds){
+  assert(stage>=0&&stage<MAX_PROFILE_STAGE);
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_frame().stage_times[stage] += seconds;
+}
+
+void
+Profiler::add_count(const Profile_Counter counter,
+  const int_t n){
+  assert(counter>=0&&counter<MAX_PROFILE_COUNTER);
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_frame().counts[counter] += n;
+}
+
+void
+Profiler::begin_subset(const int_t subset_gid){
+  std::lock_guard<std::mutex> lock(mutex_);
+  subset_gid_ = subset_gid;
+  subset_start_ = std::chrono::steady_clock::now();
+}
+
+void
+Profiler::end_subset(const int_t subset_gid,
+  const int_t num_iterations,
+  const int_t status){
+  const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  TEUCHOS_TEST_FOR_EXCEPTION(subset_gid!=subset_gid_,std::runtime_error,
+    "Error, end_subset() called for subset " << subset_gid << " but the timer was started for subset " << subset_gid_);
+  const std::chrono::duration<double> elapsed = end - subset_start_;
+  Subset_Record record;
+  record.subset_gid = subset_gid;
+  record.seconds = elapsed.count();
+  record.num_iterations = num_iterations;
+  record.status = status;
+  Frame_Record & frame = current_frame();
+  frame.subsets.push_back(record);
+  frame.stage_times[PROFILE_SUBSET_SOLVE] += record.seconds;
+  if(num_iterations>0)
+    frame.counts[PROFILE_SOLVER_ITERATIONS] += num_iterations;
+  subset_gid_ = -1;
+}
+
+void
+Profiler::write_trace(const std::string & prefix){
+  std::lock_guard<std::mutex> lock(mutex_);
+  // json trace with everything
+  const std::string json_name = prefix + ".json";
+  std::ofstream json(json_name.c_str());
+  TEUCHOS_TEST_FOR_EXCEPTION(!json.is_open(),std::runtime_error,"Error, could not open profile trace file " << json_name);
+  json << std::setprecision(9);
+  json << "{\n  \"frames\": [";
+  for(size_t i=0;i<frames_.size();++i){
+    const Frame_Record & frame = frames_[i];
+    json << (i==0?"\n":",\n") << "    {\n      \"frame_id\": " << frame.frame_id << ",\n      \"stages\": {";
+    for(int_t s=0;s<MAX_PROFILE_STAGE;++s)
+      json << (s==0?"":", ") << "\"" << profileStageStrings[s] << "\": " << frame.stage_times[s];
+    json << "},\n      \"counters\": {";
+    for(int_t c=0;c<MAX_PROFILE_COUNTER;++c)
+      json << (c==0?"":", ") << "\"" << profileCounterStrings[c] << "\": " << frame.counts[c];
+    json << "},\n      \"subsets\": [";
+    for(size_t j=0;j<frame.subsets.size();++j){
+      const Subset_Record & subset = frame.subsets[j];
+      json << (j==0?"\n":",\n") << "        {\"subset_id\": " << subset.subset_gid << ", \"seconds\": " << subset.seconds <<
+          ", \"iterations\": " << subset.num_iterations << ", \"status\": " << subset.status << "}";
+    }
+    json << (frame.subsets.empty()?"]\n":"\n      ]\n") << "    }";
+  }
+  json << "\n  ]\n}\n";
+  json.close();
+
+  // one row per frame with the stage times and counters
+  const std::string frames_name = prefix + ".frames.csv";
+  std::ofstream frames_csv(frames_name.c_str());
+  TEUCHOS_TEST_FOR_EXCEPTION(!frames_csv.is_open(),std::runtime_error,"Error, could not open profile trace file " << frames_name);
+  frames_csv << std::setprecision(9) << "FRAME_ID";
+  for(int_t s=0;s<MAX_PROFILE_STAGE;++s)
+    frames_csv << "," << profileStageStrings[s];
+  for(int_t c=0;c<MAX_PROFILE_COUNTER;++c)
+    frames_csv << "," << profileCounterStrings[c];
+  frames_csv << "\n";
+  for(size_t i=0;i<frames_.size();++i){
+    frames_csv << frames_[i].frame_id;
+    for(int_t s=0;s<MAX_PROFILE_STAGE;++s)
+      frames_csv << "," << frames_[i].stage_times[s];
+    for(int_t c=0;c<MAX_PROFILE_COUNTER;++c)
+      frames_csv << "," << frames_[i].counts[c];
+    frames_csv << "\n";
+  }
+  frames_csv.close();
+
+  // one row per subset per frame
+  const std::string subsets_name = prefix + ".subsets.csv";
+  std::ofstream subsets_csv(subsets_name.c_str());
+  TEUCHOS_TEST_FOR_EXCEPTION(!subsets_csv.is_open(),std::runtime_error,"Error, could not open profile trace file " << subsets_name);
+  subsets_csv << std::setprecision(9) << "FRAME_ID,SUBSET_ID,SECONDS,ITERATIONS,STATUS\n";
+  for(size_t i=0;i<frames_.size();++i){
+    for(size_t j=0;j<frames_[i].subsets.size();++j){
+      const Subset_Record & subset = frames_[i].subsets[j];
+      subsets_csv << frames_[i].frame_id << "," << subset.subset_gid << "," << subset.seconds << "," <<
+          subset.num_iterations << "," << subset.status << "\n";
+    }
+  }
+  subsets_csv.close();
+}
+
+void
+Profiler::clear(){
+  std::lock_guard<std::mutex> lock(mutex_);
+  frames_.clear();
+  subset_gid_ = -1;
+}
+
+int_t
+Profiler::num_frames(){
+  std::lock_guard<std::mutex> lock(mutex_);
+  return frames_.size();
+}
+
+double
+Profiler::stage_time(const int_t frame_index,
+  const Profile_Stage stage){
+  std::lock_guard<std::mutex> lock(mutex_);
+  TEUCHOS_TEST_FOR_EXCEPTION(frame_index<0||frame_index>=(int_t)frames_.size(),std::runtime_error,"Error, invalid frame index " << frame_index);
+  return frames_[frame_index].stage_times[stage];
+}
+
+int_t
+Profiler::count(const int_t frame_index,
+  const Profile_Counter counter){
+  std::lock_guard<std::mutex> lock(mutex_);
+  TEUCHOS_TEST_FOR_EXCEPTION(frame_index<0||frame_index>=(int_t)frames_.size(),std::runtime_error,"Error, invalid frame index " << frame_index);
+  return frames_[frame_index].counts[counter];
+}
+
+}// End DICe Namespace
@@ -0,0 +1,259 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_PROFILER_H
+#define DICE_PROFILER_H
+
+#include <DICe.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Instrumentation macros, these compile to nothing unless DICE_ENABLE_PROFILING is defined
+/// so they can be left in the hot paths
+#ifdef DICE_ENABLE_PROFILING
+#  define DICE_PROFILE_CONCAT_IMPL(a,b) a##b
+#  define DICE_PROFILE_CONCAT(a,b) DICE_PROFILE_CONCAT_IMPL(a,b)
+/// time the rest of the enclosing scope and add it to the given stage of the current frame
+#  define DICE_PROFILE_SCOPE(stage) DICe::Profile_Timer DICE_PROFILE_CONCAT(dice_profile_timer_,__LINE__)(stage)
+/// add to one of the counters of the current frame
+#  define DICE_PROFILE_COUNT(counter,n) DICe::Profiler::instance().add_count(counter,n)
+/// start a new frame, all following timings and counts are added to this frame
+#  define DICE_PROFILE_BEGIN_FRAME(frame_id) DICe::Profiler::instance().begin_frame(frame_id)
+/// start the timer for a subset
+#  define DICE_PROFILE_BEGIN_SUBSET(subset_gid) DICe::Profiler::instance().begin_subset(subset_gid)
+/// stop the timer for a subset and record the time, number of iterations and status
+#  define DICE_PROFILE_END_SUBSET(subset_gid,num_iterations,status) DICe::Profiler::instance().end_subset(subset_gid,num_iterations,status)
+/// write the trace files (prefix.json, prefix.frames.csv and prefix.subsets.csv)
+#  define DICE_PROFILE_WRITE_TRACE(prefix) DICe::Profiler::instance().write_trace(prefix)
+#else
+#  define DICE_PROFILE_SCOPE(stage) do {} while (0)
+#  define DICE_PROFILE_COUNT(counter,n) do {} while (0)
+#  define DICE_PROFILE_BEGIN_FRAME(frame_id) do {} while (0)
+#  define DICE_PROFILE_BEGIN_SUBSET(subset_gid) do {} while (0)
+#  define DICE_PROFILE_END_SUBSET(subset_gid,num_iterations,status) do {} while (0)
+#  define DICE_PROFILE_WRITE_TRACE(prefix) do {} while (0)
+#endif
+
+/*!
+ *  \namespace DICe
+ *  @{
+ */
+/// generic DICe classes and functions
+namespace DICe {
+
+/// Stages of the analysis that are timed by the profiler
+enum Profile_Stage {
+  PROFILE_IMAGE_LOAD=0,
+  PROFILE_IMAGE_FILTER,
+  PROFILE_IMAGE_GRADIENTS,
+  PROFILE_INITIALIZATION,
+  PROFILE_SUBSET_SOLVE,
+  PROFILE_INTERPOLATION,
+  PROFILE_POST_PROCESS,
+  PROFILE_WRITE_OUTPUT,
+  // DON'T ADD ANY BELOW MAX
+  MAX_PROFILE_STAGE,
+  NO_SUCH_PROFILE_STAGE
+};
+
+const static char * profileStageStrings[] = {
+  "IMAGE_LOAD",
+  "IMAGE_FILTER",
+  "IMAGE_GRADIENTS",
+  "INITIALIZATION",
+  "SUBSET_SOLVE",
+  "INTERPOLATION",
+  "POST_PROCESS",
+  "WRITE_OUTPUT"
+};
+
+/// Event counters kept by the profiler
+enum Profile_Counter {
+  PROFILE_SOLVER_ITERATIONS=0,
+  PROFILE_INTERPOLATED_PIXELS,
+  PROFILE_FAILED_SUBSETS,
+  // DON'T ADD ANY BELOW MAX
+  MAX_PROFILE_COUNTER,
+  NO_SUCH_PROFILE_COUNTER
+};
+
+const static char * profileCounterStrings[] = {
+  "SOLVER_ITERATIONS",
+  "INTERPOLATED_PIXELS",
+  "FAILED_SUBSETS"
+};
+
+/// \class DICe::Profiler
+/// \brief Collects per-frame stage timings, event counts and per-subset timings
+///
+/// There is one profiler per process. The instrumentation macros above feed it
+/// and DICE_PROFILE_WRITE_TRACE exports the results. The timings of each stage
+/// are wall clock seconds summed over all the calls made while the frame was current.
+/// Stages can be nested, for example the initialization and interpolation times are
+/// also part of the subset solve time.
+class DICE_LIB_DLL_EXPORT
+Profiler {
+public:
+  /// returns the profiler for this process
+  static Profiler & instance();
+
+  /// \brief start a new frame
+  /// \param frame_id the id used to label the frame in the trace
+  void begin_frame(const int_t frame_id);
+
+  /// \brief add time to a stage of the current frame
+  /// \param stage the stage
+  /// \param seconds the elapsed time
+  void add_time(const Profile_Stage stage,
+    const double seconds);
+
+  /// \brief add to a counter of the current frame
+  /// \param counter the counter
+  /// \param n the amount to add
+  void add_count(const Profile_Counter counter,
+    const int_t n);
+
+  /// \brief start the timer for a subset
+  /// \param subset_gid global id of the subset
+  void begin_subset(const int_t subset_gid);
+
+  /// \brief stop the timer for a subset and record it in the current frame
+  /// \param subset_gid global id of the subset
+  /// \param num_iterations number of solver iterations used
+  /// \param status the status flag of the step
+  void end_subset(const int_t subset_gid,
+    const int_t num_iterations,
+    const int_t status);
+
+  /// \brief write the trace files
+  /// \param prefix path and name prefix, writes prefix.json, prefix.frames.csv and prefix.subsets.csv
+  void write_trace(const std::string & prefix);
+
+  /// clear all recorded frames
+  void clear();
+
+  /// returns the number of recorded frames
+  int_t num_frames();
+
+  /// \brief returns the total time of a stage for a recorded frame
+  /// \param frame_index index of the frame (order in which the frames were started)
+  /// \param stage the stage
+  double stage_time(const int_t frame_index,
+    const Profile_Stage stage);
+
+  /// \brief returns a counter for a recorded frame
+  /// \param frame_index index of the frame (order in which the frames were started)
+  /// \param counter the counter
+  int_t count(const int_t frame_index,
+    const Profile_Counter counter);
+
+private:
+  /// timing of one subset
+  struct Subset_Record {
+    /// global id of the subset
+    int_t subset_gid;
+    /// elapsed time in seconds
+    double seconds;
+    /// number of solver iterations
+    int_t num_iterations;
+    /// status flag of the step
+    int_t status;
+  };
+  /// everything recorded for a frame
+  struct Frame_Record {
+    Frame_Record(const int_t id):
+      frame_id(id),
+      stage_times(MAX_PROFILE_STAGE,0.0),
+      counts(MAX_PROFILE_COUNTER,0){};
+    /// id of the frame
+    int_t frame_id;
+    /// time spent in each stage
+    std::vector<double> stage_times;
+    /// value of each counter
+    std::vector<int_t> counts;
+    /// per subset timings
+    std::vector<Subset_Record> subsets;
+  };
+  /// constructor
+  Profiler():
+    subset_gid_(-1){};
+  /// returns the current frame, creating frame 0 if no frame has been started (mutex must be locked)
+  Frame_Record & current_frame();
+  /// recorded frames
+  std::vector<Frame_Record> frames_;
+  /// global id of the subset being timed
+  int_t subset_gid_;
+  /// start time of the subset being timed
+  std::chrono::steady_clock::time_point subset_start_;
+  /// guards the records
+  std::mutex mutex_;
+};
+
+/// \class DICe::Profile_Timer
+/// \brief Adds the time between construction and destruction to a stage of the current frame
+class DICE_LIB_DLL_EXPORT
+Profile_Timer {
+public:
+  /// \brief constructor, starts the timer
+  /// \param stage the stage to add the time to
+  Profile_Timer(const Profile_Stage stage):
+    stage_(stage),
+    start_(std::chrono::steady_clock::now()){};
+  /// destructor, stops the timer
+  ~Profile_Timer(){
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    Profiler::instance().add_time(stage_,elapsed.count());
+  }
+private:
+  /// stage being timed
+  Profile_Stage stage_;
+  /// start time
+  std::chrono::steady_clock::time_point start_;
+};
+
+}// End DICe Namespace
+
+/*! @} End of Doxygen namespace*/
+
+#endif
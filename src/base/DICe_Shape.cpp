@@ -44,6 +44,7 @@
 #include <DICe_LocalShapeFunction.h>
 
 #include <cassert>
+#include <cmath>
 
 namespace DICe {
 
@@ -101,6 +102,358 @@ angle_2d(const scalar_t & x1,
   return(dtheta);
 }
 
+void
+Pixel_Mask::expand(const int_t min_x,
+  const int_t min_y,
+  const int_t max_x,
+  const int_t max_y){
+  TEUCHOS_TEST_FOR_EXCEPTION(max_x<min_x||max_y<min_y,std::invalid_argument,"Error, invalid extents for pixel mask");
+  if(width_>0&&height_>0&&min_x>=origin_x_&&min_y>=origin_y_&&
+      max_x<origin_x_+width_&&max_y<origin_y_+height_) return;
+  int_t new_origin_x = min_x;
+  int_t new_origin_y = min_y;
+  int_t new_end_x = max_x + 1;
+  int_t new_end_y = max_y + 1;
+  if(width_>0&&height_>0){
+    new_origin_x = std::min(new_origin_x,origin_x_);
+    new_origin_y = std::min(new_origin_y,origin_y_);
+    new_end_x = std::max(new_end_x,origin_x_+width_);
+    new_end_y = std::max(new_end_y,origin_y_+height_);
+  }
+  const int_t new_width = new_end_x - new_origin_x;
+  const int_t new_height = new_end_y - new_origin_y;
+  const int_t new_words_per_row = (new_width + 63)/64;
+  std::vector<uint64_t> new_bits(new_words_per_row*new_height,0);
+  // copy over any flagged pixels (growing the mask is rare so this is done pixel by pixel)
+  if(!empty_){
+    for(int_t y=0;y<height_;++y){
+      const int_t new_y = y + origin_y_ - new_origin_y;
+      for(int_t x=0;x<width_;++x){
+        if((bits_[y*words_per_row_+(x>>6)]>>(x&63))&1){
+          const int_t new_x = x + origin_x_ - new_origin_x;
+          new_bits[new_y*new_words_per_row+(new_x>>6)] |= uint64_t(1) << (new_x&63);
+        }
+      }
+    }
+  }
+  bits_.swap(new_bits);
+  origin_x_ = new_origin_x;
+  origin_y_ = new_origin_y;
+  width_ = new_width;
+  height_ = new_height;
+  words_per_row_ = new_words_per_row;
+}
+
+void
+Pixel_Mask::set_span(const int_t y,
+  const int_t x_begin,
+  const int_t x_end){
+  const int_t iy = y - origin_y_;
+  if(iy<0||iy>=height_) return;
+  const int_t b = std::max(x_begin - origin_x_,0);
+  const int_t e = std::min(x_end - origin_x_,width_-1);
+  if(b>e) return;
+  uint64_t * row = &bits_[iy*words_per_row_];
+  const int_t word_b = b>>6;
+  const int_t word_e = e>>6;
+  const uint64_t first = ~uint64_t(0) << (b&63);
+  const uint64_t last = ~uint64_t(0) >> (63-(e&63));
+  if(word_b==word_e){
+    row[word_b] |= first & last;
+  }
+  else{
+    row[word_b] |= first;
+    for(int_t w=word_b+1;w<word_e;++w)
+      row[w] = ~uint64_t(0);
+    row[word_e] |= last;
+  }
+  empty_ = false;
+}
+
+int_t
+Pixel_Mask::num_flagged()const{
+  int_t count = 0;
+  for(size_t i=0;i<bits_.size();++i){
+    uint64_t word = bits_[i];
+    while(word){
+      word &= word - 1;
+      count++;
+    }
+  }
+  return count;
+}
+
+void
+deform_vertices(Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor,
+  std::vector<int_t> & verts_x,
+  std::vector<int_t> & verts_y){
+  assert(shape_function!=Teuchos::null);
+  assert(verts_x.size()==verts_y.size());
+  assert(verts_x.size()>1);
+  scalar_t X=0.0,Y=0.0;
+  int_t new_x=0,new_y=0;
+  for(size_t i=0;i<verts_x.size();++i){
+    shape_function->map(verts_x[i],verts_y[i],cx,cy,X,Y);
+    new_x = (int_t)X;
+    if(X - (int_t)X >= 0.5) new_x++;
+    new_y = (int_t)Y;
+    if(Y - (int_t)Y >= 0.5) new_y++;
+    verts_x[i] = new_x;
+    verts_y[i] = new_y;
+  }
+  // compute the geometric centroid of the new vertices (the last vertex is a repeat of the first):
+  int_t centroid_x = 0;
+  int_t centroid_y = 0;
+  for(size_t i=0;i<verts_x.size()-1;++i){
+    centroid_x+=verts_x[i];
+    centroid_y+=verts_y[i];
+  }
+  centroid_x /= (int_t)(verts_x.size()-1);
+  centroid_y /= (int_t)(verts_y.size()-1);
+  // apply the skin factor (applied as a stretch in x and y):
+  for(size_t i=0;i<verts_x.size();++i){
+    verts_x[i] = skin_factor*(verts_x[i] - centroid_x) + centroid_x;
+    verts_y[i] = skin_factor*(verts_y[i] - centroid_y) + centroid_y;
+  }
+}
+
+void
+rasterize_spans(const std::vector<Pixel_Span> & spans,
+  Pixel_Mask & mask){
+  if(spans.empty()) return;
+  int_t min_x = spans[0].x_begin;
+  int_t max_x = spans[0].x_end;
+  for(size_t i=1;i<spans.size();++i){
+    min_x = std::min(min_x,spans[i].x_begin);
+    max_x = std::max(max_x,spans[i].x_end);
+  }
+  mask.expand(min_x,spans.front().y,max_x,spans.back().y);
+  for(size_t i=0;i<spans.size();++i)
+    mask.set_span(spans[i].y,spans[i].x_begin,spans[i].x_end);
+}
+
+void
+merge_pixel_spans(std::vector<Pixel_Span> & spans){
+  if(spans.empty()) return;
+  std::sort(spans.begin(),spans.end(),[](const Pixel_Span & a, const Pixel_Span & b)
+    {return a.y < b.y || (a.y == b.y && a.x_begin < b.x_begin);});
+  size_t last = 0;
+  for(size_t i=1;i<spans.size();++i){
+    if(spans[i].y==spans[last].y&&spans[i].x_begin<=spans[last].x_end+1){
+      spans[last].x_end = std::max(spans[last].x_end,spans[i].x_end);
+    }
+    else{
+      spans[++last] = spans[i];
+    }
+  }
+  spans.resize(last+1);
+}
+
+int_t
+num_pixels_in_spans(const std::vector<Pixel_Span> & spans){
+  int_t num_pixels = 0;
+  for(size_t i=0;i<spans.size();++i)
+    num_pixels += spans[i].x_end - spans[i].x_begin + 1;
+  return num_pixels;
+}
+
+bool
+spans_contain(const std::vector<Pixel_Span> & spans,
+  const int_t x,
+  const int_t y){
+  // find the first span that starts after the pixel, the one before it is the only candidate
+  std::vector<Pixel_Span>::const_iterator it = std::upper_bound(spans.begin(),spans.end(),std::pair<int_t,int_t>(y,x),
+    [](const std::pair<int_t,int_t> & p, const Pixel_Span & span)
+    {return p.first < span.y || (p.first == span.y && p.second < span.x_begin);});
+  if(it==spans.begin()) return false;
+  --it;
+  return it->y==y && x<=it->x_end;
+}
+
+namespace {
+
+/// the winding angle test used by Polygon::deactivate_pixels(), true if the point is in the polygon
+bool
+winding_angle_test(const int_t x,
+  const int_t y,
+  const std::vector<int_t> & verts_x,
+  const std::vector<int_t> & verts_y){
+  scalar_t dx1=0,dx2=0,dy1=0,dy2=0;
+  scalar_t angle=0.0;
+  for(size_t i=0;i+1<verts_x.size();i++) {
+    dx1 = verts_x[i] - x;
+    dy1 = verts_y[i] - y;
+    dx2 = verts_x[i+1] - x;
+    dy2 = verts_y[i+1] - y;
+    angle += angle_2d(dx1,dy1,dx2,dy2);
+  }
+  return std::abs(angle) >= DICE_PI;
+}
+
+/// floor of num/den for den > 0
+int64_t
+floor_div(const int64_t num,
+  const int64_t den){
+  int64_t q = num/den;
+  if((num%den!=0)&&(num<0)) q--;
+  return q;
+}
+
+/// an edge of the edge table (y0 < y1)
+struct Scan_Edge {
+  int64_t x0;
+  int64_t y0;
+  int64_t x1;
+  int64_t y1;
+  int_t winding;
+};
+
+/// the crossing of an edge with a row
+struct Scan_Crossing {
+  /// position of the crossing (used for sorting)
+  double x;
+  /// largest integer <= the crossing
+  int64_t floor_x;
+  /// true if the crossing is exactly on a pixel center
+  bool exact;
+  /// +1 or -1 depending on the edge direction
+  int_t winding;
+};
+
+} // end anonymous namespace
+
+void
+polygon_spans(const std::vector<int_t> & verts_x,
+  const std::vector<int_t> & verts_y,
+  std::vector<Pixel_Span> & spans){
+  assert(verts_x.size()==verts_y.size());
+  assert(verts_x.size()>=2);
+  const size_t num_edges = verts_x.size()-1;
+  std::vector<Pixel_Span> poly_spans;
+
+  // the pixels that sit exactly on an edge are the only ones where the scanline and the angle test can differ
+  std::vector<std::pair<int_t,int_t> > boundary; // (y,x)
+  std::vector<Scan_Edge> edge_table;
+  edge_table.reserve(num_edges);
+  int_t min_y = verts_y[0];
+  int_t max_y = verts_y[0];
+  for(size_t i=0;i<num_edges;++i){
+    min_y = std::min(min_y,verts_y[i]);
+    max_y = std::max(max_y,verts_y[i]);
+    const int_t dx = verts_x[i+1] - verts_x[i];
+    const int_t dy = verts_y[i+1] - verts_y[i];
+    int_t a = std::abs(dx);
+    int_t b = std::abs(dy);
+    while(b){const int_t t = a%b; a = b; b = t;}
+    const int_t g = a;
+    if(g==0){
+      boundary.push_back(std::pair<int_t,int_t>(verts_y[i],verts_x[i]));
+    }
+    else{
+      for(int_t k=0;k<=g;++k)
+        boundary.push_back(std::pair<int_t,int_t>(verts_y[i]+k*(dy/g),verts_x[i]+k*(dx/g)));
+    }
+    if(dy==0) continue; // horizontal edges do not cross any row
+    Scan_Edge edge;
+    if(dy>0){
+      edge.x0 = verts_x[i]; edge.y0 = verts_y[i]; edge.x1 = verts_x[i+1]; edge.y1 = verts_y[i+1]; edge.winding = 1;
+    }
+    else{
+      edge.x0 = verts_x[i+1]; edge.y0 = verts_y[i+1]; edge.x1 = verts_x[i]; edge.y1 = verts_y[i]; edge.winding = -1;
+    }
+    edge_table.push_back(edge);
+  }
+  std::sort(boundary.begin(),boundary.end());
+  boundary.erase(std::unique(boundary.begin(),boundary.end()),boundary.end());
+  std::sort(edge_table.begin(),edge_table.end(),[](const Scan_Edge & a, const Scan_Edge & b){return a.y0 < b.y0;});
+
+  std::vector<size_t> active;
+  std::vector<Scan_Crossing> crossings;
+  size_t next_edge = 0;
+  std::vector<std::pair<int_t,int_t> >::const_iterator boundary_it = boundary.begin();
+  for(int_t y=min_y;y<=max_y;++y){
+    // update the active edge list (half-open rule: an edge covers the rows y0 <= y < y1)
+    while(next_edge<edge_table.size()&&edge_table[next_edge].y0<=y)
+      active.push_back(next_edge++);
+    size_t num_active = 0;
+    for(size_t i=0;i<active.size();++i)
+      if(edge_table[active[i]].y1>y) active[num_active++] = active[i];
+    active.resize(num_active);
+    crossings.clear();
+    for(size_t i=0;i<active.size();++i){
+      const Scan_Edge & edge = edge_table[active[i]];
+      // exact rational crossing x0 + num/den
+      const int64_t num = (y - edge.y0)*(edge.x1 - edge.x0);
+      const int64_t den = edge.y1 - edge.y0;
+      Scan_Crossing crossing;
+      crossing.x = edge.x0 + (double)num/(double)den;
+      crossing.floor_x = edge.x0 + floor_div(num,den);
+      crossing.exact = num%den==0;
+      crossing.winding = edge.winding;
+      crossings.push_back(crossing);
+    }
+    std::sort(crossings.begin(),crossings.end(),[](const Scan_Crossing & a, const Scan_Crossing & b){return a.x < b.x;});
+    // the boundary pixels in this row
+    std::vector<std::pair<int_t,int_t> >::const_iterator row_begin = boundary_it;
+    while(boundary_it!=boundary.end()&&boundary_it->first==y) ++boundary_it;
+    std::vector<std::pair<int_t,int_t> >::const_iterator row_end = boundary_it;
+    // runs of pixels strictly inside (non-zero winding), split around the boundary pixels
+    int_t winding = 0;
+    for(size_t i=0;i+1<crossings.size();++i){
+      winding += crossings[i].winding;
+      if(winding==0) continue;
+      int_t x_begin = crossings[i].floor_x + 1;
+      const int_t x_end = crossings[i+1].exact ? crossings[i+1].floor_x - 1 : crossings[i+1].floor_x;
+      std::vector<std::pair<int_t,int_t> >::const_iterator b_it = std::lower_bound(row_begin,row_end,std::pair<int_t,int_t>(y,x_begin));
+      for(;b_it!=row_end&&b_it->second<=x_end;++b_it){
+        if(b_it->second>x_begin){
+          Pixel_Span span = {y,x_begin,b_it->second-1};
+          poly_spans.push_back(span);
+        }
+        x_begin = b_it->second + 1;
+      }
+      if(x_begin<=x_end){
+        Pixel_Span span = {y,x_begin,x_end};
+        poly_spans.push_back(span);
+      }
+    }
+    // the boundary pixels use the angle test so the result matches it exactly
+    for(std::vector<std::pair<int_t,int_t> >::const_iterator b_it=row_begin;b_it!=row_end;++b_it){
+      if(winding_angle_test(b_it->second,y,verts_x,verts_y)){
+        Pixel_Span span = {y,b_it->second,b_it->second};
+        poly_spans.push_back(span);
+      }
+    }
+  }
+  merge_pixel_spans(poly_spans);
+  spans.insert(spans.end(),poly_spans.begin(),poly_spans.end());
+}
+
+void
+get_owned_spans(const multi_shape & shapes,
+  std::vector<Pixel_Span> & spans){
+  spans.clear();
+  for(size_t i=0;i<shapes.size();++i)
+    shapes[i]->get_owned_spans(spans);
+  merge_pixel_spans(spans);
+}
+
+void
+deactivate_pixels_in_spans(const std::vector<Pixel_Span> & spans,
+  const int_t size,
+  bool * pixel_flags,
+  const int_t * x_coords,
+  const int_t * y_coords){
+  if(spans.empty()) return;
+  for(int_t i=0;i<size;++i){
+    if(spans_contain(spans,x_coords[i],y_coords[i]))
+      pixel_flags[i] = false;
+  }
+}
+
 void
 Polygon::deactivate_pixels(const int_t size,
   bool * pixel_flags,
@@ -137,85 +490,41 @@ Polygon::get_owned_pixels(Teuchos::RCP<Local_Shape_Function> shape_function,
   const int_t cx,
   const int_t cy,
   const scalar_t skin_factor)const{
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
+  std::set<std::pair<int_t,int_t> > coordSet;
+  // the spans are sorted so each insert goes at the end of the set
+  for(size_t i=0;i<spans.size();++i)
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x)
+      coordSet.insert(coordSet.end(),std::pair<int_t,int_t>(spans[i].y,x));
+  return coordSet;
+}
 
+void
+Polygon::get_owned_spans(std::vector<Pixel_Span> & spans,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  if(shape_function==Teuchos::null){
+    polygon_spans(vertex_coordinates_x_,vertex_coordinates_y_,spans);
+    return;
+  }
   std::vector<int_t> verts_x = vertex_coordinates_x_;
   std::vector<int_t> verts_y = vertex_coordinates_y_;
-  int_t min_x = min_x_;
-  int_t min_y = min_y_;
-  int_t max_x = max_x_;
-  int_t max_y = max_y_;
-
-  if(shape_function!=Teuchos::null){
-    scalar_t X=0.0,Y=0.0;
-    int_t new_x=0,new_y=0;
-    for(size_t i=0;i<vertex_coordinates_x_.size();++i){
-      int_t x = vertex_coordinates_x_[i];
-      int_t y = vertex_coordinates_y_[i];
-      // iterate over all the pixels in the reference blocking subset and compute the current position
-      shape_function->map(x,y,cx,cy,X,Y);
-      new_x = (int_t)X;
-      if(X - (int_t)X >= 0.5) new_x++;
-      new_y = (int_t)Y;
-      if(Y - (int_t)Y >= 0.5) new_y++;
-      verts_x[i] = new_x;
-      verts_y[i] = new_y;
-    }
-    // compute the geometric centroid of the new vertices:
-    int_t centroid_x = 0;
-    int_t centroid_y = 0;
-    for(size_t i=0;i<verts_x.size()-1;++i){
-      centroid_x+=verts_x[i];
-      centroid_y+=verts_y[i];
-    }
-    centroid_x /= verts_x.size()-1==0.0?1.0:(verts_x.size()-1);
-    centroid_y /= verts_y.size()-1==0.0?1.0:(verts_y.size()-1);
-    // apply the skin factor
-    for(size_t i=0;i<verts_x.size();++i){
-      // add the skin to the new vertex (applied as a stretch in x and y):
-      new_x = skin_factor*(verts_x[i] - centroid_x) + centroid_x;
-      new_y = skin_factor*(verts_y[i] - centroid_y) + centroid_y;
-      verts_x[i] = new_x;
-      verts_y[i] = new_y;
-      if(i==0){
-        min_x = new_x;
-        max_x = new_x;
-        min_y = new_y;
-        max_y = new_y;
-      }
-      else{
-        if(new_x < min_x){min_x = new_x;}
-        if(new_x > max_x){max_x = new_x;}
-        if(new_y < min_y){min_y = new_y;}
-        if(new_y > max_y){max_y = new_y;}
-      }
-    } // vertex_loop
-  }
-
-  std::set<std::pair<int_t,int_t> > coordSet;
+  deform_vertices(shape_function,cx,cy,skin_factor,verts_x,verts_y);
+  polygon_spans(verts_x,verts_y,spans);
+}
 
-  scalar_t dx1=0,dx2=0,dy1=0,dy2=0;
-  scalar_t angle=0;
-  // rip over the points in the extents of the polygon to determine which onese are inside
-  for(int_t y=min_y;y<=max_y;++y){
-    for(int_t x=min_x;x<=max_x;++x){
-      // x and y are the global coordinates of the point to test
-      angle=0.0;
-      for (int_t i=0;i<num_vertices_;i++) {
-        // get the two end points of the polygon side and construct
-        // a vector from the point to each one:
-        dx1 = verts_x[i] - x;
-        dy1 = verts_y[i] - y;
-        dx2 = verts_x[i+1] - x;
-        dy2 = verts_y[i+1] - y;
-        angle += angle_2d(dx1,dy1,dx2,dy2);
-      }
-      // if the angle is greater than PI, the point is in the polygon
-      if(std::abs(angle) >= DICE_PI){
-        coordSet.insert(std::pair<int_t,int_t>(y,x));
-      }
-    }
-  }
-  return coordSet;
+void
+Polygon::rasterize(Pixel_Mask & mask,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
+  rasterize_spans(spans,mask);
 }
 
 Circle::Circle(const int_t centroid_x,
@@ -260,22 +569,43 @@ Circle::get_owned_pixels(Teuchos::RCP<Local_Shape_Function> shape_function,
   const int_t cx,
   const int_t cy,
   const scalar_t skin_factor)const{
-  TEUCHOS_TEST_FOR_EXCEPTION(shape_function!=Teuchos::null,std::runtime_error,"Error, circle deformation has not been implemented yet");
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
   std::set<std::pair<int_t,int_t> > coordSet;
+  for(size_t i=0;i<spans.size();++i)
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x)
+      coordSet.insert(coordSet.end(),std::pair<int_t,int_t>(spans[i].y,x));
+  return coordSet;
+}
 
-  scalar_t dx=0,dy=0;
-  // rip over the points in the extents of the circle to determine which onese are inside
+void
+Circle::get_owned_spans(std::vector<Pixel_Span> & spans,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(shape_function!=Teuchos::null,std::runtime_error,"Error, circle deformation has not been implemented yet");
   for(int_t y=min_y_;y<=max_y_;++y){
-    for(int_t x=min_x_;x<=max_x_;++x){
-      // x and y are the global coordinates of the point to test
-      dx = (x-centroid_x_)*(x-centroid_x_);
-      dy = (y-centroid_y_)*(y-centroid_y_);
-      if(dx + dy <= radius2_){
-        coordSet.insert(std::pair<int_t,int_t>(y,x));
-      }
-    }
+    const scalar_t dy2 = (y-centroid_y_)*(y-centroid_y_);
+    if(dy2 > radius2_) continue;
+    // half width of the row, corrected for round off in the square root
+    int_t half_width = (int_t)std::sqrt(radius2_ - dy2);
+    while((half_width+1)*(half_width+1) + dy2 <= radius2_) half_width++;
+    while(half_width>0 && half_width*half_width + dy2 > radius2_) half_width--;
+    Pixel_Span span = {y,centroid_x_-half_width,centroid_x_+half_width};
+    spans.push_back(span);
   }
-  return coordSet;
+}
+
+void
+Circle::rasterize(Pixel_Mask & mask,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
+  rasterize_spans(spans,mask);
 }
 
 Rectangle::Rectangle(const int_t centroid_x,
@@ -321,105 +651,53 @@ Rectangle::get_owned_pixels(Teuchos::RCP<Local_Shape_Function> shape_function,
   const int_t cx,
   const int_t cy,
   const scalar_t skin_factor)const{
-
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
   std::set<std::pair<int_t,int_t> > coordSet;
+  for(size_t i=0;i<spans.size();++i)
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x)
+      coordSet.insert(coordSet.end(),std::pair<int_t,int_t>(spans[i].y,x));
+  return coordSet;
+}
 
-  if(shape_function!=Teuchos::null){
-    int_t min_x = 0;
-    int_t min_y = 0;
-    int_t max_x = 0;
-    int_t max_y = 0;
-    scalar_t X=0.0,Y=0.0;
-    int_t new_x=0,new_y=0;
-    std::vector<int_t> vertex_coordinates_x(5,0.0);
-    std::vector<int_t> vertex_coordinates_y(5,0.0);
-    std::vector<int_t> verts_x(5,0.0);
-    std::vector<int_t> verts_y(5,0.0);
-    vertex_coordinates_x[0] = origin_x_;
-    vertex_coordinates_x[1] = origin_x_ + width_;
-    vertex_coordinates_x[2] = origin_x_ + width_;
-    vertex_coordinates_x[3] = origin_x_;
-    vertex_coordinates_x[4] = origin_x_;
-    vertex_coordinates_y[0] = origin_y_;
-    vertex_coordinates_y[1] = origin_y_;
-    vertex_coordinates_y[2] = origin_y_ + height_;
-    vertex_coordinates_y[3] = origin_y_ + height_;
-    vertex_coordinates_y[4] = origin_y_;
-
-    for(size_t i=0;i<vertex_coordinates_x.size();++i){
-      int_t x = vertex_coordinates_x[i];
-      int_t y = vertex_coordinates_y[i];
-      shape_function->map(x,y,cx,cy,X,Y);
-      // iterate over all the pixels in the reference blocking subset and compute the current position
-      new_x = (int_t)X;
-      if(X - (int_t)X >= 0.5) new_x++;
-      new_y = (int_t)Y;
-      if(Y - (int_t)Y >= 0.5) new_y++;
-      verts_x[i] = new_x;
-      verts_y[i] = new_y;
-    } // vertex loop
-    // compute the geometric centroid of the new vertices:
-    int_t centroid_x = 0;
-    int_t centroid_y = 0;
-    for(size_t i=0;i<verts_x.size()-1;++i){
-      centroid_x+=verts_x[i];
-      centroid_y+=verts_y[i];
-    }
-    centroid_x /= verts_x.size()-1==0.0?1.0:(verts_x.size()-1);
-    centroid_y /= verts_y.size()-1==0.0?1.0:(verts_y.size()-1);
-    // apply the skin factor
-    for(size_t i=0;i<verts_x.size();++i){
-      // add the skin to the new vertex (applied as a stretch in x and y):
-      new_x = skin_factor*(verts_x[i] - centroid_x) + centroid_x;
-      new_y = skin_factor*(verts_y[i] - centroid_y) + centroid_y;
-      verts_x[i] = new_x;
-      verts_y[i] = new_y;
-      if(i==0){
-        min_x = new_x;
-        max_x = new_x;
-        min_y = new_y;
-        max_y = new_y;
-      }
-      else{
-        if(new_x < min_x){min_x = new_x;}
-        if(new_x > max_x){max_x = new_x;}
-        if(new_y < min_y){min_y = new_y;}
-        if(new_y > max_y){max_y = new_y;}
-      }
-    } // vertex_loop
-
-    scalar_t dx1=0,dx2=0,dy1=0,dy2=0;
-    scalar_t angle=0;
-    // rip over the points in the extents of the polygon to determine which onese are inside
-    for(int_t y=min_y;y<=max_y;++y){
-      for(int_t x=min_x;x<=max_x;++x){
-        // x and y are the global coordinates of the point to test
-        angle=0.0;
-        for (int_t i=0;i<4;i++) {
-          // get the two end points of the polygon side and construct
-          // a vector from the point to each one:
-          dx1 = verts_x[i] - x;
-          dy1 = verts_y[i] - y;
-          dx2 = verts_x[i+1] - x;
-          dy2 = verts_y[i+1] - y;
-          angle += angle_2d(dx1,dy1,dx2,dy2);
-        }
-        // if the angle is greater than PI, the point is in the polygon
-        if(std::abs(angle) >= DICE_PI){
-          coordSet.insert(std::pair<int_t,int_t>(y,x));
-        }
-      }
-    }
-  } // has deformation
-  else{
-    // rip over the points in the extents of the circle to determine which onese are inside
-    for(int_t y=0;y<height_;++y){
-      for(int_t x=0;x<width_;++x){
-        coordSet.insert(std::pair<int_t,int_t>(origin_y_+y,origin_x_+x));
-      }
+void
+Rectangle::get_owned_spans(std::vector<Pixel_Span> & spans,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  if(shape_function==Teuchos::null){
+    for(int_t y=origin_y_;y<origin_y_+height_;++y){
+      Pixel_Span span = {y,origin_x_,origin_x_+width_-1};
+      spans.push_back(span);
     }
+    return;
   }
-  return coordSet;
+  std::vector<int_t> verts_x(5,0);
+  std::vector<int_t> verts_y(5,0);
+  verts_x[0] = origin_x_;
+  verts_x[1] = origin_x_ + width_;
+  verts_x[2] = origin_x_ + width_;
+  verts_x[3] = origin_x_;
+  verts_x[4] = origin_x_;
+  verts_y[0] = origin_y_;
+  verts_y[1] = origin_y_;
+  verts_y[2] = origin_y_ + height_;
+  verts_y[3] = origin_y_ + height_;
+  verts_y[4] = origin_y_;
+  deform_vertices(shape_function,cx,cy,skin_factor,verts_x,verts_y);
+  polygon_spans(verts_x,verts_y,spans);
+}
+
+void
+Rectangle::rasterize(Pixel_Mask & mask,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor)const{
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(spans,shape_function,cx,cy,skin_factor);
+  rasterize_spans(spans,mask);
 }
 
 }// End DICe Namespace
@@ -48,12 +48,188 @@
 #include <Teuchos_ArrayRCP.hpp>
 
 #include <set>
+#include <vector>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 namespace DICe {
 
 class Local_Shape_Function;
 
+/// \class DICe::Pixel_Mask
+/// \brief Bit-packed occupancy raster used to flag a collection of pixels (for example the pixels
+/// covered by a set of deformed shapes)
+///
+/// Each row of the mask is stored as 64 bit words so that testing a pixel is a shift and
+/// a bitwise and rather than a search through a set of coordinates. The extents of the mask
+/// grow to include whatever is rasterized into it and are retained when the mask is cleared
+/// so that the storage can be reused from one frame to the next.
+class DICE_LIB_DLL_EXPORT
+Pixel_Mask {
+public:
+  /// default constructor creates an empty mask with no extents
+  Pixel_Mask():
+    origin_x_(0),
+    origin_y_(0),
+    width_(0),
+    height_(0),
+    words_per_row_(0),
+    empty_(true){};
+
+  ~Pixel_Mask(){};
+
+  /// returns true if the pixel is flagged, pixels outside the extents of the mask are never flagged
+  /// \param x global x-coordinate of the pixel
+  /// \param y global y-coordinate of the pixel
+  bool operator()(const int_t x,
+    const int_t y)const{
+    const int_t ix = x - origin_x_;
+    const int_t iy = y - origin_y_;
+    if(ix<0||iy<0||ix>=width_||iy>=height_) return false;
+    return (bits_[iy*words_per_row_+(ix>>6)]>>(ix&63))&1;
+  }
+
+  /// \brief grow the extents of the mask (if necessary) so that they include the given box,
+  /// pixels that are already flagged are preserved
+  /// \param min_x global minimum x-coordinate of the box
+  /// \param min_y global minimum y-coordinate of the box
+  /// \param max_x global maximum x-coordinate of the box (inclusive)
+  /// \param max_y global maximum y-coordinate of the box (inclusive)
+  void expand(const int_t min_x,
+    const int_t min_y,
+    const int_t max_x,
+    const int_t max_y);
+
+  /// \brief flag a horizontal run of pixels, the portion of the run outside the extents is ignored
+  /// (call expand() first to make sure the mask is large enough)
+  /// \param y global y-coordinate of the row
+  /// \param x_begin global x-coordinate of the first pixel in the run
+  /// \param x_end global x-coordinate of the last pixel in the run (inclusive)
+  void set_span(const int_t y,
+    const int_t x_begin,
+    const int_t x_end);
+
+  /// unflag all pixels (the extents and storage are kept)
+  void clear(){
+    std::fill(bits_.begin(),bits_.end(),0);
+    empty_ = true;
+  }
+
+  /// returns true if no pixels have been flagged since the last clear
+  bool empty()const{
+    return empty_;
+  }
+
+  /// returns the global x-coordinate of the upper left corner of the mask
+  int_t origin_x()const{
+    return origin_x_;
+  }
+
+  /// returns the global y-coordinate of the upper left corner of the mask
+  int_t origin_y()const{
+    return origin_y_;
+  }
+
+  /// returns the width of the mask
+  int_t width()const{
+    return width_;
+  }
+
+  /// returns the height of the mask
+  int_t height()const{
+    return height_;
+  }
+
+  /// returns the number of flagged pixels
+  int_t num_flagged()const;
+
+private:
+  /// global x-coordinate of the upper left corner
+  int_t origin_x_;
+  /// global y-coordinate of the upper left corner
+  int_t origin_y_;
+  /// width of the mask in pixels
+  int_t width_;
+  /// height of the mask in pixels
+  int_t height_;
+  /// number of 64 bit words used to store each row
+  int_t words_per_row_;
+  /// true if nothing has been flagged since the last clear
+  bool empty_;
+  /// the bits, stored row by row
+  std::vector<uint64_t> bits_;
+};
+
+/// \brief A horizontal run of pixels in one row of an image
+struct DICE_LIB_DLL_EXPORT
+Pixel_Span {
+  /// global y-coordinate of the row
+  int_t y;
+  /// global x-coordinate of the first pixel in the run
+  int_t x_begin;
+  /// global x-coordinate of the last pixel in the run (inclusive)
+  int_t x_end;
+};
+
+/// \brief Sort the spans by row then by x and merge the ones that overlap or touch so
+/// that each pixel is covered by at most one span
+/// \param spans [in/out] the spans to sort and merge
+DICE_LIB_DLL_EXPORT
+void merge_pixel_spans(std::vector<Pixel_Span> & spans);
+
+/// \brief Returns the total number of pixels in a set of merged spans
+/// \param spans the spans (must be merged, see merge_pixel_spans())
+DICE_LIB_DLL_EXPORT
+int_t num_pixels_in_spans(const std::vector<Pixel_Span> & spans);
+
+/// \brief Returns true if the pixel is covered by one of the spans
+/// \param spans the spans (must be merged, see merge_pixel_spans())
+/// \param x global x-coordinate of the pixel
+/// \param y global y-coordinate of the pixel
+DICE_LIB_DLL_EXPORT
+bool spans_contain(const std::vector<Pixel_Span> & spans,
+  const int_t x,
+  const int_t y);
+
+/// \brief Scanline conversion of a closed polygon (first vertex repeated at the end) into spans.
+///
+/// The pixels owned are the same as those of the winding angle test used by
+/// Polygon::deactivate_pixels(). An edge table is used to find the runs of pixels strictly
+/// inside the polygon (non-zero winding rule) and only the pixels that sit exactly on an
+/// edge are checked with the angle test, so the cost grows with the perimeter rather than the area.
+/// \param verts_x x-coordinates of the vertices
+/// \param verts_y y-coordinates of the vertices
+/// \param spans [out] the spans are appended to this vector (sorted and merged)
+DICE_LIB_DLL_EXPORT
+void polygon_spans(const std::vector<int_t> & verts_x,
+  const std::vector<int_t> & verts_y,
+  std::vector<Pixel_Span> & spans);
+
+/// \brief Map a closed list of vertices (first vertex repeated at the end) to the deformed
+/// configuration and apply the skin factor as a stretch about the geometric centroid
+/// of the deformed vertices
+/// \param shape_function the deformation map
+/// \param cx x centroid of the map
+/// \param cy y centroid of the map
+/// \param skin_factor padding added to the outside of the shape to make it larger or smaller
+/// \param verts_x [in/out] x-coordinates of the vertices
+/// \param verts_y [in/out] y-coordinates of the vertices
+DICE_LIB_DLL_EXPORT
+void deform_vertices(Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t skin_factor,
+  std::vector<int_t> & verts_x,
+  std::vector<int_t> & verts_y);
+
+/// \brief Flag the pixels of a set of spans in a mask
+/// \param spans the spans to flag (sorted by row, see merge_pixel_spans())
+/// \param mask [out] the mask to rasterize into (it is expanded to include the spans)
+DICE_LIB_DLL_EXPORT
+void rasterize_spans(const std::vector<Pixel_Span> & spans,
+  Pixel_Mask & mask);
+
 /// \class DICe::Shape
 /// \brief Generic class for defining regions in an image
 ///
@@ -85,6 +261,36 @@ public:
     return nullSet;
   }
 
+  /// \brief Appends the pixels interior to this shape as sorted, non-overlapping runs of pixels.
+  /// Covers the same pixels as get_owned_pixels() without building a set
+  /// \param spans [out] the spans are appended to this vector
+  /// \param shape_function Optional mapping to the deformed shape, otherwise reference map is used
+  /// \param cx Optional x centroid of the map
+  /// \param cy Optional y centroid of the map
+  /// \param skin_factor Optional padding added to the outside of the shape to make it larger or smaller
+  virtual void get_owned_spans(std::vector<Pixel_Span> & spans,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const{
+    assert(false && "  DICe ERROR: Base class implementation of this method should not be called.");
+  }
+
+  /// \brief Flags all the pixels interior to this shape in the given mask.
+  /// Same as get_owned_pixels(), but the result is rasterized into a bit mask
+  /// \param mask [out] the mask to add this shape's pixels to (it is expanded to include the shape)
+  /// \param shape_function Optional mapping to the deformed shape, otherwise reference map is used
+  /// \param cx Optional x centroid of the map
+  /// \param cy Optional y centroid of the map
+  /// \param skin_factor Optional padding added to the outside of the shape to make it larger or smaller
+  virtual void rasterize(Pixel_Mask & mask,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const{
+    assert(false && "  DICe ERROR: Base class implementation of this method should not be called.");
+  }
+
   /// \brief Method used to turn pixels off that fall inside the shape.
   /// Mostly called in the construction of a conformal subset to turn off interior regions to the subset.
   /// \param pixel_flags [out] An array of bools true means the pixel is still active false means that
@@ -134,6 +340,20 @@ public:
     const int_t cy=0,
     const scalar_t skin_factor=1.0)const;
 
+  /// See base class documentation
+  virtual void get_owned_spans(std::vector<Pixel_Span> & spans,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
+  /// See base class documentation
+  virtual void rasterize(Pixel_Mask & mask,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
   /// See base class documentation
   virtual void deactivate_pixels(const int_t size,
     bool * pixel_flags,
@@ -229,6 +449,20 @@ public:
     const int_t cy=0,
     const scalar_t skin_factor=1.0)const;
 
+  /// See base class documentation
+  virtual void get_owned_spans(std::vector<Pixel_Span> & spans,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
+  /// See base class documentation
+  virtual void rasterize(Pixel_Mask & mask,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
   /// See base class documentation
   virtual void deactivate_pixels(const int_t size,
     bool * pixel_flags,
@@ -279,6 +513,20 @@ public:
     const int_t cy=0,
     const scalar_t skin_factor=1.0)const;
 
+  /// See base class documentation
+  virtual void get_owned_spans(std::vector<Pixel_Span> & spans,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
+  /// See base class documentation
+  virtual void rasterize(Pixel_Mask & mask,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t skin_factor=1.0)const;
+
   /// See base class documentation
   virtual void deactivate_pixels(const int_t size,
     bool * pixel_flags,
@@ -303,6 +551,26 @@ private:
 /// A vector that stores a collection of pointers to shapes, used as a way to associate shapes into a larger object.
 typedef std::vector<Teuchos::RCP<Shape> > multi_shape;
 
+/// \brief Gather the pixels owned by a collection of shapes as merged spans
+/// \param shapes the shapes (the union of their pixels is returned)
+/// \param spans [out] the merged spans (any existing spans are removed)
+DICE_LIB_DLL_EXPORT
+void get_owned_spans(const multi_shape & shapes,
+  std::vector<Pixel_Span> & spans);
+
+/// \brief Turn off the flags of the pixels that are covered by the spans
+/// \param spans the spans (must be merged, see merge_pixel_spans())
+/// \param size the number of pixels
+/// \param pixel_flags [out] the flags of the covered pixels are set to false
+/// \param x_coords the x-coordinates of the pixels
+/// \param y_coords the y-coordinates of the pixels
+DICE_LIB_DLL_EXPORT
+void deactivate_pixels_in_spans(const std::vector<Pixel_Span> & spans,
+  const int_t size,
+  bool * pixel_flags,
+  const int_t * x_coords,
+  const int_t * y_coords);
+
 /// \class DICe::Conformal_Area_Def
 /// \brief A simple container for geometry information defining the boundary of a DICe::Subset.
 ///
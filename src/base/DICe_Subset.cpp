@@ -58,11 +58,7 @@ Subset::is_obstructed_pixel(const scalar_t & coord_x,
   int_t c_y = (int_t)coord_y;
   if(coord_y - (int_t)coord_y >= 0.5) c_y++;
   // now check if c_x and c_y are obstructed
-  // Note the x and y coordinates are switched because that is how they live in the set
-  // this was done for performance in loops over y then x
-  std::pair<int_t,int_t> point(c_y,c_x);
-  const bool obstructed = obstructed_coords_.find(point)!=obstructed_coords_.end();
-  return obstructed;
+  return obstructed_pixels_(c_x,c_y);
 }
 
 std::set<std::pair<int_t,int_t> >
@@ -80,6 +76,18 @@ Subset::deformed_shapes(Teuchos::RCP<Local_Shape_Function> shape_function,
   return coords;
 }
 
+void
+Subset::deformed_shapes(Pixel_Mask & mask,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t cx,
+  const int_t cy,
+  const scalar_t & skin_factor){
+  if(!is_conformal_) return;
+  for(size_t i=0;i<conformal_subset_def_.boundary()->size();++i){
+    (*conformal_subset_def_.boundary())[i]->rasterize(mask,shape_function,cx,cy,skin_factor);
+  }
+}
+
 void
 Subset::turn_off_obstructed_pixels(Teuchos::RCP<Local_Shape_Function> shape_function){
   assert(shape_function!=Teuchos::null);
@@ -101,8 +109,7 @@ Subset::turn_off_obstructed_pixels(Teuchos::RCP<Local_Shape_Function> shape_func
     if(has_blocks){
       px = ((int_t)(X + 0.5) == (int_t)(X)) ? (int_t)(X) : (int_t)(X) + 1;
       py = ((int_t)(Y + 0.5) == (int_t)(Y)) ? (int_t)(Y) : (int_t)(Y) + 1;
-      if(pixels_blocked_by_other_subsets_.find(std::pair<int_t,int_t>(py,px))
-          !=pixels_blocked_by_other_subsets_.end()){
+      if(pixels_blocked_by_other_subsets_(px,py)){
         is_deactivated_this_step(i) = true;
       }
     }
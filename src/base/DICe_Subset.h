@@ -106,6 +106,10 @@ public:
   /// virtual destructor
   virtual ~Subset(){};
 
+  /// returns a deep copy of the subset (the pixel coordinates are shared since they never change)
+  /// used as scratch storage when several deformed states of the same subset are evaluated at once
+  Teuchos::RCP<Subset> clone()const;
+
   /// returns the number of pixels in the subset
   int_t num_pixels()const{
     return num_pixels_;
@@ -275,8 +279,8 @@ public:
   bool is_obstructed_pixel(const scalar_t & coord_x,
     const scalar_t & coord_y)const;
 
-  /// \brief EXPERIMENTAL Returns a pointer to the set of pixels currently obstructed by another subset
-  std::set<std::pair<int_t,int_t> > * pixels_blocked_by_other_subsets(){
+  /// \brief EXPERIMENTAL Returns a pointer to the mask of pixels currently obstructed by another subset
+  Pixel_Mask * pixels_blocked_by_other_subsets(){
     return & pixels_blocked_by_other_subsets_;
   }
 
@@ -286,6 +290,18 @@ public:
     const int_t cy=0,
     const scalar_t & skin_factor=1.0);
 
+  /// \brief EXPERIMENTAL Rasterize the deformed subset boundary into a pixel mask
+  /// \param mask [out] the mask to add the pixels to (pixels already flagged are kept)
+  /// \param shape_function contains the deformation map (optional)
+  /// \param cx x centroid of the map
+  /// \param cy y centroid of the map
+  /// \param skin_factor padding added to the outside of the shapes to make them larger or smaller
+  void deformed_shapes(Pixel_Mask & mask,
+    Teuchos::RCP<Local_Shape_Function> shape_function=Teuchos::null,
+    const int_t cx=0,
+    const int_t cy=0,
+    const scalar_t & skin_factor=1.0);
+
 #if DICE_KOKKOS
   /// x coordinate view accessor
   pixel_coord_dual_view_1d x()const{
@@ -343,14 +359,10 @@ private:
   /// initial x position of the pixels in the reference image
   Teuchos::ArrayRCP<int_t> y_;
 #endif
-  /// \brief EXPERIMENTAL Holds the obstruction coordinates if they exist.
-  /// NOTE: The coordinates are switched for this (i.e. (Y,X)) so that
-  /// the loops over y then x will be more efficient
-  std::set<std::pair<int_t,int_t> > obstructed_coords_;
-  /// \brief EXPERIMENTAL Holds the pixels blocked by other subsets if they exist.
-  /// NOTE: The coordinates are switched for this (i.e. (Y,X)) so that
-  /// the loops over y then x will be more efficient
-  std::set<std::pair<int_t,int_t> > pixels_blocked_by_other_subsets_;
+  /// \brief EXPERIMENTAL Mask of the obstructed pixels if they exist
+  Pixel_Mask obstructed_pixels_;
+  /// \brief EXPERIMENTAL Mask of the pixels blocked by other subsets if they exist
+  Pixel_Mask pixels_blocked_by_other_subsets_;
   /// centroid location x
   int_t cx_; // assumed to be the middle of the pixel
   /// centroid location y
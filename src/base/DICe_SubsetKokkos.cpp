@@ -151,27 +151,23 @@ Subset::Subset(const int_t cx,
   TEUCHOS_TEST_FOR_EXCEPTION(cx<0,std::invalid_argument,"Error, cannot have negative coordinates for cx");
   TEUCHOS_TEST_FOR_EXCEPTION(cy<0,std::invalid_argument,"Error, cannot have negative coordinates for cy");
   assert(subset_def.has_boundary());
-  std::set<std::pair<int_t,int_t> > coords;
-  for(size_t i=0;i<subset_def.boundary()->size();++i){
-    std::set<std::pair<int_t,int_t> > shapeCoords = (*subset_def.boundary())[i]->get_owned_pixels();
-    coords.insert(shapeCoords.begin(),shapeCoords.end());
-  }
+  // the union of the boundary shapes as sorted runs of pixels (ordered by y then x)
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(*subset_def.boundary(),spans);
   // warn the user if the centroid is outside the subset
-  std::pair<int_t,int_t> centroid_pair = std::pair<int_t,int_t>(cy_,cx_);
-  if(coords.find(centroid_pair)==coords.end())
+  if(!spans_contain(spans,cx_,cy_))
     std::cout << "*** Warning: centroid " << cx_ << " " << cy_ << " is outside the subset boundary" << std::endl;
-  // at this point all the coordinate pairs are in the set
-  num_pixels_ = coords.size();
+  num_pixels_ = num_pixels_in_spans(spans);
   // resize the storage arrays now that the num_pixels is known
   x_ = pixel_coord_dual_view_1d("x",num_pixels_);
   y_ = pixel_coord_dual_view_1d("y",num_pixels_);
   int_t index = 0;
-  // NOTE: the pairs are (y,x) not (x,y) so that the ordering is correct in the set
-  typename std::set<std::pair<int_t,int_t> >::iterator set_it = coords.begin();
-  for( ; set_it!=coords.end();++set_it){
-    x_.h_view(index) = set_it->second;
-    y_.h_view(index) = set_it->first;
-    index++;
+  for(size_t i=0;i<spans.size();++i){
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x){
+      x_.h_view(index) = x;
+      y_.h_view(index) = spans[i].y;
+      index++;
+    }
   }
   x_.modify<host_space>();
   y_.modify<host_space>();
@@ -189,21 +185,53 @@ Subset::Subset(const int_t cx,
   reset_is_deactivated_this_step();
   // now set the inactive bit for the second set of multishapes if they exist.
   if(subset_def.has_excluded_area()){
-    for(size_t i=0;i<subset_def.excluded_area()->size();++i){
-      (*subset_def.excluded_area())[i]->deactivate_pixels(num_pixels_,is_active_.h_view.ptr_on_device(),
-        x_.h_view.ptr_on_device(),y_.h_view.ptr_on_device());
-    }
+    std::vector<Pixel_Span> excluded_spans;
+    get_owned_spans(*subset_def.excluded_area(),excluded_spans);
+    deactivate_pixels_in_spans(excluded_spans,num_pixels_,is_active_.h_view.ptr_on_device(),
+      x_.h_view.ptr_on_device(),y_.h_view.ptr_on_device());
   }
   is_active_.modify<host_space>();
   is_active_.sync<device_space>();
   if(subset_def.has_obstructed_area()){
     for(size_t i=0;i<subset_def.obstructed_area()->size();++i){
-      std::set<std::pair<int_t,int_t> > obstructedArea = (*subset_def.obstructed_area())[i]->get_owned_pixels();
-      obstructed_coords_.insert(obstructedArea.begin(),obstructedArea.end());
+      (*subset_def.obstructed_area())[i]->rasterize(obstructed_pixels_);
     }
   }
 }
 
+Teuchos::RCP<Subset>
+Subset::clone()const{
+  // the default copy shares the pixel views so they are replaced with copies
+  Teuchos::RCP<Subset> copy = Teuchos::rcp(new Subset(*this));
+  copy->ref_intensities_ = intensity_dual_view_1d("ref_intensities",num_pixels_);
+  copy->def_intensities_ = intensity_dual_view_1d("def_intensities",num_pixels_);
+  copy->grad_x_ = scalar_dual_view_1d("grad_x",num_pixels_);
+  copy->grad_y_ = scalar_dual_view_1d("grad_y",num_pixels_);
+  copy->is_active_ = bool_dual_view_1d("is_active",num_pixels_);
+  copy->is_deactivated_this_step_ = bool_dual_view_1d("is_deactivated_this_step",num_pixels_);
+  for(int_t i=0;i<num_pixels_;++i){
+    copy->ref_intensities_.h_view(i) = ref_intensities_.h_view(i);
+    copy->def_intensities_.h_view(i) = def_intensities_.h_view(i);
+    copy->grad_x_.h_view(i) = grad_x_.h_view(i);
+    copy->grad_y_.h_view(i) = grad_y_.h_view(i);
+    copy->is_active_.h_view(i) = is_active_.h_view(i);
+    copy->is_deactivated_this_step_.h_view(i) = is_deactivated_this_step_.h_view(i);
+  }
+  copy->ref_intensities_.modify<host_space>();
+  copy->ref_intensities_.sync<device_space>();
+  copy->def_intensities_.modify<host_space>();
+  copy->def_intensities_.sync<device_space>();
+  copy->grad_x_.modify<host_space>();
+  copy->grad_x_.sync<device_space>();
+  copy->grad_y_.modify<host_space>();
+  copy->grad_y_.sync<device_space>();
+  copy->is_active_.modify<host_space>();
+  copy->is_active_.sync<device_space>();
+  copy->is_deactivated_this_step_.modify<host_space>();
+  copy->is_deactivated_this_step_.sync<device_space>();
+  return copy;
+}
+
 const int_t&
 Subset::x(const int_t pixel_index)const{
   return x_.h_view(pixel_index);
@@ -41,6 +41,7 @@
 
 #include <DICe_Subset.h>
 #include <DICe_ImageUtils.h>
+#include <DICe_Profiler.h>
 
 #include <cassert>
 
@@ -119,26 +120,22 @@ Subset::Subset(const int_t cx,
   sub_image_id_(0)
 {
   assert(subset_def.has_boundary());
-  std::set<std::pair<int_t,int_t> > coords;
-  for(size_t i=0;i<subset_def.boundary()->size();++i){
-    std::set<std::pair<int_t,int_t> > shapeCoords = (*subset_def.boundary())[i]->get_owned_pixels();
-    coords.insert(shapeCoords.begin(),shapeCoords.end());
-  }
-  // at this point all the coordinate pairs are in the set
-  num_pixels_ = coords.size();
+  // the union of the boundary shapes as sorted runs of pixels (ordered by y then x)
+  std::vector<Pixel_Span> spans;
+  get_owned_spans(*subset_def.boundary(),spans);
+  num_pixels_ = num_pixels_in_spans(spans);
   x_ = Teuchos::ArrayRCP<int_t>(num_pixels_,0);
   y_ = Teuchos::ArrayRCP<int_t>(num_pixels_,0);
   int_t index = 0;
-  // NOTE: the pairs are (y,x) not (x,y) so that the ordering is correct in the set
-  std::set<std::pair<int_t,int_t> >::iterator set_it = coords.begin();
-  for( ; set_it!=coords.end();++set_it){
-    x_[index] = set_it->second;
-    y_[index] = set_it->first;
-    index++;
+  for(size_t i=0;i<spans.size();++i){
+    for(int_t x=spans[i].x_begin;x<=spans[i].x_end;++x){
+      x_[index] = x;
+      y_[index] = spans[i].y;
+      index++;
+    }
   }
   // warn the user if the centroid is outside the subset
-  std::pair<int_t,int_t> centroid_pair = std::pair<int_t,int_t>(cy_,cx_);
-  if(coords.find(centroid_pair)==coords.end())
+  if(!spans_contain(spans,cx_,cy_))
     std::cout << "*** Warning: centroid " << cx_ << " " << cy_ << " is outside the subset boundary" << std::endl;
   ref_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
   def_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
@@ -151,18 +148,38 @@ Subset::Subset(const int_t cx,
 
   // now set the inactive bit for the second set of multishapes if they exist.
   if(subset_def.has_excluded_area()){
-    for(size_t i=0;i<subset_def.excluded_area()->size();++i){
-      (*subset_def.excluded_area())[i]->deactivate_pixels(num_pixels_,is_active_.getRawPtr(),x_.getRawPtr(),y_.getRawPtr());
-    }
+    std::vector<Pixel_Span> excluded_spans;
+    get_owned_spans(*subset_def.excluded_area(),excluded_spans);
+    deactivate_pixels_in_spans(excluded_spans,num_pixels_,is_active_.getRawPtr(),x_.getRawPtr(),y_.getRawPtr());
   }
   if(subset_def.has_obstructed_area()){
     for(size_t i=0;i<subset_def.obstructed_area()->size();++i){
-      std::set<std::pair<int_t,int_t> > obstructedArea = (*subset_def.obstructed_area())[i]->get_owned_pixels();
-      obstructed_coords_.insert(obstructedArea.begin(),obstructedArea.end());
+      (*subset_def.obstructed_area())[i]->rasterize(obstructed_pixels_);
     }
   }
 }
 
+Teuchos::RCP<Subset>
+Subset::clone()const{
+  // the default copy shares the pixel containers so they are replaced with copies
+  Teuchos::RCP<Subset> copy = Teuchos::rcp(new Subset(*this));
+  copy->ref_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
+  copy->def_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
+  copy->grad_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  copy->grad_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  copy->is_active_ = Teuchos::ArrayRCP<bool>(num_pixels_,true);
+  copy->is_deactivated_this_step_ = Teuchos::ArrayRCP<bool>(num_pixels_,false);
+  for(int_t i=0;i<num_pixels_;++i){
+    copy->ref_intensities_[i] = ref_intensities_[i];
+    copy->def_intensities_[i] = def_intensities_[i];
+    copy->grad_x_[i] = grad_x_[i];
+    copy->grad_y_[i] = grad_y_[i];
+    copy->is_active_[i] = is_active_[i];
+    copy->is_deactivated_this_step_[i] = is_deactivated_this_step_[i];
+  }
+  return copy;
+}
+
 const int_t&
 Subset::x(const int_t pixel_index)const{
   return x_[pixel_index];
@@ -301,6 +318,8 @@ Subset::initialize(Teuchos::RCP<Image> image,
   const Subset_View_Target target,
   Teuchos::RCP<Local_Shape_Function> shape_function,
   const Interpolation_Method interp){
+  DICE_PROFILE_SCOPE(PROFILE_INTERPOLATION);
+  DICE_PROFILE_COUNT(PROFILE_INTERPOLATED_PIXELS,num_pixels_);
 
   // coordinates for points x and y are always in global coordinates
   // if the input image is a sub-image i.e. it has offsets, then these need to be taken into account
@@ -335,8 +354,7 @@ Subset::initialize(Teuchos::RCP<Image> image,
         continue;
       }
       if(has_blocks){
-        if(pixels_blocked_by_other_subsets_.find(std::pair<int_t,int_t>(py,px))
-            !=pixels_blocked_by_other_subsets_.end()){
+        if(pixels_blocked_by_other_subsets_(px,py)){
           is_deactivated_this_step(i) = true;
           continue;
         }
@@ -0,0 +1,679 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_BinaryOutput.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace DICe {
+
+namespace {
+
+/// magic string at the start of a binary results file
+const char binary_output_magic[8] = {'D','I','C','E','B','I','N','1'};
+/// magic string at the end of a binary results file that has a frame index
+const char binary_output_index_magic[8] = {'D','I','C','E','I','D','X','1'};
+/// marker at the start of each block
+const uint32_t binary_output_block_marker = 0x4B4C4244;
+/// marker at the start of the frame index
+const uint32_t binary_output_index_marker = 0x58444944;
+/// version of the file layout
+const uint32_t binary_output_version = 1;
+/// target size of a block in bytes when the number of frames per block is not specified
+const size_t binary_output_block_bytes = 4*1024*1024;
+
+/// xor consecutive frames of a column and run length encode the zero bytes
+/// The encoded stream is a set of tokens: a control byte c < 128 is followed by c+1
+/// literal bytes, a control byte c >= 128 stands for c-127 zero bytes
+void encode_column(const unsigned char * raw,
+  const size_t num_frames,
+  const size_t frame_bytes,
+  std::vector<unsigned char> & encoded){
+  const size_t num_bytes = num_frames*frame_bytes;
+  std::vector<unsigned char> delta(num_bytes);
+  for(size_t i=0;i<num_bytes;++i)
+    delta[i] = i<frame_bytes ? raw[i] : raw[i]^raw[i-frame_bytes];
+  encoded.clear();
+  encoded.reserve(num_bytes/2);
+  size_t i = 0;
+  while(i<num_bytes){
+    size_t run = 0;
+    while(i+run<num_bytes&&delta[i+run]==0&&run<128) run++;
+    if(run>=2||(run==1&&i+1==num_bytes)){
+      encoded.push_back(static_cast<unsigned char>(127+run));
+      i += run;
+      continue;
+    }
+    // literal run up to the next pair of zero bytes
+    size_t lit = 0;
+    while(i+lit<num_bytes&&lit<128){
+      if(delta[i+lit]==0&&i+lit+1<num_bytes&&delta[i+lit+1]==0) break;
+      lit++;
+    }
+    encoded.push_back(static_cast<unsigned char>(lit-1));
+    encoded.insert(encoded.end(),delta.begin()+i,delta.begin()+i+lit);
+    i += lit;
+  }
+}
+
+/// inverse of encode_column
+void decode_column(const std::vector<unsigned char> & encoded,
+  const size_t num_frames,
+  const size_t frame_bytes,
+  unsigned char * raw){
+  const size_t num_bytes = num_frames*frame_bytes;
+  size_t pos = 0;
+  size_t i = 0;
+  while(i<encoded.size()){
+    const unsigned char c = encoded[i++];
+    if(c<128){
+      const size_t lit = c + 1;
+      TEUCHOS_TEST_FOR_EXCEPTION(pos+lit>num_bytes||i+lit>encoded.size(),std::runtime_error,
+        "Error, corrupt column in binary output file");
+      std::memcpy(raw+pos,&encoded[i],lit);
+      i += lit;
+      pos += lit;
+    }
+    else{
+      const size_t run = c - 127;
+      TEUCHOS_TEST_FOR_EXCEPTION(pos+run>num_bytes,std::runtime_error,
+        "Error, corrupt column in binary output file");
+      std::memset(raw+pos,0,run);
+      pos += run;
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(pos!=num_bytes,std::runtime_error,
+    "Error, corrupt column in binary output file");
+  for(size_t j=frame_bytes;j<num_bytes;++j)
+    raw[j] ^= raw[j-frame_bytes];
+}
+
+/// append a string to a header buffer (length followed by the characters)
+void pack_string(std::vector<char> & buffer,
+  const std::string & str){
+  const uint64_t len = str.size();
+  const char * len_ptr = reinterpret_cast<const char *>(&len);
+  buffer.insert(buffer.end(),len_ptr,len_ptr+sizeof(uint64_t));
+  buffer.insert(buffer.end(),str.begin(),str.end());
+}
+
+/// append a plain value to a header buffer
+template <typename T>
+void pack_value(std::vector<char> & buffer,
+  const T & value){
+  const char * ptr = reinterpret_cast<const char *>(&value);
+  buffer.insert(buffer.end(),ptr,ptr+sizeof(T));
+}
+
+/// read a plain value from a stream
+template <typename T>
+T read_value(std::ifstream & file){
+  T value;
+  file.read(reinterpret_cast<char *>(&value),sizeof(T));
+  TEUCHOS_TEST_FOR_EXCEPTION(!file.good(),std::runtime_error,
+    "Error, unexpected end of binary output file");
+  return value;
+}
+
+/// read a string from a stream
+std::string read_string(std::ifstream & file){
+  const uint64_t len = read_value<uint64_t>(file);
+  std::string str(len,' ');
+  if(len>0)
+    file.read(&str[0],len);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file.good(),std::runtime_error,
+    "Error, unexpected end of binary output file");
+  return str;
+}
+
+/// append the zero padded number used in the text file names
+void append_padded_id(std::stringstream & name,
+  const int_t id,
+  const int_t total_digits){
+  int_t num_digits = 0;
+  int_t decrement = id;
+  if(id==0) num_digits = 1;
+  else
+    while (decrement){decrement /= 10; num_digits++;}
+  for(int_t i=0;i<total_digits-num_digits;++i)
+    name << "0";
+  name << id;
+}
+
+/// write the column labels the same way Output_Spec::write_header does
+void write_text_header(std::FILE * file,
+  const Binary_Output_Info & info,
+  const std::string & row_id){
+  if(!info.omit_row_id)
+    fprintf(file,"%s%s",row_id.c_str(),info.delimiter.c_str());
+  for(size_t i=0;i<info.field_names.size();++i){
+    if(i==0)
+      fprintf(file,"%s",info.field_names[i].c_str());
+    else
+      fprintf(file,"%s%s",info.delimiter.c_str(),info.field_names[i].c_str());
+  }
+  fprintf(file,"\n");
+}
+
+/// write one row the same way Output_Spec::write_frame does
+void write_text_row(std::FILE * file,
+  const Binary_Output_Info & info,
+  const int_t row_index,
+  const std::vector<scalar_t> & values,
+  const int_t row){
+  if(!info.omit_row_id)
+    fprintf(file,"%i%s",row_index,info.delimiter.c_str());
+  const int_t num_rows = info.row_ids.size();
+  for(size_t i=0;i<info.field_names.size();++i){
+    const scalar_t value = values[i*num_rows+row];
+    if(i==0)
+      fprintf(file,"%4.4E",value);
+    else
+      fprintf(file,"%s%4.4E",info.delimiter.c_str(),value);
+  }
+  fprintf(file,"\n");
+}
+
+/// file name suffix used for parallel runs
+std::string proc_suffix(const Binary_Output_Info & info){
+  std::stringstream suffix;
+  if(info.proc_size>1)
+    suffix << "." << info.proc_size << "." << info.proc_rank;
+  return suffix.str();
+}
+
+} // end anonymous namespace
+
+Binary_Output_Writer::Binary_Output_Writer(const std::string & file_name,
+  const Binary_Output_Info & info,
+  const bool compress,
+  const int_t frames_per_block):
+  file_name_(file_name),
+  info_(info),
+  compress_(compress),
+  frames_per_block_(frames_per_block),
+  file_(NULL),
+  num_bytes_written_(0),
+  back_pending_(false),
+  shutdown_(false),
+  write_error_(false){
+  TEUCHOS_TEST_FOR_EXCEPTION(info_.field_names.empty(),std::runtime_error,
+    "Error, binary output requires at least one field");
+  TEUCHOS_TEST_FOR_EXCEPTION(frames_per_block_<0,std::runtime_error,
+    "Error, invalid number of frames per block " << frames_per_block_);
+  const size_t frame_bytes = std::max((size_t)1,num_rows()*num_fields()*sizeof(scalar_t));
+  if(frames_per_block_==0)
+    frames_per_block_ = std::max((size_t)1,binary_output_block_bytes/frame_bytes);
+  DEBUG_MSG("Binary_Output_Writer::Binary_Output_Writer(): file " << file_name_ << " frames per block " << frames_per_block_
+    << " compression " << compress_);
+  const size_t block_size = frames_per_block_*num_rows()*num_fields();
+  front_.values.resize(block_size,0.0);
+  back_.values.resize(block_size,0.0);
+  front_.frame_ids.reserve(frames_per_block_);
+  back_.frame_ids.reserve(frames_per_block_);
+
+  file_ = fopen(file_name_.c_str(),"wb"); // overwrite the file if it exists
+  TEUCHOS_TEST_FOR_EXCEPTION(file_==NULL,std::runtime_error,
+    "Error, could not open binary output file " << file_name_);
+  uint32_t flags = 0;
+  if(info_.separate_files_per_subset) flags |= 1;
+  if(info_.separate_header_file) flags |= 2;
+  if(info_.omit_row_id) flags |= 4;
+  std::vector<char> header(binary_output_magic,binary_output_magic+8);
+  pack_value(header,binary_output_version);
+  pack_value(header,(uint32_t)sizeof(scalar_t));
+  pack_value(header,(uint32_t)compress_);
+  pack_value(header,flags);
+  pack_value(header,(int32_t)info_.frame_digits);
+  pack_value(header,(int32_t)info_.subset_digits);
+  pack_value(header,(int32_t)info_.proc_size);
+  pack_value(header,(int32_t)info_.proc_rank);
+  pack_string(header,info_.delimiter);
+  pack_string(header,info_.prefix);
+  pack_string(header,info_.run_info);
+  pack_value(header,(uint32_t)num_fields());
+  for(int_t i=0;i<num_fields();++i)
+    pack_string(header,info_.field_names[i]);
+  pack_value(header,(uint32_t)num_rows());
+  for(int_t i=0;i<num_rows();++i)
+    pack_value(header,(int32_t)info_.row_ids[i]);
+  write_bytes(&header[0],header.size());
+
+  writer_ = std::thread(&Binary_Output_Writer::writer_loop,this);
+}
+
+Binary_Output_Writer::~Binary_Output_Writer(){
+  try{
+    close();
+  }
+  catch(std::exception & e){
+    std::cout << "Error closing binary output file " << file_name_ << ": " << e.what() << std::endl;
+  }
+}
+
+void
+Binary_Output_Writer::write_bytes(const void * data,
+  const size_t num_bytes){
+  if(num_bytes==0) return;
+  if(fwrite(data,1,num_bytes,file_)!=num_bytes)
+    write_error_ = true;
+  num_bytes_written_ += num_bytes;
+}
+
+void
+Binary_Output_Writer::write_frame(const int_t frame_id,
+  const std::vector<scalar_t> & values){
+  TEUCHOS_TEST_FOR_EXCEPTION(file_==NULL,std::runtime_error,
+    "Error, binary output file " << file_name_ << " has already been closed");
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)values.size()!=num_rows()*num_fields(),std::runtime_error,
+    "Error, wrong number of values for binary output frame: " << values.size() << " should be " << num_rows()*num_fields());
+  const int_t slot = front_.frame_ids.size();
+  const int_t rows = num_rows();
+  for(int_t field=0;field<num_fields();++field)
+    std::copy(values.begin()+field*rows,values.begin()+(field+1)*rows,
+      front_.values.begin()+(field*frames_per_block_+slot)*rows);
+  front_.frame_ids.push_back(frame_id);
+  if((int_t)front_.frame_ids.size()==frames_per_block_)
+    submit_block();
+}
+
+void
+Binary_Output_Writer::submit_block(){
+  std::unique_lock<std::mutex> lock(mutex_);
+  // wait for the writer thread to finish the previous block
+  cond_.wait(lock,[this]{return !back_pending_;});
+  TEUCHOS_TEST_FOR_EXCEPTION(write_error_,std::runtime_error,
+    "Error, failed writing to binary output file " << file_name_);
+  std::swap(front_,back_);
+  back_pending_ = true;
+  front_.frame_ids.clear();
+  cond_.notify_all();
+}
+
+void
+Binary_Output_Writer::writer_loop(){
+  std::unique_lock<std::mutex> lock(mutex_);
+  while(true){
+    cond_.wait(lock,[this]{return back_pending_||shutdown_;});
+    if(!back_pending_) break;
+    // the caller does not touch the back block while it is pending so the lock can be released
+    lock.unlock();
+    write_block(back_);
+    lock.lock();
+    back_pending_ = false;
+    cond_.notify_all();
+  }
+}
+
+void
+Binary_Output_Writer::write_block(const Block & block){
+  const int_t num_frames = block.frame_ids.size();
+  const int_t rows = num_rows();
+  const uint64_t block_offset = num_bytes_written_;
+  for(int_t i=0;i<num_frames;++i){
+    index_frame_ids_.push_back(block.frame_ids[i]);
+    index_offsets_.push_back(block_offset);
+    index_slots_.push_back(i);
+  }
+  write_bytes(&binary_output_block_marker,sizeof(uint32_t));
+  const uint32_t n = num_frames;
+  write_bytes(&n,sizeof(uint32_t));
+  std::vector<int32_t> ids(block.frame_ids.begin(),block.frame_ids.end());
+  write_bytes(&ids[0],ids.size()*sizeof(int32_t));
+  std::vector<unsigned char> encoded;
+  for(int_t field=0;field<num_fields();++field){
+    const scalar_t * column = block.values.data() + field*frames_per_block_*rows;
+    if(compress_){
+      encode_column(reinterpret_cast<const unsigned char *>(column),num_frames,rows*sizeof(scalar_t),encoded);
+      const uint64_t num_bytes = encoded.size();
+      write_bytes(&num_bytes,sizeof(uint64_t));
+      if(num_bytes>0)
+        write_bytes(&encoded[0],encoded.size());
+    }
+    else{
+      const uint64_t num_bytes = num_frames*rows*sizeof(scalar_t);
+      write_bytes(&num_bytes,sizeof(uint64_t));
+      write_bytes(column,num_bytes);
+    }
+  }
+  if(fflush(file_)!=0)
+    write_error_ = true;
+}
+
+void
+Binary_Output_Writer::close(){
+  if(file_==NULL) return;
+  if(!front_.frame_ids.empty())
+    submit_block();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock,[this]{return !back_pending_;});
+    shutdown_ = true;
+    cond_.notify_all();
+  }
+  writer_.join();
+  // the writer thread is done so the index can be written from here
+  const uint64_t index_offset = num_bytes_written_;
+  write_bytes(&binary_output_index_marker,sizeof(uint32_t));
+  const uint64_t num_frames = index_frame_ids_.size();
+  write_bytes(&num_frames,sizeof(uint64_t));
+  for(size_t i=0;i<index_frame_ids_.size();++i){
+    const int32_t id = index_frame_ids_[i];
+    const int32_t slot = index_slots_[i];
+    write_bytes(&id,sizeof(int32_t));
+    write_bytes(&index_offsets_[i],sizeof(uint64_t));
+    write_bytes(&slot,sizeof(int32_t));
+  }
+  write_bytes(&index_offset,sizeof(uint64_t));
+  write_bytes(binary_output_index_magic,8);
+  fclose(file_);
+  file_ = NULL;
+  DEBUG_MSG("Binary_Output_Writer::close(): wrote " << num_frames << " frames to " << file_name_);
+  TEUCHOS_TEST_FOR_EXCEPTION(write_error_,std::runtime_error,
+    "Error, failed writing to binary output file " << file_name_);
+}
+
+Binary_Output_Reader::Binary_Output_Reader(const std::string & file_name):
+  compress_(false),
+  value_size_(0),
+  cached_offset_(0),
+  cached_num_frames_(0){
+  file_.open(file_name.c_str(),std::ios::in|std::ios::binary);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file_.is_open(),std::runtime_error,
+    "Error, could not open binary output file " << file_name);
+  char magic[8];
+  file_.read(magic,8);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file_.good()||std::memcmp(magic,binary_output_magic,8)!=0,std::runtime_error,
+    "Error, " << file_name << " is not a DICe binary output file");
+  const uint32_t version = read_value<uint32_t>(file_);
+  TEUCHOS_TEST_FOR_EXCEPTION(version!=binary_output_version,std::runtime_error,
+    "Error, unsupported binary output file version " << version);
+  value_size_ = read_value<uint32_t>(file_);
+  TEUCHOS_TEST_FOR_EXCEPTION(value_size_!=sizeof(float)&&value_size_!=sizeof(double),std::runtime_error,
+    "Error, invalid value size in binary output file " << value_size_);
+  compress_ = read_value<uint32_t>(file_)!=0;
+  const uint32_t flags = read_value<uint32_t>(file_);
+  info_.separate_files_per_subset = (flags & 1)!=0;
+  info_.separate_header_file = (flags & 2)!=0;
+  info_.omit_row_id = (flags & 4)!=0;
+  info_.frame_digits = read_value<int32_t>(file_);
+  info_.subset_digits = read_value<int32_t>(file_);
+  info_.proc_size = read_value<int32_t>(file_);
+  info_.proc_rank = read_value<int32_t>(file_);
+  info_.delimiter = read_string(file_);
+  info_.prefix = read_string(file_);
+  info_.run_info = read_string(file_);
+  const uint32_t num_fields = read_value<uint32_t>(file_);
+  info_.field_names.resize(num_fields);
+  for(uint32_t i=0;i<num_fields;++i)
+    info_.field_names[i] = read_string(file_);
+  const uint32_t num_rows = read_value<uint32_t>(file_);
+  info_.row_ids.resize(num_rows);
+  for(uint32_t i=0;i<num_rows;++i)
+    info_.row_ids[i] = read_value<int32_t>(file_);
+  const uint64_t first_block_offset = file_.tellg();
+
+  // use the frame index if the file was closed properly
+  file_.seekg(0,std::ios::end);
+  const uint64_t file_size = file_.tellg();
+  bool has_index = false;
+  if(file_size>=first_block_offset+sizeof(uint64_t)+8){
+    file_.seekg(file_size-sizeof(uint64_t)-8,std::ios::beg);
+    const uint64_t index_offset = read_value<uint64_t>(file_);
+    file_.read(magic,8);
+    if(file_.good()&&std::memcmp(magic,binary_output_index_magic,8)==0&&index_offset>=first_block_offset&&index_offset<file_size){
+      file_.seekg(index_offset,std::ios::beg);
+      TEUCHOS_TEST_FOR_EXCEPTION(read_value<uint32_t>(file_)!=binary_output_index_marker,std::runtime_error,
+        "Error, corrupt frame index in binary output file " << file_name);
+      const uint64_t num_frames = read_value<uint64_t>(file_);
+      frame_ids_.resize(num_frames);
+      offsets_.resize(num_frames);
+      slots_.resize(num_frames);
+      for(uint64_t i=0;i<num_frames;++i){
+        frame_ids_[i] = read_value<int32_t>(file_);
+        offsets_[i] = read_value<uint64_t>(file_);
+        slots_[i] = read_value<int32_t>(file_);
+      }
+      has_index = true;
+    }
+  }
+  if(!has_index){
+    std::cout << "Warning: binary output file " << file_name << " has no frame index (the run may not have finished), scanning the blocks" << std::endl;
+    file_.clear();
+    scan_blocks(first_block_offset);
+  }
+  DEBUG_MSG("Binary_Output_Reader::Binary_Output_Reader(): " << file_name << " fields " << num_fields << " rows " << num_rows
+    << " frames " << frame_ids_.size());
+}
+
+Binary_Output_Reader::~Binary_Output_Reader(){
+  if(file_.is_open())
+    file_.close();
+}
+
+void
+Binary_Output_Reader::scan_blocks(const uint64_t first_block_offset){
+  uint64_t offset = first_block_offset;
+  file_.seekg(offset,std::ios::beg);
+  while(true){
+    uint32_t marker = 0;
+    file_.read(reinterpret_cast<char *>(&marker),sizeof(uint32_t));
+    if(!file_.good()||marker!=binary_output_block_marker) break;
+    uint32_t num_frames = 0;
+    file_.read(reinterpret_cast<char *>(&num_frames),sizeof(uint32_t));
+    std::vector<int32_t> ids(num_frames);
+    if(num_frames>0)
+      file_.read(reinterpret_cast<char *>(&ids[0]),num_frames*sizeof(int32_t));
+    bool complete = file_.good();
+    for(size_t field=0;field<info_.field_names.size()&&complete;++field){
+      uint64_t num_bytes = 0;
+      file_.read(reinterpret_cast<char *>(&num_bytes),sizeof(uint64_t));
+      file_.seekg(num_bytes,std::ios::cur);
+      complete = file_.good();
+    }
+    // a partially written block at the end of the file is ignored
+    if(!complete) break;
+    for(uint32_t i=0;i<num_frames;++i){
+      frame_ids_.push_back(ids[i]);
+      offsets_.push_back(offset);
+      slots_.push_back(i);
+    }
+    offset = file_.tellg();
+  }
+  file_.clear();
+}
+
+void
+Binary_Output_Reader::read_block(const uint64_t offset){
+  file_.seekg(offset,std::ios::beg);
+  TEUCHOS_TEST_FOR_EXCEPTION(read_value<uint32_t>(file_)!=binary_output_block_marker,std::runtime_error,
+    "Error, corrupt block in binary output file");
+  const int_t num_frames = read_value<uint32_t>(file_);
+  file_.seekg(num_frames*sizeof(int32_t),std::ios::cur);
+  const int_t num_rows = info_.row_ids.size();
+  const size_t column_size = num_frames*num_rows;
+  cached_values_.resize(info_.field_names.size()*column_size);
+  std::vector<unsigned char> buffer;
+  for(size_t field=0;field<info_.field_names.size();++field){
+    const uint64_t num_bytes = read_value<uint64_t>(file_);
+    buffer.resize(num_bytes);
+    if(num_bytes>0)
+      file_.read(reinterpret_cast<char *>(&buffer[0]),num_bytes);
+    TEUCHOS_TEST_FOR_EXCEPTION(!file_.good(),std::runtime_error,
+      "Error, unexpected end of binary output file");
+    // values are stored at the precision of the run that wrote the file
+    std::vector<unsigned char> raw;
+    if(compress_){
+      raw.resize(column_size*value_size_);
+      decode_column(buffer,num_frames,num_rows*value_size_,raw.empty()?NULL:&raw[0]);
+    }
+    else{
+      TEUCHOS_TEST_FOR_EXCEPTION(num_bytes!=column_size*value_size_,std::runtime_error,
+        "Error, corrupt column in binary output file");
+      raw.swap(buffer);
+    }
+    scalar_t * column = column_size>0 ? &cached_values_[field*column_size] : NULL;
+    for(size_t i=0;i<column_size;++i){
+      if(value_size_==sizeof(float)){
+        float value;
+        std::memcpy(&value,&raw[i*sizeof(float)],sizeof(float));
+        column[i] = value;
+      }
+      else{
+        double value;
+        std::memcpy(&value,&raw[i*sizeof(double)],sizeof(double));
+        column[i] = value;
+      }
+    }
+  }
+  cached_offset_ = offset;
+  cached_num_frames_ = num_frames;
+}
+
+void
+Binary_Output_Reader::read_frame(const int_t frame_index,
+  std::vector<scalar_t> & values){
+  TEUCHOS_TEST_FOR_EXCEPTION(frame_index<0||frame_index>=num_frames(),std::runtime_error,
+    "Error, invalid frame index " << frame_index);
+  if(cached_num_frames_==0||offsets_[frame_index]!=cached_offset_)
+    read_block(offsets_[frame_index]);
+  const int_t num_rows = info_.row_ids.size();
+  const int_t num_fields = info_.field_names.size();
+  const int_t slot = slots_[frame_index];
+  values.resize(num_rows*num_fields);
+  for(int_t field=0;field<num_fields;++field)
+    std::copy(cached_values_.begin()+(field*cached_num_frames_+slot)*num_rows,
+      cached_values_.begin()+(field*cached_num_frames_+slot+1)*num_rows,
+      values.begin()+field*num_rows);
+}
+
+int_t
+Binary_Output_Reader::field_index(const std::string & field_name)const{
+  for(size_t i=0;i<info_.field_names.size();++i)
+    if(info_.field_names[i]==field_name) return i;
+  return -1;
+}
+
+void
+Binary_Output_Reader::read_field(const int_t frame_index,
+  const int_t field,
+  std::vector<scalar_t> & values){
+  TEUCHOS_TEST_FOR_EXCEPTION(frame_index<0||frame_index>=num_frames(),std::runtime_error,
+    "Error, invalid frame index " << frame_index);
+  TEUCHOS_TEST_FOR_EXCEPTION(field<0||field>=(int_t)info_.field_names.size(),std::runtime_error,
+    "Error, invalid field index " << field);
+  if(cached_num_frames_==0||offsets_[frame_index]!=cached_offset_)
+    read_block(offsets_[frame_index]);
+  const int_t num_rows = info_.row_ids.size();
+  const int_t slot = slots_[frame_index];
+  values.assign(cached_values_.begin()+(field*cached_num_frames_+slot)*num_rows,
+    cached_values_.begin()+(field*cached_num_frames_+slot+1)*num_rows);
+}
+
+void
+convert_binary_output_to_text(const std::string & binary_file,
+  const std::string & output_folder){
+  Binary_Output_Reader reader(binary_file);
+  const Binary_Output_Info & info = reader.info();
+  const int_t num_rows = info.row_ids.size();
+  const std::string suffix = proc_suffix(info);
+  std::stringstream infoName;
+  infoName << output_folder << info.prefix << ".info";
+  if(info.separate_header_file&&info.proc_rank==0&&reader.num_frames()>0){
+    std::FILE * infoFilePtr = fopen(infoName.str().c_str(),"w");
+    TEUCHOS_TEST_FOR_EXCEPTION(infoFilePtr==NULL,std::runtime_error,
+      "Error, could not open file " << infoName.str());
+    fprintf(infoFilePtr,"%s",info.run_info.c_str());
+    fclose(infoFilePtr);
+  }
+  std::vector<scalar_t> values;
+  if(info.separate_files_per_subset){
+    // only a limited number of subset files are kept open at once, each group takes one pass over the frames
+    const int_t group_size = 256;
+    for(int_t group_begin=0;group_begin<num_rows;group_begin+=group_size){
+      const int_t group_end = std::min(num_rows,group_begin+group_size);
+      std::vector<std::FILE*> files(group_end-group_begin,NULL);
+      for(int_t row=group_begin;row<group_end;++row){
+        std::stringstream fName;
+        fName << output_folder << info.prefix << "_";
+        append_padded_id(fName,info.row_ids[row],info.subset_digits);
+        fName << suffix << ".txt";
+        std::FILE * filePtr = fopen(fName.str().c_str(),"w");
+        TEUCHOS_TEST_FOR_EXCEPTION(filePtr==NULL,std::runtime_error,
+          "Error, could not open file " << fName.str());
+        if(!info.separate_header_file)
+          fprintf(filePtr,"%s",info.run_info.c_str());
+        write_text_header(filePtr,info,"FRAME");
+        files[row-group_begin] = filePtr;
+      }
+      for(int_t frame=0;frame<reader.num_frames();++frame){
+        reader.read_frame(frame,values);
+        for(int_t row=group_begin;row<group_end;++row)
+          write_text_row(files[row-group_begin],info,reader.frame_id(frame),values,row);
+      }
+      for(size_t i=0;i<files.size();++i)
+        fclose(files[i]);
+    }
+  }
+  else{
+    for(int_t frame=0;frame<reader.num_frames();++frame){
+      reader.read_frame(frame,values);
+      std::stringstream fName;
+      fName << output_folder << info.prefix << "_";
+      append_padded_id(fName,reader.frame_id(frame),info.frame_digits);
+      fName << suffix << ".txt";
+      std::FILE * filePtr = fopen(fName.str().c_str(),"w");
+      TEUCHOS_TEST_FOR_EXCEPTION(filePtr==NULL,std::runtime_error,
+        "Error, could not open file " << fName.str());
+      if(!info.separate_header_file)
+        fprintf(filePtr,"%s",info.run_info.c_str());
+      write_text_header(filePtr,info,"SUBSET_ID");
+      for(int_t row=0;row<num_rows;++row)
+        write_text_row(filePtr,info,info.row_ids[row],values,row);
+      fclose(filePtr);
+    }
+  }
+}
+
+}// End DICe Namespace
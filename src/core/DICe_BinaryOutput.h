@@ -0,0 +1,297 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_BINARYOUTPUT_H
+#define DICE_BINARYOUTPUT_H
+
+#include <DICe.h>
+
+#include <Teuchos_RCP.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+ *  \namespace DICe
+ *  @{
+ */
+/// generic DICe classes and functions
+namespace DICe {
+
+/// \brief Layout and labelling information stored in the header of a binary results file
+///
+/// Everything the text writer needs to reproduce the original per-frame or per-subset
+/// text files is kept here so that a binary file can be converted without the input decks
+struct DICE_LIB_DLL_EXPORT
+Binary_Output_Info {
+  Binary_Output_Info():
+    separate_files_per_subset(false),
+    separate_header_file(false),
+    omit_row_id(false),
+    delimiter(" "),
+    prefix("DICe_solution"),
+    frame_digits(0),
+    subset_digits(0),
+    proc_size(1),
+    proc_rank(0){};
+  /// names of the columns (one column per field)
+  std::vector<std::string> field_names;
+  /// global id of each row (one row per subset)
+  std::vector<int_t> row_ids;
+  /// run information text written to the top of the text files (or to the .info file)
+  std::string run_info;
+  /// true if the text layout is one file per subset, otherwise one file per frame
+  bool separate_files_per_subset;
+  /// true if the run information goes in a separate .info file
+  bool separate_header_file;
+  /// true if the first (row id) column is omitted in the text files
+  bool omit_row_id;
+  /// delimiter used in the text files
+  std::string delimiter;
+  /// prefix for the text file names
+  std::string prefix;
+  /// total number of digits in the frame number of a text file name
+  int_t frame_digits;
+  /// total number of digits in the subset id of a text file name
+  int_t subset_digits;
+  /// number of processors in the run that wrote the file
+  int_t proc_size;
+  /// rank of the processor that wrote the file
+  int_t proc_rank;
+};
+
+/// \class DICe::Binary_Output_Writer
+/// \brief Writes the results for all frames of a run to one binary file, one column per field
+///
+/// The file is opened once and stays open for the whole run. Frames are collected in a block
+/// buffer and, once the block is full, the buffer is swapped with a second one that a background
+/// thread writes to disk while the next block is being filled. Each block stores the values
+/// column by column (all frames and rows of the first field, then the second, etc.). If compression
+/// is enabled, each column is stored as the xor of consecutive frames followed by a run length
+/// encoding of the zero bytes, which is effective since the results change little frame to frame.
+/// A frame index (frame id and block offset for each frame) is appended when the file is closed.
+class DICE_LIB_DLL_EXPORT
+Binary_Output_Writer {
+public:
+  /// \brief constructor
+  /// \param file_name name of the binary file (overwritten if it exists)
+  /// \param info layout information stored in the header
+  /// \param compress true if the columns should be compressed
+  /// \param frames_per_block number of frames per block (0 sizes the blocks to about 4 MB)
+  Binary_Output_Writer(const std::string & file_name,
+    const Binary_Output_Info & info,
+    const bool compress=false,
+    const int_t frames_per_block=0);
+
+  /// destructor, closes the file if it is still open
+  virtual ~Binary_Output_Writer();
+
+  /// \brief append the results for a frame
+  /// \param frame_id id of the frame (used as the row label in the per-subset text layout)
+  /// \param values field values stored field by field: values[field*num_rows + row]
+  void write_frame(const int_t frame_id,
+    const std::vector<scalar_t> & values);
+
+  /// flush the remaining frames, write the frame index and close the file
+  void close();
+
+  /// returns the number of rows (subsets)
+  int_t num_rows()const{
+    return info_.row_ids.size();
+  }
+
+  /// returns the number of fields (columns)
+  int_t num_fields()const{
+    return info_.field_names.size();
+  }
+
+  /// returns the number of frames per block
+  int_t frames_per_block()const{
+    return frames_per_block_;
+  }
+
+private:
+  /// a block of frames waiting to be written
+  struct Block {
+    /// ids of the frames in the block
+    std::vector<int_t> frame_ids;
+    /// values stored column major: values[field*frames_per_block*num_rows + frame*num_rows + row]
+    std::vector<scalar_t> values;
+  };
+  /// hand the front block to the writer thread
+  void submit_block();
+  /// main loop of the writer thread
+  void writer_loop();
+  /// write a block to disk (writer thread only)
+  void write_block(const Block & block);
+  /// write raw bytes and keep track of the file offset
+  void write_bytes(const void * data,
+    const size_t num_bytes);
+  /// name of the file
+  std::string file_name_;
+  /// layout information
+  Binary_Output_Info info_;
+  /// true if the columns are compressed
+  bool compress_;
+  /// number of frames per block
+  int_t frames_per_block_;
+  /// persistent file handle
+  std::FILE * file_;
+  /// number of bytes written so far (offset of the next block)
+  uint64_t num_bytes_written_;
+  /// block being filled by the caller
+  Block front_;
+  /// block being written by the writer thread
+  Block back_;
+  /// true if the back block holds data that has not been written yet
+  bool back_pending_;
+  /// true when the writer thread should exit
+  bool shutdown_;
+  /// set by the writer thread if a write failed
+  bool write_error_;
+  /// frame index: id of each frame written
+  std::vector<int_t> index_frame_ids_;
+  /// frame index: offset of the block that holds the frame
+  std::vector<uint64_t> index_offsets_;
+  /// frame index: position of the frame in its block
+  std::vector<int_t> index_slots_;
+  /// guards the buffers shared with the writer thread
+  std::mutex mutex_;
+  /// signals a change of back_pending_ or shutdown_
+  std::condition_variable cond_;
+  /// the background writer
+  std::thread writer_;
+};
+
+/// \class DICe::Binary_Output_Reader
+/// \brief Reads the binary results files written by DICe::Binary_Output_Writer
+///
+/// The frame index at the end of the file is used if present, otherwise (for example if
+/// the run did not finish) the index is rebuilt by scanning the blocks
+class DICE_LIB_DLL_EXPORT
+Binary_Output_Reader {
+public:
+  /// \brief constructor
+  /// \param file_name name of the binary file
+  Binary_Output_Reader(const std::string & file_name);
+
+  /// destructor
+  virtual ~Binary_Output_Reader();
+
+  /// returns the layout information stored in the header
+  const Binary_Output_Info & info()const{
+    return info_;
+  }
+
+  /// returns the number of frames in the file
+  int_t num_frames()const{
+    return frame_ids_.size();
+  }
+
+  /// returns the id of the given frame
+  /// \param frame_index index of the frame in the file (not the frame id)
+  int_t frame_id(const int_t frame_index)const{
+    return frame_ids_[frame_index];
+  }
+
+  /// \brief read the values for a frame
+  /// \param frame_index index of the frame in the file (not the frame id)
+  /// \param values output values stored field by field: values[field*num_rows + row]
+  void read_frame(const int_t frame_index,
+    std::vector<scalar_t> & values);
+
+  /// returns the index of the field with the given name (-1 if the file does not have the field)
+  /// \param field_name name of the field
+  int_t field_index(const std::string & field_name)const;
+
+  /// \brief read the values of one field for a frame
+  /// \param frame_index index of the frame in the file (not the frame id)
+  /// \param field index of the field (see field_index())
+  /// \param values output values, one per row
+  void read_field(const int_t frame_index,
+    const int_t field,
+    std::vector<scalar_t> & values);
+
+private:
+  /// read the block at the given offset into the cache
+  void read_block(const uint64_t offset);
+  /// rebuild the frame index by scanning the blocks
+  void scan_blocks(const uint64_t first_block_offset);
+  /// file stream
+  std::ifstream file_;
+  /// layout information
+  Binary_Output_Info info_;
+  /// true if the columns are compressed
+  bool compress_;
+  /// size of the stored values in bytes
+  int_t value_size_;
+  /// ids of the frames in the file
+  std::vector<int_t> frame_ids_;
+  /// offset of the block that holds each frame
+  std::vector<uint64_t> offsets_;
+  /// position of each frame in its block
+  std::vector<int_t> slots_;
+  /// offset of the cached block
+  uint64_t cached_offset_;
+  /// number of frames in the cached block
+  int_t cached_num_frames_;
+  /// values of the cached block (same layout as the writer blocks)
+  std::vector<scalar_t> cached_values_;
+};
+
+/// \brief convert a binary results file to the text files that DICe::Schema::write_output would have written
+/// \param binary_file name of the binary results file
+/// \param output_folder folder for the text files (with trailing slash)
+DICE_LIB_DLL_EXPORT
+void convert_binary_output_to_text(const std::string & binary_file,
+  const std::string & output_folder);
+
+}// End DICe Namespace
+
+/*! @} End of Doxygen namespace*/
+
+#endif
@@ -48,6 +48,10 @@
 
 #include <Teuchos_oblackholestream.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 namespace DICe {
 
 Decomp::Decomp(const Teuchos::RCP<Teuchos::ParameterList> & input_params,
@@ -93,12 +97,32 @@ Decomp::Decomp(Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   initialize(subset_centroids_x,subset_centroids_y,neighbor_ids,obstructing_subset_ids,correlation_params);
 }
 
+Decomp::Decomp(const int_t num_global_subsets,
+  Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+  Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+  Teuchos::RCP<std::vector<int_t> > subset_owners,
+  const Teuchos::RCP<Teuchos::ParameterList> & correlation_params):
+    num_global_subsets_(num_global_subsets),
+    image_width_(-1),
+    image_height_(-1){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_global_subsets_<=0,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(subset_owners==Teuchos::null,std::runtime_error,"");
+  comm_ = Teuchos::rcp(new MultiField_Comm());
+  // only proc 0 needs the global coords and owners
+  TEUCHOS_TEST_FOR_EXCEPTION(comm_->get_rank()==0&&subset_centroids_x.size()!=num_global_subsets_,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(comm_->get_rank()==0&&subset_centroids_y.size()!=num_global_subsets_,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(comm_->get_rank()==0&&(int_t)subset_owners->size()!=num_global_subsets_,std::runtime_error,"");
+  Teuchos::RCP<std::vector<int_t> > neighbor_ids;
+  initialize(subset_centroids_x,subset_centroids_y,neighbor_ids,Teuchos::null,correlation_params,subset_owners);
+}
+
 void
 Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
   Teuchos::RCP<std::vector<int_t> > & neighbor_ids,
   Teuchos::RCP<std::map<int_t,std::vector<int_t> > > obstructing_subset_ids,
-  const Teuchos::RCP<Teuchos::ParameterList> & correlation_params){
+  const Teuchos::RCP<Teuchos::ParameterList> & correlation_params,
+  Teuchos::RCP<std::vector<int_t> > subset_owners){
 
   DEBUG_MSG("Decomp::initialize(): num global subsets: " << num_global_subsets_);
 
@@ -109,6 +133,9 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   for(int_t i=0;i<id_decomp_map_->get_num_local_elements();++i)
     this_proc_gid_order_[i] = id_decomp_map_->get_global_element(i);
 
+  // if requested, give each processor a compact region of the image rather than a contiguous range of ids
+  create_spatial_dist_map(subset_centroids_x,subset_centroids_y,correlation_params,subset_owners);
+
   // if there are blocking subsets, they need to be on the same processor and put in order:
   create_obstruction_dist_map(obstructing_subset_ids);
 
@@ -166,6 +193,11 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
 //    for(int_t i=0;i<remote_proc_ids.size();++i)
 //      std::cout << comm_->get_rank() << " gid " << remote_gids[i] << " pid " <<  remote_proc_ids[i] << std::endl;
     std::vector<std::set<int_t> > owned_ids_on_each_proc(comm_->get_size(),std::set<int_t>());
+    // search radius for the strain window neighborhoods
+    const scalar_t tiny = 1.0E-5;
+    scalar_t neigh_rad_2 = (scalar_t)max_strain_window_size/2.0;
+    neigh_rad_2 *= neigh_rad_2;
+    neigh_rad_2 += tiny;
     if(comm_->get_rank()==0){
       // get the ids on each proc from the id_decomp_map
       for(int_t i=0;i<num_global_subsets_;++i){
@@ -173,48 +205,55 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
       }
 
       if(max_strain_window_size > 0.0){
-        // processor 0 does a neighborhood search and scatters the results to all processors
+        // processor 0 only sends each processor the candidate neighbors (the points inside the bounding box of
+        // the processor's points grown by the search radius), the exact radius search is done on each processor
         TEUCHOS_TEST_FOR_EXCEPTION(subset_centroids_x.size()!=num_global_subsets_||subset_centroids_y.size()!=num_global_subsets_,std::runtime_error,"");
-        Teuchos::RCP<Point_Cloud_2D<scalar_t> > point_cloud = Teuchos::rcp(new Point_Cloud_2D<scalar_t>());
-        point_cloud->pts.resize(num_global_subsets_);
+        const scalar_t neigh_rad = std::sqrt(neigh_rad_2);
+        // bucket the points in a uniform grid with cells the size of the search radius
+        scalar_t min_x = subset_centroids_x[0], min_y = subset_centroids_y[0];
+        scalar_t max_x = subset_centroids_x[0];
         for(int_t i=0;i<num_global_subsets_;++i){
-          point_cloud->pts[i].x = subset_centroids_x[i];
-          point_cloud->pts[i].y = subset_centroids_y[i];
+          min_x = std::min(min_x,subset_centroids_x[i]);
+          min_y = std::min(min_y,subset_centroids_y[i]);
+          max_x = std::max(max_x,subset_centroids_x[i]);
         }
-        DEBUG_MSG("Decomp::Decomp(): building the kd-tree");
-        Teuchos::RCP<kd_tree_2d_t> kd_tree = Teuchos::rcp(new kd_tree_2d_t(2 /*dim*/, *point_cloud.get(), nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */) ) );
-        kd_tree->buildIndex();
-        DEBUG_MSG("Decomp::Decomp(): kd-tree completed");
-        std::vector<std::pair<size_t,scalar_t> > ret_matches;
-        nanoflann::SearchParams params;
-        params.sorted = true; // sort by distance in ascending order
-        const scalar_t tiny = 1.0E-5;
-        scalar_t neigh_rad_2 = (scalar_t)max_strain_window_size/2.0;
-        neigh_rad_2 *= neigh_rad_2;
-        neigh_rad_2 += tiny;
-        scalar_t query_pt[2];
+        const int_t num_cells_x = static_cast<int_t>((max_x - min_x)/neigh_rad) + 1;
+        std::vector<std::pair<int64_t,int_t> > cell_ids(num_global_subsets_);
+        for(int_t i=0;i<num_global_subsets_;++i){
+          const int64_t cx = static_cast<int64_t>((subset_centroids_x[i]-min_x)/neigh_rad);
+          const int64_t cy = static_cast<int64_t>((subset_centroids_y[i]-min_y)/neigh_rad);
+          cell_ids[i] = std::pair<int64_t,int_t>(cy*num_cells_x+cx,i);
+        }
+        std::sort(cell_ids.begin(),cell_ids.end());
+        DEBUG_MSG("Decomp::Decomp(): points bucketed in a grid with " << num_cells_x << " cells per row");
         for(int_t proc=0;proc<comm_->get_size();++proc){
-          std::set<int_t> neighbors_to_add;
-          // iterate all the ids local to this processor and find all the neighbors
+          if(owned_ids_on_each_proc[proc].empty()) continue;
+          scalar_t box_min_x = std::numeric_limits<scalar_t>::max(), box_max_x = -std::numeric_limits<scalar_t>::max();
+          scalar_t box_min_y = std::numeric_limits<scalar_t>::max(), box_max_y = -std::numeric_limits<scalar_t>::max();
           for(std::set<int_t>::const_iterator it=owned_ids_on_each_proc[proc].begin();it!=owned_ids_on_each_proc[proc].end();++it){
-            assert(*it>=0&&*it<num_global_subsets_);
-            query_pt[0] = subset_centroids_x[*it];
-            query_pt[1] = subset_centroids_y[*it];
-            kd_tree->radiusSearch(&query_pt[0],neigh_rad_2,ret_matches,params);
-            for(size_t j=0;j<ret_matches.size();++j){
-              neighbors_to_add.insert(ret_matches[j].first);
-//              if(neighbor_ids!=Teuchos::null){
-//                if(j==1&&(int_t)neighbor_ids->size()>*it&&(*neighbor_ids)[*it]>0){ // check for rebalance needed, and that this is not a seed subset
-//                  (*neighbor_ids)[*it] = ret_matches[j].first;
-//                }
-//              }
-            } // loop over all neighbors
-          } // loop over all dist ids on that processor
-          // add all the neighbors to the id list
-          for(std::set<int_t>::const_iterator it = neighbors_to_add.begin(); it!=neighbors_to_add.end(); ++it)
-            owned_ids_on_each_proc[proc].insert(*it);
+            box_min_x = std::min(box_min_x,subset_centroids_x[*it]); box_max_x = std::max(box_max_x,subset_centroids_x[*it]);
+            box_min_y = std::min(box_min_y,subset_centroids_y[*it]); box_max_y = std::max(box_max_y,subset_centroids_y[*it]);
+          }
+          box_min_x -= neigh_rad; box_max_x += neigh_rad;
+          box_min_y -= neigh_rad; box_max_y += neigh_rad;
+          const int64_t cx_begin = std::max(static_cast<int64_t>(0),static_cast<int64_t>(std::floor((box_min_x-min_x)/neigh_rad)));
+          const int64_t cx_end = std::min(static_cast<int64_t>(num_cells_x-1),static_cast<int64_t>((box_max_x-min_x)/neigh_rad));
+          const int64_t cy_begin = std::max(static_cast<int64_t>(0),static_cast<int64_t>(std::floor((box_min_y-min_y)/neigh_rad)));
+          const int64_t cy_end = static_cast<int64_t>((box_max_y-min_y)/neigh_rad);
+          std::set<int_t> & candidates = owned_ids_on_each_proc[proc];
+          for(int64_t cy=cy_begin;cy<=cy_end;++cy){
+            // the cells in a row of the box are contiguous in the sorted list
+            std::vector<std::pair<int64_t,int_t> >::const_iterator it = std::lower_bound(cell_ids.begin(),cell_ids.end(),
+              std::pair<int64_t,int_t>(cy*num_cells_x+cx_begin,-1));
+            for(;it!=cell_ids.end()&&it->first<=cy*num_cells_x+cx_end;++it){
+              const int_t id = it->second;
+              if(subset_centroids_x[id]>=box_min_x&&subset_centroids_x[id]<=box_max_x&&
+                  subset_centroids_y[id]>=box_min_y&&subset_centroids_y[id]<=box_max_y)
+                candidates.insert(id);
+            }
+          }
         } // loop over each processor
-        DEBUG_MSG("Decomp::Decomp(): neighbor list constructed");
+        DEBUG_MSG("Decomp::Decomp(): candidate neighbor lists constructed");
       } // end window_size > 0
       // determine the size of the mega position vector with all the overlap coords
       int_t total_num_overlap_pts = 0;
@@ -268,20 +307,33 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
     } // end proc 0
     MultiField_Exporter field_exporter(*field_dist_map,*field_zero_data->get_map());
     field_dist_data->do_import(field_zero_data,field_exporter,INSERT);
-    Teuchos::Array<int_t> field_dist_owned_gids(num_overlap);
-    for(int_t i=0;i<num_overlap;++i){
-      field_dist_owned_gids[i] = field_dist_data->local_value(i,2);
-      //  DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] has a subset at " << field_dist_data->local_value(i,0) << " " << field_dist_data->local_value(i,1));
+    // keep the candidates that are within the search radius of one of this processor's points
+    std::vector<bool> keep(num_overlap,true);
+    if(max_strain_window_size > 0.0){
+      Teuchos::ArrayRCP<scalar_t> candidate_x(num_overlap,0.0);
+      Teuchos::ArrayRCP<scalar_t> candidate_y(num_overlap,0.0);
+      std::vector<bool> is_owned(num_overlap,false);
+      for(int_t i=0;i<num_overlap;++i){
+        candidate_x[i] = field_dist_data->local_value(i,0);
+        candidate_y[i] = field_dist_data->local_value(i,1);
+        is_owned[i] = id_decomp_map_->get_local_element(static_cast<int_t>(field_dist_data->local_value(i,2)))>=0;
+      }
+      find_points_within_radius(candidate_x,candidate_y,is_owned,neigh_rad_2,keep);
     }
-    // now that the coords have been communicated, store them in the overlap coords vectors
-    overlap_coords_x_.resize(num_overlap,0.0);
-    overlap_coords_y_.resize(num_overlap,0.0);
-    neighbor_ids_ = Teuchos::rcp(new std::vector<int_t>(num_overlap,-1));
+    Teuchos::Array<int_t> field_dist_owned_gids;
+    overlap_coords_x_.clear();
+    overlap_coords_y_.clear();
+    neighbor_ids_ = Teuchos::rcp(new std::vector<int_t>());
+    // the candidates are in ascending gid order so the overlap ids are as well
     for(int_t i=0;i<num_overlap;++i){
-      overlap_coords_x_[i] = field_dist_data->local_value(i,0);
-      overlap_coords_y_[i] = field_dist_data->local_value(i,1);
-      (*neighbor_ids_)[i] = field_dist_data->local_value(i,3);
+      if(!keep[i]) continue;
+      field_dist_owned_gids.push_back(field_dist_data->local_value(i,2));
+      // now that the coords have been communicated, store them in the overlap coords vectors
+      overlap_coords_x_.push_back(field_dist_data->local_value(i,0));
+      overlap_coords_y_.push_back(field_dist_data->local_value(i,1));
+      neighbor_ids_->push_back(field_dist_data->local_value(i,3));
     }
+    DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] kept " << field_dist_owned_gids.size() << " of " << num_overlap << " candidate overlap points");
     id_decomp_overlap_map_ = Teuchos::rcp(new MultiField_Map(-1,field_dist_owned_gids,0,*comm_));
     DEBUG_MSG("Decomp::Decomp(): coordinate list has been trimmed");
   } // end is parallel
@@ -304,6 +356,116 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] num overlap subsets:  " << id_decomp_overlap_map_->get_num_local_elements());
 }
 
+void
+Decomp::create_spatial_dist_map(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+  const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+  const Teuchos::RCP<Teuchos::ParameterList> & correlation_params,
+  Teuchos::RCP<std::vector<int_t> > subset_owners){
+
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+  if(num_procs==1) return;
+
+  Subset_Partition_Method partition_method = EVEN_SPLIT_PARTITION;
+  if(subset_owners!=Teuchos::null){
+    // the owners have already been determined, the method is only used to skip the early return below
+    partition_method = RECURSIVE_COORDINATE_BISECTION;
+  }
+  else if(correlation_params!=Teuchos::null){
+    if(correlation_params->isParameter(DICe::subset_partition_method)){
+      if(correlation_params->isType<std::string>(DICe::subset_partition_method)){
+        std::string partition_string = correlation_params->get<std::string>(DICe::subset_partition_method,"EVEN_SPLIT_PARTITION");
+        partition_method = DICe::string_to_subset_partition_method(partition_string);
+      }
+      else{
+        partition_method = correlation_params->get<DICe::Subset_Partition_Method>(DICe::subset_partition_method);
+      }
+    }
+  }
+  if(partition_method==EVEN_SPLIT_PARTITION) return;
+  if(proc_id==0&&subset_owners==Teuchos::null)
+    DEBUG_MSG("Decomp::create_spatial_dist_map(): partitioning subsets using " << subsetPartitionMethodStrings[partition_method]);
+
+  // process zero divies up the subsets:
+  Teuchos::Array<int_t> field_zero_owned_ids;
+  if(proc_id==0){
+    field_zero_owned_ids = Teuchos::Array<int_t>(num_global_subsets_);
+  }
+  for(int_t i=0;i<field_zero_owned_ids.size();++i){
+    field_zero_owned_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> field_zero_map = Teuchos::rcp (new MultiField_Map(-1, field_zero_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField> field_zero_data = Teuchos::rcp(new MultiField(field_zero_map,1,true));
+
+  // dummy field to communicate the extents to each processor
+  Teuchos::Array<int_t> zero_owned_ids;
+  if(proc_id==0){
+    for(int_t i=0;i<num_procs;++i)
+      zero_owned_ids.push_back(i);
+  }
+  Teuchos::Array<int_t> all_owned_ids;
+  all_owned_ids.push_back(proc_id);
+  Teuchos::RCP<MultiField_Map> zero_map = Teuchos::rcp (new MultiField_Map(-1, zero_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> all_map = Teuchos::rcp (new MultiField_Map(-1, all_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField> zero_data = Teuchos::rcp(new MultiField(zero_map,2,true));
+  Teuchos::RCP<MultiField> all_data = Teuchos::rcp(new MultiField(all_map,2,true));
+
+  if(proc_id==0){
+    TEUCHOS_TEST_FOR_EXCEPTION(subset_centroids_x.size()!=num_global_subsets_||subset_centroids_y.size()!=num_global_subsets_,
+      std::runtime_error,"Error, processor 0 must have the coordinates of all the subsets");
+    std::vector<int_t> part_ids;
+    if(subset_owners!=Teuchos::null)
+      part_ids = *subset_owners;
+    else if(partition_method==RECURSIVE_COORDINATE_BISECTION)
+      partition_points_rcb(subset_centroids_x,subset_centroids_y,num_procs,part_ids);
+    else if(partition_method==HILBERT_CURVE_PARTITION)
+      partition_points_hilbert(subset_centroids_x,subset_centroids_y,num_procs,part_ids);
+    else{
+      TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, invalid subset partition method");
+    }
+    TEUCHOS_TEST_FOR_EXCEPTION((int_t)part_ids.size()!=num_global_subsets_,std::runtime_error,"");
+    // restack the ids in processor order (the ids stay in ascending order on each processor)
+    std::vector<std::vector<int_t> > ids_on_each_proc(num_procs);
+    for(int_t i=0;i<num_global_subsets_;++i){
+      TEUCHOS_TEST_FOR_EXCEPTION(part_ids[i]<0||part_ids[i]>=num_procs,std::runtime_error,"");
+      ids_on_each_proc[part_ids[i]].push_back(i);
+    }
+    int_t id_count = 0;
+    for(int_t proc=0;proc<num_procs;++proc){
+      zero_data->local_value(proc,0) = id_count;
+      for(size_t i=0;i<ids_on_each_proc[proc].size();++i)
+        field_zero_data->local_value(id_count++) = ids_on_each_proc[proc][i];
+      zero_data->local_value(proc,1) = id_count - 1;
+    }
+  } // end processor 0
+
+  // communicate the extents of the ordered list to all procs:
+  MultiField_Exporter exporter(*all_map,*zero_data->get_map());
+  all_data->do_import(zero_data,exporter,INSERT);
+  const int_t start_id = all_data->local_value(0,0);
+  const int_t end_id = all_data->local_value(0,1);
+  const int_t num_ids = end_id - start_id + 1;
+  DEBUG_MSG("[PROC "<<proc_id <<"] Decomp::create_spatial_dist_map(): owns id list elements " << start_id << " through " << end_id << " num ids " << num_ids);
+
+  Teuchos::Array<int_t> field_all_owned_ids(num_ids);
+  for(int_t i=0;i<field_all_owned_ids.size();++i){
+    field_all_owned_ids[i] = start_id + i;
+  }
+  Teuchos::RCP<MultiField_Map> field_all_map = Teuchos::rcp (new MultiField_Map(-1, field_all_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField> field_all_data = Teuchos::rcp(new MultiField(field_all_map,1,true));
+  MultiField_Exporter field_exporter(*field_all_map,*field_zero_data->get_map());
+  field_all_data->do_import(field_zero_data,field_exporter,INSERT);
+
+  const int_t num_local_subsets = field_all_data->get_map()->get_num_local_elements();
+  this_proc_gid_order_ = std::vector<int_t>(num_local_subsets,-1);
+  Teuchos::Array<int_t> local_gids(num_local_subsets);
+  for(int_t i=0;i<num_local_subsets;++i){
+    this_proc_gid_order_[i] = field_all_data->local_value(i);
+    local_gids[i] = this_proc_gid_order_[i];
+  }
+  id_decomp_map_ = Teuchos::rcp(new MultiField_Map(num_global_subsets_,local_gids,0,*comm_));
+}
+
 void
 Decomp::create_obstruction_dist_map(Teuchos::RCP<std::map<int_t,std::vector<int_t> > > & obstructing_subset_ids){
   if(obstructing_subset_ids==Teuchos::null) return;
@@ -764,22 +926,18 @@ Decomp::populate_coordinate_vectors(const std::string & image_file_name,
     Teuchos::RCP<Image> sssig_image = Teuchos::rcp( new Image(image_file_name.c_str(),min_x,min_y,max_x-min_x+1,max_y-min_y+1,imgParams));
     TEUCHOS_TEST_FOR_EXCEPTION(!sssig_image->has_gradients(),std::runtime_error,
       "Error, testing valid points for SSSIG tol, but image gradients have not been computed");
+    // the subset windows overlap so the squared gradients are summed once in an integral image
+    Summed_Area_Table sssig_table(sssig_image,SUMMED_GRADIENT_MAGNITUDE_SQUARED);
     for(int_t i=0;i<num_check_points;++i){
       const int_t cx = field_dist_data->local_value(i,0);
       const int_t cy = field_dist_data->local_value(i,1);
       //DEBUG_MSG("[PROC "<<proc_rank <<"] Decomp::populate_coordinate_vectors(): checking ssig for point " << field_dist_data->local_value(i,0) << " " << field_dist_data->local_value(i,1));
       // check the gradient SSSIG threshold
-      scalar_t SSSIG = 0.0;
       const int_t left_x = cx - subset_size/2;
       const int_t right_x = left_x + subset_size;
       const int_t top_y = cy - subset_size/2;
       const int_t bottom_y = top_y + subset_size;
-      for(int_t y=top_y;y<bottom_y;++y){
-        for(int_t x=left_x;x<right_x;++x){
-          SSSIG += sssig_image->grad_x(x-min_x,y-min_y)*sssig_image->grad_x(x-min_x,y-min_y) +
-              sssig_image->grad_y(x-min_x,y-min_y)*sssig_image->grad_y(x-min_x,y-min_y);
-        }
-      }
+      scalar_t SSSIG = sssig_table.window_sum(left_x-min_x,top_y-min_y,right_x-min_x,bottom_y-min_y);
       SSSIG /= subset_size==0.0?1.0:(subset_size*subset_size);
       if(SSSIG < grad_threshold) field_dist_data->local_value(i,3) = 0.0;
       //DEBUG_MSG("[PROC "<<proc_rank <<"] x " << cx << " y " << cy << " SSSIG: " << SSSIG << " threshold " << grad_threshold << " pass " << field_dist_data->local_value(i,2));
@@ -888,6 +1046,13 @@ create_regular_grid_of_correlation_points(std::vector<scalar_t> & correlation_po
   const int_t subset_size = params->get<int_t>(DICe::subset_size);
   correlation_points.clear();
   neighbor_ids.clear();
+  // the squared gradients are summed once so that each SSSIG check is a constant time lookup
+  Teuchos::RCP<Summed_Area_Table> sssig_table;
+  if(image!=Teuchos::null&&grad_threshold > 0.0){
+    TEUCHOS_TEST_FOR_EXCEPTION(!image->has_gradients(),std::runtime_error,
+      "Error, testing valid points for SSSIG tol, but image gradients have not been computed");
+    sssig_table = Teuchos::rcp(new Summed_Area_Table(image,SUMMED_GRADIENT_MAGNITUDE_SQUARED));
+  }
   bool seed_was_specified = false;
   Teuchos::RCP<std::map<int_t,DICe::Conformal_Area_Def> > roi_defs;
   if(subset_file_info!=Teuchos::null){
@@ -970,7 +1135,7 @@ create_regular_grid_of_correlation_points(std::vector<scalar_t> & correlation_po
     //if(seed_was_specified&&this_roi_has_seed){
       x_coord = subset_size-1 + seed_col*step_size;
       y_coord = subset_size-1 + seed_row*step_size;
-    if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold)){
+    if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold,sssig_table)){
       correlation_points.push_back((scalar_t)x_coord);
       correlation_points.push_back((scalar_t)y_coord);
       //if(proc_rank==0) DEBUG_MSG("ROI " << map_it->first << " adding seed correlation point " << x_coord << " " << y_coord);
@@ -1000,7 +1165,7 @@ create_regular_grid_of_correlation_points(std::vector<scalar_t> & correlation_po
       if(col>=num_cols)break;
       x_coord = subset_size - 1 + col*step_size;
       y_coord = subset_size - 1 + row*step_size;
-      if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold)){
+      if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold,sssig_table)){
         correlation_points.push_back((scalar_t)x_coord);
         correlation_points.push_back((scalar_t)y_coord);
         //if(proc_rank==0) DEBUG_MSG("ROI " << map_it->first << " adding snake right correlation point " << x_coord << " " << y_coord);
@@ -1027,7 +1192,7 @@ create_regular_grid_of_correlation_points(std::vector<scalar_t> & correlation_po
       if(col<0)break;
       x_coord = subset_size - 1 + col*step_size;
       y_coord = subset_size - 1 + row*step_size;
-      if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold)){
+      if(valid_correlation_point(x_coord,y_coord,subset_size,img_w,img_h,coords,excluded_coords,image,grad_threshold,sssig_table)){
         correlation_points.push_back((scalar_t)x_coord);
         correlation_points.push_back((scalar_t)y_coord);
         //if(proc_rank==0) DEBUG_MSG("ROI " << map_it->first << " adding snake left correlation point " << x_coord << " " << y_coord);
@@ -1072,7 +1237,8 @@ bool valid_correlation_point(const int_t x_coord,
   std::set<std::pair<int_t,int_t> > & coords,
   std::set<std::pair<int_t,int_t> > & excluded_coords,
   Teuchos::RCP<DICe::Image> image,
-  const scalar_t & grad_threshold){
+  const scalar_t & grad_threshold,
+  Teuchos::RCP<DICe::Summed_Area_Table> sssig_table){
   // need to check if the point is interior to the image by at least one subset_size
   if(x_coord<subset_size-1) return false;
   if(x_coord>img_w-subset_size) return false;
@@ -1096,15 +1262,22 @@ bool valid_correlation_point(const int_t x_coord,
   }
   if(!all_corners_in) return false;
 
-  if(image!=Teuchos::null){
+  if(image!=Teuchos::null||sssig_table!=Teuchos::null){
     // check the gradient SSSIG threshold
     if(grad_threshold > 0.0){
-      TEUCHOS_TEST_FOR_EXCEPTION(!image->has_gradients(),std::runtime_error,
-        "Error, testing valid points for SSSIG tol, but image gradients have not been computed");
       scalar_t SSSIG = 0.0;
-      for(int_t y=corners_y[0];y<corners_y[2];++y){
-        for(int_t x=corners_x[0];x<corners_x[1];++x){
-          SSSIG += image->grad_x(x,y)*image->grad_x(x,y) + image->grad_x(x,y)*image->grad_x(x,y);
+      if(sssig_table!=Teuchos::null){
+        TEUCHOS_TEST_FOR_EXCEPTION(sssig_table->quantity()!=SUMMED_GRADIENT_MAGNITUDE_SQUARED,std::runtime_error,
+          "Error, the summed area table for the SSSIG check must be of the squared gradient magnitude");
+        SSSIG = sssig_table->window_sum(corners_x[0],corners_y[0],corners_x[1],corners_y[2]);
+      }
+      else{
+        TEUCHOS_TEST_FOR_EXCEPTION(!image->has_gradients(),std::runtime_error,
+          "Error, testing valid points for SSSIG tol, but image gradients have not been computed");
+        for(int_t y=corners_y[0];y<corners_y[2];++y){
+          for(int_t x=corners_x[0];x<corners_x[1];++x){
+            SSSIG += image->grad_x(x,y)*image->grad_x(x,y) + image->grad_y(x,y)*image->grad_y(x,y);
+          }
         }
       }
       SSSIG /= subset_size==0.0?1.0:(subset_size*subset_size);
@@ -1115,6 +1288,173 @@ bool valid_correlation_point(const int_t x_coord,
   return true;
 }
 
+DICE_LIB_DLL_EXPORT
+void find_points_within_radius(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const std::vector<bool> & is_query_point,
+  const scalar_t & radius_2,
+  std::vector<bool> & in_neighborhood){
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)is_query_point.size()!=coords_x.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  in_neighborhood = is_query_point;
+  if(num_points==0||radius_2<=0.0) return;
+  // bucket the points in a uniform grid with cells the size of the radius so that
+  // all the neighbors of a point are in the point's cell or the eight surrounding ones
+  const scalar_t cell_size = std::sqrt(radius_2);
+  scalar_t min_x = coords_x[0], max_x = coords_x[0], min_y = coords_y[0];
+  for(int_t i=0;i<num_points;++i){
+    min_x = std::min(min_x,coords_x[i]);
+    max_x = std::max(max_x,coords_x[i]);
+    min_y = std::min(min_y,coords_y[i]);
+  }
+  const int64_t num_cells_x = static_cast<int64_t>((max_x - min_x)/cell_size) + 1;
+  std::vector<int64_t> cell_x(num_points);
+  std::vector<int64_t> cell_y(num_points);
+  std::vector<std::pair<int64_t,int_t> > cell_ids(num_points);
+  for(int_t i=0;i<num_points;++i){
+    cell_x[i] = static_cast<int64_t>((coords_x[i]-min_x)/cell_size);
+    cell_y[i] = static_cast<int64_t>((coords_y[i]-min_y)/cell_size);
+    cell_ids[i] = std::pair<int64_t,int_t>(cell_y[i]*num_cells_x+cell_x[i],i);
+  }
+  std::sort(cell_ids.begin(),cell_ids.end());
+  for(int_t i=0;i<num_points;++i){
+    if(!is_query_point[i]) continue;
+    for(int64_t cy=std::max(cell_y[i]-1,static_cast<int64_t>(0));cy<=cell_y[i]+1;++cy){
+      const int64_t cx_begin = std::max(cell_x[i]-1,static_cast<int64_t>(0));
+      const int64_t cx_end = std::min(cell_x[i]+1,num_cells_x-1);
+      std::vector<std::pair<int64_t,int_t> >::const_iterator it = std::lower_bound(cell_ids.begin(),cell_ids.end(),
+        std::pair<int64_t,int_t>(cy*num_cells_x+cx_begin,-1));
+      for(;it!=cell_ids.end()&&it->first<=cy*num_cells_x+cx_end;++it){
+        const int_t j = it->second;
+        if(in_neighborhood[j]) continue;
+        const scalar_t dx = coords_x[j] - coords_x[i];
+        const scalar_t dy = coords_y[j] - coords_y[i];
+        if(dx*dx + dy*dy <= radius_2) in_neighborhood[j] = true;
+      }
+    }
+  }
+}
+
+/// recursively bisect the points in the range [begin,end) of the index vector
+void
+bisect_points(const Teuchos::ArrayRCP<scalar_t> & coords_x,
+  const Teuchos::ArrayRCP<scalar_t> & coords_y,
+  const std::vector<scalar_t> & weights,
+  std::vector<int_t>::iterator begin,
+  std::vector<int_t>::iterator end,
+  const int_t first_part,
+  const int_t num_parts,
+  std::vector<int_t> & part_ids){
+  if(num_parts==1||end-begin<=1){
+    for(std::vector<int_t>::iterator it=begin;it!=end;++it)
+      part_ids[*it] = first_part;
+    return;
+  }
+  // cut along the longer side of the bounding box
+  scalar_t min_x = coords_x[*begin], max_x = coords_x[*begin];
+  scalar_t min_y = coords_y[*begin], max_y = coords_y[*begin];
+  for(std::vector<int_t>::iterator it=begin;it!=end;++it){
+    min_x = std::min(min_x,coords_x[*it]); max_x = std::max(max_x,coords_x[*it]);
+    min_y = std::min(min_y,coords_y[*it]); max_y = std::max(max_y,coords_y[*it]);
+  }
+  const Teuchos::ArrayRCP<scalar_t> & coords = max_x - min_x >= max_y - min_y ? coords_x : coords_y;
+  // the number of points (or the weight) on each side is proportional to the number of parts on that side
+  const int_t num_left_parts = num_parts/2;
+  const int_t num_points = end - begin;
+  // ties are broken by the id so that the split is deterministic
+  auto less_than = [&coords](const int_t a, const int_t b){
+    return coords[a] < coords[b] || (coords[a] == coords[b] && a < b);};
+  std::vector<int_t>::iterator mid = begin;
+  if(weights.empty()){
+    const int_t num_left_points = (int_t)(((long long)num_points*num_left_parts + num_parts/2)/num_parts);
+    mid = begin + num_left_points;
+    std::nth_element(begin,mid,end,less_than);
+  }
+  else{
+    std::sort(begin,end,less_than);
+    scalar_t total_weight = 0.0;
+    for(std::vector<int_t>::iterator it=begin;it!=end;++it)
+      total_weight += weights[*it];
+    const scalar_t left_weight = total_weight*num_left_parts/num_parts;
+    // stop at the point that brings the running sum closest to the target weight
+    scalar_t running_weight = 0.0;
+    while(mid!=end && running_weight + 0.5*weights[*mid] < left_weight){
+      running_weight += weights[*mid];
+      ++mid;
+    }
+    // every part gets at least one point if possible
+    if(mid-begin < num_left_parts) mid = begin + std::min(num_left_parts,num_points);
+    if(end-mid < num_parts-num_left_parts) mid = end - std::min(num_parts-num_left_parts,num_points);
+  }
+  bisect_points(coords_x,coords_y,weights,begin,mid,first_part,num_left_parts,part_ids);
+  bisect_points(coords_x,coords_y,weights,mid,end,first_part+num_left_parts,num_parts-num_left_parts,part_ids);
+}
+
+DICE_LIB_DLL_EXPORT
+void partition_points_rcb(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const int_t num_parts,
+  std::vector<int_t> & part_ids,
+  const std::vector<scalar_t> & weights){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_parts<=0,std::runtime_error,"Error, invalid number of parts " << num_parts);
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(!weights.empty()&&weights.size()!=coords_x.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  part_ids.assign(num_points,0);
+  std::vector<int_t> ids(num_points);
+  for(int_t i=0;i<num_points;++i)
+    ids[i] = i;
+  bisect_points(coords_x,coords_y,weights,ids.begin(),ids.end(),0,num_parts,part_ids);
+}
 
+DICE_LIB_DLL_EXPORT
+void partition_points_hilbert(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const int_t num_parts,
+  std::vector<int_t> & part_ids){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_parts<=0,std::runtime_error,"Error, invalid number of parts " << num_parts);
+  TEUCHOS_TEST_FOR_EXCEPTION(coords_x.size()!=coords_y.size(),std::runtime_error,"");
+  const int_t num_points = coords_x.size();
+  part_ids.assign(num_points,0);
+  if(num_points==0) return;
+  scalar_t min_x = coords_x[0], max_x = coords_x[0];
+  scalar_t min_y = coords_y[0], max_y = coords_y[0];
+  for(int_t i=0;i<num_points;++i){
+    min_x = std::min(min_x,coords_x[i]); max_x = std::max(max_x,coords_x[i]);
+    min_y = std::min(min_y,coords_y[i]); max_y = std::max(max_y,coords_y[i]);
+  }
+  // map the points to a square grid over the bounding box (same scale in x and y)
+  const uint64_t grid_dim = 1 << 16;
+  const scalar_t extent = std::max(max_x - min_x, max_y - min_y);
+  const scalar_t scale = extent > 0.0 ? (grid_dim - 1)/extent : 0.0;
+  std::vector<std::pair<uint64_t,int_t> > keys(num_points);
+  for(int_t i=0;i<num_points;++i){
+    uint64_t x = (uint64_t)((coords_x[i] - min_x)*scale);
+    uint64_t y = (uint64_t)((coords_y[i] - min_y)*scale);
+    if(x>=grid_dim) x = grid_dim - 1;
+    if(y>=grid_dim) y = grid_dim - 1;
+    // distance along the Hilbert curve
+    uint64_t d = 0;
+    for(uint64_t s=grid_dim/2;s>0;s/=2){
+      const uint64_t rx = (x & s) > 0;
+      const uint64_t ry = (y & s) > 0;
+      d += s * s * ((3 * rx) ^ ry);
+      // rotate the quadrant
+      if(ry==0){
+        if(rx==1){
+          x = grid_dim - 1 - x;
+          y = grid_dim - 1 - y;
+        }
+        std::swap(x,y);
+      }
+    }
+    keys[i] = std::pair<uint64_t,int_t>(d,i);
+  }
+  std::sort(keys.begin(),keys.end());
+  // cut the curve into pieces of equal size
+  for(int_t i=0;i<num_points;++i)
+    part_ids[keys[i].second] = (int_t)(((long long)i*num_parts)/num_points);
+}
 
 }// End DICe Namespace
@@ -44,6 +44,7 @@
 
 #include <DICe.h>
 #include <DICe_Image.h>
+#include <DICe_ImageUtils.h>
 #include <DICe_Parser.h>
 #include <DICe_PointCloud.h>
 #ifdef DICE_TPETRA
@@ -84,6 +85,19 @@ public:
     Teuchos::RCP<std::map<int_t,std::vector<int_t> > > obstructing_subset_ids,
     const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
 
+  /// constructor that redistributes a set of correlation points to the given processors
+  /// (only processor 0 needs the coordinates and owners, the other processors can pass empty vectors)
+  /// \param num_global_subsets the total number of points
+  /// \param subset_centroids_x x coordinates of all global points
+  /// \param subset_centroids_y y coordinates of all global points
+  /// \param subset_owners the processor that should own each global point
+  /// \param correlation_params pointer to the parameters used for the correlation
+  Decomp(const int_t num_global_subsets,
+    Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+    Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+    Teuchos::RCP<std::vector<int_t> > subset_owners,
+    const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
+
   /// destructor
   ~Decomp(){};
 
@@ -144,11 +158,13 @@ private:
   /// \param neighbor_ids the neighbors in global ids to use for initialization of the solution if neighbor values are used
   /// \param obstructing_subset_ids obstructions listed for each subset if necessary
   /// \param correlation_params pointer to the parameters used for the correlation
+  /// \param subset_owners optional processor that should own each global point (only used on processor 0)
   void initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
     const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
     Teuchos::RCP<std::vector<int_t> > & neighbor_ids,
     Teuchos::RCP<std::map<int_t,std::vector<int_t> > > obstructing_subset_ids,
-    const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
+    const Teuchos::RCP<Teuchos::ParameterList> & correlation_params,
+    Teuchos::RCP<std::vector<int_t> > subset_owners=Teuchos::null);
 
   /// populate the coordinate vectors
   /// note: all other procs besides proc 0 get an empty vector for coords_x and coords_y
@@ -167,6 +183,17 @@ private:
     Teuchos::RCP<std::vector<int_t> > & neighbor_ids,
     Teuchos::RCP<std::map<int_t,std::vector<int_t> > > & obstructing_subset_ids);
 
+  /// redo the decomposition so that each processor owns a spatially compact group of points
+  /// (only processor 0 needs the coordinates, the other processors can pass empty vectors)
+  /// \param subset_centroids_x x coordinates of all global points
+  /// \param subset_centroids_y y coordinates of all global points
+  /// \param correlation_params correlation parameters from xml file (used to determine the partition method)
+  /// \param subset_owners if not null, the processor that should own each global point (overrides the partition method)
+  void create_spatial_dist_map(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+    const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+    const Teuchos::RCP<Teuchos::ParameterList> & correlation_params,
+    Teuchos::RCP<std::vector<int_t> > subset_owners=Teuchos::null);
+
   /// redo the ordering and decomposition of points if there are obstructions involved
   /// \param obstructing_subset_ids map giving the obstructions for each subset
   void create_obstruction_dist_map( Teuchos::RCP<std::map<int_t,std::vector<int_t> > > & obstructing_subset_ids);
@@ -233,6 +260,8 @@ void create_regular_grid_of_correlation_points(std::vector<scalar_t> & correlati
 /// \param excluded_coords Set of coordinates that should be excluded
 /// \param pointer to an image to use for checking SSSIG
 /// \param grad_threshold the SSSIG threshold to eliminate a subset without enough gradients to correlate
+/// \param sssig_table optional summed area table of the squared gradient magnitude of the image,
+/// if provided the SSSIG is a constant time lookup rather than a sum over the subset pixels
 DICE_LIB_DLL_EXPORT
 bool valid_correlation_point(const int_t x_coord,
   const int_t y_coord,
@@ -242,8 +271,56 @@ bool valid_correlation_point(const int_t x_coord,
   std::set<std::pair<int_t,int_t> > & coords,
   std::set<std::pair<int_t,int_t> > & excluded_coords,
   Teuchos::RCP<DICe::Image> image=Teuchos::null,
-  const scalar_t & grad_threshold=0.0);
+  const scalar_t & grad_threshold=0.0,
+  Teuchos::RCP<DICe::Summed_Area_Table> sssig_table=Teuchos::null);
+
+/// \brief Flag the points that are within a given distance of any of a set of query points
+///
+/// The points are bucketed in a uniform grid with cells the size of the radius so only the
+/// points in the neighboring cells of each query point have to be checked.
+/// \param coords_x x coordinates of the points
+/// \param coords_y y coordinates of the points
+/// \param is_query_point true for the points whose neighborhoods should be found
+/// \param radius_2 the square of the search radius
+/// \param in_neighborhood output true if the point is a query point or is within the radius of one
+DICE_LIB_DLL_EXPORT
+void find_points_within_radius(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const std::vector<bool> & is_query_point,
+  const scalar_t & radius_2,
+  std::vector<bool> & in_neighborhood);
+
+/// \brief Split a set of points into groups by recursive coordinate bisection
+///
+/// The points are split along the longer side of their bounding box. The number of points
+/// on each side of the cut is proportional to the number of parts on that side so the
+/// number of parts does not have to be a power of two.
+/// If weights are given, the cuts balance the sum of the weights rather than the number of points.
+/// \param coords_x x coordinates of the points
+/// \param coords_y y coordinates of the points
+/// \param num_parts number of groups to split the points into
+/// \param part_ids output group id for each point
+/// \param weights optional weight (cost) of each point
+DICE_LIB_DLL_EXPORT
+void partition_points_rcb(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const int_t num_parts,
+  std::vector<int_t> & part_ids,
+  const std::vector<scalar_t> & weights=std::vector<scalar_t>());
 
+/// \brief Split a set of points into groups of contiguous points along a Hilbert curve
+///
+/// The points are sorted by their position along a Hilbert curve that covers the
+/// bounding box of the points and the sorted list is cut into groups of equal size.
+/// \param coords_x x coordinates of the points
+/// \param coords_y y coordinates of the points
+/// \param num_parts number of groups to split the points into
+/// \param part_ids output group id for each point
+DICE_LIB_DLL_EXPORT
+void partition_points_hilbert(const Teuchos::ArrayRCP<scalar_t> coords_x,
+  const Teuchos::ArrayRCP<scalar_t> coords_y,
+  const int_t num_parts,
+  std::vector<int_t> & part_ids);
 
 }// End DICe Namespace
 
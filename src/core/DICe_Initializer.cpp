@@ -53,6 +53,8 @@
 #include <fstream>
 #include <math.h>
 #include <cassert>
+#include <limits>
+#include <algorithm>
 
 #include <Teuchos_TimeMonitor.hpp>
 
@@ -291,10 +293,159 @@ void
 Phase_Correlation_Initializer::pre_execution_tasks(){
   assert(schema_->prev_img()!=Teuchos::null);
   assert(schema_->def_img()!=Teuchos::null);
-  DICe::phase_correlate_x_y(schema_->prev_img(),schema_->def_img(),phase_cor_u_x_,phase_cor_u_y_);
+  // the images are padded to a size with only small prime factors to keep the transforms fast
+  DICe::phase_correlate_x_y(schema_->prev_img(),schema_->def_img(),phase_cor_u_x_,phase_cor_u_y_,false,true);
   DEBUG_MSG("Phase_Correlation_Initializer::pre_execution_tasks(): initial displacements ux: " << phase_cor_u_x_ << " uy: " << phase_cor_u_y_);
 }
 
+Subset_Phase_Correlation_Initializer::Subset_Phase_Correlation_Initializer(Schema * schema,
+  const int_t window_size):
+  Initializer(schema),
+  window_size_(0)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(window_size<8,std::invalid_argument,"Error, the phase correlation window size must be at least 8 pixels");
+  // round up to an even size with only small prime factors so the real transform can be used
+  window_size_ = fft_good_size(window_size);
+  while(window_size_%2!=0)
+    window_size_ = fft_good_size(window_size_+1);
+  DEBUG_MSG("Subset_Phase_Correlation_Initializer(): window size " << window_size_);
+}
+
+void
+Subset_Phase_Correlation_Initializer::pre_execution_tasks(){
+  assert(schema_->prev_img()!=Teuchos::null);
+  assert(schema_->def_img()!=Teuchos::null);
+  const int_t num_subsets = schema_->local_num_subsets();
+  phase_cor_u_x_.assign(num_subsets,0.0);
+  phase_cor_u_y_.assign(num_subsets,0.0);
+  peak_.assign(num_subsets,0.0);
+  if(num_subsets==0) return;
+
+  Teuchos::RCP<Teuchos::Time> phase_cor_time  = Teuchos::TimeMonitor::getNewCounter("subset phase correlation");
+  Teuchos::TimeMonitor phase_cor_time_monitor(*phase_cor_time);
+
+  const int_t w = window_size_;
+  const int_t half_w = w/2;
+  const int_t num_window_pixels = w*w;
+  // the windows are centered on the current location of each subset in the previous frame
+  std::vector<int_t> origin_x(num_subsets,0);
+  std::vector<int_t> origin_y(num_subsets,0);
+  for(int_t i=0;i<num_subsets;++i){
+    const scalar_t x = schema_->local_field_value(i,SUBSET_COORDINATES_X_FS) + schema_->local_field_value(i,SUBSET_DISPLACEMENT_X_FS);
+    const scalar_t y = schema_->local_field_value(i,SUBSET_COORDINATES_Y_FS) + schema_->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS);
+    origin_x[i] = (int_t)std::floor(x + 0.5) - half_w;
+    origin_y[i] = (int_t)std::floor(y + 0.5) - half_w;
+  }
+  // hann window to taper the edges of the correlation windows
+  std::vector<scalar_t> taper(w,0.0);
+  for(int_t i=0;i<w;++i)
+    taper[i] = 0.5 - 0.5*std::cos(DICE_TWOPI*i/(w-1));
+  // one set of plans shared by all the windows (requested here since the plan cache is not thread safe)
+  const FFT_Plan * forward_plan = fft_plan(w,w,0).get();
+  const FFT_Plan * inverse_plan = fft_plan(w,w,1).get();
+  Image * images[2] = {schema_->prev_img().get(),schema_->def_img().get()};
+
+#pragma omp parallel
+  {
+    std::vector<scalar_t> window(num_window_pixels,0.0);
+    std::vector<scalar_t> a_r(num_window_pixels,0.0), a_i(num_window_pixels,0.0);
+    std::vector<scalar_t> b_r(num_window_pixels,0.0), b_i(num_window_pixels,0.0);
+#pragma omp for schedule(dynamic)
+    for(int_t subset=0;subset<num_subsets;++subset){
+      // transform the window from each image (mean removed and tapered)
+      for(int_t img=0;img<2;++img){
+        const Image & image = *images[img];
+        const int_t ox = origin_x[subset] - image.offset_x();
+        const int_t oy = origin_y[subset] - image.offset_y();
+        scalar_t mean = 0.0;
+        int_t num_in_image = 0;
+        for(int_t y=std::max(0,-oy);y<std::min(w,image.height()-oy);++y){
+          for(int_t x=std::max(0,-ox);x<std::min(w,image.width()-ox);++x){
+            mean += image(ox+x,oy+y);
+            num_in_image++;
+          }
+        }
+        mean /= num_in_image==0 ? 1.0 : num_in_image;
+        for(int_t y=0;y<w;++y){
+          for(int_t x=0;x<w;++x){
+            const bool in_image = ox+x>=0 && ox+x<image.width() && oy+y>=0 && oy+y<image.height();
+            window[y*w+x] = in_image ? (image(ox+x,oy+y) - mean)*taper[x]*taper[y] : 0.0;
+          }
+        }
+        if(img==0)
+          forward_plan->transform_real(&window[0],&a_r[0],&a_i[0]);
+        else
+          forward_plan->transform_real(&window[0],&b_r[0],&b_i[0]);
+      }
+      // normalized cross-power spectrum A .* conj(B) / abs(A .* conj(B)) (stored in A)
+      scalar_t FFTR_r = 0.0, FFTR_i = 0.0, FFTR_abs = 0.0;
+      for(int_t i=0;i<num_window_pixels;++i){
+        complex_multiply(FFTR_r,FFTR_i,a_r[i],a_i[i],b_r[i],-b_i[i]);
+        complex_abs(FFTR_abs,FFTR_r,FFTR_i);
+        a_r[i] = FFTR_abs==0.0 ? 0.0 : FFTR_r/FFTR_abs;
+        a_i[i] = FFTR_abs==0.0 ? 0.0 : FFTR_i/FFTR_abs;
+      }
+      inverse_plan->transform(&a_r[0],&a_i[0]);
+      // locate the peak of the correlation surface
+      int_t peak_x = 0;
+      int_t peak_y = 0;
+      scalar_t peak = a_r[0];
+      for(int_t i=1;i<num_window_pixels;++i){
+        if(a_r[i]>peak){
+          peak = a_r[i];
+          peak_x = i%w;
+          peak_y = i/w;
+        }
+      }
+      // sub-pixel location of the peak from the ratio of the larger neighbor to the peak value (the surface is periodic),
+      // see H. Foroosh et al., Extension of Phase Correlation to Subpixel Registration, IEEE Trans. Image Proc., 11(3), 2002
+      const scalar_t c_0 = peak;
+      const scalar_t c_left = std::max((scalar_t)0.0,a_r[peak_y*w+(peak_x+w-1)%w]);
+      const scalar_t c_right = std::max((scalar_t)0.0,a_r[peak_y*w+(peak_x+1)%w]);
+      const scalar_t c_up = std::max((scalar_t)0.0,a_r[((peak_y+w-1)%w)*w+peak_x]);
+      const scalar_t c_down = std::max((scalar_t)0.0,a_r[((peak_y+1)%w)*w+peak_x]);
+      scalar_t delta_x = 0.0;
+      scalar_t delta_y = 0.0;
+      if(c_0>0.0){
+        delta_x = c_right > c_left ? c_right/(c_right+c_0) : -c_left/(c_left+c_0);
+        delta_y = c_down > c_up ? c_down/(c_down+c_0) : -c_up/(c_up+c_0);
+      }
+      // the peak sits at minus the displacement (wrapped to the window)
+      scalar_t shift_x = peak_x + delta_x;
+      scalar_t shift_y = peak_y + delta_y;
+      if(shift_x > half_w) shift_x -= w;
+      if(shift_y > half_w) shift_y -= w;
+      phase_cor_u_x_[subset] = -shift_x;
+      phase_cor_u_y_[subset] = -shift_y;
+      peak_[subset] = peak/num_window_pixels;
+    } // end subset loop
+  } // end parallel region
+  DEBUG_MSG("Subset_Phase_Correlation_Initializer::pre_execution_tasks(): correlated " << num_subsets << " subsets");
+}
+
+Status_Flag
+Subset_Phase_Correlation_Initializer::initial_guess(const int_t subset_gid,
+  Teuchos::RCP<Local_Shape_Function> shape_function){
+  const int_t subset_lid = schema_->subset_local_id(subset_gid);
+  TEUCHOS_TEST_FOR_EXCEPTION(subset_lid<0||subset_lid>=(int_t)peak_.size(),std::runtime_error,
+    "Error, subset phase correlation has not been computed for subset " << subset_gid);
+  // the correlation of windows with no common content is on the order of 1/window_size, if the peak
+  // is not well above that, don't trust the increment and use the current field values
+  const scalar_t min_peak = 4.0/window_size_;
+  scalar_t u_x = 0.0;
+  scalar_t u_y = 0.0;
+  if(peak_[subset_lid] >= min_peak){
+    u_x = phase_cor_u_x_[subset_lid];
+    u_y = phase_cor_u_y_[subset_lid];
+  }
+  DEBUG_MSG("Subset_Phase_Correlation_Initializer::initial_guess(): subset " << subset_gid << " increment ux: " << u_x <<
+    " uy: " << u_y << " peak: " << peak_[subset_lid]);
+  shape_function->insert_motion(u_x + schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_X_FS),
+    u_y + schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_Y_FS),
+    schema_->global_field_value(subset_gid,ROTATION_Z_FS));
+  return INITIALIZE_SUCCESSFUL;
+};
+
 Status_Flag
 Search_Initializer::initial_guess(const int_t subset_gid,
   Teuchos::RCP<Local_Shape_Function> shape_function){
@@ -407,7 +558,28 @@ Feature_Matching_Initializer::pre_execution_tasks(){
   if(first_call_){
     prev_img_ = schema_->ref_img();
   }
-  // read both images and match features between them
+  // restrict the feature detection to the region around the subsets owned by this processor
+  scalar_t min_x = std::numeric_limits<scalar_t>::max();
+  scalar_t max_x = std::numeric_limits<scalar_t>::lowest();
+  scalar_t min_y = std::numeric_limits<scalar_t>::max();
+  scalar_t max_y = std::numeric_limits<scalar_t>::lowest();
+  for(int_t i=0;i<schema_->local_num_subsets();++i){
+    const int_t gid = schema_->subset_global_id(i);
+    const scalar_t x = schema_->global_field_value(gid,SUBSET_COORDINATES_X_FS) + schema_->global_field_value(gid,SUBSET_DISPLACEMENT_X_FS);
+    const scalar_t y = schema_->global_field_value(gid,SUBSET_COORDINATES_Y_FS) + schema_->global_field_value(gid,SUBSET_DISPLACEMENT_Y_FS);
+    min_x = std::min(min_x,x);
+    max_x = std::max(max_x,x);
+    min_y = std::min(min_y,y);
+    max_y = std::max(max_y,y);
+  }
+  Extents roi(0,0,-1,-1); // whole image
+  if(schema_->local_num_subsets()>0){
+    // buffer to allow for the motion between frames and the size of the subsets
+    const int_t buffer = std::max(100,2*schema_->subset_dim());
+    roi = Extents((int_t)min_x - buffer,(int_t)min_y - buffer,(int_t)(max_x - min_x) + 2*buffer,(int_t)(max_y - min_y) + 2*buffer);
+  }
+  // features for approximate matching instead of brute force
+  const int_t approximate_threshold = 5000;
   std::vector<scalar_t> left_x;
   std::vector<scalar_t> left_y;
   std::vector<scalar_t> right_x;
@@ -415,17 +587,22 @@ Feature_Matching_Initializer::pre_execution_tasks(){
   Teuchos::RCP<Teuchos::Time> match_time  = Teuchos::TimeMonitor::getNewCounter("match features");
   {
     Teuchos::TimeMonitor match_time_monitor(*match_time);
-    const float tol = 0.005f;
-    std::stringstream outname;
-    outname << "fm_initializer_" << schema_->mesh()->get_comm()->get_rank() << ".png";
-    match_features(prev_img_,schema_->def_img(0),left_x,left_y,right_x,right_y,tol,outname.str());
+    // the previous image features are reused from the last call if they were detected with the same tolerance
+    if(prev_features_.empty()||prev_features_.feature_tol_!=feature_tol_)
+      detect_features(prev_img_,prev_features_,feature_tol_,roi);
+    detect_features(schema_->def_img(0),def_features_,feature_tol_,roi);
+    match_features(prev_features_,def_features_,left_x,left_y,right_x,right_y,approximate_threshold);
     int_t num_matches = left_x.size();
     DEBUG_MSG("number of features matched: " << num_matches);
     // test if not enough features were found, if so try a tighter tolerance
-    if(num_matches < 50){
+    // (the tighter tolerance is kept for the following frames)
+    const float tight_tol = 0.001f;
+    if(num_matches < 50 && feature_tol_ > tight_tol){
       DEBUG_MSG("did not find enough features, attempting again with tighter tolerance");
-      const float tight_tol = 0.001f;
-      match_features(prev_img_,schema_->def_img(0),left_x,left_y,right_x,right_y,tight_tol,outname.str());
+      feature_tol_ = tight_tol;
+      detect_features(prev_img_,prev_features_,feature_tol_,roi);
+      detect_features(schema_->def_img(0),def_features_,feature_tol_,roi);
+      match_features(prev_features_,def_features_,left_x,left_y,right_x,right_y,approximate_threshold);
       num_matches = left_x.size();
     }
     TEUCHOS_TEST_FOR_EXCEPTION(num_matches < 10,std::runtime_error,"Error, not enough features matched for feature matching initializer");
@@ -447,6 +624,8 @@ Feature_Matching_Initializer::pre_execution_tasks(){
     v_[i] = right_y[i] - left_y[i];
   }
   prev_img_ = schema_->def_img(0);
+  // the current image features become the previous image features for the next frame
+  std::swap(prev_features_,def_features_);
   first_call_ = false;
 }
 
@@ -549,15 +728,21 @@ Image_Registration_Initializer::pre_execution_tasks(){
   assert(schema_->def_img()!=Teuchos::null);
   DEBUG_MSG("Image_Registration_Initializer::pre_execution_tasks(): prev image: " << prev_img_->file_name());
   DEBUG_MSG("Image_Registration_Initializer::pre_execution_tasks(): def image: " << schema_->def_img()->file_name());
-  TEUCHOS_TEST_FOR_EXCEPTION(!prev_img_->has_file_name(),std::runtime_error,"error, image registration initializer requires the images to have file names");
-  TEUCHOS_TEST_FOR_EXCEPTION(!schema_->def_img()->has_file_name(),std::runtime_error,"error, image registration initializer requires the images to have file names");
-  cv::Mat temp = cv::imread(schema_->def_img()->file_name(), cv::ImreadModes::IMREAD_GRAYSCALE);
-  cv::Mat target = cv::imread(prev_img_->file_name(), cv::ImreadModes::IMREAD_GRAYSCALE);
+  // register the intensities already held in memory rather than re-reading the image files
+  // (for float intensities at full resolution these Mats are views of the image arrays)
+  const int_t pyramid_level = schema_->image_registration_pyramid_level();
+  DEBUG_MSG("Image_Registration_Initializer::pre_execution_tasks(): pyramid level: " << pyramid_level);
+  cv::Mat temp = opencv_32FC1(schema_->def_img(),pyramid_level);
+  cv::Mat target = opencv_32FC1(prev_img_,pyramid_level);
   int_t num_its = 500;
   scalar_t term_eps = 1E-8;
   cv::Mat warp =  cv::Mat::eye(2, 3, CV_32F);
   findTransformECC (temp,target,warp,cv::MOTION_EUCLIDEAN,
     cv::TermCriteria (cv::TermCriteria::COUNT+cv::TermCriteria::EPS,num_its, term_eps));
+  // the rotation is scale invariant, but the translation needs to be scaled back to full resolution
+  const float scale = (float)(1 << pyramid_level);
+  warp.at<float>(0,2) *= scale;
+  warp.at<float>(1,2) *= scale;
   // convert the 2x3 warp to a square matrix for inversion
   ecc_transform_ = cv::Mat::eye(3, 3, CV_32F);
   for(int_t i=0;i<warp.rows;++i){
@@ -566,6 +751,12 @@ Image_Registration_Initializer::pre_execution_tasks(){
     }
   }
   ecc_transform_ = ecc_transform_.inv();
+  // the registration is in local image coordinates, shift the translation so that the
+  // transform maps global coordinates in the previous image to global coordinates in the deformed image
+  const float prev_ox = prev_img_->offset_x();
+  const float prev_oy = prev_img_->offset_y();
+  ecc_transform_.at<float>(0,2) += schema_->def_img()->offset_x() - ecc_transform_.at<float>(0,0)*prev_ox - ecc_transform_.at<float>(0,1)*prev_oy;
+  ecc_transform_.at<float>(1,2) += schema_->def_img()->offset_y() - ecc_transform_.at<float>(1,0)*prev_ox - ecc_transform_.at<float>(1,1)*prev_oy;
   //  std::cout << ecc_transform_ << std::endl;
   theta_ = -1.0*std::asin(ecc_transform_.at<float>(0,1));
   prev_img_ = schema_->def_img(0);
@@ -1052,13 +1243,50 @@ Optical_Flow_Initializer::initial_guess(const int_t subset_gid,
   return INITIALIZE_SUCCESSFUL;
 };
 
+/// sum of squared differences of two rows of pixels, the four partial sums
+/// are independent so the loop can be vectorized
+inline scalar_t
+row_sum_of_squared_diffs(const intensity_t * lhs,
+  const intensity_t * rhs,
+  const int_t num_pixels){
+  scalar_t sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+  int_t i = 0;
+  for(;i+3<num_pixels;i+=4){
+    const scalar_t d0 = lhs[i] - rhs[i];
+    const scalar_t d1 = lhs[i+1] - rhs[i+1];
+    const scalar_t d2 = lhs[i+2] - rhs[i+2];
+    const scalar_t d3 = lhs[i+3] - rhs[i+3];
+    sum0 += d0*d0;
+    sum1 += d1*d1;
+    sum2 += d2*d2;
+    sum3 += d3*d3;
+  }
+  for(;i<num_pixels;++i){
+    const scalar_t d = lhs[i] - rhs[i];
+    sum0 += d*d;
+  }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
 Motion_Test_Utility::Motion_Test_Utility(Schema * schema,
-  const scalar_t & tol):
+  const scalar_t & tol,
+  const int_t start_x,
+  const int_t start_y,
+  const int_t end_x,
+  const int_t end_y,
+  const int_t decimation):
   schema_(schema),
   tol_(tol),
+  decimation_(decimation),
   motion_state_(MOTION_NOT_SET)
 {
-  DEBUG_MSG("Constructor for Motion_Test_Utility called, tol: " << tol_);
+  TEUCHOS_TEST_FOR_EXCEPTION(decimation_<1,std::runtime_error,"Error, invalid motion test decimation " << decimation_);
+  extents_[0] = start_x;
+  extents_[1] = end_x;
+  extents_[2] = start_y;
+  extents_[3] = end_y;
+  DEBUG_MSG("Constructor for Motion_Test_Utility called, tol: " << tol_ << " window x: " << start_x << " to " << end_x <<
+    " y: " << start_y << " to " << end_y << " decimation: " << decimation_);
 }
 
 bool
@@ -1075,22 +1303,57 @@ Motion_Test_Utility::motion_detected(const int_t sub_image_id){
     return motion_state_==MOTION_TRUE ? true: false;
   }
   else{
+    Teuchos::RCP<Image> def_img = schema_->def_img(sub_image_id);
+    Teuchos::RCP<Image> prev_img = schema_->prev_img(sub_image_id);
     // make sure that the images are gauss filtered:
-    TEUCHOS_TEST_FOR_EXCEPTION(!schema_->def_img(sub_image_id)->has_gauss_filter(),std::runtime_error,
+    TEUCHOS_TEST_FOR_EXCEPTION(!def_img->has_gauss_filter(),std::runtime_error,
       "Error, Gauss filtering required for using motion windows, but gauss filtering is not enabled in the input.");
-    const int_t half_mask = schema_->def_img(sub_image_id)->gauss_filter_mask_size()/2;
-    const int_t w = schema_->def_img(sub_image_id)->width();
-    const int_t h = schema_->def_img(sub_image_id)->height();
+    TEUCHOS_TEST_FOR_EXCEPTION(prev_img->width()!=def_img->width()||prev_img->height()!=def_img->height(),std::runtime_error,
+      "Error, the previous and deformed motion window images must have the same dimensions");
+    const int_t half_mask = def_img->gauss_filter_mask_size()/2;
+    const int_t w = def_img->width();
+    const int_t h = def_img->height();
     DEBUG_MSG("Motion_Test_Utility::motion_detected(): motion window sub_image_id " << sub_image_id << " width " << w << " height " << h);
+    // skip the outer edges since they are not filtered and restrict the diff to the motion window
+    int_t x_begin = half_mask+1;
+    int_t x_end = w-(half_mask+1);
+    int_t y_begin = half_mask+1;
+    int_t y_end = h-(half_mask+1);
+    if(extents_[1]>extents_[0]&&extents_[3]>extents_[2]){
+      x_begin = std::max(x_begin,extents_[0] - def_img->offset_x());
+      x_end = std::min(x_end,extents_[1] - def_img->offset_x() + 1);
+      y_begin = std::max(y_begin,extents_[2] - def_img->offset_y());
+      y_end = std::min(y_end,extents_[3] - def_img->offset_y() + 1);
+    }
+    // the auto tolerance is based on the full diff, otherwise stop as soon as the tolerance is exceeded
+    const bool early_exit = tol_!=-1.0;
+    // the diff is scaled by the decimation so that the tolerance does not depend on it
+    const scalar_t scale = decimation_*decimation_;
+    const scalar_t tol_squared = tol_*tol_/scale;
     //diff the two images and see if the difference is above the user requested tolerance
     scalar_t diff = 0.0;
-    // skip the outer edges since they are not filtered
-    for(int_t y=half_mask+1;y<h-(half_mask+1);++y){
-      for(int_t x=half_mask+1;x<w-(half_mask+1);++x){
-        diff += ((*schema_->def_img(sub_image_id))(x,y) - (*schema_->prev_img(sub_image_id))(x,y))*((*schema_->def_img(sub_image_id))(x,y) - (*schema_->prev_img(sub_image_id))(x,y));
+    if(x_end>x_begin&&y_end>y_begin){
+      // the intensity arrays are stored row major
+      Teuchos::ArrayRCP<intensity_t> def_intensities = def_img->intensities();
+      Teuchos::ArrayRCP<intensity_t> prev_intensities = prev_img->intensities();
+      for(int_t y=y_begin;y<y_end;y+=decimation_){
+        if(decimation_==1){
+          diff += row_sum_of_squared_diffs(def_intensities.getRawPtr()+y*w+x_begin,
+            prev_intensities.getRawPtr()+y*w+x_begin,x_end-x_begin);
+        }
+        else{
+          for(int_t x=x_begin;x<x_end;x+=decimation_){
+            const scalar_t d = def_intensities[y*w+x] - prev_intensities[y*w+x];
+            diff += d*d;
+          }
+        }
+        if(early_exit&&diff>tol_squared){
+          DEBUG_MSG("Motion_Test_Utility::motion_detected() tolerance exceeded at row " << y);
+          break;
+        }
       }
     }
-    diff = std::sqrt(diff);
+    diff = std::sqrt(diff*scale);
     DEBUG_MSG("Motion_Test_Utility::motion_detected() called, img diff: " << diff << " initial tol: " << tol_);
     if(tol_==-1.0&&diff!=0.0){ // user has not set a tolerance manually
       tol_ = diff + 5.0;
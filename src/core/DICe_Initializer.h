@@ -47,6 +47,7 @@
 #include <DICe_Subset.h>
 #include <DICe_PointCloud.h>
 #include <DICe_LocalShapeFunction.h>
+#include <DICe_Feature.h>
 
 #include <Teuchos_RCP.hpp>
 
@@ -283,6 +284,53 @@ protected:
   scalar_t phase_cor_u_y_;
 };
 
+/// \class DICe::Subset_Phase_Correlation_Initializer
+/// \brief A class that computes the phase correlation of a window around each subset
+/// to get the initial values of displacement in x and y for each subset individually.
+///
+/// The window is centered on the current (deformed) location of the subset in the previous
+/// frame and the same window is taken from the current frame. The peak of the normalized
+/// cross-power spectrum gives the incremental displacement, refined to sub-pixel accuracy using
+/// the values next to the peak. All the subsets are correlated at once in
+/// pre_execution_tasks() (threaded, with one transform plan shared by all the windows).
+/// Displacements of up to half the window size per frame can be captured. If the correlation
+/// peak for a subset is not distinct the current field values are used instead.
+class DICE_LIB_DLL_EXPORT
+Subset_Phase_Correlation_Initializer : public Initializer{
+public:
+
+  /// constructor
+  /// \param schema the parent schema
+  /// \param window_size the size of the square window to correlate (rounded up to a fast transform size)
+  Subset_Phase_Correlation_Initializer(Schema * schema,
+    const int_t window_size);
+
+  /// virtual destructor
+  virtual ~Subset_Phase_Correlation_Initializer(){};
+
+  /// see base class description
+  virtual void pre_execution_tasks();
+
+  /// see base class description
+  virtual Status_Flag initial_guess(const int_t subset_gid,
+    Teuchos::RCP<Local_Shape_Function> shape_function);
+
+  /// returns the size of the correlation window
+  int_t window_size()const{
+    return window_size_;
+  }
+
+private:
+  /// size of the square correlation window
+  int_t window_size_;
+  /// incremental displacement x for each local subset
+  std::vector<scalar_t> phase_cor_u_x_;
+  /// incremental displacement y for each local subset
+  std::vector<scalar_t> phase_cor_u_y_;
+  /// normalized height of the correlation peak for each local subset (between 0 and 1)
+  std::vector<scalar_t> peak_;
+};
+
 /// \class DICe::Search_Initializer
 /// \brief A class that searches a nearby neighborhood for the subset
 class DICE_LIB_DLL_EXPORT
@@ -376,6 +424,7 @@ public:
   Feature_Matching_Initializer(Schema * schema):
     Initializer(schema),
 //    prev_img_name_(""),
+    feature_tol_(0.005f),
     first_call_(true){};
 
   /// virtual destructor
@@ -401,6 +450,12 @@ protected:
   Teuchos::RCP<Image> prev_img_;
   /// previous image name (used if the images are constructed from file rather than array)
 //  std::string prev_img_name_;
+  /// features of the previous image (reused from the last call so each frame is only detected once)
+  Image_Features prev_features_;
+  /// features of the current deformed image
+  Image_Features def_features_;
+  /// AKAZE threshold, lowered if not enough features are matched
+  float feature_tol_;
   /// first time the pre execution tasks are called
   bool first_call_;
 };
@@ -603,8 +658,19 @@ public:
   /// constructor
   /// \param schema pointer to the schema that will be calling the motion test utility
   /// \param tol determines the threshold for the image diff to register motion
+  /// \param start_x global x coordinate of the upper left corner of the motion window
+  /// \param start_y global y coordinate of the upper left corner of the motion window
+  /// \param end_x global x coordinate of the lower right corner of the motion window
+  /// \param end_y global y coordinate of the lower right corner of the motion window
+  /// (if the end coordinates are not greater than the start coordinates the whole image is used)
+  /// \param decimation only every n-th row and column is used in the image diff
   Motion_Test_Utility(Schema * schema,
-    const scalar_t & tol);
+    const scalar_t & tol,
+    const int_t start_x=0,
+    const int_t start_y=0,
+    const int_t end_x=0,
+    const int_t end_y=0,
+    const int_t decimation=1);
 
   /// virtual destructor
   ~Motion_Test_Utility(){};
@@ -623,6 +689,10 @@ private:
   Schema * schema_;
   /// image diff tolerance (above this means motion is occurring)
   scalar_t tol_;
+  /// global coordinates of the motion window: start_x, end_x, start_y, end_y
+  int_t extents_[4];
+  /// only every n-th row and column is used in the image diff
+  int_t decimation_;
   /// keep a copy of the result incase another call is
   /// made for this initializer by another subset
   Motion_State motion_state_;
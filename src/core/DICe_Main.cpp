@@ -44,6 +44,7 @@
 #include <DICe_Image.h>
 #include <DICe_ImageIO.h>
 #include <DICe_Schema.h>
+#include <DICe_Profiler.h>
 #include <DICe_Triangulation.h>
 
 #include <fstream>
@@ -179,6 +180,18 @@ int main(int argc, char *argv[]) {
       if(separate_header_file){
         *outStream << "Execution information will be written to a separate file (not placed in the output headers)" << std::endl;
       }
+      const bool binary_output = input_params->get<bool>(DICe::write_binary_output_file,false);
+      const bool compress_binary_output = input_params->get<bool>(DICe::compress_binary_output_file,false);
+      if(binary_output){
+        *outStream << "Results will also be written to a binary output file" << (compress_binary_output ? " (compressed)" : "") << std::endl;
+      }
+
+      const int_t image_buffer_pool_size = input_params->get<int_t>(DICe::image_buffer_pool_size,0);
+      TEUCHOS_TEST_FOR_EXCEPTION(image_buffer_pool_size<0,std::runtime_error,"Error, image_buffer_pool_size must be >= 0");
+      if(image_buffer_pool_size>0){
+        *outStream << "Up to " << image_buffer_pool_size << " MB of image buffers will be kept for reuse" << std::endl;
+        Image_Buffer_Pool::instance().set_memory_budget(static_cast<size_t>(image_buffer_pool_size)*1024*1024);
+      }
 
       // create schemas:
       Teuchos::RCP<DICe::Schema> schema = Teuchos::rcp(new DICe::Schema(input_params,correlation_params));
@@ -272,6 +285,8 @@ int main(int argc, char *argv[]) {
       TEUCHOS_TEST_FOR_EXCEPTION(is_stereo&&triangulation==Teuchos::null,std::runtime_error,
         "Error, triangulation should be instantiated at this point");
 
+      // the reference image and cross correlation are profiled as frame 0
+      DICE_PROFILE_BEGIN_FRAME(0);
       // if this is a stereo analysis do the initial cross correlation:
       if(is_stereo){
         Teuchos::TimeMonitor cross_time_monitor(*cross_time);
@@ -306,6 +321,7 @@ int main(int argc, char *argv[]) {
 
       for(int_t image_it=1;image_it<=num_frames;++image_it){
         *outStream << "Processing frame: " << image_it << " of " << num_frames << ", " << image_files[image_it] << std::endl;
+        DICE_PROFILE_BEGIN_FRAME(image_it);
         if(schema->use_incremental_formulation()&&image_it>1){
           schema->set_ref_image(schema->def_img());
         }
@@ -338,6 +354,8 @@ int main(int argc, char *argv[]) {
         {
           Teuchos::TimeMonitor write_time_monitor(*write_time);
           schema->write_output(output_folder,file_prefix,separate_output_file_for_each_subset,separate_header_file,no_text_output);
+          if(binary_output)
+            schema->write_binary_output(output_folder,file_prefix,separate_output_file_for_each_subset,separate_header_file,compress_binary_output);
           schema->post_execution_tasks();
           // print the timing data with or without verbose flag
           if(input_params->get<bool>(DICe::print_stats,false)){
@@ -349,12 +367,27 @@ int main(int argc, char *argv[]) {
           if(is_stereo){
             if(input_params->get<bool>(DICe::output_stereo_files,false)){
               stereo_schema->write_output(output_folder,stereo_file_prefix,separate_output_file_for_each_subset,separate_header_file,no_text_output);
+              if(binary_output)
+                stereo_schema->write_binary_output(output_folder,stereo_file_prefix,separate_output_file_for_each_subset,separate_header_file,compress_binary_output);
             }
             stereo_schema->post_execution_tasks();
           }
         }
+        // move subsets among the processors if the load is out of balance
+        if(!is_stereo&&image_it<num_frames&&schema->rebalance_subsets()){
+          *outStream << "Subsets were redistributed among the processors after frame " << image_it << std::endl;
+          // the images have to be read again since the extents of the owned subsets changed
+          schema->update_extents();
+          if(schema->use_incremental_formulation())
+            schema->set_def_image(image_files[image_it]);
+          else
+            schema->set_ref_image(image_files[0]);
+        }
       } // image loop
 
+      schema->finalize_output();
+      if(is_stereo)
+        stereo_schema->finalize_output();
       schema->write_stats(output_folder,file_prefix);
       if(is_stereo)
         stereo_schema->write_stats(output_folder,stereo_file_prefix);
@@ -378,6 +411,12 @@ int main(int argc, char *argv[]) {
     ofs.close();
     if(proc_rank!=0) // only keep the process zero copy of the timing results
       std::remove(timeFileName.str().c_str());
+#ifdef DICE_ENABLE_PROFILING
+    // write the per frame and per subset profile trace (one per process)
+    std::stringstream profileFileName;
+    profileFileName << output_folder << "profile."<< proc_size << "." << proc_rank;
+    DICE_PROFILE_WRITE_TRACE(profileFileName.str());
+#endif
 
     DICe::finalize();
   }
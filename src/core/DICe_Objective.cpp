@@ -50,6 +50,11 @@
 #include <iomanip>
 
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace DICe {
 
@@ -57,23 +62,83 @@ using namespace field_enums;
 
 scalar_t
 Objective::gamma( Teuchos::RCP<Local_Shape_Function> shape_function) const {
+  return gamma(shape_function,subset_,schema_->def_img(subset_->sub_image_id()));
+}
+
+scalar_t
+Objective::gamma( Teuchos::RCP<Local_Shape_Function> shape_function,
+  Teuchos::RCP<Subset> subset,
+  Teuchos::RCP<Image> def_img) const {
   try{
-    subset_->initialize(schema_->def_img(subset_->sub_image_id()),DEF_INTENSITIES,shape_function,schema_->interpolation_method());
+    subset->initialize(def_img,DEF_INTENSITIES,shape_function,schema_->interpolation_method());
   }
   catch (std::logic_error & err) {
     return -1.0;
   }
-  scalar_t gamma = subset_->gamma();
+  scalar_t gamma = subset->gamma();
   if(schema_->normalize_gamma_with_active_pixels()){
     int_t num_active_pixels = 0;
-    for(int_t i=0;i<subset_->num_pixels();++i)
-      if(subset_->is_active(i)) num_active_pixels++;
+    for(int_t i=0;i<subset->num_pixels();++i)
+      if(subset->is_active(i)) num_active_pixels++;
     if(num_active_pixels > 0)
       gamma /= num_active_pixels==0.0?1.0:num_active_pixels;
   }
   return gamma;
 }
 
+void
+Objective::create_batch_workspace(Gamma_Batch_Workspace & workspace) const {
+  int_t num_threads = 1;
+#ifdef _OPENMP
+  TEUCHOS_TEST_FOR_EXCEPTION(omp_in_parallel(),std::runtime_error,
+    "Error, the batch workspace cannot be created inside a parallel region");
+  num_threads = omp_get_max_threads();
+#endif
+  // the copies are made here, serially, since the reference counts of the subset's arrays are not thread safe
+  Image * def_img = schema_->def_img(subset_->sub_image_id()).get();
+  workspace.subsets.resize(num_threads);
+  workspace.def_imgs.resize(num_threads);
+  workspace.shape_functions.resize(num_threads);
+  for(int_t i=0;i<num_threads;++i){
+    workspace.subsets[i] = subset_->clone();
+    workspace.def_imgs[i] = Teuchos::rcp(def_img,false);
+    workspace.shape_functions[i] = shape_function_factory(schema_);
+  }
+}
+
+void
+Objective::gamma_batch(const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & parameters,
+  const Gamma_Batch_Workspace & workspace,
+  std::vector<scalar_t> & gamma_values) const {
+  const int_t num_evaluations = parameters.size();
+  gamma_values.assign(num_evaluations,-1.0);
+  if(num_evaluations==0) return;
+  const int_t num_threads = workspace.subsets.size();
+  TEUCHOS_TEST_FOR_EXCEPTION(num_threads<=0||(int_t)workspace.def_imgs.size()!=num_threads||
+    (int_t)workspace.shape_functions.size()!=num_threads,std::runtime_error,"Error, invalid batch workspace");
+  const int_t num_params = workspace.shape_functions[0]->num_params();
+  for(int_t i=0;i<num_evaluations;++i){
+    TEUCHOS_TEST_FOR_EXCEPTION((int_t)parameters[i]->size()!=num_params,std::runtime_error,
+      "Error, the number of shape function parameters does not match");
+  }
+  // the threads only dereference the copies in the workspace, no RCPs are created or destroyed in the parallel region
+#pragma omp parallel num_threads(num_threads)
+  {
+    int_t thread_id = 0;
+#ifdef _OPENMP
+    thread_id = omp_get_thread_num();
+#endif
+    const Teuchos::RCP<Subset> & thread_subset = workspace.subsets[thread_id];
+    const Teuchos::RCP<Image> & thread_def_img = workspace.def_imgs[thread_id];
+    const Teuchos::RCP<Local_Shape_Function> & thread_shape_function = workspace.shape_functions[thread_id];
+#pragma omp for schedule(dynamic,1)
+    for(int_t i=0;i<num_evaluations;++i){
+      *thread_shape_function->parameters() = *parameters[i];
+      gamma_values[i] = gamma(thread_shape_function,thread_subset,thread_def_img);
+    }
+  }
+}
+
 scalar_t
 Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
   // for now return -1 for beta if affine shape functions are used
@@ -276,6 +341,137 @@ Objective::computeUncertaintyFields(Teuchos::RCP<Local_Shape_Function> shape_fun
 //  schema_->mesh()->get_field(DICe::field_enums::FIELD_10_FS)->global_value(correlation_point_global_id_) = std::sqrt(int_sub_r_approx);
 }
 
+Status_Flag
+Objective::computeUpdateCoarse(Teuchos::RCP<Local_Shape_Function> shape_function,
+  const int_t num_levels){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_levels<0,std::runtime_error,"Error, invalid number of pyramid levels " << num_levels);
+  if(num_levels==0||subset_->num_pixels()==0) return CORRELATION_SUCCESSFUL;
+  const scalar_t cx = subset_->centroid_x();
+  const scalar_t cy = subset_->centroid_y();
+  scalar_t u = 0.0,v = 0.0,t = 0.0;
+  shape_function->map_to_u_v_theta(cx,cy,u,v,t);
+  const scalar_t initial_u = u;
+  const scalar_t initial_v = v;
+  // the coarse levels use the bounding box of the subset
+  int_t min_x = subset_->x(0), max_x = subset_->x(0);
+  int_t min_y = subset_->y(0), max_y = subset_->y(0);
+  for(int_t i=1;i<subset_->num_pixels();++i){
+    min_x = std::min(min_x,subset_->x(i));
+    max_x = std::max(max_x,subset_->x(i));
+    min_y = std::min(min_y,subset_->y(i));
+    max_y = std::max(max_y,subset_->y(i));
+  }
+  const int_t max_its = 20;
+  const scalar_t tolerance = 0.01; // coarse pixels
+  Status_Flag status = CORRELATION_SUCCESSFUL;
+  std::vector<scalar_t> ref_x, ref_y, ref_values, def_values, def_grad_x, def_grad_y;
+  std::vector<bool> valid;
+  for(int_t level=num_levels;level>0;--level){
+    Teuchos::RCP<Image> ref_level;
+    Teuchos::RCP<Image> def_level;
+    try{
+      ref_level = schema_->ref_img()->pyramid_level(level);
+      def_level = schema_->def_img(subset_->sub_image_id())->pyramid_level(level);
+    }
+    catch(std::exception & e){
+      DEBUG_MSG("Subset " << correlation_point_global_id_ << " skipping pyramid level " << level << ": " << e.what());
+      continue;
+    }
+    const scalar_t scale = static_cast<scalar_t>(1 << level);
+    // gather the reference values for this level
+    ref_x.clear();
+    ref_y.clear();
+    ref_values.clear();
+    for(int_t y=static_cast<int_t>(std::floor(min_y/scale));y<=static_cast<int_t>(std::ceil(max_y/scale));++y){
+      const int_t ly = y - ref_level->offset_y();
+      if(ly<0||ly>=ref_level->height()) continue;
+      for(int_t x=static_cast<int_t>(std::floor(min_x/scale));x<=static_cast<int_t>(std::ceil(max_x/scale));++x){
+        const int_t lx = x - ref_level->offset_x();
+        if(lx<0||lx>=ref_level->width()) continue;
+        ref_x.push_back(x);
+        ref_y.push_back(y);
+        ref_values.push_back((*ref_level)(lx,ly));
+      }
+    }
+    const int_t num_points = ref_values.size();
+    if(num_points<9) continue;
+    def_values.resize(num_points);
+    def_grad_x.resize(num_points);
+    def_grad_y.resize(num_points);
+    valid.resize(num_points);
+    scalar_t level_u = u/scale;
+    scalar_t level_v = v/scale;
+    bool level_failed = false;
+    int_t it = 0;
+    for(;it<max_its;++it){
+      // interpolate the deformed level at the displaced reference points
+      int_t num_valid = 0;
+      scalar_t mean_f = 0.0, mean_g = 0.0;
+      for(int_t i=0;i<num_points;++i){
+        const scalar_t lx = ref_x[i] + level_u - def_level->offset_x();
+        const scalar_t ly = ref_y[i] + level_v - def_level->offset_y();
+        valid[i] = lx>=1.0&&lx<def_level->width()-2.0&&ly>=1.0&&ly<def_level->height()-2.0;
+        if(!valid[i]) continue;
+        def_values[i] = def_level->interpolate_bilinear(lx,ly);
+        def_grad_x[i] = def_level->interpolate_grad_x_bilinear(lx,ly);
+        def_grad_y[i] = def_level->interpolate_grad_y_bilinear(lx,ly);
+        mean_f += ref_values[i];
+        mean_g += def_values[i];
+        num_valid++;
+      }
+      if(num_valid<9||num_valid<num_points/2){
+        level_failed = true;
+        break;
+      }
+      mean_f /= num_valid;
+      mean_g /= num_valid;
+      scalar_t sum_ff = 0.0, sum_gg = 0.0;
+      for(int_t i=0;i<num_points;++i){
+        if(!valid[i]) continue;
+        sum_ff += (ref_values[i] - mean_f)*(ref_values[i] - mean_f);
+        sum_gg += (def_values[i] - mean_g)*(def_values[i] - mean_g);
+      }
+      if(sum_ff<=0.0||sum_gg<=0.0){
+        level_failed = true;
+        break;
+      }
+      // zero-normalized residual: the reference values are scaled to the contrast of the deformed values
+      const scalar_t norm_ratio = std::sqrt(sum_gg/sum_ff);
+      scalar_t H00 = 0.0, H01 = 0.0, H11 = 0.0, q0 = 0.0, q1 = 0.0;
+      for(int_t i=0;i<num_points;++i){
+        if(!valid[i]) continue;
+        const scalar_t GmF = (def_values[i] - mean_g) - norm_ratio*(ref_values[i] - mean_f);
+        H00 += def_grad_x[i]*def_grad_x[i];
+        H01 += def_grad_x[i]*def_grad_y[i];
+        H11 += def_grad_y[i]*def_grad_y[i];
+        q0 += GmF*def_grad_x[i];
+        q1 += GmF*def_grad_y[i];
+      }
+      const scalar_t det = H00*H11 - H01*H01;
+      if(det<=0.0){
+        level_failed = true;
+        break;
+      }
+      const scalar_t du = -(H11*q0 - H01*q1)/det;
+      const scalar_t dv = -(H00*q1 - H01*q0)/det;
+      level_u += du;
+      level_v += dv;
+      if(std::abs(du)<tolerance&&std::abs(dv)<tolerance) break;
+    }
+    if(level_failed){
+      DEBUG_MSG("Subset " << correlation_point_global_id_ << " coarse update failed at pyramid level " << level);
+      status = HESSIAN_SINGULAR;
+      continue;
+    }
+    u = level_u*scale;
+    v = level_v*scale;
+    DEBUG_MSG("Subset " << correlation_point_global_id_ << " pyramid level " << level << " iterations " << it <<
+      " u " << u << " v " << v);
+  }
+  shape_function->add_translation(u - initial_u,v - initial_v);
+  return status;
+}
+
 Status_Flag
 Objective::computeUpdateRobust(Teuchos::RCP<Local_Shape_Function> shape_function,
   int_t & num_iterations,
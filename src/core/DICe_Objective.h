@@ -54,6 +54,20 @@
 
 namespace DICe {
 
+/// \brief The per-thread copies of the subset, deformed image pointer and shape function used by DICe::Objective::gamma_batch()
+///
+/// The reference counts of Teuchos::RCP are not thread safe so the copies are created and released serially
+/// on the thread that owns the objective (see DICe::Objective::create_batch_workspace()), never inside a parallel region.
+struct DICE_LIB_DLL_EXPORT
+Gamma_Batch_Workspace{
+  /// one copy of the objective's subset per thread
+  std::vector<Teuchos::RCP<Subset> > subsets;
+  /// one non-owning pointer to the deformed image per thread
+  std::vector<Teuchos::RCP<Image> > def_imgs;
+  /// one shape function per thread
+  std::vector<Teuchos::RCP<Local_Shape_Function> > shape_functions;
+};
+
 /// \class DICe::Objective
 /// \brief A container class for the subsets, optimization algorithm and initialization routine used to correlate a single point
 ///
@@ -129,6 +143,24 @@ const int_t y):
   /// \param shape_function pointer to the class that holds the deformation parameter values
   scalar_t gamma( Teuchos::RCP<Local_Shape_Function> shape_function) const;
 
+  /// \brief Creates the per-thread copies used by gamma_batch(), one for each OpenMP thread (one if OpenMP is not enabled)
+  ///
+  /// Must be called outside of a parallel region. The workspace can be reused for any number of
+  /// batches with the same deformed image and should be released on the calling thread.
+  /// \param workspace [out] the per-thread copies
+  void create_batch_workspace(Gamma_Batch_Workspace & workspace) const;
+
+  /// \brief Correlation criteria for several sets of shape function parameters, evaluated in parallel if OpenMP is enabled
+  ///
+  /// Each thread evaluates its share of the parameter sets on its own copy of the subset from the workspace,
+  /// so the subset of this objective is not modified
+  /// \param parameters the shape function parameter values for each evaluation
+  /// \param workspace the per-thread copies from create_batch_workspace() (at most one thread per copy is used)
+  /// \param gamma_values [out] the gamma value for each set of parameters
+  void gamma_batch(const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & parameters,
+    const Gamma_Batch_Workspace & workspace,
+    std::vector<scalar_t> & gamma_values) const;
+
   /// \brief Uncertainty measure for solution
   /// \param shape_function [out] pointer to the class that holds the deformation parameter values
   /// \param noise_level [out] Returned as the standard deviation estimate of the image noise sigma_g from Sutton et.al.
@@ -145,6 +177,17 @@ const int_t y):
   virtual Status_Flag computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_function,
     int_t & num_iterations) = 0;
 
+  /// \brief Translation only gradient based update computed on the Gaussian pyramids of the images
+  /// (see DICe::Image::pyramid_level()), from the coarsest level to the finest, used to seed computeUpdateFast()
+  /// when the motion is larger than the gradient based method can recover at full resolution.
+  /// Each level minimizes the zero-normalized sum of squared differences with respect to the translation.
+  /// The remaining shape function parameters are not modified. If the update fails on any level
+  /// HESSIAN_SINGULAR is returned and the caller should discard the translation.
+  /// \param shape_function [in/out] pointer to the class that holds the deformation parameter values
+  /// \param num_levels number of pyramid levels to use (level n is downsampled by 2^n)
+  Status_Flag computeUpdateCoarse(Teuchos::RCP<Local_Shape_Function> shape_function,
+    const int_t num_levels);
+
   /// \brief Simplex based optimization algorithm
   /// \param shape_function pointer to the class that holds the deformation parameter values
   /// \param num_iterations [out] The number of interations a particular frame took to execute
@@ -181,6 +224,14 @@ const int_t y):
 
 protected:
 
+  /// \brief Correlation criteria evaluated using the given subset (see gamma())
+  /// \param shape_function pointer to the class that holds the deformation parameter values
+  /// \param subset the subset to use (this objective's subset or a copy of it)
+  /// \param def_img the deformed image
+  scalar_t gamma( Teuchos::RCP<Local_Shape_Function> shape_function,
+    Teuchos::RCP<Subset> subset,
+    Teuchos::RCP<Image> def_img) const;
+
   /// Computes the difference from the exact solution and associated fields
   /// \param shape_function pointer to the class that holds the deformation parameter values
   void computeUncertaintyFields(Teuchos::RCP<Local_Shape_Function> shape_function);
@@ -235,6 +235,17 @@ Initialization_Method string_to_initialization_method(std::string & in){
   return NO_SUCH_INITIALIZATION_METHOD; // prevent no return errors
 }
 DICE_LIB_DLL_EXPORT
+Subset_Partition_Method string_to_subset_partition_method(std::string & in){
+  // convert the string to uppercase
+  stringToUpper(in);
+  for(int_t i=0;i<MAX_SUBSET_PARTITION_METHOD;++i){
+    if(subsetPartitionMethodStrings[i]==in) return static_cast<Subset_Partition_Method>(i);
+  }
+  std::cout << "Error: Subset_Partition_Method " << in << " does not exist." << std::endl;
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"");
+  return NO_SUCH_SUBSET_PARTITION_METHOD; // prevent no return errors
+}
+DICE_LIB_DLL_EXPORT
 Optimization_Method string_to_optimization_method(std::string & in){
   // convert the string to uppercase
   stringToUpper(in);
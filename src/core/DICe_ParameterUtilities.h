@@ -127,6 +127,10 @@ Initialization_Method string_to_initialization_method(std::string & in);
 DICE_LIB_DLL_EXPORT
 Interpolation_Method string_to_interpolation_method(std::string & in);
 
+/// Convert a string to a DICe::Subset_Partition_Method
+DICE_LIB_DLL_EXPORT
+Subset_Partition_Method string_to_subset_partition_method(std::string & in);
+
 /// Convert a string to a DICe::Interpolation_Method
 DICE_LIB_DLL_EXPORT
 Gradient_Method string_to_gradient_method(std::string & in);
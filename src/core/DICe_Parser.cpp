@@ -53,6 +53,9 @@
 #include <iostream>
 #include <fstream>
 #include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <algorithm>
 #include <vector>
@@ -385,6 +388,10 @@ Teuchos::RCP<Teuchos::ParameterList> read_correlation_params(const std::string &
         diceParams->set(DICe::initialization_method,DICe::string_to_initialization_method(
           stringParams->get<std::string>(it->first)));
       }
+      else if(paramName == DICe::subset_partition_method){
+        diceParams->set(DICe::subset_partition_method,DICe::string_to_subset_partition_method(
+          stringParams->get<std::string>(it->first)));
+      }
       else{
         if(proc_rank==0) DEBUG_MSG("Not a string parameter that needs to be translated");
         diceParams->setEntry(it->first,it->second);
@@ -821,6 +828,12 @@ void generate_template_input_files(const std::string & file_prefix){
   write_xml_comment(inputFile,"Write a separate output file for each subset with all frames in that file (default is to write one file per frame with all subsets)");
   write_xml_bool_param(inputFile,DICe::create_separate_run_info_file,"false",false);
   write_xml_comment(inputFile,"Write a separate output file that has the header information rather than place it at the top of the output files");
+  write_xml_bool_param(inputFile,DICe::write_binary_output_file,"false",false);
+  write_xml_comment(inputFile,"Also write the results for all frames to one binary file per processor (use DICe_BinaryToText to convert it to the text layout)");
+  write_xml_bool_param(inputFile,DICe::compress_binary_output_file,"false",false);
+  write_xml_comment(inputFile,"Compress the columns of the binary output file");
+  write_xml_size_param(inputFile,DICe::image_buffer_pool_size,"0",false);
+  write_xml_comment(inputFile,"Size in MB of the image buffers that can be kept for reuse when images are replaced (for example the reference image in incremental or stereo runs)");
   write_xml_string_param(inputFile,DICe::subset_file,"<path>");
   write_xml_comment(inputFile,"Optional file to specify the coordinates of the subset centroids (cannot be used with step_size param)");
   write_xml_comment(inputFile,"The subset file should be space separated (no commas) with one integer value for the number of subsets on the first line");
@@ -1002,6 +1015,290 @@ bool is_number(const std::string& s)
   return !s.empty() && it == s.end();
 }
 
+DICE_LIB_DLL_EXPORT
+bool parse_number(const char * begin,
+  const char * end,
+  scalar_t & value){
+  // powers of ten that are exactly representable as a double
+  static const double exact_powers_of_ten[] = {1.0E0,1.0E1,1.0E2,1.0E3,1.0E4,1.0E5,1.0E6,1.0E7,1.0E8,1.0E9,1.0E10,
+    1.0E11,1.0E12,1.0E13,1.0E14,1.0E15,1.0E16,1.0E17,1.0E18,1.0E19,1.0E20,1.0E21,1.0E22};
+  const char * pos = begin;
+  if(pos==end) return false;
+  bool negative = false;
+  if(*pos=='+'||*pos=='-'){
+    negative = *pos=='-';
+    ++pos;
+  }
+  uint64_t mantissa = 0;
+  int_t num_significant_digits = 0;
+  int_t exponent = 0;
+  bool has_digits = false;
+  while(pos!=end&&*pos>='0'&&*pos<='9'){
+    has_digits = true;
+    if(num_significant_digits<19)
+      mantissa = mantissa*10 + (*pos-'0');
+    else
+      exponent++;
+    if(mantissa>0) num_significant_digits++;
+    ++pos;
+  }
+  if(pos!=end&&*pos=='.'){
+    ++pos;
+    while(pos!=end&&*pos>='0'&&*pos<='9'){
+      has_digits = true;
+      if(num_significant_digits<19){
+        mantissa = mantissa*10 + (*pos-'0');
+        exponent--;
+      }
+      if(mantissa>0) num_significant_digits++;
+      ++pos;
+    }
+  }
+  if(!has_digits) return false;
+  if(pos!=end&&(*pos=='e'||*pos=='E')){
+    ++pos;
+    bool negative_exponent = false;
+    if(pos!=end&&(*pos=='+'||*pos=='-')){
+      negative_exponent = *pos=='-';
+      ++pos;
+    }
+    if(pos==end) return false;
+    int_t exp_value = 0;
+    while(pos!=end&&*pos>='0'&&*pos<='9'){
+      if(exp_value<100000)
+        exp_value = exp_value*10 + (*pos-'0');
+      ++pos;
+    }
+    exponent += negative_exponent ? -exp_value : exp_value;
+  }
+  if(pos!=end) return false;
+  if(num_significant_digits<=15&&exponent>=-22&&exponent<=22){
+    // the mantissa and the power of ten are both exact so the result is correctly rounded
+    double result = static_cast<double>(mantissa);
+    if(exponent<0) result /= exact_powers_of_ten[-exponent];
+    else result *= exact_powers_of_ten[exponent];
+    value = negative ? -result : result;
+    return true;
+  }
+  const std::string str(begin,end);
+  value = strtod(str.c_str(),NULL);
+  return true;
+}
+
+Delimited_Text_Reader::Delimited_Text_Reader(const std::string & file_name,
+  const std::string & delimiters,
+  const bool skip_comment_lines,
+  const bool collapse_delimiters):
+  is_delimiter_(256,false),
+  collapse_delimiters_(collapse_delimiters){
+  for(size_t i=0;i<delimiters.size();++i)
+    is_delimiter_[static_cast<unsigned char>(delimiters[i])] = true;
+  is_delimiter_['\n'] = true;
+  // a carriage return at the end of a line would otherwise create an extra empty field
+  if(collapse_delimiters_)
+    is_delimiter_['\r'] = true;
+
+  // std::streamoff is 64 bit on all platforms (ftell returns a 32 bit long on Windows)
+  std::ifstream file(file_name.c_str(),std::ios_base::in|std::ios_base::binary|std::ios_base::ate);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file.good(),std::runtime_error,"Error reading file " << file_name);
+  const std::streamoff file_size = file.tellg();
+  TEUCHOS_TEST_FOR_EXCEPTION(file_size<0,std::runtime_error,"Error reading file " << file_name);
+  buffer_.resize(static_cast<size_t>(file_size));
+  file.seekg(0,std::ios_base::beg);
+  if(!buffer_.empty())
+    file.read(&buffer_[0],static_cast<std::streamsize>(buffer_.size()));
+  TEUCHOS_TEST_FOR_EXCEPTION(!file||file.gcount()!=static_cast<std::streamsize>(buffer_.size()),std::runtime_error,"Error reading file " << file_name);
+  file.close();
+
+  // index the lines, if comment lines are kept every line is kept (so blank header rows are counted too)
+  // except blank lines at the end of the file
+  const char * data = buffer_.empty() ? NULL : &buffer_[0];
+  size_t num_lines_with_values = 0;
+  size_t begin = 0;
+  while(begin<buffer_.size()){
+    const char * newline = static_cast<const char*>(memchr(data+begin,'\n',buffer_.size()-begin));
+    const size_t end = newline ? newline - data : buffer_.size();
+    const char * first_value = collapse_delimiters_ ? next_value(data+begin,data+end) : skip_spaces(data+begin,data+end);
+    const bool blank = first_value==data+end;
+    if(!skip_comment_lines||(!blank&&*first_value!=parser_comment_char[0])){
+      line_begin_.push_back(begin);
+      line_end_.push_back(end);
+      if(!blank) num_lines_with_values = line_begin_.size();
+    }
+    begin = end + 1;
+  }
+  line_begin_.resize(num_lines_with_values);
+  line_end_.resize(num_lines_with_values);
+  DEBUG_MSG("Delimited_Text_Reader::Delimited_Text_Reader(): " << file_name << " has " << num_lines() << " lines");
+}
+
+const char *
+Delimited_Text_Reader::next_value(const char * pos,
+  const char * line_end)const{
+  while(pos!=line_end&&is_delimiter_[static_cast<unsigned char>(*pos)]) ++pos;
+  return pos;
+}
+
+const char *
+Delimited_Text_Reader::value_end(const char * pos,
+  const char * line_end)const{
+  while(pos!=line_end&&!is_delimiter_[static_cast<unsigned char>(*pos)]) ++pos;
+  return pos;
+}
+
+bool
+Delimited_Text_Reader::is_space(const char c)const{
+  return (c==' '||c=='\t'||c=='\r')&&!is_delimiter_[static_cast<unsigned char>(c)];
+}
+
+const char *
+Delimited_Text_Reader::skip_spaces(const char * pos,
+  const char * line_end)const{
+  while(pos!=line_end&&is_space(*pos)) ++pos;
+  return pos;
+}
+
+const char *
+Delimited_Text_Reader::first_field(const int_t line)const{
+  const char * line_begin = &buffer_[0] + line_begin_[line];
+  const char * line_end = &buffer_[0] + line_end_[line];
+  // a blank line has no fields (rather than one empty field)
+  if(!collapse_delimiters_&&skip_spaces(line_begin,line_end)==line_end)
+    return NULL;
+  return line_begin;
+}
+
+bool
+Delimited_Text_Reader::next_field(const char *& pos,
+  const char * line_end,
+  const char *& begin,
+  const char *& end)const{
+  if(pos==NULL) return false;
+  if(collapse_delimiters_){
+    pos = next_value(pos,line_end);
+    if(pos==line_end) return false;
+    begin = pos;
+    end = value_end(pos,line_end);
+    pos = end;
+    return true;
+  }
+  // every delimiter ends a field, pos is set to NULL after the last field in the line
+  begin = pos;
+  end = value_end(pos,line_end);
+  pos = end==line_end ? NULL : end + 1;
+  begin = skip_spaces(begin,end);
+  while(end!=begin&&is_space(*(end-1))) --end;
+  return true;
+}
+
+int_t
+Delimited_Text_Reader::num_values(const int_t line)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(line<0||line>=num_lines(),std::runtime_error,"Error, invalid line " << line);
+  const char * line_end = &buffer_[0] + line_end_[line];
+  const char * pos = first_field(line);
+  const char * begin = NULL;
+  const char * end = NULL;
+  int_t count = 0;
+  while(next_field(pos,line_end,begin,end))
+    count++;
+  return count;
+}
+
+std::vector<std::string>
+Delimited_Text_Reader::tokens(const int_t line,
+  const bool capitalize)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(line<0||line>=num_lines(),std::runtime_error,"Error, invalid line " << line);
+  std::vector<std::string> result;
+  const char * line_end = &buffer_[0] + line_end_[line];
+  const char * pos = first_field(line);
+  const char * begin = NULL;
+  const char * end = NULL;
+  while(next_field(pos,line_end,begin,end)){
+    result.push_back(std::string(begin,end));
+    if(capitalize)
+      to_upper(result.back());
+  }
+  return result;
+}
+
+void
+Delimited_Text_Reader::read_columns(const int_t first_line,
+  const std::vector<int_t> & columns,
+  std::vector<std::vector<scalar_t> > & values,
+  const int_t num_values_per_line)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(first_line<0,std::runtime_error,"Error, invalid first line " << first_line);
+  const int_t num_columns = columns.size();
+  int_t max_column = -1;
+  for(int_t i=0;i<num_columns;++i){
+    TEUCHOS_TEST_FOR_EXCEPTION(columns[i]<0,std::runtime_error,"Error, invalid column " << columns[i]);
+    max_column = std::max(max_column,columns[i]);
+  }
+  // map from the column in the file to the output vector (-1 if the column is not requested),
+  // columns that are requested more than once are copied after the conversion
+  std::vector<int_t> output_index(max_column+1,-1);
+  int_t num_unique_columns = 0;
+  for(int_t i=0;i<num_columns;++i){
+    if(output_index[columns[i]]<0){
+      output_index[columns[i]] = i;
+      num_unique_columns++;
+    }
+  }
+  const int_t num_rows = std::max(num_lines() - first_line,0);
+  values.resize(num_columns);
+  for(int_t i=0;i<num_columns;++i)
+    values[i].assign(num_rows,0.0);
+  if(num_rows==0) return;
+
+  // the first bad line and the reason (lines are converted in parallel so the error is thrown afterwards)
+  int_t bad_row = num_rows;
+  std::string bad_row_msg;
+  const char * data = &buffer_[0];
+#pragma omp parallel for schedule(dynamic,1024)
+  for(int_t row=0;row<num_rows;++row){
+    const int_t line = first_line + row;
+    const char * line_end = data + line_end_[line];
+    const char * pos = first_field(line);
+    const char * begin = NULL;
+    const char * end = NULL;
+    int_t column = 0;
+    int_t num_found = 0;
+    const char * error = NULL;
+    while(next_field(pos,line_end,begin,end)){
+      const bool requested = column<=max_column&&output_index[column]>=0;
+      if(requested||num_values_per_line>0){
+        scalar_t value = 0.0;
+        if(!parse_number(begin,end,value)){
+          error = "Invalid (non-numeric) line entry in file";
+          break;
+        }
+        if(requested){
+          values[output_index[column]][row] = value;
+          num_found++;
+        }
+      }
+      column++;
+      if(num_values_per_line<=0&&num_found==num_unique_columns) break;
+    }
+    if(error==NULL&&num_values_per_line>0&&column!=num_values_per_line)
+      error = "Invalid line in file (inconsistent number of values per line)";
+    if(error==NULL&&num_found!=num_unique_columns)
+      error = "Invalid line in file (missing values)";
+    if(error!=NULL){
+#pragma omp critical (delimited_text_reader_error)
+      {
+        if(row<bad_row){
+          bad_row = row;
+          bad_row_msg = error;
+        }
+      }
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(bad_row<num_rows,std::runtime_error,bad_row_msg << " (line " << first_line + bad_row << ")");
+  for(int_t i=0;i<num_columns;++i)
+    if(output_index[columns[i]]!=i)
+      values[i] = values[output_index[columns[i]]];
+}
+
 
 DICE_LIB_DLL_EXPORT
 const Teuchos::RCP<Subset_File_Info> read_subset_file(const std::string & fileName,
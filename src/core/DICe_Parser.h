@@ -167,6 +167,12 @@ const char* const image_file_prefix = "image_file_prefix";
 const char* const separate_output_file_for_each_subset = "separate_output_file_for_each_subset";
 /// Input parameter
 const char* const create_separate_run_info_file = "create_separate_run_info_file";
+/// Input parameter
+const char* const write_binary_output_file = "write_binary_output_file";
+/// Input parameter
+const char* const compress_binary_output_file = "compress_binary_output_file";
+/// Input parameter
+const char* const image_buffer_pool_size = "image_buffer_pool_size";
 
 
 /// Parser string
@@ -426,6 +432,106 @@ std::vector<std::string> tokenize_line(std::istream &dataFile,
 DICE_LIB_DLL_EXPORT
 bool is_number(const std::string& s);
 
+/// \brief Converts the characters in [begin,end) to a number without making a copy of the string
+///
+/// Values with at most 15 significant digits and a small exponent (which covers everything DICe writes)
+/// are converted exactly with one multiplication or division by a power of ten, anything else is
+/// handed to strtod
+/// \param begin pointer to the first character
+/// \param end pointer to one past the last character
+/// \param value [out] the converted value
+/// \return false if the characters are not a valid number
+DICE_LIB_DLL_EXPORT
+bool parse_number(const char * begin,
+  const char * end,
+  scalar_t & value);
+
+/// \class DICe::Delimited_Text_Reader
+/// \brief Fast reader for delimited numeric text files (DICe text results, csv and point files)
+///
+/// The whole file is read into memory with one read and the lines are indexed once. Blank lines and
+/// lines that start with a comment character are skipped (the same lines tokenize_line() skips).
+/// Numeric columns are then converted in place, in parallel over the lines, without creating a
+/// string for each value.
+///
+/// By default a run of delimiters separates two values (like tokenize_line()). For csv files where
+/// empty fields have to keep their column position, collapse_delimiters=false makes every delimiter
+/// end a field; spaces and tabs around a value that are not delimiters are trimmed.
+class DICE_LIB_DLL_EXPORT
+Delimited_Text_Reader {
+public:
+  /// \brief constructor
+  /// \param file_name name of the file to read
+  /// \param delimiters characters that separate the values in a line (line endings are always delimiters)
+  /// \param skip_comment_lines false if every line should be kept, including blank lines and lines that start with a
+  /// comment character (for files with a fixed number of header rows), blank lines at the end of the file are always dropped
+  /// \param collapse_delimiters false if every delimiter ends a field so that empty fields are preserved
+  Delimited_Text_Reader(const std::string & file_name,
+    const std::string & delimiters=" \t\r,",
+    const bool skip_comment_lines=true,
+    const bool collapse_delimiters=true);
+
+  /// returns the number of lines that were kept
+  int_t num_lines()const{
+    return line_begin_.size();
+  }
+
+  /// returns the number of values in the given line
+  /// \param line the line index
+  int_t num_values(const int_t line)const;
+
+  /// \brief returns the values in the given line as strings
+  /// \param line the line index
+  /// \param capitalize true if the tokens should be converted to upper case (as tokenize_line() does)
+  std::vector<std::string> tokens(const int_t line,
+    const bool capitalize=true)const;
+
+  /// \brief convert the given columns of the lines [first_line,num_lines()) to numbers
+  /// \param first_line index of the first line to convert (for example 1 to skip a header line)
+  /// \param columns indices of the columns to convert (a column can be requested more than once)
+  /// \param values [out] values[i] holds the values of columns[i], one entry per line
+  /// \param num_values_per_line if positive, every line must have this many values and all of them must be numeric
+  void read_columns(const int_t first_line,
+    const std::vector<int_t> & columns,
+    std::vector<std::vector<scalar_t> > & values,
+    const int_t num_values_per_line=-1)const;
+
+private:
+  /// returns the pointer to the start of the next value in the line, or line_end if there are no more values
+  const char * next_value(const char * pos,
+    const char * line_end)const;
+  /// returns the pointer to one past the end of the value that starts at pos
+  const char * value_end(const char * pos,
+    const char * line_end)const;
+  /// returns true if the character is a space, tab or carriage return that is not a delimiter
+  bool is_space(const char c)const;
+  /// returns the pointer to the first character at or after pos that is not a space
+  const char * skip_spaces(const char * pos,
+    const char * line_end)const;
+  /// returns the position to start reading the fields of the given line from (NULL if the line has no fields)
+  const char * first_field(const int_t line)const;
+  /// \brief find the next field in a line
+  /// \param pos [in/out] position to start from, advanced past the field
+  /// \param line_end pointer to one past the last character in the line
+  /// \param begin [out] pointer to the first character of the field
+  /// \param end [out] pointer to one past the last character of the field
+  /// \return false if there are no more fields in the line
+  bool next_field(const char *& pos,
+    const char * line_end,
+    const char *& begin,
+    const char *& end)const;
+  /// contents of the file
+  std::vector<char> buffer_;
+  /// offset of the first character of each line
+  std::vector<size_t> line_begin_;
+  /// offset of one past the last character of each line
+  std::vector<size_t> line_end_;
+  /// lookup table of the delimiter characters
+  std::vector<bool> is_delimiter_;
+  /// true if a run of delimiters separates two values, false if every delimiter ends a field
+  bool collapse_delimiters_;
+};
+
 /// \brief Read a list of coordinates for correlation points from file
 /// \param fileName String name of the file that defines the subsets
 /// \param width The image width (used to check for valid coords)
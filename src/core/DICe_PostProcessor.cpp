@@ -68,6 +68,8 @@ Post_Processor::initialize(Teuchos::RCP<DICe::mesh::Mesh> & mesh){
   overlap_num_points_ = mesh_->get_scalar_node_overlap_map()->get_num_local_elements();
   assert(local_num_points_>0);
   assert(overlap_num_points_>0);
+  // the neighborhoods have to be recomputed if the post processor is re-initialized with a new mesh
+  neighborhood_initialized_ = false;
   for(size_t i=0;i<field_specs_.size();++i)
     mesh_->create_field(field_specs_[i]);
 }
@@ -166,6 +168,9 @@ Post_Processor::initialize_neighborhood(const scalar_t & neighborhood_radius){
   DEBUG_MSG("kd-tree completed");
 
   // perform a pass to size the neighbor lists
+  neighbor_list_.clear();
+  neighbor_dist_x_.clear();
+  neighbor_dist_y_.clear();
   neighbor_list_.resize(local_num_points_);
   neighbor_dist_x_.resize(local_num_points_);
   neighbor_dist_y_.resize(local_num_points_);
@@ -257,6 +262,8 @@ VSG_Strain_Post_Processor::pre_execution_tasks(){
   DEBUG_MSG("VSG_Strain_Post_Processor pre_execution_tasks() begin");
   const scalar_t neigh_rad = (scalar_t)window_size_/2.0;
   initialize_neighborhood(neigh_rad);
+  // the cached strain operators depend on the neighbor lists so they are rebuilt on the next execute
+  op_status_.clear();
   TEUCHOS_TEST_FOR_EXCEPTION(!neighborhood_initialized_,std::runtime_error,"Error, neighborhoods should be initialized here.");
   DEBUG_MSG("VSG_Strain_Post_Processor pre_execution_tasks() end");
   set_stereo_field_names();
@@ -274,6 +281,72 @@ VSG_Strain_Post_Processor::pre_execution_tasks(){
     std::runtime_error,"Error: invalid field selections");
 }
 
+void
+VSG_Strain_Post_Processor::update_operator(const int_t subset,
+  const std::vector<scalar_t> & sigma){
+  const int_t N = 3;
+  const int_t num_neigh = neighbor_list_[subset].size();
+  std::vector<bool> & mask = op_valid_mask_[subset];
+  std::vector<scalar_t> & weights_x = op_weights_x_[subset];
+  std::vector<scalar_t> & weights_y = op_weights_y_[subset];
+  mask.resize(num_neigh);
+  weights_x.assign(num_neigh,0.0);
+  weights_y.assign(num_neigh,0.0);
+  op_status_[subset] = 0;
+  int_t num_valid_neigh = 0;
+  for(int_t j=0;j<num_neigh;++j){
+    mask[j] = sigma[neighbor_list_[subset][j]]>=0.0;
+    if(mask[j]) num_valid_neigh++;
+  }
+  if(num_valid_neigh < 3) return;
+
+  // set up X^T*X, the rows of X^T are [1 dx dy] for each valid neighbor
+  Teuchos::SerialDenseMatrix<int_t,double> X_t_X(N,N,true);
+  for(int_t j=0;j<num_neigh;++j){
+    if(!mask[j]) continue;
+    const double row[3] = {1.0,neighbor_dist_x_[subset][j],neighbor_dist_y_[subset][j]};
+    for(int_t k=0;k<N;++k)
+      for(int_t m=0;m<N;++m)
+        X_t_X(k,m) += row[k]*row[m];
+  }
+
+  // compute the 1-norm of X^T*X:
+  double anorm = 0.0;
+  for(int_t i=0;i<N;++i){
+    double col_total = 0.0;
+    for(int_t j=0;j<N;++j)
+      col_total += std::abs(X_t_X(j,i));
+    if(col_total > anorm) anorm = col_total;
+  }
+  // work arrays are local so that operators for different subsets can be built concurrently
+  // (no debug messages in this method since it is called from the threaded subset loop)
+  int IPIV[N+1];
+  int LWORK = N*N;
+  int INFO = 0;
+  double WORK[N*N];
+  double GWORK[10*N];
+  int IWORK[N*N];
+  // Note, LAPACK does not allow templating on long int or scalar_t...must use int and double
+  Teuchos::LAPACK<int,double> lapack;
+  double rcond=0.0; // reciporical condition number
+  lapack.GETRF(N,N,X_t_X.values(),N,IPIV,&INFO);
+  if(INFO!=0) return;
+  lapack.GECON('1',N,X_t_X.values(),N,anorm,&rcond,GWORK,IWORK,&INFO);
+  if(rcond < 1.0E-12) return;
+  lapack.GETRI(N,X_t_X.values(),N,IPIV,WORK,LWORK,&INFO);
+  if(INFO!=0) return;
+
+  // rows 1 and 2 of (X^T*X)^-1*X^T map the neighbor values to the x and y derivatives
+  for(int_t j=0;j<num_neigh;++j){
+    if(!mask[j]) continue;
+    const double dx = neighbor_dist_x_[subset][j];
+    const double dy = neighbor_dist_y_[subset][j];
+    weights_x[j] = X_t_X(1,0) + X_t_X(1,1)*dx + X_t_X(1,2)*dy;
+    weights_y[j] = X_t_X(2,0) + X_t_X(2,1)*dx + X_t_X(2,2)*dy;
+  }
+  op_status_[subset] = 1;
+}
+
 void
 VSG_Strain_Post_Processor::execute(){
   DEBUG_MSG("VSG_Strain_Post_Processor execute() begin");
@@ -309,35 +382,65 @@ VSG_Strain_Post_Processor::execute(){
   Teuchos::RCP<DICe::MultiField> vsg_dvdy_rcp = mesh_->get_field(DICe::field_enums::VSG_DVDY_FS);
   Teuchos::RCP<DICe::MultiField> match = mesh_->get_field(DICe::field_enums::MATCH_FS);
 
-  const int_t N = 3;
-  int *IPIV = new int[N+1];
-  int LWORK = N*N;
-  int INFO = 0;
-  double *WORK = new double[LWORK];
-  double *GWORK = new double[10*N];
-  int *IWORK = new int[LWORK];
-  // Note, LAPACK does not allow templating on long int or scalar_t...must use int and double
-  Teuchos::LAPACK<int,double> lapack;
-
-  int_t num_neigh = 0;
-  std::vector<bool> neigh_valid;
-  int_t neigh_id = 0;
+  // copy the overlap values into flat arrays so that the subset loop below can be threaded
+  std::vector<scalar_t> sigma_values(overlap_num_points_);
+  std::vector<scalar_t> u_x(overlap_num_points_);
+  std::vector<scalar_t> u_y(overlap_num_points_);
+  for(int_t i=0;i<overlap_num_points_;++i){
+    sigma_values[i] = sigma->local_value(i);
+    u_x[i] = disp->local_value(i*spa_dim+0);
+    u_y[i] = disp->local_value(i*spa_dim+1);
+  }
+  // the cached operators are sized lazily so that a re-initialized neighborhood is picked up here
+  if((int_t)op_status_.size()!=local_num_points_){
+    op_valid_mask_.assign(local_num_points_,std::vector<bool>());
+    op_weights_x_.assign(local_num_points_,std::vector<scalar_t>());
+    op_weights_y_.assign(local_num_points_,std::vector<scalar_t>());
+    op_status_.assign(local_num_points_,0);
+  }
+  std::vector<scalar_t> dudx(local_num_points_,0.0);
+  std::vector<scalar_t> dudy(local_num_points_,0.0);
+  std::vector<scalar_t> dvdx(local_num_points_,0.0);
+  std::vector<scalar_t> dvdy(local_num_points_,0.0);
+  std::vector<int_t> valid(local_num_points_,0);
+  // the map is only used for the debug messages in the serial loop below (the RCP count is not thread safe)
+  const Teuchos::RCP<MultiField_Map> dist_map = mesh_->get_scalar_node_dist_map();
+
+#pragma omp parallel for schedule(dynamic,64)
   for(int_t subset=0;subset<local_num_points_;++subset){
-    DEBUG_MSG("Processing subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << ", " << subset + 1 << " of " << local_num_points_);
-    // search the neighbors to see how many valid neighbors exist:
-    num_neigh = neighbor_list_[subset].size();
-    neigh_valid.resize(num_neigh);
-    int_t num_valid_neigh = 0;
+    const std::vector<int_t> & neighbors = neighbor_list_[subset];
+    const int_t num_neigh = neighbors.size();
+    // the operator only depends on the geometry and which neighbors are valid,
+    // so it is only rebuilt if the valid set has changed since the last frame
+    bool mask_changed = (int_t)op_valid_mask_[subset].size()!=num_neigh;
+    for(int_t j=0;j<num_neigh&&!mask_changed;++j)
+      mask_changed = (sigma_values[neighbors[j]]>=0.0)!=op_valid_mask_[subset][j];
+    if(mask_changed) update_operator(subset,sigma_values);
+    if(!op_status_[subset] || num_neigh==0 || sigma_values[neighbors[0]] < 0.0) continue;
+    const scalar_t * weights_x = &op_weights_x_[subset][0];
+    const scalar_t * weights_y = &op_weights_y_[subset][0];
+    scalar_t sum_dudx = 0.0;
+    scalar_t sum_dudy = 0.0;
+    scalar_t sum_dvdx = 0.0;
+    scalar_t sum_dvdy = 0.0;
+    // invalid neighbors have zero weight so no need to check the mask here
     for(int_t j=0;j<num_neigh;++j){
-      if(sigma->local_value(neighbor_list_[subset][j])>=0.0){
-        neigh_valid[j] = true;
-        num_valid_neigh++;
-      }else{
-        neigh_valid[j] = false;
-      }
+      const scalar_t ux = u_x[neighbors[j]];
+      const scalar_t uy = u_y[neighbors[j]];
+      sum_dudx += weights_x[j]*ux;
+      sum_dudy += weights_y[j]*ux;
+      sum_dvdx += weights_x[j]*uy;
+      sum_dvdy += weights_y[j]*uy;
     }
-    DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " num valid neighbors: " << num_valid_neigh);
-    if(num_valid_neigh < 3 || sigma->local_value(neighbor_list_[subset][0]) < 0.0){
+    dudx[subset] = sum_dudx;
+    dudy[subset] = sum_dudy;
+    dvdx[subset] = sum_dvdx;
+    dvdy[subset] = sum_dvdy;
+    valid[subset] = 1;
+  } // end subset loop
+
+  for(int_t subset=0;subset<local_num_points_;++subset){
+    if(!valid[subset]){
       vsg_dudx_rcp->local_value(subset) = 0.0;
       vsg_dudy_rcp->local_value(subset) = 0.0;
       vsg_dvdx_rcp->local_value(subset) = 0.0;
@@ -345,141 +448,28 @@ VSG_Strain_Post_Processor::execute(){
       vsg_strain_xx_rcp->local_value(subset) = 0.0;
       vsg_strain_yy_rcp->local_value(subset) = 0.0;
       vsg_strain_xy_rcp->local_value(subset) = 0.0;
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " failed subset (sigma=-1) or not enough neighbors to calculate VSG strain."
-          " Setting all strain values to zero.");
+      DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " failed subset (sigma=-1), not enough neighbors,"
+          " or singular pseudo-inverse in the VSG strain calculation. Setting all strain values to zero.");
       match->local_value(subset) = -1;
-    }else{
-      Teuchos::ArrayRCP<double> u_x(num_valid_neigh,0.0);
-      Teuchos::ArrayRCP<double> u_y(num_valid_neigh,0.0);
-      Teuchos::ArrayRCP<double> X_t_u_x(N,0.0);
-      Teuchos::ArrayRCP<double> X_t_u_y(N,0.0);
-      Teuchos::ArrayRCP<double> coeffs_x(N,0.0);
-      Teuchos::ArrayRCP<double> coeffs_y(N,0.0);
-      Teuchos::SerialDenseMatrix<int_t,double> X_t(N,num_valid_neigh, true);
-      Teuchos::SerialDenseMatrix<int_t,double> X_t_X(N,N,true);
-
-      // gather the displacements of the neighbors
-      int_t valid_id = 0;
-      for(int_t j=0;j<num_neigh;++j){
-        if(!neigh_valid[j])continue;
-        neigh_id = neighbor_list_[subset][j];
-        assert(sigma->local_value(neigh_id)>=0.0);
-        u_x[valid_id] = disp->local_value(neigh_id*spa_dim+0);
-        u_y[valid_id] = disp->local_value(neigh_id*spa_dim+1);
-        // set up the X^T matrix
-        X_t(0,valid_id) = 1.0;
-        X_t(1,valid_id) = neighbor_dist_x_[subset][j];
-        X_t(2,valid_id) = neighbor_dist_y_[subset][j];
-        valid_id++;
-      }
-
-      // set up X^T*X
-      for(int_t k=0;k<N;++k){
-        for(int_t m=0;m<N;++m){
-          for(int_t j=0;j<num_valid_neigh;++j){
-            X_t_X(k,m) += X_t(k,j)*X_t(m,j);
-          }
-        }
-      }
-      //X_t_X.print(std::cout);
-
-      // Invert X^T*X
-      // TODO: remove for performance?
-      // compute the 1-norm of H:
-      std::vector<double> colTotals(X_t_X.numCols(),0.0);
-      for(int_t i=0;i<X_t_X.numCols();++i){
-        for(int_t j=0;j<X_t_X.numRows();++j){
-          colTotals[i]+=std::abs(X_t_X(j,i));
-        }
-      }
-      double anorm = 0.0;
-      for(int_t i=0;i<X_t_X.numCols();++i){
-        if(colTotals[i] > anorm) anorm = colTotals[i];
-      }
-      DEBUG_MSG("Subset " << subset << " anorm " << anorm);
-      double rcond=0.0; // reciporical condition number
-      try
-      {
-        lapack.GETRF(X_t_X.numRows(),X_t_X.numCols(),X_t_X.values(),X_t_X.numRows(),IPIV,&INFO);
-        lapack.GECON('1',X_t_X.numRows(),X_t_X.values(),X_t_X.numRows(),anorm,&rcond,GWORK,IWORK,&INFO);
-        DEBUG_MSG("Subset " << subset << " VSG X^T*X RCOND(H): "<< rcond);
-        if(rcond < 1.0E-12) {
-          vsg_dudx_rcp->local_value(subset) = 0.0;
-          vsg_dudy_rcp->local_value(subset) = 0.0;
-          vsg_dvdx_rcp->local_value(subset) = 0.0;
-          vsg_dvdy_rcp->local_value(subset) = 0.0;
-          vsg_strain_xx_rcp->local_value(subset) = 0.0;
-          vsg_strain_yy_rcp->local_value(subset) = 0.0;
-          vsg_strain_xy_rcp->local_value(subset) = 0.0;
-          DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " failed subset, the pseudo-inverse of the VSG strain calculation is (or is near) singular."
-              " Setting all strain values to zero.");
-          match->local_value(subset) = -1;
-          continue;
-          //std::cout << "Error: The pseudo-inverse of the VSG strain calculation is (or is near) singular." << std::endl;
-          //TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"");
-        }
-      }
-      catch(std::exception &e){
-        DEBUG_MSG( e.what() << '\n');
-        std::cout << "Error: Something went wrong in the condition number calculation" << std::endl;
-        TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"");
-      }
-      try
-      {
-        lapack.GETRI(X_t_X.numRows(),X_t_X.values(),X_t_X.numRows(),IPIV,WORK,LWORK,&INFO);
-      }
-      catch(std::exception &e){
-        DEBUG_MSG( e.what() << '\n');
-        std::cout << "Error: Something went wrong in the inverse calculation of X^T*X " << std::endl;
-      }
-
-      // compute X^T*u
-      for(int_t i=0;i<N;++i){
-        for(int_t j=0;j<num_valid_neigh;++j){
-          X_t_u_x[i] += X_t(i,j)*u_x[j];
-          X_t_u_y[i] += X_t(i,j)*u_y[j];
-        }
-      }
-
-      // compute the coeffs
-      for(int_t i=0;i<N;++i){
-        for(int_t j=0;j<N;++j){
-          coeffs_x[i] += X_t_X(i,j)*X_t_u_x[j];
-          coeffs_y[i] += X_t_X(i,j)*X_t_u_y[j];
-        }
-      }
-
-      // update the field values
-      const double dudx = coeffs_x[1];
-      const double dudy = coeffs_x[2];
-      const double dvdx = coeffs_y[1];
-      const double dvdy = coeffs_y[2];
-      vsg_dudx_rcp->local_value(subset) = dudx;
-      vsg_dudy_rcp->local_value(subset) = dudy;
-      vsg_dvdx_rcp->local_value(subset) = dvdx;
-      vsg_dvdy_rcp->local_value(subset) = dvdy;
-
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " dudx " << dudx << " dudy " << dudy <<
-        " dvdx " << dvdx << " dvdy " << dvdy);
-
-      // compute the Green-Lagrange strain based on the derivatives computed above:
-      const scalar_t GL_xx = 0.5*(2.0*dudx + dudx*dudx + dvdx*dvdx);
-      const scalar_t GL_yy = 0.5*(2.0*dvdy + dudy*dudy + dvdy*dvdy);
-      const scalar_t GL_xy = 0.5*(dudy + dvdx + dudx*dudy + dvdx*dvdy);
-      vsg_strain_xx_rcp->local_value(subset) = GL_xx;
-      vsg_strain_yy_rcp->local_value(subset) = GL_yy;
-      vsg_strain_xy_rcp->local_value(subset) = GL_xy;
-
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " VSG Green-Lagrange strain XX: " << GL_xx << " YY: " << GL_yy <<
-        " XY: " << GL_xy);
-    } // end has enough valid neighbors to compute strain check
-
-  } // end subset loop
-
-  delete [] WORK;
-  delete [] GWORK;
-  delete [] IWORK;
-  delete [] IPIV;
+      continue;
+    }
+    vsg_dudx_rcp->local_value(subset) = dudx[subset];
+    vsg_dudy_rcp->local_value(subset) = dudy[subset];
+    vsg_dvdx_rcp->local_value(subset) = dvdx[subset];
+    vsg_dvdy_rcp->local_value(subset) = dvdy[subset];
+    DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " dudx " << dudx[subset] << " dudy " << dudy[subset] <<
+      " dvdx " << dvdx[subset] << " dvdy " << dvdy[subset]);
+
+    // compute the Green-Lagrange strain based on the derivatives computed above:
+    const scalar_t GL_xx = 0.5*(2.0*dudx[subset] + dudx[subset]*dudx[subset] + dvdx[subset]*dvdx[subset]);
+    const scalar_t GL_yy = 0.5*(2.0*dvdy[subset] + dudy[subset]*dudy[subset] + dvdy[subset]*dvdy[subset]);
+    const scalar_t GL_xy = 0.5*(dudy[subset] + dvdx[subset] + dudx[subset]*dudy[subset] + dvdx[subset]*dvdy[subset]);
+    vsg_strain_xx_rcp->local_value(subset) = GL_xx;
+    vsg_strain_yy_rcp->local_value(subset) = GL_yy;
+    vsg_strain_xy_rcp->local_value(subset) = GL_xy;
+    DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " VSG Green-Lagrange strain XX: " << GL_xx << " YY: " << GL_yy <<
+      " XY: " << GL_xy);
+  }
   DEBUG_MSG("VSG_Strain_Post_Processor execute() end");
 }
 
@@ -521,6 +511,34 @@ NLVC_Strain_Post_Processor::pre_execution_tasks(){
   const scalar_t neigh_rad = (scalar_t)horizon_/2.0;
   initialize_neighborhood(neigh_rad);
   TEUCHOS_TEST_FOR_EXCEPTION(!neighborhood_initialized_,std::runtime_error,"Error, neighborhoods should be initialized here.");
+
+  // the kernel only depends on the geometry so it is evaluated once here and
+  // stored in a compressed row table that execute() multiplies by the displacements
+  kernel_offsets_.resize(local_num_points_+1);
+  kernel_offsets_[0] = 0;
+  for(int_t subset=0;subset<local_num_points_;++subset)
+    kernel_offsets_[subset+1] = kernel_offsets_[subset] + neighbor_list_[subset].size();
+  const int_t num_entries = kernel_offsets_[local_num_points_];
+  kernel_ids_.resize(num_entries);
+  kernel_x_.resize(num_entries);
+  kernel_y_.resize(num_entries);
+  scalar_t kx = 0.0;
+  scalar_t ky = 0.0;
+  for(int_t subset=0;subset<local_num_points_;++subset){
+    // neighbor 0 is yourself
+    scalar_t patch_area = 0.0;
+    if(neighbor_dist_x_[subset].size()>1)
+      patch_area = neighbor_dist_x_[subset][1]*neighbor_dist_x_[subset][1] +
+        neighbor_dist_y_[subset][1]*neighbor_dist_y_[subset][1];
+    for(size_t j=0;j<neighbor_list_[subset].size();++j){
+      const int_t entry = kernel_offsets_[subset] + j;
+      compute_kernel(neighbor_dist_x_[subset][j],neighbor_dist_y_[subset][j],kx,ky);
+      kernel_ids_[entry] = neighbor_list_[subset][j];
+      kernel_x_[entry] = kx*patch_area;
+      kernel_y_[entry] = ky*patch_area;
+    }
+  }
+  DEBUG_MSG("NLVC_Strain_Post_Processor kernel table has " << num_entries << " entries");
   DEBUG_MSG("NLVC_Strain_Post_Processor pre_execution_tasks() end");
   set_stereo_field_names();
   DICe::field_enums::Field_Spec disp_x_spec = mesh_->get_field_spec(disp_x_name_);
@@ -587,35 +605,63 @@ NLVC_Strain_Post_Processor::execute(){
   Teuchos::RCP<DICe::MultiField> f10_rcp = mesh_->get_field(DICe::field_enums::FIELD_10_FS);
   Teuchos::RCP<DICe::MultiField> match = mesh_->get_field(DICe::field_enums::MATCH_FS);
 
-  std::vector<bool> neigh_valid;
+  // copy the overlap values into flat arrays so that the subset loop below can be threaded
+  std::vector<scalar_t> sigma_values(overlap_num_points_);
+  std::vector<scalar_t> u_x(overlap_num_points_);
+  std::vector<scalar_t> u_y(overlap_num_points_);
+  for(int_t i=0;i<overlap_num_points_;++i){
+    sigma_values[i] = sigma->local_value(i);
+    u_x[i] = disp->local_value(i*spa_dim+0);
+    u_y[i] = disp->local_value(i*spa_dim+1);
+  }
+  std::vector<scalar_t> dudx(local_num_points_,0.0);
+  std::vector<scalar_t> dudy(local_num_points_,0.0);
+  std::vector<scalar_t> dvdx(local_num_points_,0.0);
+  std::vector<scalar_t> dvdy(local_num_points_,0.0);
+  std::vector<scalar_t> sum_int_x(local_num_points_,0.0);
+  std::vector<scalar_t> sum_int_y(local_num_points_,0.0);
+  std::vector<int_t> valid(local_num_points_,0);
+  // the map is only used for the debug messages in the serial loop below (the RCP count is not thread safe)
+  const Teuchos::RCP<MultiField_Map> dist_map = mesh_->get_scalar_node_dist_map();
+
+  // sparse matrix-vector product of the kernel table with the valid displacements
+#pragma omp parallel for schedule(dynamic,64)
   for(int_t subset=0;subset<local_num_points_;++subset){
-    DEBUG_MSG("Processing subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << ", " << subset + 1 << " of " << local_num_points_);
-    scalar_t dudx = 0.0;
-    scalar_t dudy = 0.0;
-    scalar_t dvdx = 0.0;
-    scalar_t dvdy = 0.0;
-    scalar_t ux = 0.0;
-    scalar_t uy = 0.0;
-    scalar_t dx = 0.0;
-    scalar_t dy = 0.0;
-    scalar_t sum_int_x = 0.0;
-    scalar_t sum_int_y = 0.0;
-    scalar_t kx = 0.0;
-    scalar_t ky = 0.0;
-    int_t neigh_id = 0;
-    const int_t num_neigh = neighbor_dist_x_[subset].size();
-    neigh_valid.resize(num_neigh);
+    const int_t begin = kernel_offsets_[subset];
+    const int_t end = kernel_offsets_[subset+1];
+    if(end==begin || sigma_values[kernel_ids_[begin]] < 0.0) continue;
     int_t num_valid_neigh = 0;
-    for(int_t j=0;j<num_neigh;++j){
-      if(sigma->local_value(neighbor_list_[subset][j])>=0.0){
-        neigh_valid[j] = true;
-        num_valid_neigh++;
-      }else{
-        neigh_valid[j] = false;
-      }
-    }
-    DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " num valid neighbors: " << num_valid_neigh);
-    if(num_valid_neigh < 3 || sigma->local_value(neighbor_list_[subset][0])<0.0){
+    scalar_t sx = 0.0;
+    scalar_t sy = 0.0;
+    scalar_t sum_dudx = 0.0;
+    scalar_t sum_dudy = 0.0;
+    scalar_t sum_dvdx = 0.0;
+    scalar_t sum_dvdy = 0.0;
+    for(int_t j=begin;j<end;++j){
+      const int_t neigh_id = kernel_ids_[j];
+      if(sigma_values[neigh_id] < 0.0) continue;
+      num_valid_neigh++;
+      const scalar_t kx = kernel_x_[j];
+      const scalar_t ky = kernel_y_[j];
+      sx += kx;
+      sy += ky;
+      sum_dudx -= u_x[neigh_id]*kx;
+      sum_dudy -= u_x[neigh_id]*ky;
+      sum_dvdx -= u_y[neigh_id]*kx;
+      sum_dvdy -= u_y[neigh_id]*ky;
+    } // neighbor loop
+    if(num_valid_neigh < 3) continue;
+    dudx[subset] = sum_dudx;
+    dudy[subset] = sum_dudy;
+    dvdx[subset] = sum_dvdx;
+    dvdy[subset] = sum_dvdy;
+    sum_int_x[subset] = sx;
+    sum_int_y[subset] = sy;
+    valid[subset] = 1;
+  } // subset loop
+
+  for(int_t subset=0;subset<local_num_points_;++subset){
+    if(!valid[subset]){
       nlvc_dudx_rcp->local_value(subset) = 0.0;
       nlvc_dudy_rcp->local_value(subset) = 0.0;
       nlvc_dvdx_rcp->local_value(subset) = 0.0;
@@ -623,58 +669,36 @@ NLVC_Strain_Post_Processor::execute(){
       nlvc_strain_xx_rcp->local_value(subset) = 0.0;
       nlvc_strain_yy_rcp->local_value(subset) = 0.0;
       nlvc_strain_xy_rcp->local_value(subset) = 0.0;
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " failed subset (sigma=-1) or not enough neighbors to calculate NLVC strain."
+      DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " failed subset (sigma=-1) or not enough neighbors to calculate NLVC strain."
           " Setting all strain values to zero.");
       match->local_value(subset) = -1;
-    }else{
-      assert(neighbor_dist_x_[subset].size()>1);
-      assert(neighbor_dist_y_[subset].size()>1);
-      // neighbor 0 is yourself
-      const scalar_t nearest_neigh_dist = std::sqrt(neighbor_dist_x_[subset][1]*neighbor_dist_x_[subset][1] +
-        neighbor_dist_y_[subset][1]*neighbor_dist_y_[subset][1]);
-      const scalar_t patch_area = nearest_neigh_dist*nearest_neigh_dist;
-      for(int_t j=0;j<num_neigh;++j){
-        if(!neigh_valid[j]) continue;
-        neigh_id = neighbor_list_[subset][j];
-        assert(sigma->local_value(neigh_id)>=0.0);
-        ux = disp->local_value(neigh_id*spa_dim+0);
-        uy = disp->local_value(neigh_id*spa_dim+1);
-        dx = neighbor_dist_x_[subset][j];
-        dy = neighbor_dist_y_[subset][j];
-        compute_kernel(dx,dy,kx,ky);
-        sum_int_x += kx*patch_area;
-        sum_int_y += ky*patch_area;
-        dudx -= ux * kx*patch_area;
-        dudy -= ux * ky*patch_area;
-        dvdx -= uy * kx*patch_area;
-        dvdy -= uy * ky*patch_area;
-      } // neighbor loop
-      nlvc_dudx_rcp->local_value(subset) = dudx;
-      nlvc_dudy_rcp->local_value(subset) = dudy;
-      nlvc_dvdx_rcp->local_value(subset) = dvdx;
-      nlvc_dvdy_rcp->local_value(subset) = dvdy;
-      f9_rcp->local_value(subset) = sum_int_x;
-      f10_rcp->local_value(subset) = sum_int_y;
-
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " dudx " << dudx << " dudy " << dudy <<
-        " dvdx " << dvdx << " dvdy " << dvdy);
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " sum_int_x " << sum_int_x <<
-        " sum_int_y " << sum_int_y);
-
-      // compute the Green-Lagrange strain based on the derivatives computed above:
-      const scalar_t GL_xx = 0.5*(2.0*dudx + dudx*dudx + dvdx*dvdx);
-      const scalar_t GL_yy = 0.5*(2.0*dvdy + dudy*dudy + dvdy*dvdy);
-      const scalar_t GL_xy = 0.5*(dudy + dvdx + dudx*dudy + dvdx*dvdy);
-      nlvc_strain_xx_rcp->local_value(subset) = GL_xx;
-      nlvc_strain_yy_rcp->local_value(subset) = GL_yy;
-      nlvc_strain_xy_rcp->local_value(subset) = GL_xy;
-      if(sum_int_x > 0.01 || sum_int_y > 0.01 || sum_int_x < -0.01 || sum_int_y < -0.01){
-        match->local_value(subset) = -1;
-      }
-      DEBUG_MSG("Subset gid " << mesh_->get_scalar_node_dist_map()->get_global_element(subset) << " NLVC Green-Lagrange strain XX: " << GL_xx << " YY: " << GL_yy <<
-        " XY: " << GL_xy);
+      continue;
     }
-  } // subset loop
+    nlvc_dudx_rcp->local_value(subset) = dudx[subset];
+    nlvc_dudy_rcp->local_value(subset) = dudy[subset];
+    nlvc_dvdx_rcp->local_value(subset) = dvdx[subset];
+    nlvc_dvdy_rcp->local_value(subset) = dvdy[subset];
+    f9_rcp->local_value(subset) = sum_int_x[subset];
+    f10_rcp->local_value(subset) = sum_int_y[subset];
+
+    DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " dudx " << dudx[subset] << " dudy " << dudy[subset] <<
+      " dvdx " << dvdx[subset] << " dvdy " << dvdy[subset]);
+    DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " sum_int_x " << sum_int_x[subset] <<
+      " sum_int_y " << sum_int_y[subset]);
+
+    // compute the Green-Lagrange strain based on the derivatives computed above:
+    const scalar_t GL_xx = 0.5*(2.0*dudx[subset] + dudx[subset]*dudx[subset] + dvdx[subset]*dvdx[subset]);
+    const scalar_t GL_yy = 0.5*(2.0*dvdy[subset] + dudy[subset]*dudy[subset] + dvdy[subset]*dvdy[subset]);
+    const scalar_t GL_xy = 0.5*(dudy[subset] + dvdx[subset] + dudx[subset]*dudy[subset] + dvdx[subset]*dvdy[subset]);
+    nlvc_strain_xx_rcp->local_value(subset) = GL_xx;
+    nlvc_strain_yy_rcp->local_value(subset) = GL_yy;
+    nlvc_strain_xy_rcp->local_value(subset) = GL_xy;
+    if(sum_int_x[subset] > 0.01 || sum_int_y[subset] > 0.01 || sum_int_x[subset] < -0.01 || sum_int_y[subset] < -0.01){
+      match->local_value(subset) = -1;
+    }
+    DEBUG_MSG("Subset gid " << dist_map->get_global_element(subset) << " NLVC Green-Lagrange strain XX: " << GL_xx << " YY: " << GL_yy <<
+      " XY: " << GL_xy);
+  }
 
   DEBUG_MSG("NLVC_Strain_Post_Processor execute() end");
 }
@@ -238,8 +238,22 @@ public:
   using Post_Processor::field_specs;
 
 private:
+  /// Rebuild the cached least-squares operator for a subset from the current set of valid neighbors
+  /// \param subset the local id of the subset
+  /// \param sigma overlap sigma values used to determine which neighbors are valid
+  void update_operator(const int_t subset,
+    const std::vector<scalar_t> & sigma);
+
   /// Window size for the virtual strain gauge (in pixels)
   int_t window_size_;
+  /// valid neighbor mask used when the cached operator for each subset was computed
+  std::vector<std::vector<bool> > op_valid_mask_;
+  /// cached row of the pseudo-inverse (X^T*X)^-1*X^T that gives the x-derivative from the neighbor values
+  std::vector<std::vector<scalar_t> > op_weights_x_;
+  /// cached row of the pseudo-inverse (X^T*X)^-1*X^T that gives the y-derivative from the neighbor values
+  std::vector<std::vector<scalar_t> > op_weights_y_;
+  /// 1 if the cached operator for the subset is usable, 0 if there are too few neighbors or X^T*X is singular
+  std::vector<int_t> op_status_;
 };
 
 /// \class DICe::NLVC_Strain_Post_Processor
@@ -292,6 +306,14 @@ public:
 private:
   /// Neighborhood diameter (circular distance around the point of interest where the interaction is non-negligible)
   int_t horizon_;
+  /// offsets into the kernel arrays for each local point (CSR row pointers, size local_num_points_+1)
+  std::vector<int_t> kernel_offsets_;
+  /// overlap local id of each neighbor in the kernel table
+  std::vector<int_t> kernel_ids_;
+  /// x kernel value times the patch area for each neighbor in the kernel table
+  std::vector<scalar_t> kernel_x_;
+  /// y kernel value times the patch area for each neighbor in the kernel table
+  std::vector<scalar_t> kernel_y_;
 };
 
 /// \class DICe::Altitude_Post_Processor
@@ -50,6 +50,7 @@
 #include <DICe_Triangulation.h>
 #include <DICe_Simplex.h>
 #include <DICe_Cine.h>
+#include <DICe_Profiler.h>
 #ifdef DICE_ENABLE_GLOBAL
   #include <DICe_MeshIO.h>
   #include <DICe_MeshIOUtils.h>
@@ -57,6 +58,7 @@
 
 #include <Teuchos_XMLParameterListHelpers.hpp>
 #include <Teuchos_ArrayRCP.hpp>
+#include <Teuchos_Time.hpp>
 
 #include <ctime>
 #include <iostream>
@@ -165,6 +167,7 @@ Schema::set_def_image(const std::string & defName,
   imgParams->set(DICe::gauss_filter_images,gauss_filter_images_);
   imgParams->set(DICe::gauss_filter_mask_size,gauss_filter_mask_size_);
   imgParams->set(DICe::gradient_method,gradient_method_);
+  imgParams->set(DICe::compact_intensity_storage,compact_intensity_storage_);
 
   // query the image dimensions:
   if(has_extents_){
@@ -250,6 +253,7 @@ Schema::set_ref_image(const std::string & refName){
   imgParams->set(DICe::gauss_filter_mask_size,gauss_filter_mask_size_);
   imgParams->set(DICe::gradient_method,gradient_method_);
   imgParams->set(DICe::compute_laplacian_image,compute_laplacian_image_);
+  imgParams->set(DICe::compact_intensity_storage,compact_intensity_storage_);
   if(has_extents_){
     utils::read_image_dimensions(refName.c_str(),full_ref_img_width_,full_ref_img_height_);
     const int_t buffer = 100; // if the extents are within 100 pixels of the image boundary use the whole image
@@ -339,6 +343,17 @@ Schema::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & p
   normalize_gamma_with_active_pixels_ = false;
   gauss_filter_images_ = false;
   gauss_filter_mask_size_ = 7;
+  image_registration_pyramid_level_ = 0;
+  phase_correlation_window_size_ = 0;
+  exodus_output_queue_size_ = 4;
+  motion_test_decimation_ = 1;
+  coarse_to_fine_levels_ = 0;
+  compact_intensity_storage_ = false;
+  rebalance_interval_ = 0;
+  rebalance_threshold_ = 0.1;
+  frames_since_rebalance_ = 0;
+  rebalance_cost_ = -1.0;
+  exodus_output_created_ = false;
   init_params_ = params==Teuchos::null ? Teuchos::rcp(new Teuchos::ParameterList()):
     Teuchos::rcp(new Teuchos::ParameterList(*params));
   comm_ = Teuchos::rcp(new MultiField_Comm());
@@ -363,6 +378,17 @@ Schema::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & p
   full_ref_img_height_ = -1;
 }
 
+Schema::~Schema(){
+  // the exodus steps may still be queued on the I/O thread if finalize_output() was never called,
+  // write them and close the files here (a destructor must not throw so failures are only reported)
+  try{
+    finalize_output();
+  }
+  catch(std::exception & e){
+    std::cout << "Error, the output files could not be finalized: " << e.what() << std::endl;
+  }
+}
+
 void
 Schema::set_params(const std::string & params_file_name){
   // create a parameter list from the selected file
@@ -492,6 +518,21 @@ Schema::set_params(const Teuchos::RCP<Teuchos::ParameterList> & params){
   sort_txt_output_ = diceParams->get<bool>(DICe::sort_txt_output,false);
   gauss_filter_images_ = diceParams->get<bool>(DICe::gauss_filter_images,false);
   gauss_filter_mask_size_ = diceParams->get<int_t>(DICe::gauss_filter_mask_size,7);
+  image_registration_pyramid_level_ = diceParams->get<int_t>(DICe::image_registration_pyramid_level,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(image_registration_pyramid_level_<0,std::runtime_error,"Error, image_registration_pyramid_level must be >= 0");
+  phase_correlation_window_size_ = diceParams->get<int_t>(DICe::phase_correlation_window_size,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(phase_correlation_window_size_<0,std::runtime_error,"Error, phase_correlation_window_size must be >= 0");
+  exodus_output_queue_size_ = diceParams->get<int_t>(DICe::exodus_output_queue_size,4);
+  TEUCHOS_TEST_FOR_EXCEPTION(exodus_output_queue_size_<0,std::runtime_error,"Error, exodus_output_queue_size must be >= 0");
+  motion_test_decimation_ = diceParams->get<int_t>(DICe::motion_test_decimation,1);
+  TEUCHOS_TEST_FOR_EXCEPTION(motion_test_decimation_<1,std::runtime_error,"Error, motion_test_decimation must be >= 1");
+  coarse_to_fine_levels_ = diceParams->get<int_t>(DICe::coarse_to_fine_levels,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(coarse_to_fine_levels_<0,std::runtime_error,"Error, coarse_to_fine_levels must be >= 0");
+  compact_intensity_storage_ = diceParams->get<bool>(DICe::compact_intensity_storage,false);
+  rebalance_interval_ = diceParams->get<int_t>(DICe::rebalance_interval,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(rebalance_interval_<0,std::runtime_error,"Error, rebalance_interval must be >= 0");
+  rebalance_threshold_ = diceParams->get<double>(DICe::rebalance_threshold,0.1);
+  TEUCHOS_TEST_FOR_EXCEPTION(rebalance_threshold_<0.0,std::runtime_error,"Error, rebalance_threshold must be >= 0");
   compute_ref_gradients_ = diceParams->get<bool>(DICe::compute_ref_gradients,true);
   compute_def_gradients_ = diceParams->get<bool>(DICe::compute_def_gradients,false);
   compute_laplacian_image_ = diceParams->get<bool>(DICe::compute_laplacian_image,false);
@@ -1012,16 +1053,17 @@ Schema::initialize(const Teuchos::RCP<Teuchos::ParameterList> & input_params,
   const int_t num_elem = schema->mesh()->get_scalar_node_dist_map()->get_num_local_elements();
   Teuchos::ArrayRCP<int_t> connectivity(num_elem,0);
   Teuchos::ArrayRCP<int_t> elem_map(num_elem,0);
-  // note: this assumes the elements are contiguous in terms of ids and that the overlap ids
-  // are in ascending order
-  int_t overlap_offset = 0;
-  for(int_t i=0;i<node_map.size();++i){
-    if(schema->mesh()->get_scalar_node_dist_map()->get_global_element_list()[0] <= node_map[i]) break;
-    overlap_offset++;
-  }
+  // each element is the node with the same global id, so its connectivity is the local overlap index of that id
+  // (the owned ids need not be contiguous or ordered the same way in the overlap map)
+  Teuchos::RCP<MultiField_Map> overlap_map = schema->mesh()->get_scalar_node_overlap_map();
+  Teuchos::RCP<MultiField_Map> dist_map = schema->mesh()->get_scalar_node_dist_map();
   for(int_t i=0;i<num_elem;++i){
-    connectivity[i] = overlap_offset + i + 1; // + 1 because exodus elem ids are 1-based
-    elem_map[i] = schema->mesh()->get_scalar_node_dist_map()->get_global_element(i);
+    const int_t gid = dist_map->get_global_element(i);
+    const int_t overlap_lid = overlap_map->get_local_element(gid);
+    TEUCHOS_TEST_FOR_EXCEPTION(overlap_lid<0||overlap_lid>=num_overlap_coords,std::runtime_error,
+      "Error, owned subset gid " << gid << " is not in the overlap map");
+    connectivity[i] = overlap_lid + 1; // + 1 because exodus elem ids are 1-based
+    elem_map[i] = gid;
   }
   // filename for output
   std::stringstream exo_name;
@@ -1135,16 +1177,15 @@ Schema::create_mesh(Teuchos::RCP<Decomp> decomp){
   // the overlap map for is dictated by which neighbors are needed to access
   Teuchos::ArrayRCP<int_t> connectivity(num_coords,0);
   Teuchos::ArrayRCP<int_t> elem_map(num_coords,0);
-  // note: this assumes the elements are contiguous in terms of ids and that the overlap ids
-  // are in ascending order
-  int_t overlap_offset = 0;
-  for(int_t i=0;i<node_map.size();++i){
-    if(decomp->id_decomp_map()->get_global_element_list()[0] <= node_map[i]) break;
-    overlap_offset++;
-  }
+  // each element is the node with the same global id, so its connectivity is the local overlap index of that id
+  // (after a rebalance the owned ids are not contiguous)
   for(int_t i=0;i<num_coords;++i){
-    connectivity[i] = overlap_offset + i + 1; // + 1 because exodus elem ids are 1-based
-    elem_map[i] = decomp->id_decomp_map()->get_global_element_list()[i];
+    const int_t gid = decomp->id_decomp_map()->get_global_element(i);
+    const int_t overlap_lid = decomp->id_decomp_overlap_map()->get_local_element(gid);
+    TEUCHOS_TEST_FOR_EXCEPTION(overlap_lid<0||overlap_lid>=num_overlap_coords,std::runtime_error,
+      "Error, owned subset gid " << gid << " is not in the overlap map");
+    connectivity[i] = overlap_lid + 1; // + 1 because exodus elem ids are 1-based
+    elem_map[i] = gid;
   }
   // filename for output
   std::stringstream exo_name;
@@ -1253,6 +1294,204 @@ Schema::post_execution_tasks(){
   }
 }
 
+bool
+Schema::rebalance_subsets(){
+  if(rebalance_interval_<=0||analysis_type_!=LOCAL_DIC) return false;
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+  if(num_procs==1||frames_since_rebalance_<rebalance_interval_) return false;
+  // these checks give the same result on all processors so either all of them return here or none do
+  if(correlation_routine_!=GENERIC_ROUTINE) return false;
+  if(initialization_method_==USE_NEIGHBOR_VALUES||initialization_method_==USE_NEIGHBOR_VALUES_FIRST_STEP_ONLY) return false;
+  if(obstructing_subset_ids_!=Teuchos::null&&obstructing_subset_ids_->size()>0) return false;
+  if(motion_window_params_->size()>0) return false;
+  if(write_exodus_output_||binary_output_writer_!=Teuchos::null) return false;
+  for(size_t i=0;i<post_processors_.size();++i)
+    if(Teuchos::rcp_dynamic_cast<Live_Plot_Post_Processor>(post_processors_[i])!=Teuchos::null) return false;
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)subset_costs_.size()!=local_num_subsets_,std::runtime_error,"");
+  DEBUG_MSG("[PROC " << proc_id << "] Schema::rebalance_subsets(): checking the load balance after " << frames_since_rebalance_ << " frames");
+
+  // gather the cost, owner, and coordinates of all the subsets on processor 0
+  Teuchos::RCP<MultiField_Map> dist_map = mesh_->get_scalar_node_dist_map();
+  Teuchos::RCP<MultiField> costs = Teuchos::rcp(new MultiField(dist_map,2,true)); // the cols are cost and owner
+  for(int_t i=0;i<local_num_subsets_;++i){
+    costs->local_value(i,0) = subset_costs_[i];
+    costs->local_value(i,1) = proc_id;
+  }
+  const int_t num_zero_ids = proc_id==0 ? global_num_subsets_ : 0;
+  Teuchos::Array<int_t> zero_owned_ids(num_zero_ids);
+  for(int_t i=0;i<num_zero_ids;++i)
+    zero_owned_ids[i] = i;
+  Teuchos::RCP<MultiField_Map> zero_map = Teuchos::rcp(new MultiField_Map(-1,zero_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField> zero_costs = Teuchos::rcp(new MultiField(zero_map,2,true));
+  MultiField_Exporter cost_exporter(*zero_map,*dist_map);
+  zero_costs->do_import(costs,cost_exporter);
+  Teuchos::ArrayRCP<scalar_t> all_coords_x;
+  Teuchos::ArrayRCP<scalar_t> all_coords_y;
+  gather_subset_coordinates(all_coords_x,all_coords_y);
+
+  // processor 0 decides if the subsets should move and communicates the decision to all
+  Teuchos::Array<int_t> flag_zero_ids;
+  if(proc_id==0){
+    for(int_t i=0;i<num_procs;++i)
+      flag_zero_ids.push_back(i);
+  }
+  Teuchos::Array<int_t> flag_all_ids;
+  flag_all_ids.push_back(proc_id);
+  Teuchos::RCP<MultiField_Map> flag_zero_map = Teuchos::rcp(new MultiField_Map(-1,flag_zero_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> flag_all_map = Teuchos::rcp(new MultiField_Map(-1,flag_all_ids,0,*comm_));
+  Teuchos::RCP<MultiField> flag_zero_data = Teuchos::rcp(new MultiField(flag_zero_map,1,true));
+  Teuchos::RCP<MultiField> flag_all_data = Teuchos::rcp(new MultiField(flag_all_map,1,true));
+
+  Teuchos::RCP<std::vector<int_t> > owners = Teuchos::rcp(new std::vector<int_t>());
+  if(proc_id==0){
+    owners->resize(global_num_subsets_);
+    std::vector<scalar_t> weights(global_num_subsets_,0.0);
+    std::vector<scalar_t> loads(num_procs,0.0);
+    scalar_t total_load = 0.0;
+    for(int_t i=0;i<global_num_subsets_;++i){
+      weights[i] = zero_costs->local_value(i,0);
+      (*owners)[i] = static_cast<int_t>(zero_costs->local_value(i,1));
+      loads[(*owners)[i]] += weights[i];
+      total_load += weights[i];
+    }
+    const scalar_t avg_load = total_load/num_procs;
+    const scalar_t max_load = *std::max_element(loads.begin(),loads.end());
+    const scalar_t imbalance = avg_load > 0.0 ? max_load/avg_load - 1.0 : 0.0;
+    DEBUG_MSG("Schema::rebalance_subsets(): slowest processor time " << max_load << " average " << avg_load << " imbalance " << imbalance);
+    if(imbalance > rebalance_threshold_){
+      // subsets that were skipped still need a small weight so they get spread out
+      const scalar_t min_weight = 1.0E-3*avg_load*num_procs/global_num_subsets_;
+      for(int_t i=0;i<global_num_subsets_;++i)
+        weights[i] = std::max(weights[i],min_weight);
+      std::vector<int_t> part_ids;
+      partition_points_rcb(all_coords_x,all_coords_y,num_procs,part_ids,weights);
+      // give each part to the processor that already owns the largest share of its cost to limit the migration
+      std::map<std::pair<int_t,int_t>,scalar_t> shared_costs; // (part, proc) -> cost
+      for(int_t i=0;i<global_num_subsets_;++i)
+        shared_costs[std::pair<int_t,int_t>(part_ids[i],(*owners)[i])] += weights[i];
+      std::vector<std::tuple<scalar_t,int_t,int_t> > candidates;
+      for(std::map<std::pair<int_t,int_t>,scalar_t>::const_iterator it=shared_costs.begin();it!=shared_costs.end();++it)
+        candidates.push_back(std::tuple<scalar_t,int_t,int_t>(it->second,it->first.first,it->first.second));
+      std::sort(candidates.begin(),candidates.end(),[](const std::tuple<scalar_t,int_t,int_t> & a, const std::tuple<scalar_t,int_t,int_t> & b)
+        {return std::get<0>(a) > std::get<0>(b);});
+      std::vector<int_t> part_to_proc(num_procs,-1);
+      std::vector<bool> proc_taken(num_procs,false);
+      for(size_t i=0;i<candidates.size();++i){
+        const int_t part = std::get<1>(candidates[i]);
+        const int_t proc = std::get<2>(candidates[i]);
+        if(part_to_proc[part]!=-1||proc_taken[proc]) continue;
+        part_to_proc[part] = proc;
+        proc_taken[proc] = true;
+      }
+      int_t next_proc = 0;
+      for(int_t part=0;part<num_procs;++part){
+        if(part_to_proc[part]!=-1) continue;
+        while(proc_taken[next_proc]) next_proc++;
+        part_to_proc[part] = next_proc;
+        proc_taken[next_proc] = true;
+      }
+      std::vector<scalar_t> new_loads(num_procs,0.0);
+      int_t num_moved = 0;
+      for(int_t i=0;i<global_num_subsets_;++i){
+        const int_t new_owner = part_to_proc[part_ids[i]];
+        new_loads[new_owner] += weights[i];
+        if(new_owner!=(*owners)[i]) num_moved++;
+      }
+      const scalar_t new_max_load = *std::max_element(new_loads.begin(),new_loads.end());
+      // the loads were measured over frames_since_rebalance_ frames, assume they hold for the next interval
+      const scalar_t expected_savings = (max_load - new_max_load)/frames_since_rebalance_*rebalance_interval_;
+      // if there hasn't been a migration yet, assume it costs as much as a frame on the slowest processor
+      const scalar_t migration_cost = rebalance_cost_ >= 0.0 ? rebalance_cost_ : max_load/frames_since_rebalance_;
+      DEBUG_MSG("Schema::rebalance_subsets(): new slowest processor time " << new_max_load << " subsets to move " << num_moved <<
+        " expected savings " << expected_savings << " estimated migration cost " << migration_cost);
+      if(num_moved>0&&expected_savings>migration_cost){
+        for(int_t i=0;i<global_num_subsets_;++i)
+          (*owners)[i] = part_to_proc[part_ids[i]];
+        flag_zero_data->put_scalar(1.0);
+      }
+    }
+  } // end proc 0
+  MultiField_Exporter flag_exporter(*flag_all_map,*flag_zero_map);
+  flag_all_data->do_import(flag_zero_data,flag_exporter,INSERT);
+
+  // start a new measurement window
+  frames_since_rebalance_ = 0;
+  subset_costs_.assign(local_num_subsets_,0.0);
+  if(flag_all_data->local_value(0)<=0.0) return false;
+
+  const double migration_start_time = Teuchos::Time::wallTime();
+  migrate_subsets(owners,all_coords_x,all_coords_y);
+  rebalance_cost_ = Teuchos::Time::wallTime() - migration_start_time;
+  DEBUG_MSG("[PROC " << proc_id << "] Schema::rebalance_subsets(): migration time " << rebalance_cost_);
+  return true;
+}
+
+void
+Schema::gather_subset_coordinates(Teuchos::ArrayRCP<scalar_t> & coords_x,
+  Teuchos::ArrayRCP<scalar_t> & coords_y){
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_zero_ids = proc_id==0 ? global_num_subsets_*2 : 0;
+  Teuchos::Array<int_t> zero_owned_vector_ids(num_zero_ids);
+  for(int_t i=0;i<num_zero_ids;++i)
+    zero_owned_vector_ids[i] = i;
+  Teuchos::RCP<MultiField_Map> zero_vector_map = Teuchos::rcp(new MultiField_Map(-1,zero_owned_vector_ids,0,*comm_));
+  Teuchos::RCP<MultiField> zero_coords = Teuchos::rcp(new MultiField(zero_vector_map,1,true));
+  Teuchos::RCP<MultiField> coords = mesh_->get_field(INITIAL_COORDINATES_FS);
+  MultiField_Exporter coords_exporter(*zero_vector_map,*coords->get_map());
+  zero_coords->do_import(coords,coords_exporter);
+  coords_x.clear();
+  coords_y.clear();
+  if(proc_id!=0) return;
+  coords_x.resize(global_num_subsets_);
+  coords_y.resize(global_num_subsets_);
+  for(int_t i=0;i<global_num_subsets_;++i){
+    coords_x[i] = zero_coords->local_value(i*2+0);
+    coords_y[i] = zero_coords->local_value(i*2+1);
+  }
+}
+
+void
+Schema::migrate_subsets(Teuchos::RCP<std::vector<int_t> > owners){
+  TEUCHOS_TEST_FOR_EXCEPTION(analysis_type_!=LOCAL_DIC||mesh_==Teuchos::null,std::runtime_error,
+    "Error, subsets can only be migrated for a local DIC analysis that has been initialized");
+  if(owners==Teuchos::null)
+    owners = Teuchos::rcp(new std::vector<int_t>());
+  TEUCHOS_TEST_FOR_EXCEPTION(comm_->get_rank()==0&&(int_t)owners->size()!=global_num_subsets_,std::runtime_error,
+    "Error, the number of owners " << owners->size() << " does not match the number of subsets " << global_num_subsets_);
+  Teuchos::ArrayRCP<scalar_t> all_coords_x;
+  Teuchos::ArrayRCP<scalar_t> all_coords_y;
+  gather_subset_coordinates(all_coords_x,all_coords_y);
+  migrate_subsets(owners,all_coords_x,all_coords_y);
+}
+
+void
+Schema::migrate_subsets(Teuchos::RCP<std::vector<int_t> > owners,
+  Teuchos::ArrayRCP<scalar_t> all_coords_x,
+  Teuchos::ArrayRCP<scalar_t> all_coords_y){
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::migrate_subsets(): moving subsets");
+  Teuchos::RCP<DICe::mesh::Mesh> old_mesh = mesh_;
+  Teuchos::RCP<Decomp> decomp = Teuchos::rcp(new Decomp(global_num_subsets_,all_coords_x,all_coords_y,owners,init_params_));
+  this_proc_gid_order_ = decomp->this_proc_gid_order();
+  create_mesh(decomp);
+  // copy the field values from the old owners to the new ones
+  DICe::mesh::field_registry::iterator field_it = old_mesh->get_field_registry()->begin();
+  for(;field_it!=old_mesh->get_field_registry()->end();++field_it){
+    mesh_->create_field(field_it->first);
+    Teuchos::RCP<MultiField> to_field = mesh_->get_field(field_it->first);
+    MultiField_Exporter field_exporter(*to_field->get_map(),*field_it->second->get_map());
+    to_field->do_import(field_it->second,field_exporter,INSERT);
+  }
+  // the tracking routine objectives and initializers were built for the old local subsets,
+  // they are rebuilt from the reference image on the next call to execute_correlation()
+  obj_vec_.clear();
+  opt_initializers_.clear();
+  for(size_t i=0;i<post_processors_.size();++i)
+    post_processors_[i]->initialize(mesh_);
+  subset_costs_.assign(local_num_subsets_,0.0);
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::migrate_subsets(): now owns " << local_num_subsets_ << " subsets");
+}
+
 void
 Schema::project_right_image_into_left_frame(Teuchos::RCP<Triangulation> tri,
   const bool reference){
@@ -1456,7 +1695,10 @@ Schema::execute_correlation(){
   if(has_initial_condition_file()&&frame_id_==first_frame_id_){
     TEUCHOS_TEST_FOR_EXCEPTION(initialization_method_!=USE_FIELD_VALUES,std::runtime_error,
       "Initialization method must be USE_FIELD_VALUES if an initial condition file is specified");
-    Teuchos::RCP<DICe::mesh::Importer_Projector> importer = Teuchos::rcp(new DICe::mesh::Importer_Projector(initial_condition_file_,mesh_));
+    // the importer is only rebuilt if the file or the local subset locations have changed since it was created
+    if(initial_condition_importer_==Teuchos::null||!initial_condition_importer_->matches(initial_condition_file_,mesh_))
+      initial_condition_importer_ = Teuchos::rcp(new DICe::mesh::Importer_Projector(initial_condition_file_,mesh_));
+    Teuchos::RCP<DICe::mesh::Importer_Projector> importer = initial_condition_importer_;
     TEUCHOS_TEST_FOR_EXCEPTION(importer->num_target_pts()!=local_num_subsets_,std::runtime_error,"");
     std::vector<scalar_t> disp_x;
     std::vector<scalar_t> disp_y;
@@ -1485,8 +1727,12 @@ Schema::execute_correlation(){
     TEUCHOS_TEST_FOR_EXCEPTION(motion_window_params_->size()!=0,std::runtime_error,
       "Error, motion windows are intended only for the TRACKING_ROUTINE");
     prepare_optimization_initializers();
+    if(rebalance_interval_>0&&(int_t)subset_costs_.size()!=local_num_subsets_)
+      subset_costs_.assign(local_num_subsets_,0.0);
     for(int_t subset_index=0;subset_index<local_num_subsets_;++subset_index){
       DEBUG_MSG("Schema::execute_correlation(): creating Objective for subset " << this_proc_gid_order_[subset_index]);
+      DICE_PROFILE_BEGIN_SUBSET(this_proc_gid_order_[subset_index]);
+      const double subset_start_time = rebalance_interval_>0 ? Teuchos::Time::wallTime() : 0.0;
       try{
         Teuchos::RCP<Objective> obj = Teuchos::rcp(new Objective_ZNSSD(this,this_proc_gid_order_[subset_index]));
         DEBUG_MSG("Schema::execute_correlation(): Objective creation successful");
@@ -1496,7 +1742,14 @@ Schema::execute_correlation(){
         DEBUG_MSG("Schema::execute_correlation(): subset " << this_proc_gid_order_[subset_index] << " failed");
         record_failed_step(this_proc_gid_order_[subset_index],static_cast<int_t>(INITIALIZE_FAILED_BY_EXCEPTION),-1);
       }
+      if(rebalance_interval_>0)
+        subset_costs_[subset_local_id(this_proc_gid_order_[subset_index])] += Teuchos::Time::wallTime() - subset_start_time;
+      DICE_PROFILE_END_SUBSET(this_proc_gid_order_[subset_index],
+        static_cast<int_t>(global_field_value(this_proc_gid_order_[subset_index],ITERATIONS_FS)),
+        static_cast<int_t>(global_field_value(this_proc_gid_order_[subset_index],STATUS_FLAG_FS)));
     }
+    if(rebalance_interval_>0)
+      frames_since_rebalance_++;
   }
   // In this routine there are usually only a handful of subsets, but thousands of images.
   // In this case it is a lot more efficient to make the objectives static since there won't
@@ -1526,7 +1779,10 @@ Schema::execute_correlation(){
       const int_t subset_gid = this_proc_gid_order_[subset_index];
       const int_t subset_lid = subset_local_id(subset_gid);
       check_for_blocking_subsets(subset_gid);
+      DICE_PROFILE_BEGIN_SUBSET(subset_gid);
       generic_correlation_routine(obj_vec_[subset_lid]);
+      DICE_PROFILE_END_SUBSET(subset_gid,static_cast<int_t>(global_field_value(subset_gid,ITERATIONS_FS)),
+        static_cast<int_t>(global_field_value(subset_gid,STATUS_FLAG_FS)));
     }
     if(output_deformed_subset_images_)
       write_deformed_subsets_image();
@@ -1586,6 +1842,7 @@ Schema::save_cross_correlation_fields(){
 
 void
 Schema::execute_post_processors(){
+  DICE_PROFILE_SCOPE(PROFILE_POST_PROCESS);
   // compute post-processed quantities
   for(size_t i=0;i<post_processors_.size();++i){
     post_processors_[i]->execute();
@@ -1598,9 +1855,12 @@ Schema::prepare_optimization_initializers(){
   // method only needs to be called once, return if the pointers are alread addressed
   if(opt_initializers_.size()>0){
     DEBUG_MSG("Repeat call to prepare_optimization_initializers(), calling pre_execution_tasks");
+    // the default initializer is shared by many subsets so make sure each one is only called once
+    std::set<Initializer*> prepared;
     for(std::map<int_t,Teuchos::RCP<Initializer> >::iterator opt_it = opt_initializers_.begin();
         opt_it != opt_initializers_.end();++opt_it){
       //assert(*opt_it!=Teuchos::null);
+      if(!prepared.insert(opt_it->second.get()).second) continue;
       opt_it->second->pre_execution_tasks();
     }
     return;
@@ -1612,6 +1872,16 @@ Schema::prepare_optimization_initializers(){
     DEBUG_MSG("Default initializer is phase correlation initializer");
     default_initializer = Teuchos::rcp(new Phase_Correlation_Initializer(this));
   }
+  else if(initialization_method_==USE_SUBSET_PHASE_CORRELATION){
+    DEBUG_MSG("Default initializer is subset phase correlation initializer");
+    int_t window_size = phase_correlation_window_size_;
+    if(window_size==0){
+      TEUCHOS_TEST_FOR_EXCEPTION(subset_dim_<=0,std::runtime_error,"Error, phase_correlation_window_size must be "
+          "specified for USE_SUBSET_PHASE_CORRELATION if the subsets are not square");
+      window_size = 2*subset_dim_;
+    }
+    default_initializer = Teuchos::rcp(new Subset_Phase_Correlation_Initializer(this,window_size));
+  }
   else if(initialization_method_==USE_ZEROS){
     DEBUG_MSG("Default initializer is zero value initializer");
     default_initializer = Teuchos::rcp(new Zero_Value_Initializer(this));
@@ -1680,9 +1950,11 @@ Schema::prepare_optimization_initializers(){
     opt_initializers_.insert(std::pair<int_t,Teuchos::RCP<Initializer> >(0,default_initializer));
   }
 
-  // call pre-correlation tasks for initializers
+  // call pre-correlation tasks for initializers (once for each unique initializer)
+  std::set<Initializer*> prepared;
   for(std::map<int_t,Teuchos::RCP<Initializer> >::iterator opt_it = opt_initializers_.begin();
       opt_it != opt_initializers_.end();++opt_it){
+    if(!prepared.insert(opt_it->second.get()).second) continue;
     opt_it->second->pre_execution_tasks();
   }
 }
@@ -1700,7 +1972,8 @@ Schema::motion_detected(const int_t subset_gid){
       // create the motion detector because it doesn't exist
       DEBUG_MSG("Creating a motion test utility for subset " << subset_gid << " using id " << use_subset_id);
       Motion_Window_Params mwp = motion_window_params_->find(use_subset_id)->second;
-      motion_detectors_.insert(std::pair<int_t,Teuchos::RCP<Motion_Test_Utility> >(use_subset_id,Teuchos::rcp(new Motion_Test_Utility(this,mwp.tol_))));
+      motion_detectors_.insert(std::pair<int_t,Teuchos::RCP<Motion_Test_Utility> >(use_subset_id,Teuchos::rcp(new Motion_Test_Utility(this,mwp.tol_,
+        mwp.start_x_,mwp.start_y_,mwp.end_x_,mwp.end_y_,motion_test_decimation_))));
     }
     TEUCHOS_TEST_FOR_EXCEPTION(motion_detectors_.find(use_subset_id)==motion_detectors_.end(),std::runtime_error,
       "Error, the motion detector should exist here, but it doesn't.");
@@ -1720,6 +1993,7 @@ Schema::record_failed_step(const int_t subset_gid,
   const int_t status,
   const int_t num_iterations){
   DEBUG_MSG("Subset " << subset_gid << " record failed step");
+  DICE_PROFILE_COUNT(PROFILE_FAILED_SUBSETS,1);
   global_field_value(subset_gid,SIGMA_FS) = -1.0;
   global_field_value(subset_gid,MATCH_FS) = -1.0;
   global_field_value(subset_gid,GAMMA_FS) = -1.0;
@@ -1769,6 +2043,7 @@ Schema::initial_guess(const int_t subset_gid,
   }
   TEUCHOS_TEST_FOR_EXCEPTION(opt_initializers_.find(sid)==opt_initializers_.end(),std::runtime_error,
     "Initializer does not exist, but should here");
+  DICE_PROFILE_SCOPE(PROFILE_INITIALIZATION);
   return opt_initializers_.find(sid)->second->initial_guess(subset_gid,shape_function);
 }
 
@@ -1948,6 +2223,13 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
   else if(optimization_method_==DICe::GRADIENT_BASED||optimization_method_==DICe::GRADIENT_BASED_THEN_SIMPLEX||
       optimization_method_==DICe::GRADIENT_THEN_SEARCH){
     try{
+      if(coarse_to_fine_levels_>0){
+        const std::vector<scalar_t> initial_parameters = *shape_function->parameters();
+        if(obj->computeUpdateCoarse(shape_function,coarse_to_fine_levels_)!=CORRELATION_SUCCESSFUL){
+          DEBUG_MSG("Subset " << subset_gid << " coarse-to-fine update failed, using the initial guess");
+          *shape_function->parameters() = initial_parameters;
+        }
+      }
       corr_status = obj->computeUpdateFast(shape_function,num_iterations);
     }
     catch (std::logic_error &err) { //a non-graceful exception occurred
@@ -2338,22 +2620,13 @@ Schema::estimate_resolution_error(const Teuchos::RCP<Teuchos::ParameterList> & c
     fclose(infoFilePtr);
   }
   const int_t spa_dim = mesh_->spatial_dimension();
+  // list all the cases up front so that the synthetic images can be generated ahead of the correlation
+  std::vector<scalar_t> case_periods;
+  std::vector<scalar_t> case_amplitudes;
+  std::vector<std::string> case_file_names;
   for(scalar_t period=max_period;period>=min_period;period*=period_factor){
-    // reset the displacements between frequency updates, otherwise the existing solution makes a nice initial guess
-    if(is_subset_based){
-      mesh_->get_field(SUBSET_DISPLACEMENT_X_FS)->put_scalar(0.0);
-      mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS)->put_scalar(0.0);
-    }else{
-      mesh_->get_field(DISPLACEMENT_FS)->put_scalar(0.0);
-    }
-    mesh_->get_field(SIGMA_FS)->put_scalar(0.0);
     for(scalar_t amplitude=min_amp;amplitude<=max_amp;amplitude+=amp_step){
-      if(proc_id==0)
-        std::cout << "processing resolution error for period " << period << " amplitude " << amplitude << std::endl;
-      // create an image deformer class
-      image_deformer_ = Teuchos::rcp(new SinCos_Image_Deformer(period,amplitude));
       std::stringstream sincos_name;
-      Teuchos::RCP<Image> def_img;
       std::stringstream amp_ss;
       std::stringstream per_ss;
       amp_ss << amplitude;
@@ -2363,230 +2636,246 @@ Schema::estimate_resolution_error(const Teuchos::RCP<Teuchos::ParameterList> & c
       std::string per_s = per_ss.str();
       std::replace( per_s.begin(), per_s.end(), '.', 'p'); // replace dots with p for file name
       sincos_name << image_dir_str << "amp_" << std::setprecision(4) << amp_s << "_period_" << std::setprecision(4) << per_s << "_proc_" << proc_id << ".tif";
-
-      // check to see if the deformed image already exists:
-      std::ifstream f(sincos_name.str().c_str());
-      //if(f.good()){
-      //  DEBUG_MSG("using previously saved image");
-      //  def_img = Teuchos::rcp(new DICe::Image(sincos_name.str().c_str()));
-      //}else{
-        DEBUG_MSG("generating new synthetic image");
-        def_img = image_deformer_->deform_image(ref_img());
-        if(noise_percent > 0.0){
-          add_noise_to_image(def_img,noise_percent);
-        }
-        def_img->write(sincos_name.str());
-      //}
-
-      // set the deformed image for the schema
-      set_def_image(def_img);
-      int_t corr_error = execute_correlation();
-      TEUCHOS_TEST_FOR_EXCEPTION(corr_error,std::runtime_error,"Error, correlation unsuccesssful");
-      DEBUG_MSG("Error prediction step correlation return value " << corr_error);
-      execute_post_processors();
-      post_execution_tasks();
-
-      // gather all owned fields here
-      Teuchos::RCP<MultiField> coords = mesh_->get_field(INITIAL_COORDINATES_FS);
-      Teuchos::RCP<MultiField> disp;
+      case_periods.push_back(period);
+      case_amplitudes.push_back(amplitude);
+      case_file_names.push_back(sincos_name.str());
+    }
+  }
+  const int_t num_threads = correlation_params->get<int_t>(DICe::estimate_resolution_error_num_threads,1);
+  TEUCHOS_TEST_FOR_EXCEPTION(num_threads <= 0,std::runtime_error,"Error, invalid number of threads: " << num_threads);
+  DEBUG_MSG("generating the synthetic images for " << case_periods.size() << " cases on " << num_threads << " thread(s)");
+  // the deformed images are filtered and their gradients computed by the generator so that
+  // set_def_image() below does not repeat the work on this thread, the reference image is held
+  // here for the life of the generator in case the schema's reference image is replaced
+  Teuchos::RCP<Image> sweep_ref_img = ref_img();
+  Synthetic_Image_Generator image_generator(sweep_ref_img,case_periods,case_amplitudes,case_file_names,noise_percent,
+    gauss_filter_images_ ? gauss_filter_mask_size_ : -1,compute_def_gradients_,num_threads);
+  for(int_t case_it=0;case_it<image_generator.num_cases();++case_it){
+    const scalar_t period = case_periods[case_it];
+    const scalar_t amplitude = case_amplitudes[case_it];
+    if(case_it==0||period!=case_periods[case_it-1]){
+      // reset the displacements between frequency updates, otherwise the existing solution makes a nice initial guess
       if(is_subset_based){
-        Teuchos::RCP<MultiField> disp_x = mesh_->get_field(SUBSET_DISPLACEMENT_X_FS);
-        Teuchos::RCP<MultiField> disp_y = mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS);
-        Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
-        disp = Teuchos::rcp( new MultiField(map,1,true));
-        for(int_t i=0;i<local_num_subsets_;++i){
-          disp->local_value(i*spa_dim+0) = disp_x->local_value(i);
-          disp->local_value(i*spa_dim+1) = disp_y->local_value(i);
-        }
+        mesh_->get_field(SUBSET_DISPLACEMENT_X_FS)->put_scalar(0.0);
+        mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS)->put_scalar(0.0);
       }else{
-        disp = mesh_->get_field(DISPLACEMENT_FS);
+        mesh_->get_field(DISPLACEMENT_FS)->put_scalar(0.0);
+      }
+      mesh_->get_field(SIGMA_FS)->put_scalar(0.0);
+    }
+    if(proc_id==0)
+      std::cout << "processing resolution error for period " << period << " amplitude " << amplitude << std::endl;
+    // the image deformer for this case is used below to compute the exact solution
+    Teuchos::RCP<Image> def_img = image_generator.next(image_deformer_);
+
+    // set the deformed image for the schema
+    set_def_image(def_img);
+    int_t corr_error = execute_correlation();
+    TEUCHOS_TEST_FOR_EXCEPTION(corr_error,std::runtime_error,"Error, correlation unsuccesssful");
+    DEBUG_MSG("Error prediction step correlation return value " << corr_error);
+    execute_post_processors();
+    post_execution_tasks();
+
+    // gather all owned fields here
+    Teuchos::RCP<MultiField> coords = mesh_->get_field(INITIAL_COORDINATES_FS);
+    Teuchos::RCP<MultiField> disp;
+    if(is_subset_based){
+      Teuchos::RCP<MultiField> disp_x = mesh_->get_field(SUBSET_DISPLACEMENT_X_FS);
+      Teuchos::RCP<MultiField> disp_y = mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS);
+      Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
+      disp = Teuchos::rcp( new MultiField(map,1,true));
+      for(int_t i=0;i<local_num_subsets_;++i){
+        disp->local_value(i*spa_dim+0) = disp_x->local_value(i);
+        disp->local_value(i*spa_dim+1) = disp_y->local_value(i);
       }
-      Teuchos::RCP<MultiField> vsg_xx;
-      Teuchos::RCP<MultiField> vsg_xy;
-      Teuchos::RCP<MultiField> vsg_yy;
-      Teuchos::RCP<MultiField> nlvc_xx;
-      Teuchos::RCP<MultiField> nlvc_xy;
-      Teuchos::RCP<MultiField> nlvc_yy;
+    }else{
+      disp = mesh_->get_field(DISPLACEMENT_FS);
+    }
+    Teuchos::RCP<MultiField> vsg_xx;
+    Teuchos::RCP<MultiField> vsg_xy;
+    Teuchos::RCP<MultiField> vsg_yy;
+    Teuchos::RCP<MultiField> nlvc_xx;
+    Teuchos::RCP<MultiField> nlvc_xy;
+    Teuchos::RCP<MultiField> nlvc_yy;
+    if(has_vsg){
+      vsg_xx = mesh_->get_field(VSG_STRAIN_XX_FS);
+      vsg_xy = mesh_->get_field(VSG_STRAIN_XY_FS);
+      vsg_yy = mesh_->get_field(VSG_STRAIN_YY_FS);
+    }
+    if(has_nlvc){
+      nlvc_xx = mesh_->get_field(NLVC_STRAIN_XX_FS);
+      nlvc_xy = mesh_->get_field(NLVC_STRAIN_XY_FS);
+      nlvc_yy = mesh_->get_field(NLVC_STRAIN_YY_FS);
+    }
+    // compute the error fields
+    for(int_t i=0;i<local_num_subsets_;++i){
+      const scalar_t x = coords->local_value(i*spa_dim+0);
+      const scalar_t y = coords->local_value(i*spa_dim+1);
+      const scalar_t u = disp->local_value(i*spa_dim+0);
+      const scalar_t v = disp->local_value(i*spa_dim+1);
+      scalar_t exact_u = 0.0;
+      scalar_t exact_v = 0.0;
+      image_deformer_->compute_deformation(x,y,exact_u,exact_v);
+      exact_disp->local_value(i*spa_dim+0) = exact_u;
+      exact_disp->local_value(i*spa_dim+1) = exact_v;
+      scalar_t error_v = 0.0;
+      scalar_t error_u = 0.0;
+      image_deformer_->compute_displacement_error(x,y,u,v,error_u,error_v);
+      disp_error->local_value(i*spa_dim+0) = std::abs(error_u);
+      disp_error->local_value(i*spa_dim+1) = std::abs(error_v);
+      scalar_t strain_xx = 0.0;
+      scalar_t strain_xy = 0.0;
+      scalar_t strain_yy = 0.0;
+      image_deformer_->compute_lagrange_strain(x,y,strain_xx,strain_xy,strain_yy);
+      exact_strain_xx->local_value(i) = strain_xx;
+      exact_strain_xy->local_value(i) = strain_xy;
+      exact_strain_yy->local_value(i) = strain_yy;
       if(has_vsg){
-        vsg_xx = mesh_->get_field(VSG_STRAIN_XX_FS);
-        vsg_xy = mesh_->get_field(VSG_STRAIN_XY_FS);
-        vsg_yy = mesh_->get_field(VSG_STRAIN_YY_FS);
+        const scalar_t e_xx = vsg_xx->local_value(i);
+        const scalar_t e_xy = vsg_xy->local_value(i);
+        const scalar_t e_yy = vsg_yy->local_value(i);
+        scalar_t error_xx = 0.0;
+        scalar_t error_xy = 0.0;
+        scalar_t error_yy = 0.0;
+        image_deformer_->compute_lagrange_strain_error(x,y,e_xx,e_xy,e_yy,error_xx,error_xy,error_yy);
+        vsg_error_xx->local_value(i) = std::abs(error_xx);
+        vsg_error_xy->local_value(i) = std::abs(error_xy);
+        vsg_error_yy->local_value(i) = std::abs(error_yy);
       }
       if(has_nlvc){
-        nlvc_xx = mesh_->get_field(NLVC_STRAIN_XX_FS);
-        nlvc_xy = mesh_->get_field(NLVC_STRAIN_XY_FS);
-        nlvc_yy = mesh_->get_field(NLVC_STRAIN_YY_FS);
+        const scalar_t e_xx = nlvc_xx->local_value(i);
+        const scalar_t e_xy = nlvc_xy->local_value(i);
+        const scalar_t e_yy = nlvc_yy->local_value(i);
+        scalar_t error_xx = 0.0;
+        scalar_t error_xy = 0.0;
+        scalar_t error_yy = 0.0;
+        image_deformer_->compute_lagrange_strain_error(x,y,e_xx,e_xy,e_yy,error_xx,error_xy,error_yy);
+        nlvc_error_xx->local_value(i) = std::abs(error_xx);
+        nlvc_error_xy->local_value(i) = std::abs(error_xy);
+        nlvc_error_yy->local_value(i) = std::abs(error_yy);
       }
-      // compute the error fields
-      for(int_t i=0;i<local_num_subsets_;++i){
-        const scalar_t x = coords->local_value(i*spa_dim+0);
-        const scalar_t y = coords->local_value(i*spa_dim+1);
-        const scalar_t u = disp->local_value(i*spa_dim+0);
-        const scalar_t v = disp->local_value(i*spa_dim+1);
-        scalar_t exact_u = 0.0;
-        scalar_t exact_v = 0.0;
-        image_deformer_->compute_deformation(x,y,exact_u,exact_v);
-        exact_disp->local_value(i*spa_dim+0) = exact_u;
-        exact_disp->local_value(i*spa_dim+1) = exact_v;
-        scalar_t error_v = 0.0;
-        scalar_t error_u = 0.0;
-        image_deformer_->compute_displacement_error(x,y,u,v,error_u,error_v);
-        disp_error->local_value(i*spa_dim+0) = std::abs(error_u);
-        disp_error->local_value(i*spa_dim+1) = std::abs(error_v);
-        scalar_t strain_xx = 0.0;
-        scalar_t strain_xy = 0.0;
-        scalar_t strain_yy = 0.0;
-        image_deformer_->compute_lagrange_strain(x,y,strain_xx,strain_xy,strain_yy);
-        exact_strain_xx->local_value(i) = strain_xx;
-        exact_strain_xy->local_value(i) = strain_xy;
-        exact_strain_yy->local_value(i) = strain_yy;
-        if(has_vsg){
-          const scalar_t e_xx = vsg_xx->local_value(i);
-          const scalar_t e_xy = vsg_xy->local_value(i);
-          const scalar_t e_yy = vsg_yy->local_value(i);
-          scalar_t error_xx = 0.0;
-          scalar_t error_xy = 0.0;
-          scalar_t error_yy = 0.0;
-          image_deformer_->compute_lagrange_strain_error(x,y,e_xx,e_xy,e_yy,error_xx,error_xy,error_yy);
-          vsg_error_xx->local_value(i) = std::abs(error_xx);
-          vsg_error_xy->local_value(i) = std::abs(error_xy);
-          vsg_error_yy->local_value(i) = std::abs(error_yy);
-        }
-        if(has_nlvc){
-          const scalar_t e_xx = nlvc_xx->local_value(i);
-          const scalar_t e_xy = nlvc_xy->local_value(i);
-          const scalar_t e_yy = nlvc_yy->local_value(i);
-          scalar_t error_xx = 0.0;
-          scalar_t error_xy = 0.0;
-          scalar_t error_yy = 0.0;
-          image_deformer_->compute_lagrange_strain_error(x,y,e_xx,e_xy,e_yy,error_xx,error_xy,error_yy);
-          nlvc_error_xx->local_value(i) = std::abs(error_xx);
-          nlvc_error_xy->local_value(i) = std::abs(error_xy);
-          nlvc_error_yy->local_value(i) = std::abs(error_yy);
-        }
-      } // end local subsets loop
-
-      result_stream << subset_elem_size << " " << step_size << " " << avg_speckle_size << " " << noise_percent << " " << vsg_size << " " << nlvc_size;
-
-      // collect the global stats based on the field info above:
-      scalar_t min_error_u = 0.0;
-      scalar_t max_error_u = 0.0;
-      scalar_t avg_error_u = 0.0;
-      scalar_t std_dev_error_u = 0.0;
-      scalar_t min_error_v = 0.0;
-      scalar_t max_error_v = 0.0;
-      scalar_t avg_error_v = 0.0;
-      scalar_t std_dev_error_v = 0.0;
-      mesh_->field_stats(DISP_ERROR_FS,min_error_u,max_error_u,avg_error_u,std_dev_error_u,0,SIGMA_FS,-1.0);
-      mesh_->field_stats(DISP_ERROR_FS,min_error_v,max_error_v,avg_error_v,std_dev_error_v,1,SIGMA_FS,-1.0);
-      result_stream << " " << std::setprecision(4) << period << " "<< std::setprecision(4) << amplitude
-          << " " << min_error_u << " " << max_error_u << " " << avg_error_u << " " << std_dev_error_u << " " << min_error_v << " " << max_error_v << " " << avg_error_v << " " << std_dev_error_v;
-
-      scalar_t peaks_avg_error_x = 0.0;
-      scalar_t peaks_std_dev_error_x = 0.0;
-      scalar_t peaks_avg_error_y = 0.0;
-      scalar_t peaks_std_dev_error_y = 0.0;
-      // analyze the peaks of the output to evaluate the roll off
-      compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,disp,exact_disp,disp_error,
-        peaks_avg_error_x,peaks_std_dev_error_x,peaks_avg_error_y,peaks_std_dev_error_y);
-      result_stream << " " << peaks_avg_error_x << " " << peaks_std_dev_error_x << " " << peaks_avg_error_y << " " << peaks_std_dev_error_y;
+    } // end local subsets loop
+
+    result_stream << subset_elem_size << " " << step_size << " " << avg_speckle_size << " " << noise_percent << " " << vsg_size << " " << nlvc_size;
+
+    // collect the global stats based on the field info above:
+    scalar_t min_error_u = 0.0;
+    scalar_t max_error_u = 0.0;
+    scalar_t avg_error_u = 0.0;
+    scalar_t std_dev_error_u = 0.0;
+    scalar_t min_error_v = 0.0;
+    scalar_t max_error_v = 0.0;
+    scalar_t avg_error_v = 0.0;
+    scalar_t std_dev_error_v = 0.0;
+    mesh_->field_stats(DISP_ERROR_FS,min_error_u,max_error_u,avg_error_u,std_dev_error_u,0,SIGMA_FS,-1.0);
+    mesh_->field_stats(DISP_ERROR_FS,min_error_v,max_error_v,avg_error_v,std_dev_error_v,1,SIGMA_FS,-1.0);
+    result_stream << " " << std::setprecision(4) << period << " "<< std::setprecision(4) << amplitude
+        << " " << min_error_u << " " << max_error_u << " " << avg_error_u << " " << std_dev_error_u << " " << min_error_v << " " << max_error_v << " " << avg_error_v << " " << std_dev_error_v;
+
+    scalar_t peaks_avg_error_x = 0.0;
+    scalar_t peaks_std_dev_error_x = 0.0;
+    scalar_t peaks_avg_error_y = 0.0;
+    scalar_t peaks_std_dev_error_y = 0.0;
+    // analyze the peaks of the output to evaluate the roll off
+    compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,disp,exact_disp,disp_error,
+      peaks_avg_error_x,peaks_std_dev_error_x,peaks_avg_error_y,peaks_std_dev_error_y);
+    result_stream << " " << peaks_avg_error_x << " " << peaks_std_dev_error_x << " " << peaks_avg_error_y << " " << peaks_std_dev_error_y;
 
-      if(has_vsg){
-        scalar_t min_vsg_xx = 0.0;
-        scalar_t max_vsg_xx = 0.0;
-        scalar_t avg_vsg_xx = 0.0;
-        scalar_t std_dev_vsg_xx = 0.0;
-        scalar_t min_vsg_xy = 0.0;
-        scalar_t max_vsg_xy = 0.0;
-        scalar_t avg_vsg_xy = 0.0;
-        scalar_t std_dev_vsg_xy = 0.0;
-        scalar_t min_vsg_yy = 0.0;
-        scalar_t max_vsg_yy = 0.0;
-        scalar_t avg_vsg_yy = 0.0;
-        scalar_t std_dev_vsg_yy = 0.0;
-        mesh_->field_stats(VSG_STRAIN_XX_ERROR_FS,min_vsg_xx,max_vsg_xx,avg_vsg_xx,std_dev_vsg_xx,0,SIGMA_FS,-1.0);
-        mesh_->field_stats(VSG_STRAIN_XY_ERROR_FS,min_vsg_xy,max_vsg_xy,avg_vsg_xy,std_dev_vsg_xy,0,SIGMA_FS,-1.0);
-        mesh_->field_stats(VSG_STRAIN_YY_ERROR_FS,min_vsg_yy,max_vsg_yy,avg_vsg_yy,std_dev_vsg_yy,0,SIGMA_FS,-1.0);
-        result_stream << " " << min_vsg_xx << " " << max_vsg_xx << " " << avg_vsg_xx << " " << std_dev_vsg_xx;
-        result_stream << " " << min_vsg_xy << " " << max_vsg_xy << " " << avg_vsg_xy << " " << std_dev_vsg_xy;
-        result_stream << " " << min_vsg_yy << " " << max_vsg_yy << " " << avg_vsg_yy << " " << std_dev_vsg_yy;
-        scalar_t strain_peaks_avg_error_x = 0.0;
-        scalar_t strain_peaks_std_dev_error_x = 0.0;
-        scalar_t strain_peaks_avg_error_y = 0.0;
-        scalar_t strain_peaks_std_dev_error_y = 0.0;
-        // assemble the strains into a vector
-        Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
-        Teuchos::RCP<MultiField> strain = Teuchos::rcp( new MultiField(map,1,true));
-        Teuchos::RCP<MultiField> exact_strain = Teuchos::rcp( new MultiField(map,1,true));
-        Teuchos::RCP<MultiField> strain_error = Teuchos::rcp( new MultiField(map,1,true));
-        for(int_t i=0;i<local_num_subsets_;++i){
-          strain->local_value(i*spa_dim+0) = vsg_xx->local_value(i);
-          strain->local_value(i*spa_dim+1) = vsg_yy->local_value(i);
-          exact_strain->local_value(i*spa_dim+0) = exact_strain_xx->local_value(i);
-          exact_strain->local_value(i*spa_dim+1) = exact_strain_yy->local_value(i);
-          strain_error->local_value(i*spa_dim+0) = vsg_error_xx->local_value(i);
-          strain_error->local_value(i*spa_dim+1) = vsg_error_yy->local_value(i);
-        }
-        // analyze the peaks of the output to evaluate the roll off
-        compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,strain,exact_strain,strain_error,
-          strain_peaks_avg_error_x,strain_peaks_std_dev_error_x,strain_peaks_avg_error_y,strain_peaks_std_dev_error_y);
-        result_stream << " " << strain_peaks_avg_error_x << " " << strain_peaks_std_dev_error_x << " " << strain_peaks_avg_error_y << " " << strain_peaks_std_dev_error_y;
+    if(has_vsg){
+      scalar_t min_vsg_xx = 0.0;
+      scalar_t max_vsg_xx = 0.0;
+      scalar_t avg_vsg_xx = 0.0;
+      scalar_t std_dev_vsg_xx = 0.0;
+      scalar_t min_vsg_xy = 0.0;
+      scalar_t max_vsg_xy = 0.0;
+      scalar_t avg_vsg_xy = 0.0;
+      scalar_t std_dev_vsg_xy = 0.0;
+      scalar_t min_vsg_yy = 0.0;
+      scalar_t max_vsg_yy = 0.0;
+      scalar_t avg_vsg_yy = 0.0;
+      scalar_t std_dev_vsg_yy = 0.0;
+      mesh_->field_stats(VSG_STRAIN_XX_ERROR_FS,min_vsg_xx,max_vsg_xx,avg_vsg_xx,std_dev_vsg_xx,0,SIGMA_FS,-1.0);
+      mesh_->field_stats(VSG_STRAIN_XY_ERROR_FS,min_vsg_xy,max_vsg_xy,avg_vsg_xy,std_dev_vsg_xy,0,SIGMA_FS,-1.0);
+      mesh_->field_stats(VSG_STRAIN_YY_ERROR_FS,min_vsg_yy,max_vsg_yy,avg_vsg_yy,std_dev_vsg_yy,0,SIGMA_FS,-1.0);
+      result_stream << " " << min_vsg_xx << " " << max_vsg_xx << " " << avg_vsg_xx << " " << std_dev_vsg_xx;
+      result_stream << " " << min_vsg_xy << " " << max_vsg_xy << " " << avg_vsg_xy << " " << std_dev_vsg_xy;
+      result_stream << " " << min_vsg_yy << " " << max_vsg_yy << " " << avg_vsg_yy << " " << std_dev_vsg_yy;
+      scalar_t strain_peaks_avg_error_x = 0.0;
+      scalar_t strain_peaks_std_dev_error_x = 0.0;
+      scalar_t strain_peaks_avg_error_y = 0.0;
+      scalar_t strain_peaks_std_dev_error_y = 0.0;
+      // assemble the strains into a vector
+      Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
+      Teuchos::RCP<MultiField> strain = Teuchos::rcp( new MultiField(map,1,true));
+      Teuchos::RCP<MultiField> exact_strain = Teuchos::rcp( new MultiField(map,1,true));
+      Teuchos::RCP<MultiField> strain_error = Teuchos::rcp( new MultiField(map,1,true));
+      for(int_t i=0;i<local_num_subsets_;++i){
+        strain->local_value(i*spa_dim+0) = vsg_xx->local_value(i);
+        strain->local_value(i*spa_dim+1) = vsg_yy->local_value(i);
+        exact_strain->local_value(i*spa_dim+0) = exact_strain_xx->local_value(i);
+        exact_strain->local_value(i*spa_dim+1) = exact_strain_yy->local_value(i);
+        strain_error->local_value(i*spa_dim+0) = vsg_error_xx->local_value(i);
+        strain_error->local_value(i*spa_dim+1) = vsg_error_yy->local_value(i);
       }
-      if(has_nlvc){
-        scalar_t min_nlvc_xx = 0.0;
-        scalar_t max_nlvc_xx = 0.0;
-        scalar_t avg_nlvc_xx = 0.0;
-        scalar_t std_dev_nlvc_xx = 0.0;
-        scalar_t min_nlvc_xy = 0.0;
-        scalar_t max_nlvc_xy = 0.0;
-        scalar_t avg_nlvc_xy = 0.0;
-        scalar_t std_dev_nlvc_xy = 0.0;
-        scalar_t min_nlvc_yy = 0.0;
-        scalar_t max_nlvc_yy = 0.0;
-        scalar_t avg_nlvc_yy = 0.0;
-        scalar_t std_dev_nlvc_yy = 0.0;
-        mesh_->field_stats(NLVC_STRAIN_XX_ERROR_FS,min_nlvc_xx,max_nlvc_xx,avg_nlvc_xx,std_dev_nlvc_xx,0,SIGMA_FS,-1.0);
-        mesh_->field_stats(NLVC_STRAIN_XY_ERROR_FS,min_nlvc_xy,max_nlvc_xy,avg_nlvc_xy,std_dev_nlvc_xy,0,SIGMA_FS,-1.0);
-        mesh_->field_stats(NLVC_STRAIN_YY_ERROR_FS,min_nlvc_yy,max_nlvc_yy,avg_nlvc_yy,std_dev_nlvc_yy,0,SIGMA_FS,-1.0);
-        result_stream << " " << min_nlvc_xx << " " << max_nlvc_xx << " " << avg_nlvc_xx << " " << std_dev_nlvc_xx;
-        result_stream << " " << min_nlvc_xy << " " << max_nlvc_xy << " " << avg_nlvc_xy << " " << std_dev_nlvc_xy;
-        result_stream << " " << min_nlvc_yy << " " << max_nlvc_yy << " " << avg_nlvc_yy << " " << std_dev_nlvc_yy;
-        scalar_t strain_peaks_avg_error_x = 0.0;
-        scalar_t strain_peaks_std_dev_error_x = 0.0;
-        scalar_t strain_peaks_avg_error_y = 0.0;
-        scalar_t strain_peaks_std_dev_error_y = 0.0;
-        // assemble the strains into a vector
-        Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
-        Teuchos::RCP<MultiField> strain = Teuchos::rcp( new MultiField(map,1,true));
-        Teuchos::RCP<MultiField> exact_strain = Teuchos::rcp( new MultiField(map,1,true));
-        Teuchos::RCP<MultiField> strain_error = Teuchos::rcp( new MultiField(map,1,true));
-        for(int_t i=0;i<local_num_subsets_;++i){
-          strain->local_value(i*spa_dim+0) = vsg_xx->local_value(i);
-          strain->local_value(i*spa_dim+1) = vsg_yy->local_value(i);
-          exact_strain->local_value(i*spa_dim+0) = exact_strain_xx->local_value(i);
-          exact_strain->local_value(i*spa_dim+1) = exact_strain_yy->local_value(i);
-          strain_error->local_value(i*spa_dim+0) = nlvc_error_xx->local_value(i);
-          strain_error->local_value(i*spa_dim+1) = nlvc_error_yy->local_value(i);
-        }
-        // analyze the peaks of the output to evaluate the roll off
-        compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,strain,exact_strain,strain_error,
-          strain_peaks_avg_error_x,strain_peaks_std_dev_error_x,strain_peaks_avg_error_y,strain_peaks_std_dev_error_y);
-        result_stream << " " << strain_peaks_avg_error_x << " " << strain_peaks_std_dev_error_x << " " << strain_peaks_avg_error_y << " " << strain_peaks_std_dev_error_y;
+      // analyze the peaks of the output to evaluate the roll off
+      compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,strain,exact_strain,strain_error,
+        strain_peaks_avg_error_x,strain_peaks_std_dev_error_x,strain_peaks_avg_error_y,strain_peaks_std_dev_error_y);
+      result_stream << " " << strain_peaks_avg_error_x << " " << strain_peaks_std_dev_error_x << " " << strain_peaks_avg_error_y << " " << strain_peaks_std_dev_error_y;
+    }
+    if(has_nlvc){
+      scalar_t min_nlvc_xx = 0.0;
+      scalar_t max_nlvc_xx = 0.0;
+      scalar_t avg_nlvc_xx = 0.0;
+      scalar_t std_dev_nlvc_xx = 0.0;
+      scalar_t min_nlvc_xy = 0.0;
+      scalar_t max_nlvc_xy = 0.0;
+      scalar_t avg_nlvc_xy = 0.0;
+      scalar_t std_dev_nlvc_xy = 0.0;
+      scalar_t min_nlvc_yy = 0.0;
+      scalar_t max_nlvc_yy = 0.0;
+      scalar_t avg_nlvc_yy = 0.0;
+      scalar_t std_dev_nlvc_yy = 0.0;
+      mesh_->field_stats(NLVC_STRAIN_XX_ERROR_FS,min_nlvc_xx,max_nlvc_xx,avg_nlvc_xx,std_dev_nlvc_xx,0,SIGMA_FS,-1.0);
+      mesh_->field_stats(NLVC_STRAIN_XY_ERROR_FS,min_nlvc_xy,max_nlvc_xy,avg_nlvc_xy,std_dev_nlvc_xy,0,SIGMA_FS,-1.0);
+      mesh_->field_stats(NLVC_STRAIN_YY_ERROR_FS,min_nlvc_yy,max_nlvc_yy,avg_nlvc_yy,std_dev_nlvc_yy,0,SIGMA_FS,-1.0);
+      result_stream << " " << min_nlvc_xx << " " << max_nlvc_xx << " " << avg_nlvc_xx << " " << std_dev_nlvc_xx;
+      result_stream << " " << min_nlvc_xy << " " << max_nlvc_xy << " " << avg_nlvc_xy << " " << std_dev_nlvc_xy;
+      result_stream << " " << min_nlvc_yy << " " << max_nlvc_yy << " " << avg_nlvc_yy << " " << std_dev_nlvc_yy;
+      scalar_t strain_peaks_avg_error_x = 0.0;
+      scalar_t strain_peaks_std_dev_error_x = 0.0;
+      scalar_t strain_peaks_avg_error_y = 0.0;
+      scalar_t strain_peaks_std_dev_error_y = 0.0;
+      // assemble the strains into a vector
+      Teuchos::RCP<MultiField_Map> map = mesh_->get_vector_node_dist_map();
+      Teuchos::RCP<MultiField> strain = Teuchos::rcp( new MultiField(map,1,true));
+      Teuchos::RCP<MultiField> exact_strain = Teuchos::rcp( new MultiField(map,1,true));
+      Teuchos::RCP<MultiField> strain_error = Teuchos::rcp( new MultiField(map,1,true));
+      for(int_t i=0;i<local_num_subsets_;++i){
+        strain->local_value(i*spa_dim+0) = vsg_xx->local_value(i);
+        strain->local_value(i*spa_dim+1) = vsg_yy->local_value(i);
+        exact_strain->local_value(i*spa_dim+0) = exact_strain_xx->local_value(i);
+        exact_strain->local_value(i*spa_dim+1) = exact_strain_yy->local_value(i);
+        strain_error->local_value(i*spa_dim+0) = nlvc_error_xx->local_value(i);
+        strain_error->local_value(i*spa_dim+1) = nlvc_error_yy->local_value(i);
       }
+      // analyze the peaks of the output to evaluate the roll off
+      compute_roll_off_stats(period,full_ref_img_width_,full_ref_img_height_,coords,strain,exact_strain,strain_error,
+        strain_peaks_avg_error_x,strain_peaks_std_dev_error_x,strain_peaks_avg_error_y,strain_peaks_std_dev_error_y);
+      result_stream << " " << strain_peaks_avg_error_x << " " << strain_peaks_std_dev_error_x << " " << strain_peaks_avg_error_y << " " << strain_peaks_std_dev_error_y;
+    }
 
-      result_stream << std::endl;
-      write_output(output_folder,prefix,false,true);
-      // write the results to the .info file
-      if(proc_id==0){
-        std::FILE * infoFilePtr = fopen(data_name.str().c_str(),"a");
-        fprintf(infoFilePtr,"%s",result_stream.str().c_str());
-        fclose(infoFilePtr);
-        *outStream << result_stream.str();
-      }
-      result_stream.clear();
-      result_stream.str("");
-    } // end step loop
-  } // end mag loop
+    result_stream << std::endl;
+    write_output(output_folder,prefix,false,true);
+    // write the results to the .info file
+    if(proc_id==0){
+      std::FILE * infoFilePtr = fopen(data_name.str().c_str(),"a");
+      fprintf(infoFilePtr,"%s",result_stream.str().c_str());
+      fclose(infoFilePtr);
+      *outStream << result_stream.str();
+    }
+    result_stream.clear();
+    result_stream.str("");
+  } // end case loop
 #endif
 }
 
@@ -2940,6 +3229,7 @@ Schema::write_output(const std::string & output_folder,
   if(analysis_type_==GLOBAL_DIC){
     return;
   }
+  DICE_PROFILE_SCOPE(PROFILE_WRITE_OUTPUT);
   TEUCHOS_TEST_FOR_EXCEPTION(output_spec_==Teuchos::null,std::runtime_error,"");
   int_t my_proc = comm_->get_rank();
   int_t proc_size = comm_->get_size();
@@ -2952,8 +3242,14 @@ Schema::write_output(const std::string & output_folder,
         output_dir = init_params_->get<std::string>(DICe::output_folder,"");
       DICe::mesh::create_output_exodus_file(mesh_,output_dir);
       DICe::mesh::create_exodus_output_variable_names(mesh_);
+      exodus_output_created_ = true;
     }
-    DICe::mesh::exodus_output_dump(mesh_,frame_id_-first_frame_id_,frame_id_-first_frame_id_);
+    // the field values are copied and written by a background I/O thread, netcdf images are read
+    // with the same library as exodus so in that case the frames are written synchronously
+    const std::string & img_name = ref_img_->file_name();
+    const bool netcdf_images = img_name.size()>3&&img_name.substr(img_name.size()-3)==".nc";
+    DICe::mesh::exodus_output_dump_async(mesh_,frame_id_-first_frame_id_,frame_id_-first_frame_id_,
+      netcdf_images ? 0 : exodus_output_queue_size_);
   }
 #endif
 
@@ -3078,6 +3374,97 @@ Schema::write_output(const std::string & output_folder,
   }
 }
 
+void
+Schema::write_binary_output(const std::string & output_folder,
+  const std::string & prefix,
+  const bool separate_files_per_subset,
+  const bool separate_header_file,
+  const bool compress){
+  if(analysis_type_==GLOBAL_DIC){
+    return;
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(output_spec_==Teuchos::null,std::runtime_error,"");
+  const int_t my_proc = comm_->get_rank();
+  const int_t proc_size = comm_->get_size();
+
+  // populate the RCP vector of fields in the output spec
+  output_spec_->gather_fields();
+
+  if(binary_output_writer_==Teuchos::null){
+    Binary_Output_Info info;
+    info.field_names = output_spec_->field_names();
+    info.delimiter = output_spec_->delimiter();
+    info.omit_row_id = output_spec_->omit_row_id();
+    info.prefix = prefix;
+    info.separate_files_per_subset = separate_files_per_subset;
+    info.separate_header_file = separate_header_file;
+    info.proc_size = proc_size;
+    info.proc_rank = my_proc;
+    int_t decrement_total = global_num_subsets_;
+    while (decrement_total){decrement_total /= 10; info.subset_digits++;}
+    if(num_frames_>0){
+      decrement_total = first_frame_id_+num_frames_;
+      while (decrement_total){decrement_total /= 10; info.frame_digits++;}
+    }
+    // the rows are stored in the order the text output would list them
+    binary_output_rows_.resize(local_num_subsets_);
+    for(int_t i=0;i<local_num_subsets_;++i)
+      binary_output_rows_[i] = i;
+    if(sort_txt_output_&&!separate_files_per_subset){
+      Teuchos::RCP<MultiField> subset_coords_x = mesh_->get_field(SUBSET_COORDINATES_X_FS);
+      Teuchos::RCP<MultiField> subset_coords_y = mesh_->get_field(SUBSET_COORDINATES_Y_FS);
+      std::stable_sort(binary_output_rows_.begin(),binary_output_rows_.end(),[&](const int_t a, const int_t b)
+      {return subset_coords_x->local_value(a) < subset_coords_x->local_value(b) ||
+        ((subset_coords_x->local_value(a) == subset_coords_x->local_value(b))&&(subset_coords_y->local_value(a) < subset_coords_y->local_value(b)));});
+    }
+    info.row_ids.resize(local_num_subsets_);
+    for(int_t i=0;i<local_num_subsets_;++i)
+      info.row_ids[i] = subset_global_id(binary_output_rows_[i]);
+    // capture the run information the text files would have in their header
+    std::FILE * infoFilePtr = std::tmpfile();
+    TEUCHOS_TEST_FOR_EXCEPTION(infoFilePtr==NULL,std::runtime_error,"Error, could not create a temporary file for the run information");
+    output_spec_->write_info(infoFilePtr,separate_header_file);
+    const long info_size = ftell(infoFilePtr);
+    rewind(infoFilePtr);
+    info.run_info.resize(info_size>0?info_size:0);
+    if(info_size>0&&fread(&info.run_info[0],1,info_size,infoFilePtr)!=(size_t)info_size)
+      info.run_info.clear();
+    fclose(infoFilePtr);
+
+    std::stringstream fName;
+    fName << output_folder << prefix;
+    if(proc_size>1)
+      fName << "." << proc_size << "." << my_proc;
+    fName << ".dbin";
+    DEBUG_MSG("Schema::write_binary_output(): opening binary output file " << fName.str());
+    binary_output_writer_ = Teuchos::rcp(new Binary_Output_Writer(fName.str(),info,compress));
+  }
+
+  // gather the values column by column
+  std::vector<Teuchos::RCP<MultiField> > & field_vec = *output_spec_->field_vec();
+  const int_t num_rows = binary_output_rows_.size();
+  std::vector<scalar_t> values(field_vec.size()*num_rows,0.0);
+  for(size_t i=0;i<field_vec.size();++i){
+    if(field_vec[i]==Teuchos::null) continue;
+    for(int_t row=0;row<num_rows;++row)
+      values[i*num_rows+row] = field_vec[i]->local_value(binary_output_rows_[row]);
+  }
+  binary_output_writer_->write_frame(frame_id_-1,values); // frame is decremented because write gets called after update_frame
+}
+
+void
+Schema::finalize_output(){
+#ifdef DICE_ENABLE_GLOBAL
+  if(exodus_output_created_){
+    DICe::mesh::close_exodus_output(mesh_);
+    exodus_output_created_ = false;
+  }
+#endif
+  if(binary_output_writer_==Teuchos::null) return;
+  binary_output_writer_->close();
+  binary_output_writer_ = Teuchos::null;
+}
+
 void
 Schema::write_stats(const std::string & output_folder,
   const std::string & prefix){
@@ -3137,8 +3524,9 @@ Schema::check_for_blocking_subsets(const int_t subset_global_id){
   const int_t subset_lid = subset_local_id(subset_global_id);
 
   // turn off pixels in this subset that are blocked by another
-  // get a pointer to the member data in the subset that will store the list of blocked pixels
-  std::set<std::pair<int_t,int_t> > & blocked_pixels =
+  // get a pointer to the member data in the subset that will store the mask of blocked pixels
+  // (clearing the mask keeps its storage so it is reused from frame to frame)
+  Pixel_Mask & blocked_pixels =
       *obj_vec_[subset_lid]->subset()->pixels_blocked_by_other_subsets();
   blocked_pixels.clear();
 
@@ -3153,9 +3541,7 @@ Schema::check_for_blocking_subsets(const int_t subset_global_id){
     int_t cy = obj_vec_[local_ss]->subset()->centroid_y();
     Teuchos::RCP<Local_Shape_Function> shape_function = shape_function_factory(this);
     shape_function->initialize_parameters_from_fields(this,global_ss);
-    std::set<std::pair<int_t,int_t> > subset_pixels =
-        obj_vec_[local_ss]->subset()->deformed_shapes(shape_function,cx,cy,obstruction_skin_factor_);
-    blocked_pixels.insert(subset_pixels.begin(),subset_pixels.end());
+    obj_vec_[local_ss]->subset()->deformed_shapes(blocked_pixels,shape_function,cx,cy,obstruction_skin_factor_);
   } // blocking subsets loop
 }
 
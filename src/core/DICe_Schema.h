@@ -47,8 +47,10 @@
 #include <DICe_Shape.h>
 #include <DICe_Initializer.h>
 #include <DICe_Parser.h>
+#include <DICe_BinaryOutput.h>
 #ifdef DICE_ENABLE_GLOBAL
   #include <DICe_Global.h>
+  #include <DICe_MeshIOUtils.h>
 #endif
 #include <DICe_Mesh.h>
 #include <DICe_FieldEnums.h>
@@ -267,7 +269,8 @@ public:
     Teuchos::RCP<std::vector<int_t> > neighbor_ids=Teuchos::null,
     const Teuchos::RCP<Teuchos::ParameterList> & params=Teuchos::null);
 
-  virtual ~Schema(){};
+  /// Flushes and closes any output files that are still open (see finalize_output())
+  virtual ~Schema();
 
   /// If a schema's parameters are changed, set_params() must be called again
   /// any params that aren't set are reset to the default value (so this method
@@ -371,6 +374,28 @@ public:
   /// do clean up tasks
   void post_execution_tasks();
 
+  /// \brief Redistribute the subsets among processors if the measured costs are out of balance
+  ///
+  /// The wall time of each subset is accumulated by execute_correlation(). Every rebalance_interval
+  /// frames, processor 0 gathers the costs and computes a new cost weighted partition of the subsets
+  /// by recursive coordinate bisection. The subsets are only moved if the time the new partition is
+  /// expected to save over the next interval is larger than the cost of the migration (the measured
+  /// time of the previous migration or one frame on the slowest processor if there hasn't been one).
+  /// When the subsets are moved a new mesh is created and all the field values are copied to the new
+  /// owners. The caller is responsible for re-reading the images for the new extents.
+  /// Returns true if the subsets were moved. Rebalancing is skipped for global DIC, the tracking
+  /// routine, neighbor value initialization, obstructions, motion windows, live plots, and
+  /// exodus or binary output (the output files are tied to the original decomposition).
+  bool rebalance_subsets();
+
+  /// \brief Move the subsets to the given processors
+  ///
+  /// Creates the mesh for the new decomposition and copies the field values to the new owner of each subset global id.
+  /// The objectives are rebuilt from the reference image on the next call to execute_correlation() and the
+  /// post processors are re-initialized. The caller is responsible for re-reading the images for the new extents.
+  /// \param owners the processor that should own each subset global id (only used on processor 0)
+  void migrate_subsets(Teuchos::RCP<std::vector<int_t> > owners);
+
   /// Returns if the field storage is initilaized
   int_t is_initialized()const{
     return is_initialized_;
@@ -593,6 +618,41 @@ public:
     return projection_method_;
   }
 
+  /// Returns the number of times the images are downsampled for the image registration initializer
+  int_t image_registration_pyramid_level()const{
+    return image_registration_pyramid_level_;
+  }
+
+  /// Returns the window size for the subset phase correlation initializer (0 means use twice the subset size)
+  int_t phase_correlation_window_size()const{
+    return phase_correlation_window_size_;
+  }
+
+  /// Returns the number of frames that can wait to be written to the exodus output file
+  int_t exodus_output_queue_size()const{
+    return exodus_output_queue_size_;
+  }
+
+  /// Returns the stride used to sample the motion windows when testing for motion
+  int_t motion_test_decimation()const{
+    return motion_test_decimation_;
+  }
+
+  /// Returns the number of image pyramid levels used to seed the gradient based solve
+  int_t coarse_to_fine_levels()const{
+    return coarse_to_fine_levels_;
+  }
+
+  /// Returns true if images read from file are stored as 8 or 16 bit integers when possible
+  bool compact_intensity_storage()const{
+    return compact_intensity_storage_;
+  }
+
+  /// Returns the number of frames between load balance checks (0 is off)
+  int_t rebalance_interval()const{
+    return rebalance_interval_;
+  }
+
   /// set up the initializers
   void prepare_optimization_initializers();
 
@@ -626,6 +686,25 @@ public:
     const bool separate_header_file=false,
     const bool no_text_output=false);
 
+  /// \brief Append the solution for the current frame to a binary results file
+  ///
+  /// The file (one per processor) is opened on the first call and stays open until
+  /// finalize_output() is called. The file can be converted to the layout of the
+  /// text files with DICe::convert_binary_output_to_text (see the DICe_BinaryToText tool).
+  /// \param output_folder Name of the folder for output
+  /// \param prefix Optional string to use as the file prefix
+  /// \param separate_files_per_subset layout to use when the file is converted to text
+  /// \param separate_header_file place the run information in another file when converted to text
+  /// \param compress true if the columns of the binary file should be compressed
+  void write_binary_output(const std::string & output_folder,
+    const std::string & prefix="DICe_solution",
+    const bool separate_files_per_subset=false,
+    const bool separate_header_file=false,
+    const bool compress=false);
+
+  /// \brief Flush the remaining frames and close the exodus and binary results files (no-op for files that are not open)
+  void finalize_output();
+
   /// \brief Write the stats for a completed run
   /// \param output_folder Name of the folder for output (the file name is fixed)
   /// \param prefix Optional string to use as the file prefix
@@ -1057,6 +1136,15 @@ private:
   /// with no overlap
   void create_mesh(Teuchos::RCP<Decomp> decomp);
 
+  /// gather the initial subset coordinates on processor 0 (the arrays are empty on the other processors)
+  void gather_subset_coordinates(Teuchos::ArrayRCP<scalar_t> & coords_x,
+    Teuchos::ArrayRCP<scalar_t> & coords_y);
+
+  /// move the subsets given the owners and the initial coordinates of all subsets on processor 0
+  void migrate_subsets(Teuchos::RCP<std::vector<int_t> > owners,
+    Teuchos::ArrayRCP<scalar_t> all_coords_x,
+    Teuchos::ArrayRCP<scalar_t> all_coords_y);
+
   /// create all of the fields necessary on the mesh
   void create_mesh_fields();
 
@@ -1130,6 +1218,10 @@ private:
   bool has_output_spec_;
   /// Determines how the output is formatted
   Teuchos::RCP<DICe::Output_Spec> output_spec_;
+  /// Persistent writer for the binary results file
+  Teuchos::RCP<DICe::Binary_Output_Writer> binary_output_writer_;
+  /// Local subset index for each row of the binary results file
+  std::vector<int_t> binary_output_rows_;
   /// Stores current fame number for a sequence of images
   int_t frame_id_;
   /// Stores the offset to the first image's index (cine files can start with a negative index)
@@ -1185,6 +1277,10 @@ private:
   bool gauss_filter_images_;
   /// filter the images using a gauss_filter_mask_size_ point gauss filter
   int_t gauss_filter_mask_size_;
+  /// number of times the images are downsampled by two before computing the image registration initialization
+  int_t image_registration_pyramid_level_;
+  /// size of the window around each subset for the subset phase correlation initializer
+  int_t phase_correlation_window_size_;
   /// Compute the reference image gradients
   bool compute_ref_gradients_;
   /// Compute the deformed image gradients
@@ -1231,11 +1327,33 @@ private:
   bool output_beta_;
   /// true if exodus output should be written
   bool write_exodus_output_;
+  /// number of frames that can wait to be written to the exodus output file by the I/O thread
+  int_t exodus_output_queue_size_;
+  /// true if the exodus output file has been created and not yet closed
+  bool exodus_output_created_;
+  /// only every n-th row and column of a motion window is used to test for motion
+  int_t motion_test_decimation_;
+  /// number of image pyramid levels used to seed the gradient based solve (0 is off)
+  int_t coarse_to_fine_levels_;
+  /// true if images read from file are stored as 8 or 16 bit integers when possible
+  bool compact_intensity_storage_;
+  /// number of frames between load balance checks (0 is off)
+  int_t rebalance_interval_;
+  /// relative load imbalance below which the subsets are not moved
+  scalar_t rebalance_threshold_;
+  /// wall time accumulated by each local subset since the last load balance check
+  std::vector<scalar_t> subset_costs_;
+  /// number of frames correlated since the last load balance check
+  int_t frames_since_rebalance_;
+  /// measured wall time of the last migration of subsets (negative if there hasn't been one)
+  scalar_t rebalance_cost_;
   /// true if search initialization should be used for failed steps (otherwise the subset is skipped)
   bool use_search_initialization_for_failed_steps_;
 #ifdef DICE_ENABLE_GLOBAL
   /// Global algorithm
   Teuchos::RCP<DICe::global::Global_Algorithm> global_algorithm_;
+  /// importer for the initial condition file (the projection weights are reused if the schema is executed again)
+  Teuchos::RCP<DICe::mesh::Importer_Projector> initial_condition_importer_;
 #endif
   /// keep track of stats for each subset (only for tracking routine)
   Teuchos::RCP<Stat_Container> stat_container_;
@@ -1314,6 +1432,21 @@ public:
     return &field_vec_;
   }
 
+  /// returns the names of the output fields in column order
+  const std::vector<std::string> & field_names()const{
+    return field_names_;
+  }
+
+  /// returns the delimiter
+  const std::string & delimiter()const{
+    return delimiter_;
+  }
+
+  /// returns true if the row id column is omitted
+  bool omit_row_id()const{
+    return omit_row_id_;
+  }
+
   /// gather all the fields necessary to write the output
   void gather_fields();
 
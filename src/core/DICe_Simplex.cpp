@@ -43,6 +43,9 @@
 #include <DICe_Triangulation.h>
 
 #include <cassert>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace DICe {
 
@@ -76,12 +79,8 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
 #endif
 
   // allocate temp storage for routine and initialize the simplex vertices
-  std::vector<scalar_t> init_variables(num_dofs,0.0);
-  for(int_t i=0;i<num_dofs;++i)
-    init_variables[i] = (*variables)[i];
-
   const int_t mpts = num_dofs + 1;
-  scalar_t * gamma_values = new scalar_t[mpts];
+  std::vector<scalar_t> gamma_values(mpts,0.0);
   std::vector< Teuchos::RCP<std::vector<scalar_t> > > points(mpts);
   for(int_t i=0;i<mpts;++i){
     points[i] = Teuchos::rcp(new std::vector<scalar_t>(num_dofs,0.0));
@@ -96,27 +95,68 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
     for(int_t j=0;j<num_dofs;++j) std::cout << " " << (*points[i])[j];
     std::cout << std::endl;
 #endif
-    // evaluate gamma at these points
-    for(int_t j=0;j<num_dofs;++j)
-       (*variables)[j] = (*points[i])[j];
-    gamma_values[i] = objective(variables);
+  }
+  // evaluate gamma at the initial guess first, the analysis is skipped if it is good enough
+  gamma_values[0] = objective(variables);
+  DEBUG_MSG("Gamma value for this point: " << gamma_values[0]);
+  if(gamma_values[0]<threshold&&gamma_values[0]>=0.0){
+    num_iterations = 0;
+    DEBUG_MSG("Initial variables guess is good enough (gamma < " << threshold << " for this guess)");
+    return CORRELATION_SUCCESSFUL;
+  }
+  // the rest of the vertices are independent of each other
+  std::vector<scalar_t> batch_values;
+  objective_batch(variables,std::vector<Teuchos::RCP<std::vector<scalar_t> > >(points.begin()+1,points.end()),batch_values);
+  for(int_t i=1;i<mpts;++i){
+    gamma_values[i] = batch_values[i-1];
     DEBUG_MSG("Gamma value for this point: " << gamma_values[i]);
-    if(i==0&&gamma_values[i]<threshold&&gamma_values[i]>=0.0){
-      num_iterations = 0;
-      DEBUG_MSG("Initial variables guess is good enough (gamma < " << threshold << " for this guess)");
-      return CORRELATION_SUCCESSFUL;
-    }
-    for(int_t j=0;j<num_dofs;++j)
-       (*variables)[j] = init_variables[j];
   }
+  // true if the last call to objective() was made with the current variables
+  bool objective_is_current = false;
 
   // work variables
 
   int_t inhi;
   scalar_t ysave;
   int_t nfunk = 0;
-  scalar_t * points_column_sums = new scalar_t[num_dofs];
-  scalar_t * ptry = new scalar_t[num_dofs];
+  std::vector<scalar_t> points_column_sums(num_dofs,0.0);
+  std::vector<scalar_t> ptry(num_dofs,0.0);
+
+  // trial point along the line from the worst vertex through the centroid of the others
+  auto trial_point = [num_dofs](const std::vector<scalar_t> & sums,
+      const std::vector<scalar_t> & worst,
+      const scalar_t & fac,
+      std::vector<scalar_t> & trial){
+    const scalar_t fac1 = (1.0 - fac)/num_dofs;
+    const scalar_t fac2 = fac1 - fac;
+    for (int_t j = 0; j < num_dofs; j++)
+      trial[j] = sums[j]*fac1 - worst[j]*fac2;
+  };
+
+  // if enough evaluations can run at once, the reflection, expansion, and both contraction points
+  // are evaluated together at the start of each iteration and the sequential logic below picks up
+  // the precomputed values (the search path is the same as if they were evaluated one at a time)
+  const bool speculate = max_parallel_evaluations() >= 4;
+  std::vector< Teuchos::RCP<std::vector<scalar_t> > > candidates;
+  std::vector<scalar_t> candidate_values;
+  std::vector<scalar_t> reflected_sums(num_dofs,0.0);
+  if(speculate){
+    for(int_t i=0;i<4;++i)
+      candidates.push_back(Teuchos::rcp(new std::vector<scalar_t>(num_dofs,0.0)));
+  }
+  // evaluate the objective at ptry, reusing the precomputed value if there is one
+  auto evaluate_trial = [&]()->scalar_t{
+    for(int_t n=0;n<num_dofs;++n)
+      (*variables)[n] = ptry[n];
+    for(size_t c=0;c<candidate_values.size();++c){
+      if(*candidates[c]==ptry){
+        objective_is_current = false;
+        return candidate_values[c];
+      }
+    }
+    objective_is_current = true;
+    return objective(variables);
+  };
 
   // sum up the columns of the simplex vertices
 
@@ -139,9 +179,9 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
   for (iteration=0; iteration < max_iterations_; iteration++) {
     if( iteration >= max_iterations_-1){
       DEBUG_MSG("Simplex method max iterations exceeded");
-      delete [] gamma_values;
-      delete [] points_column_sums;
-      delete [] ptry;
+      // leave the objective in the state of the returned variables
+      if(!objective_is_current)
+        objective(variables);
       num_iterations = iteration;
       return MAX_ITERATIONS_REACHED;
     }
@@ -183,18 +223,24 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
     }
     nfunk += 2;
 
-    scalar_t ytry,fac,fac1,fac2;
-
-    fac = -1.0;
-    fac1 = (1.0 - fac)/num_dofs;
-    fac2 = fac1 - fac;
+    candidate_values.clear();
+    if(speculate){
+      // reflection
+      trial_point(points_column_sums,*points[ihi],-1.0,*candidates[0]);
+      // expansion and contraction if the reflection replaces the worst vertex
+      for (int_t j = 0; j < num_dofs; j++)
+        reflected_sums[j] = points_column_sums[j] + ((*candidates[0])[j] - (*points[ihi])[j]);
+      trial_point(reflected_sums,*candidates[0],2.0,*candidates[1]);
+      trial_point(reflected_sums,*candidates[0],0.5,*candidates[2]);
+      // contraction if the reflection is rejected
+      trial_point(points_column_sums,*points[ihi],0.5,*candidates[3]);
+      objective_batch(variables,candidates,candidate_values);
+    }
 
-    for (int_t j = 0; j < num_dofs; j++)
-      ptry[j] = points_column_sums[j]*fac1 - (*points[ihi])[j]*fac2;
+    scalar_t ytry;
 
-    for(int_t n=0;n<num_dofs;++n)
-      (*variables)[n] = ptry[n];
-    ytry = objective(variables);
+    trial_point(points_column_sums,*points[ihi],-1.0,ptry);
+    ytry = evaluate_trial();
 
     if (ytry < gamma_values[ihi]) {
       gamma_values[ihi] = ytry;
@@ -204,15 +250,8 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
       }
     }
     if (ytry <= gamma_values[ilo]) {
-      fac = 2.0;
-      fac1 = (1.0 - fac)/num_dofs;
-      fac2 = fac1 - fac;
-      for (int_t j = 0; j < num_dofs; j++)
-        ptry[j] = points_column_sums[j]*fac1 - (*points[ihi])[j]*fac2;
-
-      for(int_t n=0;n<num_dofs;++n)
-        (*variables)[n] = ptry[n];
-      ytry = objective(variables);
+      trial_point(points_column_sums,*points[ihi],2.0,ptry);
+      ytry = evaluate_trial();
 
       if (ytry < gamma_values[ihi]) {
         gamma_values[ihi] = ytry;
@@ -223,15 +262,8 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
       }
     } else if (ytry >= gamma_values[inhi]) {
       ysave = gamma_values[ihi];
-      fac = 0.5;
-      fac1 = (1.0 - fac)/num_dofs;
-      fac2 = fac1 - fac;
-      for (int_t j = 0; j < num_dofs; j++)
-        ptry[j] = points_column_sums[j]*fac1 - (*points[ihi])[j]*fac2;
-
-      for(int_t n=0;n<num_dofs;++n)
-        (*variables)[n] = ptry[n];
-      ytry = objective(variables);
+      trial_point(points_column_sums,*points[ihi],0.5,ptry);
+      ytry = evaluate_trial();
 
       if (ytry < gamma_values[ihi]) {
         gamma_values[ihi] = ytry;
@@ -241,15 +273,25 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
         }
       }
       if (ytry >= ysave) {
+        // shrink the simplex toward the best vertex
+        std::vector< Teuchos::RCP<std::vector<scalar_t> > > shrunk_points;
+        std::vector<int_t> shrunk_ids;
         for (int_t i = 0; i < mpts; i++) {
           if (i != ilo) {
             for (int_t j = 0; j < num_dofs; j++)
-              (*points[i])[j] = points_column_sums[j] = 0.5*((*points[i])[j] + (*points[ilo])[j]);
-            for(int_t n=0;n<num_dofs;++n)
-              (*variables)[n] = points_column_sums[n];
-            gamma_values[i] = objective(variables);
+              (*points[i])[j] = 0.5*((*points[i])[j] + (*points[ilo])[j]);
+            shrunk_points.push_back(points[i]);
+            shrunk_ids.push_back(i);
           }
         }
+        objective_batch(variables,shrunk_points,batch_values);
+        for(size_t i=0;i<shrunk_ids.size();++i)
+          gamma_values[shrunk_ids[i]] = batch_values[i];
+        // the variables end up at the last shrunk vertex
+        for(int_t n=0;n<num_dofs;++n)
+          (*variables)[n] = (*shrunk_points.back())[n];
+        ytry = batch_values.back();
+        objective_is_current = false;
         nfunk += num_dofs;
 
         for (int_t j = 0; j < num_dofs; j++) {
@@ -261,7 +303,7 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
       }
     } else --nfunk;
 
-    gamma_new = objective(variables);
+    gamma_new = ytry;
 #ifdef DICE_DEBUG_MSG
     std::cout << "Iteration " << iteration;
     for(int_t i=0;i<num_dofs;++i) std::cout << " " << (*variables)[i];
@@ -269,13 +311,29 @@ Simplex::minimize(Teuchos::RCP<std::vector<scalar_t> > variables,
 #endif
   }
 
-  delete [] gamma_values;
-  delete [] points_column_sums;
-  delete [] ptry;
+  // leave the objective in the state of the returned variables
+  if(!objective_is_current)
+    objective(variables);
   num_iterations = iteration;
   return CORRELATION_SUCCESSFUL;
 }
 
+void
+Simplex::objective_batch(Teuchos::RCP<std::vector<scalar_t> > variables,
+  const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & points,
+  std::vector<scalar_t> & values){
+  const std::vector<scalar_t> init_variables(*variables);
+  values.resize(points.size());
+  for(size_t i=0;i<points.size();++i){
+    assert(points[i]->size()==variables->size());
+    for(size_t j=0;j<variables->size();++j)
+      (*variables)[j] = (*points[i])[j];
+    values[i] = objective(variables);
+  }
+  for(size_t j=0;j<variables->size();++j)
+    (*variables)[j] = init_variables[j];
+}
+
 Status_Flag
 Subset_Simplex::minimize(Teuchos::RCP<Local_Shape_Function> shape_function,
   int_t & num_iterations,
@@ -283,7 +341,21 @@ Subset_Simplex::minimize(Teuchos::RCP<Local_Shape_Function> shape_function,
   if(shape_function_==Teuchos::null)
     shape_function_=Teuchos::RCP<Local_Shape_Function>(shape_function);
   assert(shape_function_!=Teuchos::null);
-  return Simplex::minimize(shape_function_->rcp(),shape_function_->deltas(),num_iterations,threshold);
+  // the per-thread copies are created once for the whole minimization, outside of any parallel region
+  if(max_parallel_evaluations()>1){
+    batch_workspace_ = Teuchos::rcp(new Gamma_Batch_Workspace());
+    obj_->create_batch_workspace(*batch_workspace_);
+  }
+  Status_Flag status = CORRELATION_FAILED;
+  try{
+    status = Simplex::minimize(shape_function_->rcp(),shape_function_->deltas(),num_iterations,threshold);
+  }
+  catch(...){
+    batch_workspace_ = Teuchos::null;
+    throw;
+  }
+  batch_workspace_ = Teuchos::null;
+  return status;
 }
 
 Subset_Simplex::Subset_Simplex(const DICe::Objective * const obj,
@@ -301,6 +373,26 @@ Subset_Simplex::objective(Teuchos::RCP<std::vector<scalar_t> > variables){
   return obj_->gamma(shape_function_);
 }
 
+void
+Subset_Simplex::objective_batch(Teuchos::RCP<std::vector<scalar_t> > variables,
+  const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & points,
+  std::vector<scalar_t> & values){
+  if(points.size()<=1||max_parallel_evaluations()<=1||batch_workspace_==Teuchos::null){
+    Simplex::objective_batch(variables,points,values);
+    return;
+  }
+  obj_->gamma_batch(points,*batch_workspace_,values);
+}
+
+int_t
+Subset_Simplex::max_parallel_evaluations()const{
+#ifdef _OPENMP
+  if(!omp_in_parallel())
+    return omp_get_max_threads();
+#endif
+  return 1;
+}
+
 Homography_Simplex::Homography_Simplex(Teuchos::RCP<Image> left_img,
   Teuchos::RCP<Image> right_img,
   Triangulation * tri,
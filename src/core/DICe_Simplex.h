@@ -61,6 +61,11 @@ class Triangulation;
 /// converges to a single point. This method is a lot slower than a gradient-based approach,
 /// but is much more robust. The simplex method will almost always converge to a value that
 /// that represents the best solution given the input parameters.
+///
+/// Evaluations that do not depend on each other (the vertices of the initial simplex and of a shrink step)
+/// are handed to objective_batch() together. If the derived class can run at least four evaluations at once
+/// (see max_parallel_evaluations()), the reflection, expansion and both contraction points of each iteration
+/// are also evaluated together up front. The search follows the same path either way.
 
 class DICE_LIB_DLL_EXPORT
 Simplex {
@@ -90,6 +95,19 @@ public:
   /// \param variables the current guess at which to evaluate the objective
   virtual scalar_t objective(Teuchos::RCP<std::vector<scalar_t> > variables)=0;
 
+  /// \brief evaluate the objective at several points, the default calls objective() for each point in turn
+  /// \param variables work vector passed to objective() (its values are restored on return)
+  /// \param points the points at which to evaluate the objective
+  /// \param values [out] the objective value at each point
+  virtual void objective_batch(Teuchos::RCP<std::vector<scalar_t> > variables,
+    const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & points,
+    std::vector<scalar_t> & values);
+
+  /// returns the number of objective evaluations that objective_batch() can run at the same time
+  virtual int_t max_parallel_evaluations()const{
+    return 1;
+  }
+
 protected:
   /// Maximum allowed iterations for convergence
   int_t max_iterations_;
@@ -120,7 +138,23 @@ public:
   /// \param variables the current guess at which to evaluate the objective
   virtual scalar_t objective(Teuchos::RCP<std::vector<scalar_t> > variables);
 
+  /// \brief evaluates gamma for all the points at once with DICe::Objective::gamma_batch() (in parallel if OpenMP is enabled)
+  ///
+  /// The points are evaluated one at a time if called outside of minimize() since the per-thread copies of the subset only exist during a minimization
+  /// \param variables the shape function parameters (not modified)
+  /// \param points the shape function parameters at which to evaluate gamma
+  /// \param values [out] the gamma value at each point
+  virtual void objective_batch(Teuchos::RCP<std::vector<scalar_t> > variables,
+    const std::vector<Teuchos::RCP<std::vector<scalar_t> > > & points,
+    std::vector<scalar_t> & values);
+
+  /// returns the number of OpenMP threads available (one if OpenMP is not enabled or this is called from a parallel region)
+  virtual int_t max_parallel_evaluations()const;
+
   /// call the minimization routine
+  ///
+  /// If more than one evaluation can run at once, the per-thread copies used by objective_batch() are created
+  /// at the start of the call and released at the end, both on the calling thread
   /// \param shape_function pointer to a shape function
   /// \param num_iterations the number of iterations
   /// \param threshold the convergence threshold
@@ -134,6 +168,8 @@ protected:
   const DICe::Objective * const obj_;
   /// Pointer to a shape function class
   Teuchos::RCP<Local_Shape_Function> shape_function_;
+  /// per-thread copies for DICe::Objective::gamma_batch() (only valid during minimize())
+  Teuchos::RCP<Gamma_Batch_Workspace> batch_workspace_;
 };
 
 /// a derived optimization class specific for image homography between two cameras
@@ -44,9 +44,174 @@
 #include <Teuchos_ArrayRCP.hpp>
 
 #include <cassert>
+#include <map>
 
 namespace DICe {
 
+FFT_Plan::FFT_Plan(const int_t w,
+  const int_t h,
+  const int_t inverse):
+  w_(w),
+  h_(h),
+  inverse_(inverse),
+  cfg_x_(NULL),
+  cfg_y_(NULL),
+  cfg_half_x_(NULL)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(w_<1||h_<1,std::invalid_argument,"Error, invalid dimensions for FFT plan " << w_ << " x " << h_);
+  cfg_x_ = kiss_fft_alloc(w_,inverse_,0,0);
+  if(h_>1)
+    cfg_y_ = kiss_fft_alloc(h_,inverse_,0,0);
+  // the real transform packs the even and odd samples of a row into a complex
+  // array of half the length so it is only available for even widths
+  if(inverse_==0&&w_%2==0&&w_>2){
+    const int_t half_w = w_/2;
+    cfg_half_x_ = kiss_fft_alloc(half_w,0,0,0);
+    twiddle_r_.resize(half_w+1);
+    twiddle_i_.resize(half_w+1);
+    for(int_t k=0;k<=half_w;++k){
+      twiddle_r_[k] = std::cos(-DICE_TWOPI*k/w_);
+      twiddle_i_[k] = std::sin(-DICE_TWOPI*k/w_);
+    }
+  }
+}
+
+FFT_Plan::~FFT_Plan(){
+  if(cfg_x_) kiss_fft_free(cfg_x_);
+  if(cfg_y_) kiss_fft_free(cfg_y_);
+  if(cfg_half_x_) kiss_fft_free(cfg_half_x_);
+}
+
+void
+FFT_Plan::transform(scalar_t * real,
+  scalar_t * complex)const{
+  // fft the rows
+#pragma omp parallel
+  {
+    std::vector<kiss_fft_cpx> row_in(w_);
+    std::vector<kiss_fft_cpx> row_out(w_);
+#pragma omp for schedule(static)
+    for(int_t y=0;y<h_;++y){
+      scalar_t * row_r = &real[y*w_];
+      scalar_t * row_i = &complex[y*w_];
+      for(int_t x=0;x<w_;++x){
+        row_in[x].r = row_r[x];
+        row_in[x].i = row_i[x];
+      }
+      kiss_fft(cfg_x_,&row_in[0],&row_out[0]);
+      for(int_t x=0;x<w_;++x){
+        row_r[x] = row_out[x].r;
+        row_i[x] = row_out[x].i;
+      }
+    }
+  }
+  // fft the cols
+  transform_columns(real,complex,w_);
+}
+
+void
+FFT_Plan::transform_real(const scalar_t * input,
+  scalar_t * real,
+  scalar_t * complex)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(inverse_!=0,std::runtime_error,"Error, the real transform is only available for forward plans");
+  if(cfg_half_x_==NULL){
+    // odd widths fall back to the complex transform
+    for(int_t i=0;i<w_*h_;++i){
+      real[i] = input[i];
+      complex[i] = 0.0;
+    }
+    transform(real,complex);
+    return;
+  }
+  const int_t half_w = w_/2;
+  // fft the rows (even samples are packed in the real part and odd samples in the imaginary part)
+#pragma omp parallel
+  {
+    std::vector<kiss_fft_cpx> row_in(half_w);
+    std::vector<kiss_fft_cpx> row_out(half_w);
+#pragma omp for schedule(static)
+    for(int_t y=0;y<h_;++y){
+      const scalar_t * row = &input[y*w_];
+      for(int_t n=0;n<half_w;++n){
+        row_in[n].r = row[2*n];
+        row_in[n].i = row[2*n+1];
+      }
+      kiss_fft(cfg_half_x_,&row_in[0],&row_out[0]);
+      // unpack the transforms of the even and odd samples and combine them
+      for(int_t k=0;k<=half_w;++k){
+        const kiss_fft_cpx & a = row_out[k%half_w];
+        const kiss_fft_cpx & b = row_out[(half_w-k)%half_w];
+        const scalar_t even_r = 0.5*(a.r + b.r);
+        const scalar_t even_i = 0.5*(a.i - b.i);
+        const scalar_t odd_r = 0.5*(a.i + b.i);
+        const scalar_t odd_i = -0.5*(a.r - b.r);
+        real[y*w_+k] = even_r + twiddle_r_[k]*odd_r - twiddle_i_[k]*odd_i;
+        complex[y*w_+k] = even_i + twiddle_r_[k]*odd_i + twiddle_i_[k]*odd_r;
+      }
+    }
+  }
+  // only the non-redundant columns need to be transformed
+  transform_columns(real,complex,half_w+1);
+  // the rest come from the conjugate symmetry of the transform of a real signal
+#pragma omp parallel for schedule(static)
+  for(int_t y=0;y<h_;++y){
+    const int_t sym_y = (h_-y)%h_;
+    for(int_t x=half_w+1;x<w_;++x){
+      real[y*w_+x] = real[sym_y*w_+w_-x];
+      complex[y*w_+x] = -complex[sym_y*w_+w_-x];
+    }
+  }
+}
+
+void
+FFT_Plan::transform_columns(scalar_t * real,
+  scalar_t * complex,
+  const int_t num_cols)const{
+  if(cfg_y_==NULL) return;
+#pragma omp parallel
+  {
+    std::vector<kiss_fft_cpx> col_in(h_);
+    std::vector<kiss_fft_cpx> col_out(h_);
+#pragma omp for schedule(static)
+    for(int_t x=0;x<num_cols;++x){
+      for(int_t y=0;y<h_;++y){
+        col_in[y].r = real[y*w_+x];
+        col_in[y].i = complex[y*w_+x];
+      }
+      kiss_fft(cfg_y_,&col_in[0],&col_out[0]);
+      for(int_t y=0;y<h_;++y){
+        real[y*w_+x] = col_out[y].r;
+        complex[y*w_+x] = col_out[y].i;
+      }
+    }
+  }
+}
+
+DICE_LIB_DLL_EXPORT
+Teuchos::RCP<FFT_Plan>
+fft_plan(const int_t w,
+  const int_t h,
+  const int_t inverse){
+  // NOTE: the cache is not guarded, so plans should be requested outside of threaded regions
+  // and shared with the threads (the plans themselves are read-only once constructed)
+  static std::map<std::pair<std::pair<int_t,int_t>,int_t>,Teuchos::RCP<FFT_Plan> > plan_cache;
+  const std::pair<std::pair<int_t,int_t>,int_t> key(std::pair<int_t,int_t>(w,h),inverse==0?0:1);
+  std::map<std::pair<std::pair<int_t,int_t>,int_t>,Teuchos::RCP<FFT_Plan> >::iterator it = plan_cache.find(key);
+  if(it!=plan_cache.end())
+    return it->second;
+  DEBUG_MSG("fft_plan(): creating a new plan for " << w << " x " << h << " inverse " << inverse);
+  Teuchos::RCP<FFT_Plan> plan = Teuchos::rcp(new FFT_Plan(w,h,key.second));
+  plan_cache.insert(std::pair<std::pair<std::pair<int_t,int_t>,int_t>,Teuchos::RCP<FFT_Plan> >(key,plan));
+  return plan;
+}
+
+DICE_LIB_DLL_EXPORT
+int_t
+fft_good_size(const int_t n){
+  if(n<=1) return 1;
+  return kiss_fft_next_fast_size(n);
+}
+
 DICE_LIB_DLL_EXPORT
 void
 complex_divide(kiss_fft_cpx * lhs,
@@ -127,14 +292,17 @@ phase_correlate_x_y(Teuchos::RCP<Image> image_a,
   Teuchos::RCP<Image> image_b,
   scalar_t & u_x,
   scalar_t & u_y,
-  const bool convert_to_r_theta){
-
-  const int_t w = image_a->width();
-  const int_t h = image_a->height();
-  assert(image_b->width()==w && "Error: images must be the same dims");
-  assert(image_b->height()==h && "Error: images must be the same dims");
-  assert(w>8);
-  assert(h>8);
+  const bool convert_to_r_theta,
+  const bool pad_to_good_size){
+
+  const int_t img_w = image_a->width();
+  const int_t img_h = image_a->height();
+  assert(image_b->width()==img_w && "Error: images must be the same dims");
+  assert(image_b->height()==img_h && "Error: images must be the same dims");
+  assert(img_w>8);
+  assert(img_h>8);
+  TEUCHOS_TEST_FOR_EXCEPTION(convert_to_r_theta&&pad_to_good_size,std::invalid_argument,
+    "Error, the images cannot be padded for an r theta phase correlation");
 
   // test that the images don't have the same intensities, if so return 0,0
   // This hopefully removes the false 0,0 peak
@@ -149,43 +317,34 @@ phase_correlate_x_y(Teuchos::RCP<Image> image_a,
     return -1.0;
   }
 
+  // dimensions of the transforms (padded if requested)
+  const int_t w = pad_to_good_size ? fft_good_size(img_w) : img_w;
+  const int_t h = pad_to_good_size ? fft_good_size(img_h) : img_h;
+
   // fft of image a
   Teuchos::ArrayRCP<scalar_t> a_r,a_i;
-  DICe::image_fft(image_a,a_r,a_i,0);
+  DICe::image_fft(image_a,a_r,a_i,0,true,pad_to_good_size);
 
   // fft of image b
   Teuchos::ArrayRCP<scalar_t> b_r,b_i;
-  DICe::image_fft(image_b,b_r,b_i,0);
-
-  // conjugate of image b
-  for(int_t i=0;i<w*h;++i)
-    b_i[i] = -b_i[i];
-
-  // FFTR = FFT1 .* FFT2
-  Teuchos::ArrayRCP<scalar_t> FFTR_r(w*h,0.0), FFTR_i(w*h,0.0);
-  for(int_t i=0;i<w*h;++i)
-    complex_multiply(FFTR_r[i],FFTR_i[i],a_r[i],a_i[i],b_r[i],b_i[i]);
-
-  // compute abs(FFTR)
-  Teuchos::ArrayRCP<scalar_t> FFTR_abs(w*h,0.0);
-  for(int_t i=0;i<w*h;++i)
-    complex_abs(FFTR_abs[i],FFTR_r[i],FFTR_i[i]);
-
-  //FFTRN = FFTR / (abs(FT1 .* FFT2))
-  Teuchos::ArrayRCP<scalar_t> FFTRN_r(w*h,0.0), FFTRN_i(w*h,0.0),zero(w*h,0.0);
-  for(int_t i=0;i<w*h;++i)
-    complex_divide(FFTRN_r[i],FFTRN_i[i],FFTR_r[i],FFTR_i[i],FFTR_abs[i],zero[i]);
+  DICe::image_fft(image_b,b_r,b_i,0,true,pad_to_good_size);
+  assert(a_r.size()==w*h);
+  assert(b_r.size()==w*h);
+
+  // FFTRN = FFT1 .* conj(FFT2) / abs(FFT1 .* conj(FFT2)) (stored in place of FFT1)
+#pragma omp parallel for schedule(static)
+  for(int_t i=0;i<w*h;++i){
+    scalar_t FFTR_r = 0.0, FFTR_i = 0.0, FFTR_abs = 0.0;
+    complex_multiply(FFTR_r,FFTR_i,a_r[i],a_i[i],b_r[i],-b_i[i]);
+    complex_abs(FFTR_abs,FFTR_r,FFTR_i);
+    a_r[i] = FFTR_abs==0.0 ? 0.0 : FFTR_r/FFTR_abs;
+    a_i[i] = FFTR_abs==0.0 ? 0.0 : FFTR_i/FFTR_abs;
+  }
 
   // result = inverse FFTRN
-  array_2d_fft_in_place(w,h,FFTRN_r,FFTRN_i,1);
-
-//  std::cout << " FFTRN " << std::endl;
-//  for(int_t i=0;i<h;++i){
-//    for(int_t j=0;j<w;++j){
-//      std::cout << FFTRN_r[i*w+j] << "+"<< FFTRN_i[i*w+j] << "j " << std::endl;
-//    }
-//    std::cout << std::endl;
-//  }
+  fft_plan(w,h,1)->transform(a_r.getRawPtr(),a_i.getRawPtr());
+  Teuchos::ArrayRCP<scalar_t> FFTRN_r = a_r;
+  Teuchos::ArrayRCP<scalar_t> FFTRN_i = a_i;
 
   // find max of result
   scalar_t max_real = 0.0;
@@ -291,71 +450,31 @@ phase_correlate_row(Teuchos::RCP<Image> image_a,
   int_t w = image_a->width();
   assert(w>1);
 
-  // compute the hamming filter
-  Teuchos::ArrayRCP<scalar_t> x_ham(w,0.0);
-  for(int_t i=0;i<w;++i)
-    x_ham[i] = 0.54 - 0.46*std::cos(DICE_TWOPI*i/(w-1));
-
-  // compute th fft of image a's row
-  Teuchos::ArrayRCP<scalar_t> a_real(w,0.0), a_complex(w,0.0);
-  kiss_fft_cpx * img_row = new kiss_fft_cpx[w];
-  kiss_fft_cfg cfg_ffx = kiss_fft_alloc(w,0,0,0);
-  // fft the rows
-  for(int_t x=0;x<w;++x){
-    img_row[x].r=(*image_a)(x,row_id)*x_ham[x];
-    img_row[x].i=0;
-  }
-  kiss_fft(cfg_ffx,img_row,img_row);
-  for(int_t x=0;x<w;++x){
-    a_real[x] = img_row[x].r;
-    a_complex[x] = img_row[x].i;
-  }
-  // compute the fft of b's row:
-  Teuchos::ArrayRCP<scalar_t> b_real(w,0.0), b_complex(w,0.0);
-  for(int_t x=0;x<w;++x){
-    img_row[x].r=(*image_b)(x,row_id)*x_ham[x];
-    img_row[x].i=0;
-  }
-  kiss_fft(cfg_ffx,img_row,img_row);
+  // apply the hamming filter to the rows
+  std::vector<scalar_t> row_a(w,0.0), row_b(w,0.0);
   for(int_t x=0;x<w;++x){
-    b_real[x] = img_row[x].r;
-    b_complex[x] = img_row[x].i;
+    const scalar_t x_ham = 0.54 - 0.46*std::cos(DICE_TWOPI*x/(w-1));
+    row_a[x] = (*image_a)(x,row_id)*x_ham;
+    row_b[x] = (*image_b)(x,row_id)*x_ham;
   }
-  free(cfg_ffx);
-
 
-  // conjugate of image b
-  for(int_t i=0;i<w;++i)
-    b_complex[i] = -b_complex[i];
+  // compute the fft of each row
+  Teuchos::RCP<FFT_Plan> forward_plan = fft_plan(w,1,0);
+  std::vector<scalar_t> FFTRN_r(w,0.0), FFTRN_i(w,0.0), b_real(w,0.0), b_complex(w,0.0);
+  forward_plan->transform_real(&row_a[0],&FFTRN_r[0],&FFTRN_i[0]);
+  forward_plan->transform_real(&row_b[0],&b_real[0],&b_complex[0]);
 
-  // FFTR = FFT1 .* FFT2
-  Teuchos::ArrayRCP<scalar_t> FFTR_r(w,0.0), FFTR_i(w,0.0);
-  for(int_t i=0;i<w;++i)
-    complex_multiply(FFTR_r[i],FFTR_i[i],a_real[i],a_complex[i],b_real[i],b_complex[i]);
-
-  // compute abs(FFTR)
-  Teuchos::ArrayRCP<scalar_t> FFTR_abs(w,0.0);
-  for(int_t i=0;i<w;++i)
-    complex_abs(FFTR_abs[i],FFTR_r[i],FFTR_i[i]);
-
-  //FFTRN = FFTR / (abs(FT1 .* FFT2))
-  Teuchos::ArrayRCP<scalar_t> FFTRN_r(w,0.0), FFTRN_i(w,0.0),zero(w,0.0);
-  for(int_t i=0;i<w;++i)
-    complex_divide(FFTRN_r[i],FFTRN_i[i],FFTR_r[i],FFTR_i[i],FFTR_abs[i],zero[i]);
-
-  kiss_fft_cfg cfg_ffxi = kiss_fft_alloc(w,1,0,0);
-  // fft the rows
-  for(int_t x=0;x<w;++x){
-    img_row[x].r=FFTRN_r[x];
-    img_row[x].i=FFTRN_i[x];
-  }
-  kiss_fft(cfg_ffxi,img_row,img_row);
-  for(int_t x=0;x<w;++x){
-    FFTRN_r[x] = img_row[x].r;
-    FFTRN_i[x] = img_row[x].i;
+  //FFTRN = FFT1 .* conj(FFT2) / abs(FFT1 .* conj(FFT2))
+  scalar_t FFTR_r = 0.0, FFTR_i = 0.0, FFTR_abs = 0.0;
+  for(int_t i=0;i<w;++i){
+    complex_multiply(FFTR_r,FFTR_i,FFTRN_r[i],FFTRN_i[i],b_real[i],-b_complex[i]);
+    complex_abs(FFTR_abs,FFTR_r,FFTR_i);
+    FFTRN_r[i] = FFTR_abs==0.0 ? 0.0 : FFTR_r/FFTR_abs;
+    FFTRN_i[i] = FFTR_abs==0.0 ? 0.0 : FFTR_i/FFTR_abs;
   }
-  free(cfg_ffxi);
-  delete[] img_row;
+
+  // inverse fft back to the time domain
+  fft_plan(w,1,1)->transform(&FFTRN_r[0],&FFTRN_i[0]);
 
   // find the max and convert to theta if necessary
   u = 0;
@@ -546,73 +665,51 @@ image_fft(Teuchos::RCP<Image> image,
   Teuchos::ArrayRCP<scalar_t> & real,
   Teuchos::ArrayRCP<scalar_t> & complex,
   const int_t inverse,
-  const bool hamming_filter){
-
-  const int_t w = image->width();
-  assert(w>1);
-  const int_t h = image->height();
-  assert(h>1);
+  const bool hamming_filter,
+  const bool pad_to_good_size){
+
+  const int_t img_w = image->width();
+  assert(img_w>1);
+  const int_t img_h = image->height();
+  assert(img_h>1);
+  const int_t w = pad_to_good_size ? fft_good_size(img_w) : img_w;
+  const int_t h = pad_to_good_size ? fft_good_size(img_h) : img_h;
+  // any padding is left as zeros
+  Teuchos::ArrayRCP<scalar_t> input(w*h,0.0);
   real = Teuchos::ArrayRCP<scalar_t> (w*h,0.0);
   complex = Teuchos::ArrayRCP<scalar_t> (w*h,0.0);
 
   if(hamming_filter){
-    Teuchos::ArrayRCP<scalar_t> x_ham(w,0.0);
-    Teuchos::ArrayRCP<scalar_t> y_ham(h,0.0);
-    for(int_t i=0;i<w;++i){
-      x_ham[i] = 0.54 - 0.46*std::cos(DICE_TWOPI*i/(w-1));
+    Teuchos::ArrayRCP<scalar_t> x_ham(img_w,0.0);
+    Teuchos::ArrayRCP<scalar_t> y_ham(img_h,0.0);
+    for(int_t i=0;i<img_w;++i){
+      x_ham[i] = 0.54 - 0.46*std::cos(DICE_TWOPI*i/(img_w-1));
     }
-    for(int_t i=0;i<h;++i){
-      y_ham[i] = 0.54 - 0.46*std::cos(DICE_TWOPI*i/(h-1));
+    for(int_t i=0;i<img_h;++i){
+      y_ham[i] = 0.54 - 0.46*std::cos(DICE_TWOPI*i/(img_h-1));
     }
-    for(int_t y=0;y<h;++y){
-      for(int_t x=0;x<w;++x){
-        real[y*w+x] = (*image)(x,y)*x_ham[x]*y_ham[y];
+    for(int_t y=0;y<img_h;++y){
+      for(int_t x=0;x<img_w;++x){
+        input[y*w+x] = (*image)(x,y)*x_ham[x]*y_ham[y];
       }
     }
   }
   else{
-    for(int_t y=0;y<h;++y){
-      for(int_t x=0;x<w;++x){
-        real[y*w+x] = (*image)(x,y);
+    for(int_t y=0;y<img_h;++y){
+      for(int_t x=0;x<img_w;++x){
+        input[y*w+x] = (*image)(x,y);
       }
     }
   }
 
-  kiss_fft_cpx * img_row = new kiss_fft_cpx[w];
-  kiss_fft_cpx * img_col = new kiss_fft_cpx[h];
-  kiss_fft_cfg cfg_ffx = kiss_fft_alloc(w,inverse,0,0);
-  kiss_fft_cfg cfg_ffy = kiss_fft_alloc(h,inverse,0,0);
-
-  // fft the rows
-  for(int_t y=0;y<h;++y){
-    for(int_t x=0;x<w;++x){
-      img_row[x].r=real[y*w+x];
-      img_row[x].i=0.0;
-    }
-    kiss_fft(cfg_ffx,img_row,img_row);
-    for(int_t x=0;x<w;++x){
-      real[y*w+x] = img_row[x].r;
-      complex[y*w+x] = img_row[x].i;
-    }
+  if(inverse==0){
+    // the image is real valued so the cheaper real to complex transform can be used
+    fft_plan(w,h,0)->transform_real(input.getRawPtr(),real.getRawPtr(),complex.getRawPtr());
   }
-  // fft the cols
-  for(int_t x=0;x<w;++x){
-    for(int_t y=0;y<h;++y){
-      img_col[y].r=real[y*w+x];
-      img_col[y].i=complex[y*w+x];
-    }
-    kiss_fft(cfg_ffy,img_col,img_col);
-    for(int_t y=0;y<h;++y){
-      real[y*w+x] = img_col[y].r;
-      complex[y*w+x] = img_col[y].i;
-    }
+  else{
+    real = input;
+    fft_plan(w,h,1)->transform(real.getRawPtr(),complex.getRawPtr());
   }
-
-  free(cfg_ffx);
-  free(cfg_ffy);
-  delete[] img_row;
-  delete[] img_col;
-
 };
 
 DICE_LIB_DLL_EXPORT
@@ -622,40 +719,9 @@ array_2d_fft_in_place(const int_t w,
   Teuchos::ArrayRCP<scalar_t> & real,
   Teuchos::ArrayRCP<scalar_t> & complex,
   const int_t inverse){
-
-  kiss_fft_cpx * img_row = new kiss_fft_cpx[w];
-  kiss_fft_cpx * img_col = new kiss_fft_cpx[h];
-  kiss_fft_cfg cfg_ffx = kiss_fft_alloc(w,inverse,0,0);
-  kiss_fft_cfg cfg_ffy = kiss_fft_alloc(h,inverse,0,0);
-
-  // fft the rows
-  for(int_t y=0;y<h;++y){
-    for(int_t x=0;x<w;++x){
-      img_row[x].r=real[y*w+x];
-      img_row[x].i=complex[y*w+x];
-    }
-    kiss_fft(cfg_ffx,img_row,img_row);
-    for(int_t x=0;x<w;++x){
-      real[y*w+x] = img_row[x].r;
-      complex[y*w+x] = img_row[x].i;
-    }
-  }
-  // fft the cols
-  for(int_t x=0;x<w;++x){
-    for(int_t y=0;y<h;++y){
-      img_col[y].r=real[y*w+x];
-      img_col[y].i=complex[y*w+x];
-    }
-    kiss_fft(cfg_ffy,img_col,img_col);
-    for(int_t y=0;y<h;++y){
-      real[y*w+x] = img_col[y].r;
-      complex[y*w+x] = img_col[y].i;
-    }
-  }
-  free(cfg_ffx);
-  free(cfg_ffy);
-  delete[] img_row;
-  delete[] img_col;
+  assert(real.size()==w*h);
+  assert(complex.size()==w*h);
+  fft_plan(w,h,inverse)->transform(real.getRawPtr(),complex.getRawPtr());
 };
 
 }// End DICe Namespace
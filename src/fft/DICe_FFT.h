@@ -48,9 +48,113 @@
 #include <Teuchos_ArrayRCP.hpp>
 
 #include <cassert>
+#include <vector>
 
 namespace DICe {
 
+/// \class DICe::FFT_Plan
+/// \brief Holds the kiss_fft configurations (twiddle factors, factorization) for a 2D
+/// transform of a given size and direction
+///
+/// Plans should be obtained with fft_plan(), which caches them by (width, height, direction)
+/// so that the configurations are only computed once for each size. The row and column
+/// passes are threaded when OpenMP is enabled. A plan is read-only once it has been
+/// constructed, so the same plan can be used from multiple threads.
+class DICE_LIB_DLL_EXPORT
+FFT_Plan {
+public:
+  /// constructor
+  /// \param w width of the arrays to transform
+  /// \param h height of the arrays to transform (1 for a 1D transform)
+  /// \param inverse 1 if this is an inverse transform (back to the time domain)
+  FFT_Plan(const int_t w,
+    const int_t h,
+    const int_t inverse);
+
+  /// destructor
+  ~FFT_Plan();
+
+  /// returns the width of the transform
+  int_t width()const{
+    return w_;
+  }
+
+  /// returns the height of the transform
+  int_t height()const{
+    return h_;
+  }
+
+  /// returns 1 if this is an inverse transform
+  int_t inverse()const{
+    return inverse_;
+  }
+
+  /// complex to complex 2D transform in place
+  /// \param real [in/out] the real part of the array (w*h values stored row by row)
+  /// \param complex [in/out] the imaginary part of the array
+  void transform(scalar_t * real,
+    scalar_t * complex)const;
+
+  /// \brief forward transform of a purely real array
+  ///
+  /// Each row is transformed as a complex array of half the length and unpacked, and only the
+  /// w/2+1 non-redundant columns are transformed, the rest of the spectrum is filled in using
+  /// the conjugate symmetry of the transform of a real signal. The full w*h spectrum is returned.
+  /// Must only be called on a forward plan.
+  /// \param input the real valued input array (w*h values stored row by row)
+  /// \param real [out] the real part of the transform
+  /// \param complex [out] the imaginary part of the transform
+  void transform_real(const scalar_t * input,
+    scalar_t * real,
+    scalar_t * complex)const;
+
+private:
+  /// not copyable (the configurations are owned by the plan)
+  FFT_Plan(const FFT_Plan &);
+  /// not assignable
+  FFT_Plan & operator=(const FFT_Plan &);
+  /// column pass for the first num_cols columns of the array
+  void transform_columns(scalar_t * real,
+    scalar_t * complex,
+    const int_t num_cols)const;
+  /// width
+  int_t w_;
+  /// height
+  int_t h_;
+  /// 1 for an inverse transform
+  int_t inverse_;
+  /// configuration for the rows
+  kiss_fft_cfg cfg_x_;
+  /// configuration for the columns (null for a 1D transform)
+  kiss_fft_cfg cfg_y_;
+  /// configuration for the half length rows used by the real transform (null if w is odd)
+  kiss_fft_cfg cfg_half_x_;
+  /// real part of the twiddle factors used to unpack the half length real transform
+  std::vector<scalar_t> twiddle_r_;
+  /// imaginary part of the twiddle factors used to unpack the half length real transform
+  std::vector<scalar_t> twiddle_i_;
+};
+
+/// returns a plan for the given size and direction, plans are cached so that repeated
+/// transforms of the same size reuse the same configuration. The cache is not guarded, so this
+/// must be called outside of threaded regions. A plan is read-only once constructed, so threads
+/// can share the raw pointer (plan.get()) as long as the returned RCP is held by the calling thread
+/// \param w width of the transform
+/// \param h height of the transform (1 for a 1D transform)
+/// \param inverse 1 if this should be an inverse transform
+DICE_LIB_DLL_EXPORT
+Teuchos::RCP<FFT_Plan>
+fft_plan(const int_t w,
+  const int_t h,
+  const int_t inverse=0);
+
+/// returns the smallest size greater than or equal to n that has only 2, 3, and 5 as factors
+/// (transforms of these sizes are the fastest)
+/// \param n the size to round up
+DICE_LIB_DLL_EXPORT
+int_t
+fft_good_size(const int_t n);
+
 /// complex number divide
 /// \param lhs left hand side
 /// \param rhs right hand side
@@ -67,13 +171,16 @@ complex_divide(kiss_fft_cpx * lhs,
 /// \param complex [out] the imaginary part of the FFT
 /// \param inverse 1 if this should be an inverse FFT (back to time domain)
 /// \param hamming_filter true if a hamming filter should be applied to the image
+/// \param pad_to_good_size true if the image should be zero padded to the next size
+/// that has only 2, 3, and 5 as factors (in which case the output arrays are of the padded size)
 DICE_LIB_DLL_EXPORT
 void
 image_fft(Teuchos::RCP<Image> image,
   Teuchos::ArrayRCP<scalar_t> & real,
   Teuchos::ArrayRCP<scalar_t> & complex,
   const int_t inverse = 0,
-  const bool hamming_filter=true);
+  const bool hamming_filter=true,
+  const bool pad_to_good_size=false);
 
 /// compute the image fft and return an image with
 /// intensity values as the magnitude of the FFT values
@@ -104,13 +211,16 @@ image_fft(Teuchos::RCP<Image> image,
 /// \param u_y [out] displacement y
 /// \param convert_to_r_theta true if the images are polar transforms and
 /// the correlation is for radius and angle of rotation
+/// \param pad_to_good_size true if the images should be zero padded to a size that
+/// has only 2, 3, and 5 as factors (not valid with convert_to_r_theta since the angle is periodic)
 DICE_LIB_DLL_EXPORT
 scalar_t
 phase_correlate_x_y(Teuchos::RCP<Image> image_a,
   Teuchos::RCP<Image> image_b,
   scalar_t & u_x,
   scalar_t & u_y,
-  const bool convert_to_r_theta=false);
+  const bool convert_to_r_theta=false,
+  const bool pad_to_good_size=false);
 
 /// Phase correlate a single row from two images
 /// \param image_a the first image
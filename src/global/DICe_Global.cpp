@@ -991,8 +991,10 @@ Global_Algorithm::execute(){
       disp_nm1->put_scalar(0.0);
     }
     if(schema_->has_initial_condition_file()&&schema_->frame_id()==schema_->first_frame_id()){
-      Teuchos::RCP<DICe::mesh::Importer_Projector> importer =
-          Teuchos::rcp(new DICe::mesh::Importer_Projector(schema_->initial_condition_file(),mesh_));
+      // the importer is only rebuilt if the file or the node locations have changed since it was created
+      if(initial_condition_importer_==Teuchos::null||!initial_condition_importer_->matches(schema_->initial_condition_file(),mesh_))
+        initial_condition_importer_ = Teuchos::rcp(new DICe::mesh::Importer_Projector(schema_->initial_condition_file(),mesh_));
+      Teuchos::RCP<DICe::mesh::Importer_Projector> importer = initial_condition_importer_;
       TEUCHOS_TEST_FOR_EXCEPTION(importer->num_target_pts()!=(int_t)mesh_->num_nodes(),std::runtime_error,"");
       std::vector<scalar_t> disp_x;
       std::vector<scalar_t> disp_y;
@@ -46,6 +46,7 @@
 #include <DICe_GlobalUtils.h>
 #include <DICe_BCManager.h>
 #include <DICe_Image.h>
+#include <DICe_MeshIOUtils.h>
 
 #include <BelosBlockCGSolMgr.hpp>
 #include <BelosBlockGmresSolMgr.hpp>
@@ -227,6 +228,8 @@ protected:
   Teuchos::RCP< Belos::SolverManager<mv_scalar_type,vec_type,operator_type> > belos_solver_;
   /// boundary condition manager
   Teuchos::RCP<BC_Manager> bc_manager_;
+  /// importer for the initial condition file (the projection weights are reused if the algorithm is executed again)
+  Teuchos::RCP<DICe::mesh::Importer_Projector> initial_condition_importer_;
   /// true if the solver, etc been initialized
   bool is_initialized_;
   /// set of active terms in the formulation
@@ -44,6 +44,12 @@
 
 #include <exodusII.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #ifdef HAVE_MPI
 #  include <mpi.h>
 #endif
@@ -51,10 +57,21 @@
 namespace DICe {
 namespace mesh {
 
+namespace {
+/// the exodus and netcdf libraries are not thread safe so every call into them from this file
+/// (including the ones made by the asynchronous output writers) is made while holding this mutex,
+/// recursive since some of the readers call each other
+std::recursive_mutex & exodus_library_mutex(){
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+} // end anonymous namespace
+
 DICE_LIB_DLL_EXPORT
 Teuchos::RCP<Mesh> read_exodus_mesh(const std::string & serial_input_filename,
   const std::string & serial_output_filename)
 {
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   std::stringstream in_file_base, out_file_base;
   // find the position of the file extension
   // only alow .g or .e
@@ -456,6 +473,7 @@ read_exodus_num_steps(Teuchos::RCP<Mesh> mesh){
 DICE_LIB_DLL_EXPORT
 int_t
 read_exodus_num_steps(const std::string & file_name){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   int_t num_steps = 0;
   float version;
   int_t CPU_word_size = 0;
@@ -508,6 +526,7 @@ std::vector<scalar_t>
 read_exodus_field(const std::string & file_name,
   const int_t var_index,
   const int_t step){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   TEUCHOS_TEST_FOR_EXCEPTION(step==0,std::runtime_error,"Invalid step (<=0): " << step);
   const int_t num_steps = read_exodus_num_steps(file_name);
   TEUCHOS_TEST_FOR_EXCEPTION(step>num_steps,std::runtime_error,"Invalid step (>num_steps): " << step);
@@ -552,6 +571,7 @@ read_exodus_field_names(Teuchos::RCP<Mesh> mesh){
 DICE_LIB_DLL_EXPORT
 std::vector<std::string>
 read_exodus_field_names(const std::string & file_name){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   float version;
   int_t CPU_word_size = 0;
   int_t IO_word_size = 0;
@@ -589,6 +609,7 @@ void read_exodus_coordinates(const std::string & exo_file,
   std::vector<scalar_t> & coords_x,
   std::vector<scalar_t> & coords_y,
   std::vector<scalar_t> & coords_z){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
 
   coords_x.clear();
   coords_y.clear();
@@ -644,6 +665,7 @@ void read_exodus_coordinates(const std::string & exo_file,
 DICE_LIB_DLL_EXPORT
 void
 read_exodus_coordinates(Teuchos::RCP<Mesh> mesh){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   int error_int;
   float version;
   int_t CPU_word_size = 0;
@@ -751,6 +773,7 @@ read_exodus_coordinates(Teuchos::RCP<Mesh> mesh){
 DICE_LIB_DLL_EXPORT
 void create_output_exodus_file(Teuchos::RCP<Mesh> mesh,
   const std::string & output_folder){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
 
   std::stringstream out_file;
   out_file << output_folder << mesh->get_output_filename();
@@ -1059,18 +1082,36 @@ void create_output_exodus_file(Teuchos::RCP<Mesh> mesh,
   delete[] dist_fact;
 }
 
-DICE_LIB_DLL_EXPORT
+namespace {
+
+/// \brief Copy of the printable field values for one time step, ready to be written to an exodus file
+struct Exodus_Snapshot {
+  /// time step number (1 or greater)
+  int_t time_step_num;
+  /// time value for the step
+  float time_value;
+  /// true if the variable is an element variable, otherwise nodal
+  std::vector<bool> is_elem_var;
+  /// exodus variable index of each variable
+  std::vector<int_t> var_index;
+  /// block id for element variables
+  std::vector<int_t> block_id;
+  /// values of each variable
+  std::vector<std::vector<float> > values;
+};
+
+/// copy the printable fields of the mesh into a snapshot (has to be called from the thread that owns the mesh)
 void
-exodus_output_dump(Teuchos::RCP<Mesh> mesh,
+take_exodus_snapshot(Teuchos::RCP<Mesh> mesh,
   const int_t & time_step_num,
-  const float & time_value)
-{
-  DEBUG_MSG("exodus_output_dump(): time_step_num: " << time_step_num << " time: " << time_value);
-  int error_int = 0;
-  error_int = ex_put_time(mesh->get_output_exoid(), time_step_num, &time_value);
-  TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"ex_put_time(): Failure " << error_int);
-
-  // write fields
+  const float & time_value,
+  Exodus_Snapshot & snapshot){
+  snapshot.time_step_num = time_step_num;
+  snapshot.time_value = time_value;
+  snapshot.is_elem_var.clear();
+  snapshot.var_index.clear();
+  snapshot.block_id.clear();
+  snapshot.values.clear();
   DICe::mesh::field_registry::iterator field_it = mesh->get_field_registry()->begin();
   DICe::mesh::field_registry::iterator field_end = mesh->get_field_registry()->end();
   for(;field_it!=field_end;++field_it)
@@ -1078,24 +1119,25 @@ exodus_output_dump(Teuchos::RCP<Mesh> mesh,
     if(!field_it->first.is_printable()) continue;
     if(field_it->first.get_rank()!=field_enums::ELEMENT_RANK && field_it->first.get_rank()!=field_enums::NODE_RANK) continue;
     const int_t num_comps = (field_it->first.get_field_type()==field_enums::VECTOR_FIELD_TYPE) ? mesh->spatial_dimension(): 1;
+    std::string components[3];
+    components[0] = (field_it->first.get_field_type()==field_enums::VECTOR_FIELD_TYPE) ? "X" : "";
+    components[1] = "Y";
+    components[2] = "Z";
 
     if(field_it->first.get_rank()==field_enums::ELEMENT_RANK)
     {
       MultiField & field = *mesh->get_field(field_it->first);
-      //Teuchos::ArrayRCP<const scalar_t> field_values = field.vec()->get_1d_view();
       DICe::mesh::block_type_map::iterator block_type_map_end = mesh->get_block_type_map()->end();
-      std::string components[3];
-      components[0] = (field_it->first.get_field_type()==field_enums::VECTOR_FIELD_TYPE) ? "X" : "";
-      components[1] = "Y";
-      components[2] = "Z";
       for (int_t comp = 0; comp < num_comps; ++comp)
       {
+        const int_t var_index = get_var_index(mesh, DICe::tostring(field_it->first.get_name()), components[comp], field_it->first.get_rank());
         for(DICe::mesh::block_type_map::iterator block_type_map_it = mesh->get_block_type_map()->begin();
             block_type_map_it!=block_type_map_end;++block_type_map_it)
         {
           const int_t num_elements = mesh->num_elem_in_block(block_type_map_it->first);
           if(num_elements==0) continue;
-          float * values = new float[num_elements];
+          snapshot.values.push_back(std::vector<float>(num_elements,0.0));
+          std::vector<float> & values = snapshot.values.back();
           DICe::mesh::element_set::const_iterator elem_it = mesh->get_element_set()->begin();
           DICe::mesh::element_set::const_iterator elem_end = mesh->get_element_set()->end();
           for(;elem_it!=elem_end;++elem_it)
@@ -1103,51 +1145,218 @@ exodus_output_dump(Teuchos::RCP<Mesh> mesh,
             if(elem_it->get()->block_id()!=block_type_map_it->first)continue; // filter out the elements not from this block
             values[elem_it->get()->index_in_block()] = field.local_value(elem_it->get()->local_id()*num_comps+comp);  // this may not work since the elements are in a set rather than a vector, may have to re-order them
           }
-          const int_t var_index = get_var_index(mesh, DICe::tostring(field_it->first.get_name()), components[comp], field_it->first.get_rank());
-          error_int = ex_put_elem_var(mesh->get_output_exoid(), time_step_num, var_index, block_type_map_it->first, mesh->num_elem_in_block(block_type_map_it->first),values);
-          TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"Failure ex_put_elem_var(): " + DICe::tostring(field_it->first.get_name()));
-          delete [] values;
+          snapshot.is_elem_var.push_back(true);
+          snapshot.var_index.push_back(var_index);
+          snapshot.block_id.push_back(block_type_map_it->first);
         }
       }
     }
     else if(field_it->first.get_rank()==field_enums::NODE_RANK)
     {
       Teuchos::RCP<MultiField > field = mesh->get_overlap_field(field_it->first);
-      float * values = new float[mesh->num_nodes()];
-      std::string components[3];
-      components[0] = (field_it->first.get_field_type()==field_enums::VECTOR_FIELD_TYPE) ? "X" : "";
-      components[1] = "Y";
-      components[2] = "Z";
       for (int_t comp = 0; comp < num_comps; ++comp)
       {
+        snapshot.values.push_back(std::vector<float>(mesh->num_nodes(),0.0));
+        std::vector<float> & values = snapshot.values.back();
         DICe::mesh::node_set::const_iterator node_it = mesh->get_node_set()->begin();
         DICe::mesh::node_set::const_iterator node_end = mesh->get_node_set()->end();
         for(;node_it!=node_end;++node_it)
         {
           values[node_it->second->overlap_local_id()] = field->local_value(node_it->second->overlap_local_id()*num_comps+comp);
         }
-        const int_t var_index = get_var_index(mesh, DICe::tostring(field_it->first.get_name()), components[comp], field_it->first.get_rank());
-        error_int = ex_put_nodal_var(mesh->get_output_exoid(), time_step_num, var_index,mesh->num_nodes(), values);
+        snapshot.is_elem_var.push_back(false);
+        snapshot.var_index.push_back(get_var_index(mesh, DICe::tostring(field_it->first.get_name()), components[comp], field_it->first.get_rank()));
+        snapshot.block_id.push_back(0);
       }
-      delete [] values;
     }
-//    else
-//    {
-//      std::stringstream oss;
-//      oss << "exodus_output_dump(): unrecognized field rank or output functions have not been implemented for: " << tostring(field_it->first.get_rank()) << std::endl;
-//      TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,oss.str());
-//    }
   }
-  error_int = ex_update(mesh->get_output_exoid());
+}
+
+/// write a snapshot to an open exodus file (ex_update is left to the caller)
+void
+write_exodus_snapshot(const int output_exoid,
+  Exodus_Snapshot & snapshot){
+  int error_int = ex_put_time(output_exoid, snapshot.time_step_num, &snapshot.time_value);
+  TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"ex_put_time(): Failure " << error_int);
+  for(size_t i=0;i<snapshot.values.size();++i){
+    if(snapshot.values[i].empty()) continue;
+    if(snapshot.is_elem_var[i]){
+      error_int = ex_put_elem_var(output_exoid, snapshot.time_step_num, snapshot.var_index[i], snapshot.block_id[i],
+        snapshot.values[i].size(),&snapshot.values[i][0]);
+      TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"Failure ex_put_elem_var(): variable index " << snapshot.var_index[i]);
+    }
+    else{
+      error_int = ex_put_nodal_var(output_exoid, snapshot.time_step_num, snapshot.var_index[i],snapshot.values[i].size(),&snapshot.values[i][0]);
+    }
+  }
+}
+
+/// \brief Writes exodus snapshots on a dedicated I/O thread
+///
+/// The queue is bounded so that at most max_queued snapshots are held in memory, the caller blocks if
+/// the I/O thread falls behind. The I/O thread writes every snapshot waiting in the queue and then
+/// calls ex_update once for the whole batch, so each rank flushes its own file once per batch rather
+/// than once per frame. The writes are not aggregated across ranks: every rank still writes its own
+/// exodus file independently (gathering the snapshots onto writer ranks is not implemented). While the writer exists the I/O thread
+/// is the only one that uses the output exoid. Each batch is written while holding the exodus library
+/// mutex so the writers for different files (e.g. stereo runs) never call into exodus at the same time.
+/// The writer mutex is never held while waiting for the library mutex and vice versa.
+class Exodus_Output_Writer {
+public:
+  Exodus_Output_Writer(const int output_exoid,
+    const int_t max_queued):
+    output_exoid_(output_exoid),
+    max_queued_(std::max(max_queued,1)),
+    busy_(false),
+    shutdown_(false){
+    io_thread_ = std::thread(&Exodus_Output_Writer::io_loop,this);
+  }
+
+  ~Exodus_Output_Writer(){
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      shutdown_ = true;
+      cond_.notify_all();
+    }
+    io_thread_.join();
+  }
+
+  /// hand a snapshot to the I/O thread (blocks if the queue is full)
+  void enqueue(Exodus_Snapshot & snapshot){
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock,[this]{return (int_t)queue_.size()<max_queued_||!error_msg_.empty();});
+    check_error();
+    queue_.push_back(Exodus_Snapshot());
+    std::swap(queue_.back(),snapshot);
+    cond_.notify_all();
+  }
+
+  /// wait until every queued snapshot has been written
+  void flush(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock,[this]{return (queue_.empty()&&!busy_)||!error_msg_.empty();});
+    check_error();
+  }
+
+private:
+  /// throw on the calling thread if the I/O thread failed (mutex must be held)
+  void check_error(){
+    if(error_msg_.empty()) return;
+    const std::string msg = error_msg_;
+    error_msg_.clear();
+    TEUCHOS_TEST_FOR_EXCEPTION(true,std::logic_error,"Error, asynchronous exodus output failed: " << msg);
+  }
+
+  void io_loop(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::deque<Exodus_Snapshot> batch;
+    while(true){
+      cond_.wait(lock,[this]{return !queue_.empty()||shutdown_;});
+      if(queue_.empty()) break;
+      batch.swap(queue_);
+      busy_ = true;
+      // a slot in the queue is open again
+      cond_.notify_all();
+      lock.unlock();
+      std::string msg;
+      try{
+        std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
+        for(size_t i=0;i<batch.size();++i)
+          write_exodus_snapshot(output_exoid_,batch[i]);
+        const int error_int = ex_update(output_exoid_);
+        TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"ex_update(): Failure");
+      }
+      catch(std::exception & e){
+        msg = e.what();
+      }
+      DEBUG_MSG("Exodus_Output_Writer::io_loop(): wrote " << batch.size() << " time steps to exoid " << output_exoid_);
+      batch.clear();
+      lock.lock();
+      if(!msg.empty()) error_msg_ = msg;
+      busy_ = false;
+      cond_.notify_all();
+    }
+  }
+
+  /// exodus id of the output file
+  const int output_exoid_;
+  /// maximum number of snapshots waiting to be written
+  const int_t max_queued_;
+  /// snapshots waiting to be written
+  std::deque<Exodus_Snapshot> queue_;
+  /// true while the I/O thread is writing a batch
+  bool busy_;
+  /// true when the I/O thread should exit
+  bool shutdown_;
+  /// message from the last failure on the I/O thread
+  std::string error_msg_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::thread io_thread_;
+};
+
+/// asynchronous writers for the open exodus output files (only accessed from the main thread)
+std::map<int,Teuchos::RCP<Exodus_Output_Writer> > & exodus_output_writers(){
+  static std::map<int,Teuchos::RCP<Exodus_Output_Writer> > writers;
+  return writers;
+}
+
+} // end anonymous namespace
+
+DICE_LIB_DLL_EXPORT
+void
+exodus_output_dump(Teuchos::RCP<Mesh> mesh,
+  const int_t & time_step_num,
+  const float & time_value)
+{
+  DEBUG_MSG("exodus_output_dump(): time_step_num: " << time_step_num << " time: " << time_value);
+  // make sure any asynchronous steps are on disk first so the steps stay in order
+  flush_exodus_output(mesh);
+  Exodus_Snapshot snapshot;
+  take_exodus_snapshot(mesh,time_step_num,time_value,snapshot);
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
+  write_exodus_snapshot(mesh->get_output_exoid(),snapshot);
+  const int error_int = ex_update(mesh->get_output_exoid());
   TEUCHOS_TEST_FOR_EXCEPTION(error_int,std::logic_error,"ex_update(): Failure");
 }
 
+DICE_LIB_DLL_EXPORT
+void
+exodus_output_dump_async(Teuchos::RCP<Mesh> mesh,
+  const int_t & time_step_num,
+  const float & time_value,
+  const int_t max_queued_steps)
+{
+  if(max_queued_steps<=0){
+    exodus_output_dump(mesh,time_step_num,time_value);
+    return;
+  }
+  DEBUG_MSG("exodus_output_dump_async(): time_step_num: " << time_step_num << " time: " << time_value);
+  Exodus_Snapshot snapshot;
+  take_exodus_snapshot(mesh,time_step_num,time_value,snapshot);
+  const int output_exoid = mesh->get_output_exoid();
+  std::map<int,Teuchos::RCP<Exodus_Output_Writer> > & writers = exodus_output_writers();
+  if(writers.find(output_exoid)==writers.end())
+    writers[output_exoid] = Teuchos::rcp(new Exodus_Output_Writer(output_exoid,max_queued_steps));
+  writers.find(output_exoid)->second->enqueue(snapshot);
+}
+
+DICE_LIB_DLL_EXPORT
+void
+flush_exodus_output(Teuchos::RCP<Mesh> mesh){
+  std::map<int,Teuchos::RCP<Exodus_Output_Writer> > & writers = exodus_output_writers();
+  std::map<int,Teuchos::RCP<Exodus_Output_Writer> >::iterator it = writers.find(mesh->get_output_exoid());
+  if(it==writers.end()) return;
+  it->second->flush();
+}
+
 DICE_LIB_DLL_EXPORT
 void
 exodus_face_edge_output_dump(Teuchos::RCP<Mesh> mesh,
   const int_t & time_step_num,
   const float & time_value)
 {
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   const int_t spa_dim = mesh->spatial_dimension();
   int error_int = 0;
   error_int = ex_put_time(mesh->get_face_edge_output_exoid(), time_step_num, &time_value);
@@ -1240,12 +1449,22 @@ get_var_index(Teuchos::RCP<Mesh> mesh,
 DICE_LIB_DLL_EXPORT
 void
 close_exodus_output(Teuchos::RCP<Mesh> mesh){
+  std::map<int,Teuchos::RCP<Exodus_Output_Writer> > & writers = exodus_output_writers();
+  std::map<int,Teuchos::RCP<Exodus_Output_Writer> >::iterator it = writers.find(mesh->get_output_exoid());
+  if(it!=writers.end()){
+    // write the remaining steps and stop the I/O thread before the file is closed
+    Teuchos::RCP<Exodus_Output_Writer> writer = it->second;
+    writers.erase(it);
+    writer->flush();
+  }
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   ex_close(mesh->get_output_exoid());
 }
 
 DICE_LIB_DLL_EXPORT
 void
 close_face_edge_exodus_output(Teuchos::RCP<Mesh> mesh){
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   ex_close(mesh->get_face_edge_output_exoid());
 }
 
@@ -1253,6 +1472,7 @@ DICE_LIB_DLL_EXPORT
 void
 create_face_edge_output_variable_names(Teuchos::RCP<Mesh> mesh)
 {
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   int error_int;
   const int_t spatial_dimension = mesh->spatial_dimension();
   const int output_exoid = mesh->get_face_edge_output_exoid();
@@ -1297,6 +1517,7 @@ void
 create_face_edge_output_exodus_file(Teuchos::RCP<Mesh> mesh,
   const std::string & output_folder)
 {
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
 
   std::stringstream out_file;
   out_file << output_folder << mesh->get_face_edge_output_filename();
@@ -1429,6 +1650,7 @@ DICE_LIB_DLL_EXPORT
 void
 create_exodus_output_variable_names(Teuchos::RCP<Mesh> mesh)
 {
+  std::lock_guard<std::recursive_mutex> exodus_lock(exodus_library_mutex());
   int error_int;
   const int_t spatial_dimension = mesh->spatial_dimension();
   const int output_exoid = mesh->get_output_exoid();
@@ -170,6 +170,31 @@ void exodus_output_dump(Teuchos::RCP<Mesh> mesh,
   const int_t & time_step_num,
   const float & time_value);
 
+/// Stage a time step for the exodus file and return without waiting for the write
+///
+/// The field values are copied into a snapshot and written by a dedicated I/O thread.
+/// At most max_queued_steps snapshots are held in memory (the call blocks when the queue is full).
+/// The steps are on disk after flush_exodus_output() or close_exodus_output() returns.
+/// The steps waiting in the queue are written as a batch with one ex_update() per batch. In parallel each
+/// rank writes its own file on its own I/O thread, the output is not aggregated across ranks.
+/// All the exodus calls made by the functions in this file (including the ones on the I/O threads)
+/// are serialized by a process-wide mutex. Calls into the netcdf library made elsewhere (e.g. reading
+/// netcdf images) are not covered by it, so the steps should be written synchronously in that case.
+/// \param mesh The mesh to use for this function
+/// \param time_step_num The time step number NOTE: has to be 1 or greater or exodus will throw an error
+/// \param time_value The time for this step
+/// \param max_queued_steps Maximum number of steps waiting to be written (0 writes the step synchronously)
+DICE_LIB_DLL_EXPORT
+void exodus_output_dump_async(Teuchos::RCP<Mesh> mesh,
+  const int_t & time_step_num,
+  const float & time_value,
+  const int_t max_queued_steps=4);
+
+/// Wait until all the asynchronous time steps have been written to the exodus file
+/// \param mesh The mesh to use for this function
+DICE_LIB_DLL_EXPORT
+void flush_exodus_output(Teuchos::RCP<Mesh> mesh);
+
 /// Write a time step to the exodus file
 /// \param mesh The mesh to use for this function
 /// \param time_step_num The time step number NOTE: has to be 1 or greater or exodus will throw an error
@@ -179,7 +204,7 @@ void exodus_face_edge_output_dump(Teuchos::RCP<Mesh> mesh,
   const int_t & time_step_num,
   const float & time_value);
 
-/// Close the exodus file
+/// Close the exodus file (any asynchronous time steps are written first)
 /// \param mesh The mesh to use for this function
 DICE_LIB_DLL_EXPORT
 void close_exodus_output(Teuchos::RCP<Mesh> mesh);
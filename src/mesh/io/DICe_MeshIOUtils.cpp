@@ -42,6 +42,7 @@
 #include <DICe_MeshIO.h>
 #include <DICe_MeshIOUtils.h>
 #include <DICe_Parser.h>
+#include <DICe_BinaryOutput.h>
 #include <DICe_PointCloud.h>
 
 #include <Teuchos_RCP.hpp>
@@ -56,24 +57,36 @@
 namespace DICe {
 namespace mesh {
 
+namespace {
+/// gather the initial coordinates of the local nodes of a mesh
+void
+mesh_node_coordinates(Teuchos::RCP<DICe::mesh::Mesh> mesh,
+  std::vector<scalar_t> & coords_x,
+  std::vector<scalar_t> & coords_y){
+  const int_t spa_dim = mesh->spatial_dimension();
+  Teuchos::RCP<MultiField> coords = mesh->get_field(DICe::field_enums::INITIAL_COORDINATES_FS);
+  coords_x.resize(mesh->num_nodes());
+  coords_y.resize(mesh->num_nodes());
+  for(size_t i=0;i<mesh->num_nodes();++i){
+    coords_x[i] = coords->local_value(i*spa_dim+0);
+    coords_y[i] = coords->local_value(i*spa_dim+1);
+  }
+}
+} // end anonymous namespace
+
 Importer_Projector::Importer_Projector(const std::string & source_file_name,
   Teuchos::RCP<DICe::mesh::Mesh> target_mesh):
+  source_file_name_(source_file_name),
   projection_required_(true),
   num_neigh_(5){
 
-  const int_t spa_dim = target_mesh->spatial_dimension();
-  Teuchos::RCP<MultiField> coords = target_mesh->get_field(DICe::field_enums::INITIAL_COORDINATES_FS);
-  target_pts_x_.resize(target_mesh->num_nodes());
-  target_pts_y_.resize(target_mesh->num_nodes());
-  for(size_t i=0;i<target_mesh->num_nodes();++i){
-    target_pts_x_[i] = coords->local_value(i*spa_dim+0);
-    target_pts_y_[i] = coords->local_value(i*spa_dim+1);
-  }
+  mesh_node_coordinates(target_mesh,target_pts_x_,target_pts_y_);
   initialize_source_points(source_file_name);
 }
 
 Importer_Projector::Importer_Projector(const std::string & source_file_name,
   const std::string & target_file_name):
+  source_file_name_(source_file_name),
   projection_required_(true),
   num_neigh_(5){
 
@@ -98,6 +111,7 @@ Importer_Projector::initialize_source_points(const std::string & source_file_nam
   // DICe text output file
   const std::string text_ext(".txt");
   const std::string exo_ext(".e");
+  const std::string binary_ext(".dbin");
   // make sure its not a locations file as the input
   if(source_file_name.find(text_ext)!=std::string::npos){
     std::fstream dataFile(source_file_name.c_str(), std::ios_base::in);
@@ -106,7 +120,8 @@ Importer_Projector::initialize_source_points(const std::string & source_file_nam
     TEUCHOS_TEST_FOR_EXCEPTION(tokens.size()<4,std::runtime_error,"Error, invalid source file " << source_file_name << ". must have at least 4 cols, (x,y,u,v)");
     dataFile.close();
   }
-  if(source_file_name.find(text_ext)!=std::string::npos||source_file_name.find(exo_ext)!=std::string::npos){
+  if(source_file_name.find(text_ext)!=std::string::npos||source_file_name.find(exo_ext)!=std::string::npos
+      ||source_file_name.find(binary_ext)!=std::string::npos){
     read_coordinates(source_file_name,source_pts_x_,source_pts_y_);
   }
   // DICe exodus file
@@ -146,112 +161,40 @@ Importer_Projector::initialize_source_points(const std::string & source_file_nam
         Teuchos::rcp(new kd_tree_2d_t(2 /*dim*/, *point_cloud.get(), nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */) ) );
     kd_tree->buildIndex();
     DEBUG_MSG("Importer_Projector::Importer_Projector(): kd-tree completed");
-    std::vector<std::pair<size_t,scalar_t> > ret_matches;
     DEBUG_MSG("Importer_Projector::Importer_Projector(): executing neighbor search");
-    neighbors_.resize(target_pts_x_.size());
-    neighbor_dist_x_.resize(target_pts_x_.size());
-    neighbor_dist_y_.resize(target_pts_x_.size());
-    for(size_t i=0;i<target_pts_x_.size();++i){
-      neighbors_[i].resize(num_neigh_);
-      neighbor_dist_x_[i].resize(num_neigh_);
-      neighbor_dist_y_[i].resize(num_neigh_);
-    }
+    const int_t num_points = target_pts_x_.size();
+    neighbors_.assign(num_points*num_neigh_,0);
+    projection_weights_.assign(num_points*num_neigh_,0.0);
     std::vector<size_t> ret_index(num_neigh_);
     std::vector<scalar_t> out_dist_sqr(num_neigh_);
     std::vector<scalar_t> query_pt(2,0.0);
-    for(size_t i=0;i<target_pts_x_.size();++i){
-      query_pt[0] = target_pts_x_[i];
-      query_pt[1] = target_pts_y_[i];
-      kd_tree->knnSearch(&query_pt[0], num_neigh_, &ret_index[0], &out_dist_sqr[0]);
-      for(int_t neigh = 0;neigh<num_neigh_;++neigh){
-        neighbors_[i][neigh] = ret_index[neigh];
-        neighbor_dist_x_[i][neigh] = source_pts_x_[ret_index[neigh]] - target_pts_x_[i];
-        neighbor_dist_y_[i][neigh] = source_pts_y_[ret_index[neigh]] - target_pts_y_[i];
-      }
-    }
-    DEBUG_MSG("Importer_Projector::Importer_Projector(): projection neighborhood has been initialized");
-  }
-}
-
-void
-Importer_Projector::import_vector_field(const std::string & file_name,
-  const std::string & field_name,
-  std::vector<scalar_t> & field_x,
-  std::vector<scalar_t> & field_y,
-  const int_t step){
-
-  // read and project (if necessary) the requested field from the source file to the target points
-  field_x.clear();
-  field_y.clear();
-  if(!projection_required_){
-    // simple copy operation
-    read_vector_field(file_name,field_name,field_x,field_y,step);
 
-    // fields have to be of compatible sizes
-    TEUCHOS_TEST_FOR_EXCEPTION(field_x.size()!=target_pts_x_.size(),std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION(field_y.size()!=target_pts_y_.size(),std::runtime_error,"");
-    return;
-  }
-  else{
-    std::vector<scalar_t> source_field_x;
-    std::vector<scalar_t> source_field_y;
-    read_vector_field(file_name,field_name,source_field_x,source_field_y,step);
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)source_field_x.size()!=num_source_pts(),std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)source_field_y.size()!=num_source_pts(),std::runtime_error,"");
-    field_x.resize(num_target_pts());
-    field_y.resize(num_target_pts());
-
-    static int_t N = 3;
-    static std::vector<int> IPIV(N+1,0);
-    static int_t LWORK = N*N;
-    static int_t INFO = 0;
-    static std::vector<double> WORK(LWORK,0.0);
+    // the projected value at a target point is the constant term of a linear least squares fit to
+    // the neighbors' values, coeffs = (X^T*X)^-1*X^T*u, so the weight of each neighbor is the
+    // first row of (X^T*X)^-1*X^T which only depends on the point locations
+    const int_t N = 3;
+    std::vector<int> IPIV(N+1,0);
+    const int_t LWORK = N*N;
+    int INFO = 0;
+    std::vector<double> WORK(LWORK,0.0);
     Teuchos::LAPACK<int,double> lapack;
-
-    static Teuchos::ArrayRCP<double> u_x(num_neigh_,0.0);
-    static Teuchos::ArrayRCP<double> u_y(num_neigh_,0.0);
-    static Teuchos::ArrayRCP<double> X_t_u_x(N,0.0);
-    static Teuchos::ArrayRCP<double> X_t_u_y(N,0.0);
-    static Teuchos::ArrayRCP<double> coeffs_x(N,0.0);
-    static Teuchos::ArrayRCP<double> coeffs_y(N,0.0);
-    static Teuchos::SerialDenseMatrix<int_t,double> X_t(N,num_neigh_, true);
-    static Teuchos::SerialDenseMatrix<int_t,double> X_t_X(N,N,true);
-
-    const int_t num_points = target_pts_x_.size();
-    TEUCHOS_TEST_FOR_EXCEPTION(num_points<=0,std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)target_pts_y_.size()!=num_points,std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)neighbors_.size()!=num_points,std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)neighbor_dist_x_.size()!=num_points,std::runtime_error,"");
-    TEUCHOS_TEST_FOR_EXCEPTION((int_t)neighbor_dist_y_.size()!=num_points,std::runtime_error,"");
-
-    int_t neigh_id = 0;
+    Teuchos::SerialDenseMatrix<int_t,double> X_t(N,num_neigh_,true);
+    Teuchos::SerialDenseMatrix<int_t,double> X_t_X(N,N,true);
     for(int_t pt=0;pt<num_points;++pt){
-      // clear storage
-      for(int_t i=0;i<N;++i){
-        X_t_u_x[i] = 0.0;
-        X_t_u_y[i] = 0.0;
-        coeffs_x[i] = 0.0;
-        coeffs_y[i] = 0.0;
-        for(int_t j=0;j<N;++j)
-          X_t_X(i,j) = 0.0;
-        for(int_t j=0;j<num_neigh_;++j)
-          X_t(i,j) = 0.0;
-      }
-      // gather the displacements of the neighbors
-      for(int_t j=0;j<num_neigh_;++j){
-        neigh_id = neighbors_[pt][j];
-        u_x[j] = source_field_x[neigh_id];
-        u_y[j] = source_field_y[neigh_id];
-      }
+      query_pt[0] = target_pts_x_[pt];
+      query_pt[1] = target_pts_y_[pt];
+      kd_tree->knnSearch(&query_pt[0], num_neigh_, &ret_index[0], &out_dist_sqr[0]);
       // set up the X^T matrix
       for(int_t j=0;j<num_neigh_;++j){
+        neighbors_[pt*num_neigh_+j] = ret_index[j];
         X_t(0,j) = 1.0;
-        X_t(1,j) = neighbor_dist_x_[pt][j];
-        X_t(2,j) = neighbor_dist_y_[pt][j];
+        X_t(1,j) = source_pts_x_[ret_index[j]] - target_pts_x_[pt];
+        X_t(2,j) = source_pts_y_[ret_index[j]] - target_pts_y_[pt];
       }
       // set up X^T*X
       for(int_t k=0;k<N;++k){
         for(int_t m=0;m<N;++m){
+          X_t_X(k,m) = 0.0;
           for(int_t j=0;j<num_neigh_;++j){
             X_t_X(k,m) += X_t(k,j)*X_t(m,j);
           }
@@ -274,24 +217,67 @@ Importer_Projector::import_vector_field(const std::string & file_name,
         DEBUG_MSG( e.what() << '\n');
         TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"");
       }
-      // compute X^T*u
-      for(int_t i=0;i<N;++i){
-        for(int_t j=0;j<num_neigh_;++j){
-          X_t_u_x[i] += X_t(i,j)*u_x[j];
-          X_t_u_y[i] += X_t(i,j)*u_y[j];
-        }
-      }
-      // compute the coeffs
-      for(int_t i=0;i<N;++i){
-        for(int_t j=0;j<N;++j){
-          coeffs_x[i] += X_t_X(i,j)*X_t_u_x[j];
-          coeffs_y[i] += X_t_X(i,j)*X_t_u_y[j];
-        }
+      // weights are the first row of (X^T*X)^-1*X^T
+      for(int_t j=0;j<num_neigh_;++j){
+        double weight = 0.0;
+        for(int_t i=0;i<N;++i)
+          weight += X_t_X(0,i)*X_t(i,j);
+        projection_weights_[pt*num_neigh_+j] = weight;
       }
-      // update the field values
-      field_x[pt] = coeffs_x[0];
-      field_y[pt] = coeffs_y[0];
-    }// end point loop
+    }
+    DEBUG_MSG("Importer_Projector::Importer_Projector(): projection weights have been initialized");
+  }
+}
+
+void
+Importer_Projector::project_field(const std::vector<scalar_t> & source_field,
+  std::vector<scalar_t> & target_field){
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)source_field.size()!=num_source_pts(),std::runtime_error,
+    "Error, the field has " << source_field.size() << " values, but there are " << num_source_pts() << " source points");
+  if(!projection_required_){
+    target_field = source_field;
+    return;
+  }
+  const int_t num_points = num_target_pts();
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)neighbors_.size()!=num_points*num_neigh_,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)projection_weights_.size()!=num_points*num_neigh_,std::runtime_error,"");
+  target_field.resize(num_points);
+#pragma omp parallel for schedule(static)
+  for(int_t pt=0;pt<num_points;++pt){
+    double value = 0.0;
+    for(int_t j=pt*num_neigh_;j<(pt+1)*num_neigh_;++j)
+      value += projection_weights_[j]*source_field[neighbors_[j]];
+    target_field[pt] = value;
+  }
+}
+
+void
+Importer_Projector::import_vector_field(const std::string & file_name,
+  const std::string & field_name,
+  std::vector<scalar_t> & field_x,
+  std::vector<scalar_t> & field_y,
+  const int_t step){
+
+  // read and project (if necessary) the requested field from the source file to the target points
+  field_x.clear();
+  field_y.clear();
+  if(!projection_required_){
+    // simple copy operation
+    read_vector_field(file_name,field_name,field_x,field_y,step);
+
+    // fields have to be of compatible sizes
+    TEUCHOS_TEST_FOR_EXCEPTION(field_x.size()!=target_pts_x_.size(),std::runtime_error,"");
+    TEUCHOS_TEST_FOR_EXCEPTION(field_y.size()!=target_pts_y_.size(),std::runtime_error,"");
+    return;
+  }
+  else{
+    std::vector<scalar_t> source_field_x;
+    std::vector<scalar_t> source_field_y;
+    read_vector_field(file_name,field_name,source_field_x,source_field_y,step);
+    TEUCHOS_TEST_FOR_EXCEPTION((int_t)source_field_x.size()!=num_source_pts(),std::runtime_error,"");
+    TEUCHOS_TEST_FOR_EXCEPTION((int_t)source_field_y.size()!=num_source_pts(),std::runtime_error,"");
+    project_field(source_field_x,field_x);
+    project_field(source_field_y,field_y);
   } // end projection required
 }
 
@@ -314,14 +300,15 @@ Importer_Projector::read_vector_field(const std::string & file_name,
   // determine the file type
   const std::string text_ext(".txt");
   const std::string exo_ext(".e");
+  const std::string binary_ext(".dbin");
 
   // text file, could be a set of points or DICe output file
   if(file_name.find(text_ext)!=std::string::npos){
     TEUCHOS_TEST_FOR_EXCEPTION(step!=0,std::runtime_error,"Error, cannot specify step!=0 for text input");
-    // read the first line of the file
-    std::fstream dataFile(file_name.c_str(), std::ios_base::in);
-    TEUCHOS_TEST_FOR_EXCEPTION(!dataFile.good(),std::runtime_error,"Error reading file " << file_name);
-    std::vector<std::string> tokens = tokenize_line(dataFile," \r\n,");
+    // read the whole file, the first line has the field names
+    Delimited_Text_Reader reader(file_name," \t\r\n,");
+    TEUCHOS_TEST_FOR_EXCEPTION(reader.num_lines()==0,std::runtime_error,"Error reading file " << file_name);
+    std::vector<std::string> tokens = reader.tokens(0);
     // DICe text output file
     DEBUG_MSG("Importer_Projector::read_vector_field(): reading vector field from DICe text results file: " << file_name);
     int_t x_var_index = -1;
@@ -340,18 +327,26 @@ Importer_Projector::read_vector_field(const std::string & file_name,
     DEBUG_MSG("Importer_Projector::read_vector_field(): using column: " << y_var_index << " as field " << field_name_y);
     TEUCHOS_TEST_FOR_EXCEPTION(x_var_index < 0,std::runtime_error,"Error could not find " << field_name_x);
     TEUCHOS_TEST_FOR_EXCEPTION(y_var_index < 0,std::runtime_error,"Error could not find " << field_name_y);
-    while (!dataFile.eof())
-    {
-      std::vector<std::string> tokens = tokenize_line(dataFile," \r\n,");
-      if(tokens.size()==0)continue;
-      TEUCHOS_TEST_FOR_EXCEPTION((int_t)tokens.size()!=num_values_per_line,std::runtime_error,"Invalid line in file (inconsistent number of values per line)");
-      for(int_t i=0;i<num_values_per_line;++i){
-        TEUCHOS_TEST_FOR_EXCEPTION(!is_number(tokens[i]),std::runtime_error,"Invalid (non-numeric) line entry in file");
-      }
-      field_x.push_back(strtod(tokens[x_var_index].c_str(),NULL));
-      field_y.push_back(strtod(tokens[y_var_index].c_str(),NULL));
-    } // end file read
-    dataFile.close();
+    std::vector<int_t> columns(2);
+    columns[0] = x_var_index;
+    columns[1] = y_var_index;
+    std::vector<std::vector<scalar_t> > values;
+    reader.read_columns(1,columns,values,num_values_per_line);
+    field_x.swap(values[0]);
+    field_y.swap(values[1]);
+  }
+  // DICe binary output file
+  else if(file_name.find(binary_ext)!=std::string::npos){
+    DEBUG_MSG("Importer_Projector::read_vector_field(): reading vector field from DICe binary results file: " << file_name);
+    Binary_Output_Reader reader(file_name);
+    TEUCHOS_TEST_FOR_EXCEPTION(reader.info().proc_size>1,std::runtime_error,
+      "Error, binary results files from a parallel run cannot be imported (each file only has the subsets of one processor)");
+    const int_t x_var_index = reader.field_index(field_name_x);
+    const int_t y_var_index = reader.field_index(field_name_y);
+    TEUCHOS_TEST_FOR_EXCEPTION(x_var_index < 0,std::runtime_error,"Error could not find " << field_name_x);
+    TEUCHOS_TEST_FOR_EXCEPTION(y_var_index < 0,std::runtime_error,"Error could not find " << field_name_y);
+    reader.read_field(step,x_var_index,field_x);
+    reader.read_field(step,y_var_index,field_y);
   }
     // exodus file
   else if(file_name.find(exo_ext)){
@@ -364,6 +359,23 @@ Importer_Projector::read_vector_field(const std::string & file_name,
   }
 }
 
+bool
+Importer_Projector::matches(const std::string & source_file_name,
+  const std::vector<scalar_t> & target_pts_x,
+  const std::vector<scalar_t> & target_pts_y)const{
+  return source_file_name==source_file_name_&&target_pts_x==target_pts_x_&&target_pts_y==target_pts_y_;
+}
+
+bool
+Importer_Projector::matches(const std::string & source_file_name,
+  Teuchos::RCP<DICe::mesh::Mesh> target_mesh)const{
+  if(source_file_name!=source_file_name_||target_mesh->num_nodes()!=target_pts_x_.size()) return false;
+  std::vector<scalar_t> coords_x;
+  std::vector<scalar_t> coords_y;
+  mesh_node_coordinates(target_mesh,coords_x,coords_y);
+  return matches(source_file_name,coords_x,coords_y);
+}
+
 bool
 Importer_Projector::is_valid_vector_source_field(const std::string & file_name,
   const std::string & field_name){
@@ -377,6 +389,7 @@ Importer_Projector::is_valid_vector_source_field(const std::string & file_name,
   // determine the file type
   const std::string text_ext(".txt");
   const std::string exo_ext(".e");
+  const std::string binary_ext(".dbin");
 
   // text file, could be a set of points or DICe output file
   if(file_name.find(text_ext)!=std::string::npos){
@@ -393,6 +406,11 @@ Importer_Projector::is_valid_vector_source_field(const std::string & file_name,
     }
     dataFile.close();
   }
+  // DICe binary output file
+  else if(file_name.find(binary_ext)!=std::string::npos){
+    Binary_Output_Reader reader(file_name);
+    return reader.field_index(field_name_x)>=0||reader.field_index(field_name_y)>=0;
+  }
   // exodus file
   else if(file_name.find(exo_ext)){
     std::vector<std::string> field_names = DICe::mesh::read_exodus_field_names(file_name);
@@ -420,30 +438,24 @@ Importer_Projector::read_coordinates(const std::string & file_name,
   const std::string text_ext(".txt");
   const std::string csv_ext(".csv");
   const std::string exo_ext(".e");
+  const std::string binary_ext(".dbin");
 
   // text file, could be a set of points or DICe output file
   if(file_name.find(text_ext)!=std::string::npos||file_name.find(csv_ext)!=std::string::npos){
-    // read the first line of the file
-    std::fstream dataFile(file_name.c_str(), std::ios_base::in);
-    TEUCHOS_TEST_FOR_EXCEPTION(!dataFile.good(),std::runtime_error,"Error reading file " << file_name);
-    std::vector<std::string> tokens = tokenize_line(dataFile," \r\n,");
+    // read the whole file
+    Delimited_Text_Reader reader(file_name," \t\r\n,");
+    TEUCHOS_TEST_FOR_EXCEPTION(reader.num_lines()==0,std::runtime_error,"Error reading file " << file_name);
 
     // locations file
-    if(file_name.find(csv_ext)!=std::string::npos||tokens.size()==2){
+    if(file_name.find(csv_ext)!=std::string::npos||reader.num_values(0)==2){
       DEBUG_MSG("Importer_Projector::read_coordinates(): reading points from file: " << file_name);
-      // go back to the beginning of the file
-      dataFile.clear();
-      dataFile.seekg(0, std::ios::beg);
-      // read each line of the file
-      while (!dataFile.eof())
-      {
-        std::vector<std::string> tokens = tokenize_line(dataFile," \r\n,");
-        if(tokens.size()==0)continue;
-        TEUCHOS_TEST_FOR_EXCEPTION(tokens.size()!=2,std::runtime_error,"Invalid line in file (should be two values per line)");
-        TEUCHOS_TEST_FOR_EXCEPTION(!is_number(tokens[0])||!is_number(tokens[1]),std::runtime_error,"Invalid line in file (non-numeric entry)");
-        coords_x.push_back(strtod(tokens[0].c_str(),NULL));
-        coords_y.push_back(strtod(tokens[1].c_str(),NULL));
-      } // end file read
+      std::vector<int_t> columns(2);
+      columns[0] = 0;
+      columns[1] = 1;
+      std::vector<std::vector<scalar_t> > values;
+      reader.read_columns(0,columns,values,2);
+      coords_x.swap(values[0]);
+      coords_y.swap(values[1]);
       DEBUG_MSG("Importer_Projector::read_coordinates(): number of points: " << coords_x.size());
     }
 
@@ -452,7 +464,11 @@ Importer_Projector::read_coordinates(const std::string & file_name,
       DEBUG_MSG("Importer_Projector::read_coordinates(): reading points from DICe text results file: " << file_name);
       read_vector_field(file_name,"COORDINATE",coords_x,coords_y);
     }
-    dataFile.close();
+  }
+  // DICe binary output file
+  else if(file_name.find(binary_ext)!=std::string::npos){
+    DEBUG_MSG("Importer_Projector::read_coordinates(): reading points from DICe binary results file: " << file_name);
+    read_vector_field(file_name,"COORDINATE",coords_x,coords_y);
   }
     // exodus file
   else if(file_name.find(exo_ext)){
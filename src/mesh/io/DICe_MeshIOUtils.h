@@ -60,7 +60,7 @@ Importer_Projector
 public:
   /// constructor
   /// \param source_file_name same format as the target file, but this is where the data will come from
-  /// \param target_file_name either an exodus file, a DICe text output file, or a txt file with two columns of data
+  /// \param target_file_name either an exodus file, a DICe text or binary (.dbin) output file, or a txt file with two columns of data
   /// the target locations at which the data will be projected to are read from this file.
   /// Once the points are read in, they are fixed for the life of the Importer_Projector
   /// TODO write a update_points() method for this class to relax this constraint
@@ -88,7 +88,7 @@ public:
   /// \param field_name the field to gather
   /// \param field_x [out] vector returned with field values x
   /// \param field_y [out] vector returned with field values y
-  /// \param step time step requested (must be zero for text input)
+  /// \param step time step requested (frame index for DICe binary results, must be zero for text input)
   void read_vector_field(const std::string & file_name,
     const std::string & field_name,
     std::vector<scalar_t> & field_x,
@@ -103,6 +103,13 @@ public:
     std::vector<scalar_t> & coords_x,
     std::vector<scalar_t> & coords_y);
 
+  /// project a field that is already in memory from the source points to the target points
+  /// using the cached projection weights (a copy if no projection is required)
+  /// \param source_field the field values at the source points
+  /// \param target_field [out] the field values at the target points
+  void project_field(const std::vector<scalar_t> & source_field,
+    std::vector<scalar_t> & target_field);
+
   /// import and project (if necessary) a vector field from the source
   /// file
   /// \param file_name the name of the file to import from (must have same number of points as source file)
@@ -125,6 +132,21 @@ public:
     return & target_pts_y_;
   }
 
+  /// returns true if this importer reads from the given source file and projects to the given target points,
+  /// so that a cached importer can be reused
+  /// \param source_file_name the name of the source file
+  /// \param target_pts_x the target locations in x
+  /// \param target_pts_y the target locations in y
+  bool matches(const std::string & source_file_name,
+    const std::vector<scalar_t> & target_pts_x,
+    const std::vector<scalar_t> & target_pts_y)const;
+
+  /// returns true if this importer reads from the given source file and projects to the nodes of the given mesh
+  /// \param source_file_name the name of the source file
+  /// \param target_mesh the mesh with the target locations
+  bool matches(const std::string & source_file_name,
+    Teuchos::RCP<DICe::mesh::Mesh> target_mesh)const;
+
   /// returns true if the field is a valid source field
   /// \param file_name the name of the file to check
   /// \param field_name the name of the requested field
@@ -141,6 +163,8 @@ private:
   /// \param source_file_name the string name of the file to use for source locations
   void initialize_source_points(const std::string & source_file_name);
 
+  /// name of the file the source locations were read from
+  std::string source_file_name_;
   /// locations to import the data from
   std::vector<scalar_t> source_pts_x_;
   /// locations to import the data from
@@ -151,12 +175,12 @@ private:
   std::vector<scalar_t> target_pts_y_;
   /// determines if the target and source points are colinear or not, true if not colinear
   bool projection_required_;
-  /// holds the neighbor ids in the source set for each target point
-  std::vector<std::vector<int_t> > neighbors_;
-  /// holds the neighbor x dist of the source neighbor for each target point
-  std::vector<std::vector<scalar_t> > neighbor_dist_x_;
-  /// holds the neighbor y dist of the source neighbor for each target point
-  std::vector<std::vector<scalar_t> > neighbor_dist_y_;
+  /// sparse interpolation matrix from the source to the target points, each target point has num_neigh_
+  /// entries (row i is stored in [i*num_neigh_,(i+1)*num_neigh_)), these are the source neighbor ids
+  std::vector<int_t> neighbors_;
+  /// projection weight of each neighbor, the moving least squares fit is computed once in the constructor
+  /// so projecting a field is a sparse matrix vector product
+  std::vector<scalar_t> projection_weights_;
   /// number of neighbors to use
   int_t num_neigh_;
 
@@ -45,98 +45,138 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/opencv.hpp>
 
+#include <algorithm>
 #include <cstdio>
 
 namespace DICe {
 
 DICE_LIB_DLL_EXPORT
-void match_features(Teuchos::RCP<Image> left_image,
-  Teuchos::RCP<Image> right_image,
+void detect_features(Teuchos::RCP<Image> image,
+  Image_Features & features,
+  const float & feature_tol,
+  const Extents & roi){
+  features.clear();
+  const int_t w = image->width();
+  const int_t h = image->height();
+  // clip the region of interest to the image (roi is in global coordinates)
+  int_t x_begin = 0;
+  int_t y_begin = 0;
+  int_t x_end = w;
+  int_t y_end = h;
+  if(roi.width_>0&&roi.height_>0){
+    x_begin = std::max(roi.origin_x_ - image->offset_x(),0);
+    y_begin = std::max(roi.origin_y_ - image->offset_y(),0);
+    x_end = std::min(roi.origin_x_ + roi.width_ - image->offset_x(),w);
+    y_end = std::min(roi.origin_y_ + roi.height_ - image->offset_y(),h);
+  }
+  features.offset_x_ = image->offset_x() + x_begin;
+  features.offset_y_ = image->offset_y() + y_begin;
+  features.feature_tol_ = feature_tol;
+  if(x_end<=x_begin||y_end<=y_begin){
+    DEBUG_MSG("detect_features(): region of interest does not overlap the image, no features detected");
+    return;
+  }
+  DEBUG_MSG("detect_features(): detecting features in region x " << features.offset_x_ << " to " << x_end + image->offset_x() <<
+    " y " << features.offset_y_ << " to " << y_end + image->offset_y());
+  std::vector<unsigned char> array(w*h);
+  opencv_8UC1(image,&array[0]);
+  cv::Mat img = cv::Mat(h,w,CV_8U,&array[0]);
+  // a view of the region, detecting on the view rather than using a mask avoids building the scale space for the whole image
+  cv::Mat region = img(cv::Rect(x_begin,y_begin,x_end-x_begin,y_end-y_begin));
+  cv::Ptr<cv::AKAZE> akaze = cv::AKAZE::create(cv::AKAZE::DESCRIPTOR_MLDB,0,3,feature_tol,4,4,cv::KAZE::DIFF_PM_G2);
+  akaze->detectAndCompute(region, cv::noArray(), features.keypoints_, features.descriptors_);
+  DEBUG_MSG("detect_features(): number of features detected: " << features.keypoints_.size());
+}
+
+DICE_LIB_DLL_EXPORT
+void match_features(const Image_Features & left_features,
+  const Image_Features & right_features,
   std::vector<scalar_t> & left_x,
   std::vector<scalar_t> & left_y,
   std::vector<scalar_t> & right_x,
   std::vector<scalar_t> & right_y,
-  const float & feature_tol,
-  const std::string & result_image_name){
+  const int_t approximate_threshold){
 
   left_x.clear();
   left_y.clear();
   right_x.clear();
   right_y.clear();
-
-  DEBUG_MSG("match_features(): initializing OpenCV Mats");
-  unsigned char * left_array = new unsigned char[left_image->width()*left_image->height()];
-  unsigned char * right_array = new unsigned char[right_image->width()*right_image->height()];
-  opencv_8UC1(left_image,left_array);
-  opencv_8UC1(right_image,right_array);
-  cv::Mat img1 =   cv::Mat(left_image->height(),left_image->width(),CV_8U,left_array);
-  cv::Mat img2 =   cv::Mat(right_image->height(),right_image->width(),CV_8U,right_array);
-  const float nn_match_ratio = 0.6f;   // Nearest neighbor matching ratio
-  DEBUG_MSG("match_features(): detect and compute features");
-
-  std::vector<cv::KeyPoint> kpts1, kpts2;
-  cv::Mat desc1, desc2;
-  cv::Ptr<cv::AKAZE> akaze = cv::AKAZE::create(cv::AKAZE::DESCRIPTOR_MLDB,0,3,feature_tol,4,4,cv::KAZE::DIFF_PM_G2);
-  akaze->detectAndCompute(img1, cv::noArray(), kpts1, desc1);
-  akaze->detectAndCompute(img2, cv::noArray(), kpts2, desc2);
+  if(left_features.empty()||right_features.empty()){
+    DEBUG_MSG("***Warning: no features to match");
+    return;
+  }
 
   DEBUG_MSG("match_features(): matching features");
-
-  cv::BFMatcher matcher(cv::NORM_HAMMING);
+  const float nn_match_ratio = 0.6f;   // Nearest neighbor matching ratio
   std::vector< std::vector<cv::DMatch> > nn_matches;
-  matcher.knnMatch(desc1, desc2, nn_matches, 2);
+  if(approximate_threshold>=0&&left_features.descriptors_.rows>approximate_threshold&&right_features.descriptors_.rows>approximate_threshold){
+    DEBUG_MSG("match_features(): using approximate (LSH) matching");
+    cv::FlannBasedMatcher matcher(cv::makePtr<cv::flann::LshIndexParams>(12,20,2));
+    matcher.knnMatch(left_features.descriptors_, right_features.descriptors_, nn_matches, 2);
+  }else{
+    cv::BFMatcher matcher(cv::NORM_HAMMING);
+    matcher.knnMatch(left_features.descriptors_, right_features.descriptors_, nn_matches, 2);
+  }
 
   DEBUG_MSG("match_features(): removing outliers");
-
-  std::vector<cv::KeyPoint> matched1, matched2, inliers1, inliers2;
-  std::vector<cv::DMatch> good_matches;
   for(size_t i = 0; i < nn_matches.size(); i++) {
     if(nn_matches[i].size()<2)continue;
-    cv::DMatch first = nn_matches[i][0];
+    const cv::DMatch & first = nn_matches[i][0];
     float dist1 = nn_matches[i][0].distance;
     float dist2 = nn_matches[i][1].distance;
     if(dist1 < nn_match_ratio * dist2) {
-      matched1.push_back(kpts1[first.queryIdx]);
-      matched2.push_back(kpts2[first.trainIdx]);
+      left_x.push_back(left_features.keypoints_[first.queryIdx].pt.x + left_features.offset_x_);
+      left_y.push_back(left_features.keypoints_[first.queryIdx].pt.y + left_features.offset_y_);
+      right_x.push_back(right_features.keypoints_[first.trainIdx].pt.x + right_features.offset_x_);
+      right_y.push_back(right_features.keypoints_[first.trainIdx].pt.y + right_features.offset_y_);
     }
   }
-
-  for(unsigned i = 0; i < matched1.size(); i++) {
-    int new_i = static_cast<int>(inliers1.size());
-    inliers1.push_back(matched1[i]);
-    inliers2.push_back(matched2[i]);
-    good_matches.push_back(cv::DMatch(new_i, new_i, 0));
-  }
-  assert(inliers1.size()==inliers2.size());
-  DEBUG_MSG("match_features(): number of features matched: " << inliers1.size());
-  if(inliers1.size()==0)
+  DEBUG_MSG("match_features(): number of features matched: " << left_x.size());
+  if(left_x.size()==0)
     DEBUG_MSG("***Warning: no matching features matched");
-  left_x.resize(inliers1.size(),0.0);
-  left_y.resize(inliers1.size(),0.0);
-  right_x.resize(inliers1.size(),0.0);
-  right_y.resize(inliers1.size(),0.0);
-  const scalar_t lox = left_image->offset_x();
-  const scalar_t loy = left_image->offset_y();
-  const scalar_t rox = right_image->offset_x();
-  const scalar_t roy = right_image->offset_y();
-  for(unsigned i = 0; i < left_x.size(); i++) {
-    left_x[i] = inliers1[i].pt.x + lox;
-    left_y[i] = inliers1[i].pt.y + loy;
-    right_x[i] = inliers2[i].pt.x + rox;
-    right_y[i] = inliers2[i].pt.y + roy;
-  }
+}
+
+DICE_LIB_DLL_EXPORT
+void match_features(Teuchos::RCP<Image> left_image,
+  Teuchos::RCP<Image> right_image,
+  std::vector<scalar_t> & left_x,
+  std::vector<scalar_t> & left_y,
+  std::vector<scalar_t> & right_x,
+  std::vector<scalar_t> & right_y,
+  const float & feature_tol,
+  const std::string & result_image_name){
+
+  DEBUG_MSG("match_features(): detect and compute features");
+  Image_Features left_features;
+  Image_Features right_features;
+  detect_features(left_image,left_features,feature_tol);
+  detect_features(right_image,right_features,feature_tol);
+  match_features(left_features,right_features,left_x,left_y,right_x,right_y);
+
   // draw results image if requested
   if(result_image_name!=""){
+    std::vector<cv::KeyPoint> inliers1, inliers2;
+    std::vector<cv::DMatch> good_matches;
+    for(size_t i = 0; i < left_x.size(); i++) {
+      inliers1.push_back(cv::KeyPoint(left_x[i] - left_features.offset_x_,left_y[i] - left_features.offset_y_,1.0f));
+      inliers2.push_back(cv::KeyPoint(right_x[i] - right_features.offset_x_,right_y[i] - right_features.offset_y_,1.0f));
+      good_matches.push_back(cv::DMatch((int)i, (int)i, 0));
+    }
+    std::vector<unsigned char> left_array(left_image->width()*left_image->height());
+    std::vector<unsigned char> right_array(right_image->width()*right_image->height());
+    opencv_8UC1(left_image,&left_array[0]);
+    opencv_8UC1(right_image,&right_array[0]);
+    cv::Mat img1 = cv::Mat(left_image->height(),left_image->width(),CV_8U,&left_array[0]);
+    cv::Mat img2 = cv::Mat(right_image->height(),right_image->width(),CV_8U,&right_array[0]);
     cv::Mat res;
     cv::drawMatches(img1, inliers1, img2, inliers2, good_matches, res);
     cv::imwrite(result_image_name.c_str(), res);
   }
-
-  delete [] left_array;
 }
 
 void opencv_8UC1(Teuchos::RCP<Image> image, unsigned char * array){
-  Teuchos::ArrayRCP<intensity_t> intensities = image->intensities();
+  // read only, so a compactly stored image is not expanded
+  Teuchos::ArrayRCP<const intensity_t> intensities = image->intensity_values();
   // need to scale the vaues to 0-255
   const int_t w = image->width();
   const int_t h = image->height();
@@ -163,4 +203,27 @@ void opencv_8UC1(Teuchos::RCP<Image> image, unsigned char * array){
   }
 }
 
+cv::Mat opencv_32FC1(Teuchos::RCP<Image> image,
+  const int_t pyramid_level){
+  TEUCHOS_TEST_FOR_EXCEPTION(pyramid_level<0,std::runtime_error,"Error, invalid pyramid level");
+  // read only, so a compactly stored image is not expanded (the values can be a temporary copy,
+  // so the returned matrix always owns its data)
+  Teuchos::ArrayRCP<const intensity_t> intensities = image->intensity_values();
+  intensity_t * values = const_cast<intensity_t*>(intensities.getRawPtr());
+  cv::Mat img;
+#if DICE_USE_DOUBLE
+  cv::Mat(image->height(),image->width(),CV_64F,values).convertTo(img,CV_32F);
+#else
+  img = cv::Mat(image->height(),image->width(),CV_32F,values);
+  if(pyramid_level==0)
+    img = img.clone();
+#endif
+  for(int_t level=0;level<pyramid_level;++level){
+    cv::Mat coarse;
+    cv::pyrDown(img,coarse);
+    img = coarse;
+  }
+  return img;
+}
+
 }// End DICe Namespace
@@ -47,8 +47,77 @@
 
 #include <Teuchos_RCP.hpp>
 
+#include <opencv2/core.hpp>
+
+#include <vector>
+
 namespace DICe {
 
+/// \class DICe::Image_Features
+/// \brief Keypoints and descriptors detected in an image. These are stored
+/// so that the features of an image can be reused for several matches
+/// (for example the current frame's features become the previous frame's in the next step)
+struct DICE_LIB_DLL_EXPORT
+Image_Features {
+  /// constructor
+  Image_Features():
+    offset_x_(0),
+    offset_y_(0),
+    feature_tol_(-1.0f){};
+  /// returns true if no features have been detected
+  bool empty()const{
+    return keypoints_.empty();
+  }
+  /// clear the features
+  void clear(){
+    keypoints_.clear();
+    descriptors_.release();
+    offset_x_ = 0;
+    offset_y_ = 0;
+    feature_tol_ = -1.0f;
+  }
+  /// keypoint locations relative to the upper left corner of the detection region
+  std::vector<cv::KeyPoint> keypoints_;
+  /// descriptors (one row per keypoint)
+  cv::Mat descriptors_;
+  /// global x coordinate of the upper left corner of the detection region
+  int_t offset_x_;
+  /// global y coordinate of the upper left corner of the detection region
+  int_t offset_y_;
+  /// the AKAZE threshold that was used to detect the features
+  float feature_tol_;
+};
+
+/// Free function to detect AKAZE features in a DICe image
+/// \param image pointer to the image
+/// \param features [out] the detected keypoints and descriptors
+/// \param feature_tol tolerance to use for AKAZE features
+/// \param roi region (in global image coordinates) to restrict the detection to,
+/// the whole image is used if the width or height of the region is not positive
+DICE_LIB_DLL_EXPORT
+void detect_features(Teuchos::RCP<Image> image,
+  Image_Features & features,
+  const float & feature_tol=0.001f,
+  const Extents & roi=Extents(0,0,-1,-1));
+
+/// Free function to match two sets of previously detected features
+/// \param left_features features from the left image
+/// \param right_features features from the right image
+/// \param left_x [out] image x coordinates in the left image for features
+/// \param left_y [out] image y coordinate in the left image for features
+/// \param right_x [out] image x coordinates in the right image for features
+/// \param right_y [out] image y coordinate in the right image for features
+/// \param approximate_threshold if both sets have more features than this an approximate (LSH) nearest neighbor
+/// search is used instead of brute force matching, a negative value always uses brute force
+DICE_LIB_DLL_EXPORT
+void match_features(const Image_Features & left_features,
+  const Image_Features & right_features,
+  std::vector<scalar_t> & left_x,
+  std::vector<scalar_t> & left_y,
+  std::vector<scalar_t> & right_x,
+  std::vector<scalar_t> & right_y,
+  const int_t approximate_threshold=-1);
+
 /// Free function to match features from one DICe image to another
 /// \param left_image pointer to the left image
 /// \param right_image pointer to the right image
@@ -74,6 +143,14 @@ void match_features(Teuchos::RCP<Image> left_image,
 DICE_LIB_DLL_EXPORT
 void opencv_8UC1(Teuchos::RCP<Image> image, unsigned char * array);
 
+/// create an opencv 32FC1 Mat from the intensity values of a DICe Image
+/// the Mat owns its data (a compactly stored image is read without being expanded)
+/// \param image pointer to a DICe::Image
+/// \param pyramid_level number of times to downsample the image by a factor of two (0 is full resolution)
+DICE_LIB_DLL_EXPORT
+cv::Mat opencv_32FC1(Teuchos::RCP<Image> image,
+  const int_t pyramid_level=0);
+
 
 
 }// End DICe Namespace
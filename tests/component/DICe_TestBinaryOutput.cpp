@@ -0,0 +1,218 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_TestBinaryOutput.cpp
+    \brief Testing of the binary results writer and reader
+*/
+
+#include <DICe.h>
+#include <DICe_BinaryOutput.h>
+#include <DICe_Parser.h>
+
+#include <Teuchos_oblackholestream.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  Binary_Output_Info info;
+  info.field_names.push_back("COORDINATE_X");
+  info.field_names.push_back("DISPLACEMENT_X");
+  info.field_names.push_back("SIGMA");
+  const int_t num_rows = 7;
+  for(int_t i=0;i<num_rows;++i)
+    info.row_ids.push_back(3*i);
+  info.run_info = "*** binary output test\n";
+  info.prefix = "DICe_TestBinaryOutput";
+  info.frame_digits = 2;
+  const int_t num_fields = info.field_names.size();
+  const int_t num_frames = 29;
+
+  // the frames per block is not a divisor of the number of frames so the last block is partially full
+  for(int_t compress=0;compress<2;++compress){
+    *outStream << "writing the binary file, compression " << compress << std::endl;
+    std::vector<std::vector<scalar_t> > frames(num_frames,std::vector<scalar_t>(num_rows*num_fields,0.0));
+    {
+      Binary_Output_Writer writer("DICe_TestBinaryOutput.dbin",info,compress==1,4);
+      for(int_t frame=0;frame<num_frames;++frame){
+        for(int_t row=0;row<num_rows;++row){
+          frames[frame][row] = 10.0*row;
+          frames[frame][num_rows+row] = 0.25*frame + std::sin(0.1*row*frame);
+          frames[frame][2*num_rows+row] = row%3==0 ? -1.0 : 0.01*frame;
+        }
+        writer.write_frame(frame,frames[frame]);
+      }
+      writer.close();
+    }
+    *outStream << "reading the binary file" << std::endl;
+    Binary_Output_Reader reader("DICe_TestBinaryOutput.dbin");
+    if(reader.num_frames()!=num_frames){
+      *outStream << "Error, wrong number of frames " << reader.num_frames() << std::endl;
+      errorFlag++;
+      continue;
+    }
+    if(reader.info().field_names!=info.field_names||reader.info().row_ids!=info.row_ids||reader.info().run_info!=info.run_info){
+      *outStream << "Error, the header was not read back correctly" << std::endl;
+      errorFlag++;
+    }
+    // read in reverse order to exercise the block lookup
+    std::vector<scalar_t> values;
+    for(int_t frame=num_frames-1;frame>=0;--frame){
+      reader.read_frame(frame,values);
+      if(reader.frame_id(frame)!=frame||values!=frames[frame]){
+        *outStream << "Error, frame " << frame << " was not read back correctly" << std::endl;
+        errorFlag++;
+      }
+    }
+    // single fields
+    const int_t disp_field = reader.field_index("DISPLACEMENT_X");
+    if(disp_field!=1||reader.field_index("NOT_A_FIELD")!=-1){
+      *outStream << "Error, wrong field index " << disp_field << std::endl;
+      errorFlag++;
+    }
+    for(int_t frame=0;frame<num_frames;frame+=3){
+      reader.read_field(frame,disp_field,values);
+      if(values!=std::vector<scalar_t>(frames[frame].begin()+num_rows,frames[frame].begin()+2*num_rows)){
+        *outStream << "Error, field " << disp_field << " of frame " << frame << " was not read back correctly" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  *outStream << "converting the binary file to text" << std::endl;
+  convert_binary_output_to_text("DICe_TestBinaryOutput.dbin","");
+  std::ifstream text_file("DICe_TestBinaryOutput_05.txt");
+  if(!text_file.good()){
+    *outStream << "Error, the text file for frame 5 was not written" << std::endl;
+    errorFlag++;
+  }
+  else{
+    std::string line;
+    std::getline(text_file,line);
+    if(line!="*** binary output test"){
+      *outStream << "Error, wrong run information in text file: " << line << std::endl;
+      errorFlag++;
+    }
+    std::getline(text_file,line);
+    if(line!="SUBSET_ID COORDINATE_X DISPLACEMENT_X SIGMA"){
+      *outStream << "Error, wrong header in text file: " << line << std::endl;
+      errorFlag++;
+    }
+    std::getline(text_file,line);
+    if(line!="0 0.0000E+00 1.2500E+00 -1.0000E+00"){
+      *outStream << "Error, wrong first row in text file: " << line << std::endl;
+      errorFlag++;
+    }
+    text_file.close();
+
+    // the text file should read back (to the precision of the text format) with the delimited text reader
+    *outStream << "reading the text file with the delimited text reader" << std::endl;
+    Delimited_Text_Reader text_reader("DICe_TestBinaryOutput_05.txt");
+    if(text_reader.num_lines()!=num_rows+2||text_reader.num_values(1)!=num_fields+1||text_reader.tokens(1)[2]!="DISPLACEMENT_X"){
+      *outStream << "Error, wrong layout from the delimited text reader " << text_reader.num_lines() << " lines" << std::endl;
+      errorFlag++;
+    }
+    else{
+      std::vector<int_t> columns;
+      columns.push_back(0);
+      columns.push_back(2);
+      std::vector<std::vector<scalar_t> > text_values;
+      text_reader.read_columns(2,columns,text_values,num_fields+1);
+      for(int_t row=0;row<num_rows;++row){
+        const scalar_t expected = 0.25*5 + std::sin(0.1*row*5);
+        if(text_values[0][row]!=info.row_ids[row]||std::abs(text_values[1][row]-expected)>1.0E-4){
+          *outStream << "Error, wrong value in row " << row << " from the delimited text reader " << text_values[1][row] << " expected " << expected << std::endl;
+          errorFlag++;
+        }
+      }
+    }
+  }
+
+  // the number parser should agree with strtod
+  const char * numbers[] = {"0","-1.2500E+00","3.14159","+7.","-.5e-3","1.0E+25","123456789.123456789","2.2250738585072014e-308"};
+  for(int_t i=0;i<8;++i){
+    scalar_t value = 0.0;
+    const std::string number(numbers[i]);
+    if(!parse_number(number.c_str(),number.c_str()+number.size(),value)||value!=static_cast<scalar_t>(strtod(numbers[i],NULL))){
+      *outStream << "Error, wrong value parsed for " << number << ": " << value << std::endl;
+      errorFlag++;
+    }
+  }
+  const char * not_numbers[] = {"","-","1e","1.2.3","E5","COORDINATE_X"};
+  for(int_t i=0;i<6;++i){
+    scalar_t value = 0.0;
+    const std::string number(not_numbers[i]);
+    if(parse_number(number.c_str(),number.c_str()+number.size(),value)){
+      *outStream << "Error, " << number << " should not be parsed as a number" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
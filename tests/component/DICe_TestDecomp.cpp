@@ -50,6 +50,8 @@
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_XMLParameterListHelpers.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 using namespace DICe;
@@ -118,6 +120,111 @@ int main(int argc, char *argv[]) {
     *outStream << "Error, wrong number of global subsets" << std::endl;
   }
 
+  // test the spatial partitioning of a regular grid of points
+  *outStream << "testing the spatial partitioning" << std::endl;
+  const int_t grid_w = 60;
+  const int_t grid_h = 40;
+  Teuchos::ArrayRCP<scalar_t> grid_x(grid_w*grid_h,0.0);
+  Teuchos::ArrayRCP<scalar_t> grid_y(grid_w*grid_h,0.0);
+  for(int_t j=0;j<grid_h;++j){
+    for(int_t i=0;i<grid_w;++i){
+      grid_x[j*grid_w+i] = i*10.0;
+      grid_y[j*grid_w+i] = j*10.0;
+    }
+  }
+  const int_t part_counts[] = {2,3,4,7};
+  for(int_t method=0;method<2;++method){
+    for(int_t c=0;c<4;++c){
+      const int_t num_parts = part_counts[c];
+      std::vector<int_t> part_ids;
+      if(method==0)
+        partition_points_rcb(grid_x,grid_y,num_parts,part_ids);
+      else
+        partition_points_hilbert(grid_x,grid_y,num_parts,part_ids);
+      std::vector<int_t> part_sizes(num_parts,0);
+      std::vector<int_t> min_i(num_parts,grid_w), max_i(num_parts,-1), min_j(num_parts,grid_h), max_j(num_parts,-1);
+      for(int_t k=0;k<grid_w*grid_h;++k){
+        const int_t p = part_ids[k];
+        part_sizes[p]++;
+        min_i[p] = std::min(min_i[p],k%grid_w); max_i[p] = std::max(max_i[p],k%grid_w);
+        min_j[p] = std::min(min_j[p],k/grid_w); max_j[p] = std::max(max_j[p],k/grid_w);
+      }
+      for(int_t p=0;p<num_parts;++p){
+        // the parts should be balanced
+        if(std::abs(part_sizes[p] - (grid_w*grid_h)/num_parts) > 1){
+          errorFlag++;
+          *outStream << "Error, unbalanced part " << p << " of " << num_parts << " size " << part_sizes[p] << std::endl;
+        }
+        // and compact (the bounding box of each part should not be much larger than the part itself)
+        const int_t bounding_area = (max_i[p]-min_i[p]+1)*(max_j[p]-min_j[p]+1);
+        *outStream << "method " << method << " part " << p << " of " << num_parts << " size " << part_sizes[p] << " bounding box area " << bounding_area << std::endl;
+        if(bounding_area > 2.5*part_sizes[p]){
+          errorFlag++;
+          *outStream << "Error, part " << p << " of " << num_parts << " is not compact" << std::endl;
+        }
+      }
+    }
+  }
+
+  // the weighted partition should balance the cost rather than the number of points
+  *outStream << "testing the cost weighted partitioning" << std::endl;
+  std::vector<scalar_t> grid_weights(grid_w*grid_h,1.0);
+  scalar_t total_weight = 0.0;
+  for(int_t k=0;k<grid_w*grid_h;++k){
+    if(k%grid_w < grid_w/4) grid_weights[k] = 5.0; // the left quarter of the grid is expensive
+    total_weight += grid_weights[k];
+  }
+  for(int_t c=0;c<4;++c){
+    const int_t num_parts = part_counts[c];
+    std::vector<int_t> part_ids;
+    partition_points_rcb(grid_x,grid_y,num_parts,part_ids,grid_weights);
+    std::vector<scalar_t> part_weights(num_parts,0.0);
+    for(int_t k=0;k<grid_w*grid_h;++k)
+      part_weights[part_ids[k]] += grid_weights[k];
+    for(int_t p=0;p<num_parts;++p){
+      *outStream << "part " << p << " of " << num_parts << " weight " << part_weights[p] << std::endl;
+      if(std::abs(part_weights[p] - total_weight/num_parts) > 0.01*total_weight/num_parts){
+        errorFlag++;
+        *outStream << "Error, unbalanced weighted part " << p << " of " << num_parts << " weight " << part_weights[p] << std::endl;
+      }
+    }
+  }
+
+  // the grid bucketed neighbor search should find the same points as a brute force search
+  *outStream << "testing the neighbor search" << std::endl;
+  std::vector<bool> is_query(grid_w*grid_h,false);
+  for(int_t k=0;k<grid_w*grid_h;++k){
+    // scatter the query points around the grid
+    if((k*7)%13==0&&k%grid_w<grid_w/2) is_query[k] = true;
+  }
+  const scalar_t search_radii[] = {5.0,10.0,25.0,41.0};
+  for(int_t r=0;r<4;++r){
+    const scalar_t radius_2 = search_radii[r]*search_radii[r] + 1.0E-5;
+    std::vector<bool> in_neighborhood;
+    find_points_within_radius(grid_x,grid_y,is_query,radius_2,in_neighborhood);
+    int_t num_found = 0;
+    int_t num_wrong = 0;
+    for(int_t k=0;k<grid_w*grid_h;++k){
+      bool brute_force = false;
+      for(int_t q=0;q<grid_w*grid_h;++q){
+        if(!is_query[q]) continue;
+        const scalar_t dx = grid_x[k] - grid_x[q];
+        const scalar_t dy = grid_y[k] - grid_y[q];
+        if(dx*dx + dy*dy <= radius_2){
+          brute_force = true;
+          break;
+        }
+      }
+      if(in_neighborhood[k]) num_found++;
+      if(in_neighborhood[k]!=brute_force) num_wrong++;
+    }
+    *outStream << "radius " << search_radii[r] << " found " << num_found << " points in the neighborhood" << std::endl;
+    if(num_wrong!=0){
+      errorFlag++;
+      *outStream << "Error, neighbor search with radius " << search_radii[r] << " does not match the brute force search for " << num_wrong << " points" << std::endl;
+    }
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -48,6 +48,7 @@
 #include <Teuchos_ParameterList.hpp>
 
 #include <iostream>
+#include <algorithm>
 
 using namespace DICe;
 
@@ -168,6 +169,48 @@ int main(int argc, char *argv[]) {
   }
 #endif
 
+  *outStream << "testing the real to complex transform against the complex transform" << std::endl;
+  const int_t plan_w = 30;
+  const int_t plan_h = 14;
+  Teuchos::ArrayRCP<scalar_t> signal(plan_w*plan_h,0.0);
+  for(int_t i=0;i<plan_w*plan_h;++i)
+    signal[i] = (scalar_t)((i*37)%255);
+  Teuchos::RCP<FFT_Plan> plan = fft_plan(plan_w,plan_h,0);
+  if(plan.get()!=fft_plan(plan_w,plan_h,0).get()){
+    *outStream << "Error, the fft plan should have been reused from the cache" << std::endl;
+    errorFlag++;
+  }
+  Teuchos::ArrayRCP<scalar_t> r2c_r(plan_w*plan_h,0.0), r2c_i(plan_w*plan_h,0.0);
+  plan->transform_real(signal.getRawPtr(),r2c_r.getRawPtr(),r2c_i.getRawPtr());
+  Teuchos::ArrayRCP<scalar_t> c2c_r(plan_w*plan_h,0.0), c2c_i(plan_w*plan_h,0.0);
+  for(int_t i=0;i<plan_w*plan_h;++i)
+    c2c_r[i] = signal[i];
+  array_2d_fft_in_place(plan_w,plan_h,c2c_r,c2c_i);
+  scalar_t max_transform_diff = 0.0;
+  for(int_t i=0;i<plan_w*plan_h;++i){
+    max_transform_diff = std::max(max_transform_diff,std::abs(r2c_r[i]-c2c_r[i]));
+    max_transform_diff = std::max(max_transform_diff,std::abs(r2c_i[i]-c2c_i[i]));
+  }
+  *outStream << "max difference between real and complex transforms: " << max_transform_diff << std::endl;
+  if(max_transform_diff > 0.01){
+    *outStream << "Error, the real to complex transform is not correct" << std::endl;
+    errorFlag++;
+  }
+  // round trip back to the time domain
+  array_2d_fft_in_place(plan_w,plan_h,r2c_r,r2c_i,1);
+  scalar_t max_round_trip_diff = 0.0;
+  for(int_t i=0;i<plan_w*plan_h;++i)
+    max_round_trip_diff = std::max(max_round_trip_diff,std::abs(r2c_r[i]/(plan_w*plan_h)-signal[i]));
+  *outStream << "max round trip difference: " << max_round_trip_diff << std::endl;
+  if(max_round_trip_diff > 0.01){
+    *outStream << "Error, the inverse transform did not recover the signal" << std::endl;
+    errorFlag++;
+  }
+  if(fft_good_size(plan_w)!=30||fft_good_size(plan_h)!=15||fft_good_size(97)!=100){
+    *outStream << "Error, fft_good_size is not correct" << std::endl;
+    errorFlag++;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -41,6 +41,7 @@
 
 #include <DICe.h>
 #include <DICe_Image.h>
+#include <DICe_ImageUtils.h>
 #include <DICe_Shape.h>
 #include <DICe_LocalShapeFunction.h>
 
@@ -48,7 +49,9 @@
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_ParameterList.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 using namespace DICe;
 
@@ -207,6 +210,37 @@ int main(int argc, char *argv[]) {
   }
   *outStream << "flat image gradients have been checked" << std::endl;
 
+  // the summed area table window sums should match direct sums over the window
+  *outStream << "checking the summed area tables" << std::endl;
+  Teuchos::RCP<Image> array_img_rcp = Teuchos::rcp(&array_img,false);
+  Summed_Area_Table intensity_table(array_img_rcp,SUMMED_INTENSITY);
+  Summed_Area_Table grad_table(array_img_rcp,SUMMED_GRADIENT_MAGNITUDE_SQUARED);
+  bool sat_error = false;
+  const int_t windows[][4] = {{0,0,array_w,array_h},{3,5,24,17},{-4,-4,9,9},{array_w-11,array_h-7,array_w+3,array_h},{10,10,11,11}};
+  for(int_t w=0;w<5;++w){
+    const int_t x0 = std::max(windows[w][0],0), x1 = std::min(windows[w][2],array_w);
+    const int_t y0 = std::max(windows[w][1],0), y1 = std::min(windows[w][3],array_h);
+    scalar_t intensity_sum = 0.0;
+    scalar_t grad_sum = 0.0;
+    for(int_t y=y0;y<y1;++y){
+      for(int_t x=x0;x<x1;++x){
+        intensity_sum += array_img(x,y);
+        grad_sum += array_img.grad_x(x,y)*array_img.grad_x(x,y) + array_img.grad_y(x,y)*array_img.grad_y(x,y);
+      }
+    }
+    const scalar_t intensity_table_sum = intensity_table.window_sum(windows[w][0],windows[w][1],windows[w][2],windows[w][3]);
+    const scalar_t grad_table_sum = grad_table.window_sum(windows[w][0],windows[w][1],windows[w][2],windows[w][3]);
+    *outStream << "window " << w << " intensity sum " << intensity_sum << " table " << intensity_table_sum <<
+        " gradient sum " << grad_sum << " table " << grad_table_sum << std::endl;
+    if(std::abs(intensity_sum - intensity_table_sum) > 1.0E-3*(1.0 + std::abs(intensity_sum))) sat_error = true;
+    if(std::abs(grad_sum - grad_table_sum) > 1.0E-3*(1.0 + std::abs(grad_sum))) sat_error = true;
+  }
+  if(sat_error){
+    *outStream << "Error, the summed area table window sums are wrong" << std::endl;
+    errorFlag++;
+  }
+  *outStream << "summed area tables have been checked" << std::endl;
+
   grad_x_error = false;
   grad_y_error = false;
   // check the hierarchical gradients:
@@ -533,6 +567,147 @@ int main(int argc, char *argv[]) {
     errorFlag++;
   }
 
+  *outStream << "testing the image pyramid" << std::endl;
+  // a linear ramp is reproduced exactly by the pyramid filter away from the edges
+  const int_t ramp_w = 101;
+  const int_t ramp_h = 75;
+  const int_t ramp_ox = 13;
+  const int_t ramp_oy = 6;
+  Teuchos::ArrayRCP<intensity_t> ramp_intensities(ramp_w*ramp_h,0.0);
+  for(int_t y=0;y<ramp_h;++y)
+    for(int_t x=0;x<ramp_w;++x)
+      ramp_intensities[y*ramp_w+x] = 0.5*(x+ramp_ox) + 0.25*(y+ramp_oy);
+  Teuchos::RCP<Image> ramp = Teuchos::rcp(new Image(ramp_w,ramp_h,ramp_intensities,Teuchos::null,ramp_ox,ramp_oy));
+  Teuchos::RCP<Image> ramp_1 = ramp->pyramid_level(1);
+  Teuchos::RCP<Image> ramp_2 = ramp->pyramid_level(2);
+  if(ramp->num_pyramid_levels()!=2||ramp->pyramid_level(1).get()!=ramp_1.get()){
+    *outStream << "Error, the pyramid levels are not cached" << std::endl;
+    errorFlag++;
+  }
+  if(ramp_1->width()!=50||ramp_1->height()!=38||ramp_1->offset_x()!=7||ramp_1->offset_y()!=3){
+    *outStream << "Error, pyramid level 1 has the wrong dimensions or offsets: " << ramp_1->width() << " " << ramp_1->height() <<
+        " " << ramp_1->offset_x() << " " << ramp_1->offset_y() << std::endl;
+    errorFlag++;
+  }
+  if(ramp_2->width()!=25||ramp_2->height()!=19||ramp_2->offset_x()!=4||ramp_2->offset_y()!=2){
+    *outStream << "Error, pyramid level 2 has the wrong dimensions or offsets: " << ramp_2->width() << " " << ramp_2->height() <<
+        " " << ramp_2->offset_x() << " " << ramp_2->offset_y() << std::endl;
+    errorFlag++;
+  }
+  if(!ramp_1->has_gradients()||!ramp_2->has_gradients()){
+    *outStream << "Error, the pyramid levels should have gradients" << std::endl;
+    errorFlag++;
+  }
+  scalar_t pyramid_error = 0.0;
+  for(int_t y=2;y<ramp_2->height()-2;++y){
+    for(int_t x=2;x<ramp_2->width()-2;++x){
+      // global coordinates at level 2 are one quarter of the full resolution coordinates
+      const scalar_t exact = 0.5*4*(x+ramp_2->offset_x()) + 0.25*4*(y+ramp_2->offset_y());
+      pyramid_error = std::max(pyramid_error,(scalar_t)std::abs((*ramp_2)(x,y) - exact));
+    }
+  }
+  *outStream << "pyramid level 2 max error " << pyramid_error << std::endl;
+  if(pyramid_error > 1.0E-3){
+    *outStream << "Error, the pyramid level 2 intensities are not correct" << std::endl;
+    errorFlag++;
+  }
+  ramp->gauss_filter(5);
+  if(ramp->num_pyramid_levels()!=0){
+    *outStream << "Error, the pyramid should be cleared when the intensities change" << std::endl;
+    errorFlag++;
+  }
+  // applying a conformal mask changes the intensities so the cached levels must be rebuilt
+  Teuchos::RCP<Image> masked_ramp = Teuchos::rcp(new Image(ramp_w,ramp_h,ramp_intensities));
+  const scalar_t unmasked_level_1_value = (*masked_ramp->pyramid_level(1))(10,10);
+  DICe::multi_shape ramp_boundary;
+  ramp_boundary.push_back(Teuchos::rcp(new DICe::Rectangle(80,37,31,61)));
+  DICe::Conformal_Area_Def ramp_area_def(ramp_boundary);
+  masked_ramp->apply_mask(ramp_area_def,false);
+  const scalar_t masked_level_1_value = (*masked_ramp->pyramid_level(1))(10,10);
+  *outStream << "pyramid level 1 value before mask " << unmasked_level_1_value << " after mask " << masked_level_1_value << std::endl;
+  if(std::abs(masked_level_1_value - unmasked_level_1_value) < 1.0){
+    *outStream << "Error, the pyramid should be rebuilt after a conformal mask is applied" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the image buffer pool" << std::endl;
+  Image_Buffer_Pool::instance().set_memory_budget(8*1024*1024);
+  Teuchos::RCP<Image> pool_img = Teuchos::rcp(new Image(64,48,10.0));
+  const intensity_t * pool_img_ptr = pool_img->intensities().getRawPtr();
+  pool_img = Teuchos::null;
+  if(Image_Buffer_Pool::instance().num_free_bytes()==0){
+    *outStream << "Error, the buffers of a destroyed image should be kept for reuse" << std::endl;
+    errorFlag++;
+  }
+  Teuchos::RCP<Image> reused_img = Teuchos::rcp(new Image(64,48,20.0));
+  if(reused_img->intensities().getRawPtr()!=pool_img_ptr||(*reused_img)(5,5)!=20.0||reused_img->mask(5,5)!=0.0){
+    *outStream << "Error, the image buffer was not reused or not initialized" << std::endl;
+    errorFlag++;
+  }
+  // the buffers of an image released on another thread are returned to the pool
+  const size_t num_free_bytes_before_release = Image_Buffer_Pool::instance().num_free_bytes();
+  std::thread release_thread([&reused_img]{reused_img = Teuchos::null;});
+  release_thread.join();
+  if(Image_Buffer_Pool::instance().num_free_bytes()<=num_free_bytes_before_release){
+    *outStream << "Error, the buffers of an image released on another thread should be kept for reuse" << std::endl;
+    errorFlag++;
+  }
+  Image_Buffer_Pool::instance().set_memory_budget(0);
+  if(Image_Buffer_Pool::instance().num_free_bytes()!=0){
+    *outStream << "Error, the free buffers should be released when the budget is zero" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing compact intensity storage" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> compact_params = rcp(new Teuchos::ParameterList());
+  compact_params->set(DICe::compute_image_gradients,true);
+  compact_params->set(DICe::compact_intensity_storage,true);
+  Teuchos::RCP<Teuchos::ParameterList> full_params = rcp(new Teuchos::ParameterList());
+  full_params->set(DICe::compute_image_gradients,true);
+  Teuchos::RCP<Image> compact_img = Teuchos::rcp(new Image("./images/ImageB.tif",compact_params));
+  Teuchos::RCP<Image> full_img = Teuchos::rcp(new Image("./images/ImageB.tif",full_params));
+  if(compact_img->intensity_storage()!=UINT8_INTENSITY_STORAGE){
+    *outStream << "Error, an 8 bit tiff image should be stored as 8 bit integers" << std::endl;
+    errorFlag++;
+  }
+  scalar_t compact_error = 0.0;
+  for(int_t y=5;y<full_img->height()-5;y+=3){
+    for(int_t x=5;x<full_img->width()-5;x+=3){
+      const scalar_t px = x + 0.37;
+      const scalar_t py = y + 0.61;
+      compact_error = std::max(compact_error,(scalar_t)std::abs(compact_img->interpolate_keys_fourth(px,py)-full_img->interpolate_keys_fourth(px,py)));
+      compact_error = std::max(compact_error,(scalar_t)std::abs(compact_img->interpolate_bicubic(px,py)-full_img->interpolate_bicubic(px,py)));
+      compact_error = std::max(compact_error,(scalar_t)std::abs(compact_img->interpolate_bilinear(px,py)-full_img->interpolate_bilinear(px,py)));
+      compact_error = std::max(compact_error,(scalar_t)std::abs(compact_img->grad_x(x,y)-full_img->grad_x(x,y)));
+      compact_error = std::max(compact_error,(scalar_t)std::abs((*compact_img)(x,y)-(*full_img)(x,y)));
+    }
+  }
+  *outStream << "compact storage max error " << compact_error << std::endl;
+  if(compact_error > 1.0E-4){
+    *outStream << "Error, compact intensity storage changes the interpolated values" << std::endl;
+    errorFlag++;
+  }
+  // reading the values or writing the image must not change the storage
+  Teuchos::ArrayRCP<const intensity_t> compact_values = compact_img->intensity_values();
+  Teuchos::ArrayRCP<const intensity_t> full_values = full_img->intensity_values();
+  bool values_match = compact_values.size()==full_values.size();
+  for(int_t i=0;i<compact_values.size()&&values_match;++i)
+    values_match = compact_values[i]==full_values[i];
+  if(!values_match){
+    *outStream << "Error, the intensity values of the compact image are not correct" << std::endl;
+    errorFlag++;
+  }
+  compact_img->write("compact_d.rawi");
+  if(compact_img->intensity_storage()!=UINT8_INTENSITY_STORAGE){
+    *outStream << "Error, reading or writing the intensities should not expand the compact storage" << std::endl;
+    errorFlag++;
+  }
+  compact_img->gauss_filter(5);
+  if(compact_img->intensity_storage()!=FULL_INTENSITY_STORAGE){
+    *outStream << "Error, filtering should expand the compact intensities" << std::endl;
+    errorFlag++;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
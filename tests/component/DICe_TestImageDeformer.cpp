@@ -48,6 +48,7 @@
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_ParameterList.hpp>
 
+#include <cmath>
 #include <iostream>
 
 using namespace DICe;
@@ -80,6 +81,99 @@ int main(int argc, char *argv[]) {
   Teuchos::RCP<SinCos_Image_Deformer> deformer = Teuchos::rcp(new SinCos_Image_Deformer(num_steps,true));
   Teuchos::RCP<Image> def_img = deformer->deform_image(ref_img);
   def_img->write("sincos_def.tif");
+
+  // the images generated on background threads should be the same as the ones deformed directly
+  *outStream << "generating a sweep of deformed images on background threads" << std::endl;
+  std::vector<scalar_t> periods;
+  std::vector<scalar_t> amplitudes;
+  for(scalar_t period=100.0;period>=25.0;period*=0.5){
+    for(scalar_t amplitude=0.5;amplitude<=1.5;amplitude+=0.5){
+      periods.push_back(period);
+      amplitudes.push_back(amplitude);
+    }
+  }
+  Synthetic_Image_Generator generator(ref_img,periods,amplitudes,std::vector<std::string>(),-1.0,-1,false,3);
+  bool sweep_error = false;
+  for(int_t i=0;i<generator.num_cases();++i){
+    Teuchos::RCP<Image_Deformer> case_deformer;
+    Teuchos::RCP<Image> case_img = generator.next(case_deformer);
+    SinCos_Image_Deformer exact_deformer(periods[i],amplitudes[i]);
+    Teuchos::RCP<Image> exact_img = exact_deformer.deform_image(ref_img);
+    if(case_img->width()!=exact_img->width()||case_img->height()!=exact_img->height()){
+      *outStream << "Error, wrong image dimensions for case " << i << std::endl;
+      sweep_error = true;
+      continue;
+    }
+    scalar_t bx=0.0,by=0.0,exact_bx=0.0,exact_by=0.0;
+    case_deformer->compute_deformation(10.0,20.0,bx,by);
+    exact_deformer.compute_deformation(10.0,20.0,exact_bx,exact_by);
+    if(bx!=exact_bx||by!=exact_by){
+      *outStream << "Error, wrong image deformer for case " << i << std::endl;
+      sweep_error = true;
+    }
+    for(int_t j=0;j<exact_img->width()*exact_img->height();++j){
+      if((*case_img)(j)!=(*exact_img)(j)){
+        *outStream << "Error, wrong intensity values for case " << i << " period " << periods[i] << " amplitude " << amplitudes[i] << std::endl;
+        sweep_error = true;
+        break;
+      }
+    }
+  }
+  if(sweep_error) errorFlag++;
+
+  // the batched deformation should match the point by point evaluation
+  *outStream << "checking the batched deformation evaluation" << std::endl;
+  std::vector<Teuchos::RCP<Image_Deformer> > deformers;
+  deformers.push_back(Teuchos::rcp(new SinCos_Image_Deformer(50.0,2.0)));
+  deformers.push_back(Teuchos::rcp(new DICChallenge14_Image_Deformer()));
+  deformers.push_back(Teuchos::rcp(new ConstantValue_Image_Deformer(1.5,-0.5)));
+  std::vector<scalar_t> batch_x;
+  std::vector<scalar_t> batch_y;
+  for(int_t i=0;i<500;++i){
+    batch_x.push_back(0.7*i);
+    batch_y.push_back(0.3*i + 5.0);
+  }
+  for(size_t d=0;d<deformers.size();++d){
+    std::vector<scalar_t> batch_bx;
+    std::vector<scalar_t> batch_by;
+    deformers[d]->compute_deformation_batch(batch_x,batch_y,batch_bx,batch_by);
+    bool batch_error = batch_bx.size()!=batch_x.size()||batch_by.size()!=batch_y.size();
+    for(size_t i=0;i<batch_x.size()&&!batch_error;++i){
+      scalar_t bx=0.0,by=0.0;
+      deformers[d]->compute_deformation(batch_x[i],batch_y[i],bx,by);
+      if(bx!=batch_bx[i]||by!=batch_by[i]) batch_error = true;
+    }
+    if(batch_error){
+      *outStream << "Error, the batched deformation does not match for deformer " << d << std::endl;
+      errorFlag++;
+    }
+  }
+
+  // the parallel deformed image should match a point by point deformation of the image
+  *outStream << "checking the deformed image against a point by point deformation" << std::endl;
+  const scalar_t sample_offsets_x[5] = {0.0,-0.5,0.5,0.5,-0.5};
+  const scalar_t sample_offsets_y[5] = {0.0,-0.5,-0.5,0.5,0.5};
+  SinCos_Image_Deformer check_deformer(40.0,1.5);
+  Teuchos::RCP<Image> check_img = check_deformer.deform_image(ref_img);
+  bool deform_error = false;
+  for(int_t j=0;j<ref_img->height();j+=7){
+    for(int_t i=0;i<ref_img->width();i+=5){
+      scalar_t avg_intens = 0.0;
+      for(int_t pt=0;pt<5;++pt){
+        const scalar_t sample_x = i - sample_offsets_x[pt];
+        const scalar_t sample_y = j - sample_offsets_y[pt];
+        scalar_t bx=0.0,by=0.0;
+        check_deformer.compute_deformation(sample_x+ref_img->offset_x(),sample_y+ref_img->offset_y(),bx,by);
+        avg_intens += ref_img->interpolate_keys_fourth(sample_x-bx,sample_y-by);
+      }
+      avg_intens /= 5;
+      if(std::abs(avg_intens - (*check_img)(i,j)) > 1.0E-3) deform_error = true;
+    }
+  }
+  if(deform_error){
+    *outStream << "Error, the deformed image does not match the point by point deformation" << std::endl;
+    errorFlag++;
+  }
 #endif
 
   *outStream << "--- End test ---" << std::endl;
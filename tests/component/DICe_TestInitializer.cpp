@@ -197,6 +197,7 @@ int main(int argc, char *argv[]) {
   Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList());
   std::vector<Initialization_Method> init_methods;
   init_methods.push_back(USE_PHASE_CORRELATION);
+  init_methods.push_back(USE_SUBSET_PHASE_CORRELATION);
   init_methods.push_back(USE_FIELD_VALUES);
   init_methods.push_back(INITIALIZATION_METHOD_NOT_APPLICABLE); // use this one for path file test
   std::vector<Correlation_Routine> corr_routines;
@@ -211,6 +212,8 @@ int main(int argc, char *argv[]) {
       params->set(DICe::correlation_routine,corr_routines[corr_i]);
       params->set(DICe::disp_jump_tol,500.0);
       params->set(DICe::theta_jump_tol,100.0);
+      // the window has to be large enough to capture the displacement of the subsets
+      params->set(DICe::phase_correlation_window_size,400);
       Teuchos::RCP<DICe::Schema> schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,neighbor_ids,params));
       schema->set_ref_image("./images/InitRef.tif");
       schema->set_def_image("./images/InitDef.tif");
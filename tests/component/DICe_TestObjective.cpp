@@ -46,14 +46,30 @@
 
 #include <DICe_Schema.h>
 #include <DICe_Objective.h>
+#include <DICe_Simplex.h>
 #include <DICe.h>
 
 #include <Teuchos_oblackholestream.hpp>
 
 #include <iostream>
+#include <cmath>
 
 using namespace DICe;
 
+/// subset simplex with a fixed number of parallel evaluations, used to turn the speculative evaluations on or off
+class Test_Subset_Simplex : public Subset_Simplex {
+public:
+  Test_Subset_Simplex(const DICe::Objective * const obj,
+    const int_t num_parallel_evaluations):
+    Subset_Simplex(obj),
+    num_parallel_evaluations_(num_parallel_evaluations){}
+  virtual int_t max_parallel_evaluations()const{
+    return num_parallel_evaluations_;
+  }
+private:
+  const int_t num_parallel_evaluations_;
+};
+
 int main(int argc, char *argv[]) {
 
   DICe::initialize(argc, argv);
@@ -162,6 +178,25 @@ int main(int argc, char *argv[]) {
       *outStream << "Error, gamma is not " << shift*0.4 << " value=" << gamma << "\n";
       errorFlag++;
     }
+    // the batched evaluation should match evaluating gamma for each set of parameters in turn
+    std::vector<Teuchos::RCP<std::vector<scalar_t> > > batch_parameters;
+    std::vector<scalar_t> batch_gammas(8,0.0);
+    for(int_t i=0;i<8;++i){
+      Teuchos::RCP<Local_Shape_Function> batch_shape_function = shape_function_factory(schema);
+      batch_shape_function->insert_motion(0.5*i,-0.25*i);
+      batch_parameters.push_back(Teuchos::rcp(new std::vector<scalar_t>(*batch_shape_function->parameters())));
+      batch_gammas[i] = obj->gamma(batch_shape_function);
+    }
+    std::vector<scalar_t> batch_values;
+    Gamma_Batch_Workspace batch_workspace;
+    obj->create_batch_workspace(batch_workspace);
+    obj->gamma_batch(batch_parameters,batch_workspace,batch_values);
+    for(int_t i=0;i<8;++i){
+      if(batch_values[i]!=batch_gammas[i]){
+        *outStream << "Error, batched gamma " << batch_values[i] << " does not match gamma " << batch_gammas[i] << "\n";
+        errorFlag++;
+      }
+    }
     Teuchos::RCP<DICe::Objective_ZNSSD> quadratic_obj = Teuchos::rcp(new DICe::Objective_ZNSSD(schema,0));
     const scalar_t quadratic_gamma =  quadratic_obj->gamma(quadratic_shape_function);
     *outStream << "quadratic gamma value: " << quadratic_gamma << std::endl;
@@ -172,6 +207,105 @@ int main(int argc, char *argv[]) {
     delete schema;
   }
 
+  *outStream << "testing the simplex method with and without the speculative evaluations" << std::endl;
+  {
+    // smooth pattern shifted by a sub-pixel amount
+    const scalar_t shift_x = 1.3;
+    const scalar_t shift_y = -0.6;
+    Teuchos::ArrayRCP<intensity_t> ref_intensities(img_width*img_height,0.0);
+    Teuchos::ArrayRCP<intensity_t> def_intensities(img_width*img_height,0.0);
+    for(int_t y=0;y<img_height;++y){
+      for(int_t x=0;x<img_width;++x){
+        ref_intensities[y*img_width+x] = 128.0 + 60.0*std::sin(x/5.0)*std::cos(y/7.0);
+        def_intensities[y*img_width+x] = 128.0 + 60.0*std::sin((x-shift_x)/5.0)*std::cos((y-shift_y)/7.0);
+      }
+    }
+    Teuchos::ArrayRCP<scalar_t> coords_x(1,100);
+    Teuchos::ArrayRCP<scalar_t> coords_y(1,100);
+    DICe::Schema * schema = new DICe::Schema(coords_x,coords_y,41);
+    schema->set_ref_image(img_width,img_height,ref_intensities);
+    schema->set_def_image(img_width,img_height,def_intensities);
+    Teuchos::RCP<DICe::Objective_ZNSSD> obj = Teuchos::rcp(new DICe::Objective_ZNSSD(schema,0));
+    std::vector<scalar_t> solutions[2];
+    int_t num_iterations[2] = {-1,-1};
+    Status_Flag status[2] = {CORRELATION_FAILED,CORRELATION_FAILED};
+    const int_t num_parallel[2] = {1,4};
+    for(int_t i=0;i<2;++i){
+      Teuchos::RCP<Local_Shape_Function> simplex_shape_function = shape_function_factory(schema);
+      simplex_shape_function->insert_motion(0.5,0.0);
+      Test_Subset_Simplex simplex(obj.get(),num_parallel[i]);
+      status[i] = simplex.minimize(simplex_shape_function,num_iterations[i]);
+      solutions[i] = *simplex_shape_function->parameters();
+      *outStream << "parallel evaluations: " << num_parallel[i] << " status: " << status[i] << " iterations: " << num_iterations[i] << std::endl;
+    }
+    if(status[0]!=status[1]||num_iterations[0]!=num_iterations[1]){
+      *outStream << "Error, the speculative evaluations changed the simplex status or number of iterations" << std::endl;
+      errorFlag++;
+    }
+    if(solutions[0]!=solutions[1]){
+      *outStream << "Error, the speculative evaluations changed the simplex solution" << std::endl;
+      errorFlag++;
+    }
+    delete schema;
+  }
+
+  *outStream << "testing the coarse-to-fine update for a large shift" << std::endl;
+  {
+    // long wavelength pattern shifted by more than the gradient based method can recover at full resolution,
+    // the deformed image for the coarse update also has a different contrast and brightness
+    const scalar_t shift_x = 11.5;
+    const scalar_t shift_y = -7.25;
+    Teuchos::ArrayRCP<intensity_t> ref_intensities(img_width*img_height,0.0);
+    Teuchos::ArrayRCP<intensity_t> def_intensities(img_width*img_height,0.0);
+    Teuchos::ArrayRCP<intensity_t> scaled_def_intensities(img_width*img_height,0.0);
+    Teuchos::ArrayRCP<intensity_t> flat_intensities(img_width*img_height,100.0);
+    for(int_t y=0;y<img_height;++y){
+      for(int_t x=0;x<img_width;++x){
+        ref_intensities[y*img_width+x] = 128.0 + 60.0*std::sin(x/12.0)*std::cos(y/15.0);
+        def_intensities[y*img_width+x] = 128.0 + 60.0*std::sin((x-shift_x)/12.0)*std::cos((y-shift_y)/15.0);
+        scaled_def_intensities[y*img_width+x] = 10.0 + 0.8*def_intensities[y*img_width+x];
+      }
+    }
+    Teuchos::ArrayRCP<scalar_t> coords_x(1,100);
+    Teuchos::ArrayRCP<scalar_t> coords_y(1,100);
+    DICe::Schema * schema = new DICe::Schema(coords_x,coords_y,41);
+    schema->set_ref_image(img_width,img_height,ref_intensities);
+    schema->set_def_image(img_width,img_height,scaled_def_intensities);
+    Teuchos::RCP<DICe::Objective_ZNSSD> obj = Teuchos::rcp(new DICe::Objective_ZNSSD(schema,0));
+    Teuchos::RCP<Local_Shape_Function> coarse_shape_function = shape_function_factory(schema);
+    const Status_Flag coarse_status = obj->computeUpdateCoarse(coarse_shape_function,2);
+    scalar_t u = 0.0, v = 0.0, t = 0.0;
+    coarse_shape_function->map_to_u_v_theta(100,100,u,v,t);
+    *outStream << "coarse status: " << coarse_status << " u: " << u << " v: " << v << std::endl;
+    if(coarse_status!=CORRELATION_SUCCESSFUL){
+      *outStream << "Error, the coarse update failed" << std::endl;
+      errorFlag++;
+    }
+    if(std::abs(u-shift_x)>0.5||std::abs(v-shift_y)>0.5){
+      *outStream << "Error, the coarse update did not find the shift" << std::endl;
+      errorFlag++;
+    }
+    // refine at full resolution (without the contrast change)
+    schema->set_def_image(img_width,img_height,def_intensities);
+    int_t num_iterations = 0;
+    const Status_Flag fast_status = obj->computeUpdateFast(coarse_shape_function,num_iterations);
+    coarse_shape_function->map_to_u_v_theta(100,100,u,v,t);
+    *outStream << "fast status: " << fast_status << " u: " << u << " v: " << v << std::endl;
+    if(fast_status!=CORRELATION_SUCCESSFUL||std::abs(u-shift_x)>0.01||std::abs(v-shift_y)>0.01){
+      *outStream << "Error, the gradient based update seeded by the coarse update did not converge to the shift" << std::endl;
+      errorFlag++;
+    }
+    // a deformed image without any texture should fail
+    schema->set_def_image(img_width,img_height,flat_intensities);
+    Teuchos::RCP<DICe::Objective_ZNSSD> flat_obj = Teuchos::rcp(new DICe::Objective_ZNSSD(schema,0));
+    Teuchos::RCP<Local_Shape_Function> flat_shape_function = shape_function_factory(schema);
+    if(flat_obj->computeUpdateCoarse(flat_shape_function,2)==CORRELATION_SUCCESSFUL){
+      *outStream << "Error, the coarse update should fail for an image without texture" << std::endl;
+      errorFlag++;
+    }
+    delete schema;
+  }
+
   // dummy deformation vector to pass to objective
   *outStream << "testing quadratic deformation with ZNSSD correlation" << std::endl;
   Teuchos::RCP<Local_Shape_Function> quad_shape_func_exact = Teuchos::rcp(new Quadratic_Shape_Function());
@@ -0,0 +1,166 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+
+/*! \file  DICe_TestPostProcessor.cpp
+    \brief Testing of the VSG strain post processor and its cached operators
+*/
+
+#include <DICe.h>
+#include <DICe_Schema.h>
+#include <DICe_PostProcessor.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <iostream>
+#include <cmath>
+
+using namespace DICe;
+using namespace DICe::field_enums;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+  int_t errorFlag  = 0;
+  const scalar_t errtol = 1.0E-8;
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  // regular grid of subsets
+  const int_t num_x = 11;
+  const int_t num_y = 11;
+  const scalar_t spacing = 10.0;
+  const int_t num_subsets = num_x*num_y;
+  Teuchos::ArrayRCP<scalar_t> coords_x(num_subsets,0.0);
+  Teuchos::ArrayRCP<scalar_t> coords_y(num_subsets,0.0);
+  for(int_t j=0;j<num_y;++j){
+    for(int_t i=0;i<num_x;++i){
+      coords_x[j*num_x+i] = 50.0 + i*spacing;
+      coords_y[j*num_x+i] = 50.0 + j*spacing;
+    }
+  }
+  Teuchos::RCP<Schema> schema = Teuchos::rcp(new Schema(coords_x,coords_y,9));
+  Teuchos::RCP<Teuchos::ParameterList> vsg_params = Teuchos::rcp(new Teuchos::ParameterList());
+  vsg_params->set(strain_window_size_in_pixels,45);
+  vsg_params->set(coordinates_x_field_name,SUBSET_COORDINATES_X_FS.get_name_label());
+  vsg_params->set(coordinates_y_field_name,SUBSET_COORDINATES_Y_FS.get_name_label());
+  vsg_params->set(displacement_x_field_name,SUBSET_DISPLACEMENT_X_FS.get_name_label());
+  vsg_params->set(displacement_y_field_name,SUBSET_DISPLACEMENT_Y_FS.get_name_label());
+  Teuchos::RCP<VSG_Strain_Post_Processor> vsg = Teuchos::rcp(new VSG_Strain_Post_Processor(vsg_params));
+  vsg->initialize(schema->mesh());
+
+  // the subset in the center of the grid and its neighbor to the right, which is invalid in the second frame
+  const int_t center_gid = (num_y/2)*num_x + num_x/2;
+  const int_t neighbor_gid = center_gid + 1;
+
+  // frame 0: all subsets valid
+  // frame 1: the neighbor fails and its displacement is garbage, a stale operator would use it
+  // frame 2: the neighbor is valid again, the operator has to be rebuilt with the neighbor's weight
+  const scalar_t grads[3][4] = {{0.01,-0.02,0.03,0.005},{-0.015,0.02,0.01,-0.03},{0.02,0.01,-0.01,0.015}};
+  for(int_t frame=0;frame<3;++frame){
+    *outStream << "frame " << frame << std::endl;
+    const scalar_t dudx = grads[frame][0];
+    const scalar_t dudy = grads[frame][1];
+    const scalar_t dvdx = grads[frame][2];
+    const scalar_t dvdy = grads[frame][3];
+    for(int_t i=0;i<schema->local_num_subsets();++i){
+      const int_t gid = schema->subset_global_id(i);
+      const scalar_t x = coords_x[gid];
+      const scalar_t y = coords_y[gid];
+      schema->local_field_value(i,SUBSET_COORDINATES_X_FS) = x;
+      schema->local_field_value(i,SUBSET_COORDINATES_Y_FS) = y;
+      schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = 1.0 + dudx*x + dudy*y;
+      schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = -2.0 + dvdx*x + dvdy*y;
+      schema->local_field_value(i,SIGMA_FS) = 0.01;
+      if(frame==1&&gid==neighbor_gid){
+        schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = 1000.0;
+        schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = -1000.0;
+        schema->local_field_value(i,SIGMA_FS) = -1.0;
+      }
+    }
+    vsg->execute();
+    // the displacement field is linear so the derivatives should be exact for the subsets with a full neighborhood
+    for(int_t i=0;i<schema->local_num_subsets();++i){
+      const int_t gid = schema->subset_global_id(i);
+      if(frame==1&&gid==neighbor_gid) continue;
+      const int_t ix = gid%num_x;
+      const int_t iy = gid/num_x;
+      if(ix<2||ix>=num_x-2||iy<2||iy>=num_y-2) continue;
+      if(std::abs(schema->local_field_value(i,VSG_DUDX_FS)-dudx)>errtol||
+          std::abs(schema->local_field_value(i,VSG_DUDY_FS)-dudy)>errtol||
+          std::abs(schema->local_field_value(i,VSG_DVDX_FS)-dvdx)>errtol||
+          std::abs(schema->local_field_value(i,VSG_DVDY_FS)-dvdy)>errtol){
+        *outStream << "Error, frame " << frame << " subset " << gid << " has the wrong VSG derivatives " << schema->local_field_value(i,VSG_DUDX_FS) << " " <<
+            schema->local_field_value(i,VSG_DUDY_FS) << " " << schema->local_field_value(i,VSG_DVDX_FS) << " " << schema->local_field_value(i,VSG_DVDY_FS) << std::endl;
+        errorFlag++;
+      }
+    }
+    // a failed subset gets zero strain
+    const int_t neighbor_lid = schema->subset_local_id(neighbor_gid);
+    if(frame==1&&neighbor_lid>=0){
+      if(schema->local_field_value(neighbor_lid,VSG_DUDX_FS)!=0.0||schema->local_field_value(neighbor_lid,VSG_STRAIN_XX_FS)!=0.0){
+        *outStream << "Error, the failed subset should have zero strain" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
@@ -0,0 +1,147 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_TestProfiler.cpp
+    \brief Testing of the profiler that collects the per-frame and per-subset timings
+*/
+
+#include <DICe.h>
+#include <DICe_Profiler.h>
+
+#include <Teuchos_oblackholestream.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  Profiler & profiler = Profiler::instance();
+  profiler.clear();
+
+  *outStream << "recording two frames" << std::endl;
+  profiler.begin_frame(1);
+  {
+    Profile_Timer timer(PROFILE_IMAGE_LOAD);
+  }
+  profiler.add_time(PROFILE_IMAGE_FILTER,0.5);
+  profiler.add_time(PROFILE_IMAGE_FILTER,0.25);
+  profiler.add_count(PROFILE_INTERPOLATED_PIXELS,100);
+  profiler.begin_subset(4);
+  profiler.end_subset(4,7,0);
+  profiler.begin_subset(5);
+  profiler.end_subset(5,3,0);
+  profiler.begin_frame(2);
+  profiler.add_count(PROFILE_FAILED_SUBSETS,1);
+
+  if(profiler.num_frames()!=2){
+    *outStream << "Error, the number of frames is not correct: " << profiler.num_frames() << std::endl;
+    errorFlag++;
+  }
+  if(profiler.stage_time(0,PROFILE_IMAGE_FILTER)!=0.75){
+    *outStream << "Error, the filter time was not accumulated" << std::endl;
+    errorFlag++;
+  }
+  if(profiler.stage_time(0,PROFILE_IMAGE_LOAD)<0.0){
+    *outStream << "Error, the scoped timer recorded a negative time" << std::endl;
+    errorFlag++;
+  }
+  if(profiler.count(0,PROFILE_SOLVER_ITERATIONS)!=10||profiler.count(0,PROFILE_INTERPOLATED_PIXELS)!=100){
+    *outStream << "Error, the frame 1 counters are not correct" << std::endl;
+    errorFlag++;
+  }
+  if(profiler.count(1,PROFILE_FAILED_SUBSETS)!=1||profiler.count(1,PROFILE_SOLVER_ITERATIONS)!=0){
+    *outStream << "Error, the frame 2 counters are not correct" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "writing the trace files" << std::endl;
+  profiler.write_trace("profile_test");
+  std::ifstream subsets_csv("profile_test.subsets.csv");
+  std::string line;
+  int_t num_lines = 0;
+  while(std::getline(subsets_csv,line))
+    num_lines++;
+  subsets_csv.close();
+  if(num_lines!=3){
+    *outStream << "Error, the subset trace should have a header and two rows, not " << num_lines << " lines" << std::endl;
+    errorFlag++;
+  }
+  std::ifstream json("profile_test.json");
+  if(!json.good()){
+    *outStream << "Error, the json trace was not written" << std::endl;
+    errorFlag++;
+  }
+  json.close();
+  std::remove("profile_test.json");
+  std::remove("profile_test.frames.csv");
+  std::remove("profile_test.subsets.csv");
+  profiler.clear();
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
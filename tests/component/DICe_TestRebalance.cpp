@@ -0,0 +1,253 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+
+/*! \file  DICe_TestRebalance.cpp
+    \brief Testing of moving the subsets to other processors between frames
+*/
+
+#include <DICe.h>
+#include <DICe_Schema.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <iostream>
+#include <cmath>
+
+using namespace DICe;
+using namespace DICe::field_enums;
+
+/// speckle-like intensity pattern shifted by (u,v)
+intensity_t pattern(const scalar_t & x,
+  const scalar_t & y,
+  const scalar_t & u,
+  const scalar_t & v){
+  const scalar_t pi = 3.14159265358979;
+  const scalar_t xr = x - u;
+  const scalar_t yr = y - v;
+  return static_cast<intensity_t>(128.0 + 50.0*std::sin(2.0*pi*xr/23.0)*std::cos(2.0*pi*yr/17.0)
+    + 30.0*std::sin(2.0*pi*(xr+yr)/31.0));
+}
+
+/// create the intensity array of an image shifted by (u,v)
+Teuchos::ArrayRCP<intensity_t> shifted_image(const int_t width,
+  const int_t height,
+  const scalar_t & u,
+  const scalar_t & v){
+  Teuchos::ArrayRCP<intensity_t> intensities(width*height,0.0);
+  for(int_t y=0;y<height;++y)
+    for(int_t x=0;x<width;++x)
+      intensities[y*width+x] = pattern(x,y,u,v);
+  return intensities;
+}
+
+/// gather the values of a field for all the subsets on processor 0 (indexed by subset global id)
+Teuchos::RCP<MultiField> gather_field(Teuchos::RCP<Schema> schema,
+  const Field_Spec & spec){
+  MultiField_Comm comm;
+  const int_t num_ids = comm.get_rank()==0 ? schema->global_num_subsets() : 0;
+  Teuchos::Array<int_t> ids(num_ids);
+  for(int_t i=0;i<num_ids;++i)
+    ids[i] = i;
+  Teuchos::RCP<MultiField_Map> zero_map = Teuchos::rcp(new MultiField_Map(-1,ids,0,comm));
+  Teuchos::RCP<MultiField> zero_field = Teuchos::rcp(new MultiField(zero_map,1,true));
+  MultiField_Exporter exporter(*zero_map,*schema->mesh()->get_scalar_node_dist_map());
+  zero_field->do_import(schema->mesh()->get_field(spec),exporter);
+  return zero_field;
+}
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+  int_t errorFlag  = 0;
+  const scalar_t errtol = 1.0E-10;
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  MultiField_Comm comm;
+  const int_t proc_id = comm.get_rank();
+  const int_t num_procs = comm.get_size();
+
+  const int_t width = 200;
+  const int_t height = 160;
+  const int_t subset_size = 25;
+  const int_t step = 20;
+  std::vector<scalar_t> xs;
+  std::vector<scalar_t> ys;
+  for(int_t y=30;y<=height-30;y+=step){
+    for(int_t x=30;x<=width-30;x+=step){
+      xs.push_back(x);
+      ys.push_back(y);
+    }
+  }
+  const int_t num_subsets = xs.size();
+  Teuchos::ArrayRCP<scalar_t> coords_x(num_subsets,0.0);
+  Teuchos::ArrayRCP<scalar_t> coords_y(num_subsets,0.0);
+  for(int_t i=0;i<num_subsets;++i){
+    coords_x[i] = xs[i];
+    coords_y[i] = ys[i];
+  }
+
+  Teuchos::RCP<Teuchos::ParameterList> params = rcp(new Teuchos::ParameterList());
+  params->set(DICe::enable_translation,true);
+  params->set(DICe::enable_rotation,false);
+  params->set(DICe::enable_normal_strain,false);
+  params->set(DICe::enable_shear_strain,false);
+
+  // two identical analyses, the subsets of the first one are moved after the first frame
+  Teuchos::RCP<Schema> moved_schema = Teuchos::rcp(new Schema(coords_x,coords_y,subset_size,Teuchos::null,Teuchos::null,params));
+  Teuchos::RCP<Schema> schema = Teuchos::rcp(new Schema(coords_x,coords_y,subset_size,Teuchos::null,Teuchos::null,params));
+  Teuchos::ArrayRCP<intensity_t> ref_intensities = shifted_image(width,height,0.0,0.0);
+  Teuchos::ArrayRCP<intensity_t> def_intensities = shifted_image(width,height,1.3,-0.6);
+  moved_schema->set_ref_image(width,height,ref_intensities);
+  moved_schema->set_def_image(width,height,def_intensities);
+  schema->set_ref_image(width,height,ref_intensities);
+  schema->set_def_image(width,height,def_intensities);
+  moved_schema->execute_correlation();
+  schema->execute_correlation();
+  moved_schema->update_frame_id();
+  schema->update_frame_id();
+
+  std::vector<Field_Spec> specs;
+  specs.push_back(SUBSET_COORDINATES_X_FS);
+  specs.push_back(SUBSET_COORDINATES_Y_FS);
+  specs.push_back(SUBSET_DISPLACEMENT_X_FS);
+  specs.push_back(SUBSET_DISPLACEMENT_Y_FS);
+  specs.push_back(ROTATION_Z_FS);
+  specs.push_back(SIGMA_FS);
+  specs.push_back(GAMMA_FS);
+  specs.push_back(STATUS_FLAG_FS);
+  specs.push_back(ITERATIONS_FS);
+
+  std::vector<Teuchos::RCP<MultiField> > before(specs.size());
+  for(size_t s=0;s<specs.size();++s)
+    before[s] = gather_field(moved_schema,specs[s]);
+
+  // move every subset to the next processor, in serial the owners don't change but the mesh and fields are still recreated
+  *outStream << "migrating the subsets" << std::endl;
+  Teuchos::RCP<std::vector<int_t> > owners = Teuchos::rcp(new std::vector<int_t>());
+  if(proc_id==0)
+    for(int_t i=0;i<num_subsets;++i)
+      owners->push_back((i+1)%num_procs);
+  moved_schema->migrate_subsets(owners);
+
+  // the subset state has to follow the subset global id
+  const int_t local_num_subsets = moved_schema->local_num_subsets();
+  if(local_num_subsets!=moved_schema->mesh()->get_scalar_node_dist_map()->get_num_local_elements()||
+      (int_t)moved_schema->this_proc_gid_order().size()!=local_num_subsets){
+    *outStream << "Error, the local number of subsets is not consistent with the new decomposition" << std::endl;
+    errorFlag++;
+  }
+  for(int_t i=0;i<local_num_subsets;++i){
+    const int_t gid = moved_schema->subset_global_id(i);
+    if((gid+1)%num_procs!=proc_id){
+      *outStream << "Error, subset " << gid << " should not be owned by processor " << proc_id << std::endl;
+      errorFlag++;
+    }
+  }
+  for(size_t i=0;i<moved_schema->this_proc_gid_order().size();++i){
+    if(moved_schema->subset_local_id(moved_schema->this_proc_gid_order()[i])<0){
+      *outStream << "Error, subset " << moved_schema->this_proc_gid_order()[i] << " in the gid order is not owned by this processor" << std::endl;
+      errorFlag++;
+    }
+  }
+  for(size_t s=0;s<specs.size();++s){
+    Teuchos::RCP<MultiField> after = gather_field(moved_schema,specs[s]);
+    for(int_t i=0;i<after->get_map()->get_num_local_elements();++i){
+      if(after->local_value(i)!=before[s]->local_value(i)){
+        *outStream << "Error, field " << specs[s].get_name_label() << " of subset " << i << " changed from " << before[s]->local_value(i) <<
+            " to " << after->local_value(i) << " after the migration" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  // the next frame should give the same results as the analysis that was not moved
+  *outStream << "correlating the next frame" << std::endl;
+  Teuchos::ArrayRCP<intensity_t> next_def_intensities = shifted_image(width,height,2.1,-1.1);
+  moved_schema->set_ref_image(width,height,ref_intensities);
+  moved_schema->set_def_image(width,height,next_def_intensities);
+  schema->set_def_image(width,height,next_def_intensities);
+  moved_schema->execute_correlation();
+  schema->execute_correlation();
+  for(size_t s=0;s<specs.size();++s){
+    Teuchos::RCP<MultiField> moved_field = gather_field(moved_schema,specs[s]);
+    Teuchos::RCP<MultiField> field = gather_field(schema,specs[s]);
+    for(int_t i=0;i<field->get_map()->get_num_local_elements();++i){
+      if(std::abs(moved_field->local_value(i)-field->local_value(i))>errtol){
+        *outStream << "Error, field " << specs[s].get_name_label() << " of subset " << i << " is " << moved_field->local_value(i) <<
+            " after the migration but " << field->local_value(i) << " without it" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+  // sanity check that the correlation found the shift
+  Teuchos::RCP<MultiField> disp_x = gather_field(schema,SUBSET_DISPLACEMENT_X_FS);
+  Teuchos::RCP<MultiField> disp_y = gather_field(schema,SUBSET_DISPLACEMENT_Y_FS);
+  for(int_t i=0;i<disp_x->get_map()->get_num_local_elements();++i){
+    if(std::abs(disp_x->local_value(i)-2.1)>0.05||std::abs(disp_y->local_value(i)+1.1)>0.05){
+      *outStream << "Error, subset " << i << " displacement " << disp_x->local_value(i) << " " << disp_y->local_value(i) <<
+          " should be 2.1 -1.1" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
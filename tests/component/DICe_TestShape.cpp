@@ -168,6 +168,115 @@ int main(int argc, char *argv[]) {
   DICe::Image small_skin_image(imgW,imgW,small_skin_intensities);
   small_skin_image.write("shape_small_skin.tif");
 
+  *outStream << "testing the rasterized pixel masks" << std::endl;
+  DICe::Pixel_Mask ref_mask;
+  poly1->rasterize(ref_mask);
+  DICe::Pixel_Mask def_mask;
+  poly1->rasterize(def_mask,shape_function,cx,cy);
+  // the masks are built from the owned pixels so they should match them exactly
+  for(ref_set_it = ref_owned_pixels.begin();ref_set_it!=ref_owned_pixels.end();++ref_set_it){
+    if(!ref_mask(ref_set_it->second,ref_set_it->first)){
+      *outStream << "Error, reference mask is missing pixel " << ref_set_it->second << " " << ref_set_it->first << std::endl;
+      errorFlag++;
+    }
+  }
+  for(def_set_it = def_owned_pixels.begin();def_set_it!=def_owned_pixels.end();++def_set_it){
+    if(!def_mask(def_set_it->second,def_set_it->first)){
+      *outStream << "Error, deformed mask is missing pixel " << def_set_it->second << " " << def_set_it->first << std::endl;
+      errorFlag++;
+    }
+  }
+  *outStream << "the reference mask has " << ref_mask.num_flagged() << " pixels" << std::endl;
+  if(ref_mask.num_flagged()!=def_mask.num_flagged()){
+    *outStream << "Error, the reference and deformed masks should have the same number of pixels" << std::endl;
+    errorFlag++;
+  }
+  if(ref_mask.num_flagged()!=(int_t)ref_owned_pixels.size()||def_mask.num_flagged()!=(int_t)def_owned_pixels.size()){
+    *outStream << "Error, the masks do not have the same number of pixels as the owned pixels" << std::endl;
+    errorFlag++;
+  }
+  if(def_mask(cx+u,cy+v)==false||def_mask(cx,cy)==true||def_mask(-1,-1)==true){
+    *outStream << "Error, deformed mask is not right" << std::endl;
+    errorFlag++;
+  }
+  // reusing the mask after a clear
+  def_mask.clear();
+  if(!def_mask.empty()||def_mask.num_flagged()!=0){
+    *outStream << "Error, the mask should be empty after clear()" << std::endl;
+    errorFlag++;
+  }
+  poly1->rasterize(def_mask,shape_function,cx,cy);
+  if(def_mask.num_flagged()!=ref_mask.num_flagged()){
+    *outStream << "Error, the reused mask has the wrong number of pixels" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the owned pixel spans" << std::endl;
+  std::vector<Pixel_Span> ref_spans;
+  poly1->get_owned_spans(ref_spans);
+  if(num_pixels_in_spans(ref_spans)!=(int_t)ref_owned_pixels.size()){
+    *outStream << "Error, the reference spans have the wrong number of pixels" << std::endl;
+    errorFlag++;
+  }
+  for(ref_set_it = ref_owned_pixels.begin();ref_set_it!=ref_owned_pixels.end();++ref_set_it){
+    if(!spans_contain(ref_spans,ref_set_it->second,ref_set_it->first)){
+      *outStream << "Error, pixel " << ref_set_it->second << " " << ref_set_it->first << " is missing from the spans" << std::endl;
+      errorFlag++;
+    }
+  }
+  // a shape that overlaps the polygon should give merged spans with the union of the pixels
+  multi_shape shapes;
+  shapes.push_back(poly1);
+  shapes.push_back(Teuchos::rcp(new DICe::Circle(110,100,15)));
+  std::vector<Pixel_Span> union_spans;
+  get_owned_spans(shapes,union_spans);
+  std::set<std::pair<int_t,int_t> > union_pixels = ref_owned_pixels;
+  std::set<std::pair<int_t,int_t> > circle_pixels = shapes[1]->get_owned_pixels();
+  union_pixels.insert(circle_pixels.begin(),circle_pixels.end());
+  *outStream << "the union of the shapes has " << num_pixels_in_spans(union_spans) << " pixels" << std::endl;
+  if(num_pixels_in_spans(union_spans)!=(int_t)union_pixels.size()){
+    *outStream << "Error, the union spans have the wrong number of pixels" << std::endl;
+    errorFlag++;
+  }
+  for(size_t i=1;i<union_spans.size();++i){
+    if(union_spans[i].y==union_spans[i-1].y&&union_spans[i].x_begin<=union_spans[i-1].x_end){
+      *outStream << "Error, the union spans are not merged" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "testing the conformal mask" << std::endl;
+  // the mask should flag exactly the owned pixels of the boundary shapes minus those of the excluded area
+  multi_shape mask_boundary;
+  mask_boundary.push_back(poly1);
+  mask_boundary.push_back(Teuchos::rcp(new DICe::Circle(50,50,12)));
+  mask_boundary.push_back(Teuchos::rcp(new DICe::Circle(160,40,2))); // small enough to have one pixel spans
+  multi_shape mask_excluded;
+  mask_excluded.push_back(Teuchos::rcp(new DICe::Circle(100,100,6)));
+  Conformal_Area_Def mask_area_def(mask_boundary,mask_excluded);
+  std::set<std::pair<int_t,int_t> > mask_pixels;
+  for(size_t i=0;i<mask_boundary.size();++i){
+    std::set<std::pair<int_t,int_t> > shape_pixels = mask_boundary[i]->get_owned_pixels();
+    mask_pixels.insert(shape_pixels.begin(),shape_pixels.end());
+  }
+  std::set<std::pair<int_t,int_t> > excluded_pixels = mask_excluded[0]->get_owned_pixels();
+  for(ref_set_it=excluded_pixels.begin();ref_set_it!=excluded_pixels.end();++ref_set_it)
+    mask_pixels.erase(*ref_set_it);
+  DICe::Image mask_image(imgW,imgW,Teuchos::ArrayRCP<intensity_t>(imgW*imgW,1.0));
+  mask_image.create_mask(mask_area_def,false);
+  int_t num_mask_errors = 0;
+  for(int_t y=0;y<imgW;++y){
+    for(int_t x=0;x<imgW;++x){
+      const scalar_t expected = mask_pixels.find(std::pair<int_t,int_t>(y,x))!=mask_pixels.end() ? 1.0 : 0.0;
+      if(mask_image.mask(x,y)!=expected) num_mask_errors++;
+    }
+  }
+  *outStream << "the mask has " << mask_pixels.size() << " active pixels and " << num_mask_errors << " differences from the owned pixels" << std::endl;
+  if(num_mask_errors!=0){
+    *outStream << "Error, the mask does not match the owned pixels of the area definition" << std::endl;
+    errorFlag++;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
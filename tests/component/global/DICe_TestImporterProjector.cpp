@@ -0,0 +1,195 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe.h>
+#include <DICe_MeshIOUtils.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+
+using namespace DICe;
+
+/// linear fields used as the source data, the projection should reproduce them exactly
+scalar_t field_x(const scalar_t & x, const scalar_t & y){
+  return 0.5 + 0.02*x - 0.03*y;
+}
+scalar_t field_y(const scalar_t & x, const scalar_t & y){
+  return -1.0 + 0.01*x + 0.04*y;
+}
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  // the field values are O(1) and the MLS weights amplify the rounding error of a float scalar_t
+#ifdef DICE_USE_DOUBLE
+  const scalar_t tol = 1.0E-6;
+#else
+  const scalar_t tol = 1.0E-4;
+#endif
+
+  // scattered source points with a linear displacement field
+  *outStream << "writing the source and target files" << std::endl;
+  std::mt19937 generator(12345);
+  std::uniform_real_distribution<scalar_t> distribution(0.0,100.0);
+  const int_t num_source_pts = 400;
+  std::vector<scalar_t> source_x(num_source_pts);
+  std::vector<scalar_t> source_y(num_source_pts);
+  std::ofstream source_file("importer_source.txt");
+  source_file << std::setprecision(16);
+  source_file << "COORDINATE_X,COORDINATE_Y,SUBSET_DISPLACEMENT_X,SUBSET_DISPLACEMENT_Y" << std::endl;
+  for(int_t i=0;i<num_source_pts;++i){
+    source_x[i] = distribution(generator);
+    source_y[i] = distribution(generator);
+    source_file << source_x[i] << "," << source_y[i] << "," << field_x(source_x[i],source_y[i]) << "," << field_y(source_x[i],source_y[i]) << std::endl;
+  }
+  source_file.close();
+  // target points on a grid inside the cloud of source points
+  std::vector<scalar_t> target_x;
+  std::vector<scalar_t> target_y;
+  std::ofstream target_file("importer_target.txt");
+  target_file << std::setprecision(16);
+  for(scalar_t y=10.0;y<=90.0;y+=8.0){
+    for(scalar_t x=10.0;x<=90.0;x+=8.0){
+      target_x.push_back(x);
+      target_y.push_back(y);
+      target_file << x << " " << y << std::endl;
+    }
+  }
+  target_file.close();
+  const int_t num_target_pts = target_x.size();
+
+  *outStream << "projecting a linear field from scattered points" << std::endl;
+  DICe::mesh::Importer_Projector importer("importer_source.txt","importer_target.txt");
+  if(importer.num_source_pts()!=num_source_pts||importer.num_target_pts()!=num_target_pts){
+    *outStream << "Error, wrong number of source or target points" << std::endl;
+    errorFlag++;
+  }
+  else{
+    std::vector<scalar_t> disp_x;
+    std::vector<scalar_t> disp_y;
+    importer.import_vector_field("importer_source.txt","SUBSET_DISPLACEMENT",disp_x,disp_y);
+    scalar_t max_error = 0.0;
+    for(int_t i=0;i<num_target_pts;++i){
+      max_error = std::max(max_error,std::abs(disp_x[i]-field_x(target_x[i],target_y[i])));
+      max_error = std::max(max_error,std::abs(disp_y[i]-field_y(target_x[i],target_y[i])));
+    }
+    *outStream << "max projection error: " << max_error << std::endl;
+    if(max_error>tol){
+      *outStream << "Error, the projected field does not match the analytic values" << std::endl;
+      errorFlag++;
+    }
+    // fields already in memory use the same weights
+    std::vector<scalar_t> source_field(num_source_pts);
+    for(int_t i=0;i<num_source_pts;++i)
+      source_field[i] = field_x(source_x[i],source_y[i]);
+    std::vector<scalar_t> target_field;
+    importer.project_field(source_field,target_field);
+    max_error = 0.0;
+    for(int_t i=0;i<num_target_pts;++i)
+      max_error = std::max(max_error,std::abs(target_field[i]-field_x(target_x[i],target_y[i])));
+    if(max_error>tol){
+      *outStream << "Error, the projected in-memory field does not match the analytic values" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "testing the copy path for colocated points" << std::endl;
+  DICe::mesh::Importer_Projector copy_importer("importer_source.txt","importer_source.txt");
+  std::vector<scalar_t> copy_x;
+  std::vector<scalar_t> copy_y;
+  copy_importer.import_vector_field("importer_source.txt","SUBSET_DISPLACEMENT",copy_x,copy_y);
+  bool copy_error = (int_t)copy_x.size()!=num_source_pts||(int_t)copy_y.size()!=num_source_pts;
+  for(int_t i=0;i<num_source_pts&&!copy_error;++i){
+    copy_error = std::abs(copy_x[i]-field_x(source_x[i],source_y[i]))>tol
+        || std::abs(copy_y[i]-field_y(source_x[i],source_y[i]))>tol;
+  }
+  if(copy_error){
+    *outStream << "Error, the copied field does not match the source values" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the cache key" << std::endl;
+  if(!importer.matches("importer_source.txt",target_x,target_y)){
+    *outStream << "Error, the importer should match its own source file and target points" << std::endl;
+    errorFlag++;
+  }
+  std::vector<scalar_t> moved_x = target_x;
+  moved_x[0] += 1.0;
+  if(importer.matches("importer_source.txt",moved_x,target_y)){
+    *outStream << "Error, the importer should not match target points that have moved" << std::endl;
+    errorFlag++;
+  }
+  if(importer.matches("importer_other.txt",target_x,target_y)){
+    *outStream << "Error, the importer should not match a different source file" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
+
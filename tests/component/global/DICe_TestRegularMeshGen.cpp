@@ -155,6 +155,45 @@ int main(int argc, char *argv[]) {
   }
   *outStream << "mesh has been tested for correctness" << std::endl;
 
+  *outStream << "testing the asynchronous exodus output" << std::endl;
+  Teuchos::RCP<DICe::mesh::Mesh> async_mesh =
+      DICe::generate_regular_tri_mesh(DICe::mesh::TRI6,begin_x,end_x,begin_y,end_y,h,dirichlet_sides,neumann_sides,"regular_tri_mesh_async.e");
+  async_mesh->create_field(DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+  DICe::mesh::create_output_exodus_file(async_mesh,"./");
+  DICe::mesh::create_exodus_output_variable_names(async_mesh);
+  MultiField & disp_x = *async_mesh->get_field(DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+  const int_t num_steps = 6;
+  for(int_t step=1;step<=num_steps;++step){
+    for(int_t i=0;i<num_nodes;++i)
+      disp_x.local_value(i) = 100.0*step + i;
+    // the field is changed right after the call returns so the queued steps must be copies,
+    // step 4 is written synchronously to check that the queued steps are written first
+    if(step==4)
+      DICe::mesh::exodus_output_dump(async_mesh,step,step);
+    else
+      DICe::mesh::exodus_output_dump_async(async_mesh,step,step,2);
+  }
+  DICe::mesh::close_exodus_output(async_mesh);
+  const std::string async_file_name = "./" + async_mesh->get_output_filename();
+  if(DICe::mesh::read_exodus_num_steps(async_file_name)!=num_steps){
+    *outStream << "Error, wrong number of steps in the asynchronous output file" << std::endl;
+    errorFlag++;
+  }
+  else{
+    for(int_t step=1;step<=num_steps;++step){
+      std::vector<scalar_t> values = DICe::mesh::read_exodus_field(async_file_name,
+        DICe::tostring(DICe::field_enums::SUBSET_DISPLACEMENT_X),step);
+      bool step_error = (int_t)values.size()!=num_nodes;
+      for(size_t i=0;i<values.size()&&!step_error;++i)
+        step_error = std::abs(values[i] - (100.0*step + i)) > 1.0E-3;
+      if(step_error){
+        *outStream << "Error, the values read back for step " << step << " are not correct" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+  *outStream << "asynchronous exodus output has been tested" << std::endl;
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
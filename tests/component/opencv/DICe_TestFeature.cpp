@@ -41,15 +41,30 @@
 #include <DICe.h>
 #include <DICe_Image.h>
 #include <DICe_Feature.h>
+#include <DICe_Schema.h>
+#include <DICe_Initializer.h>
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_ParameterList.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using namespace DICe;
 
+/// feature matching initializer that gives the test access to the cached features
+class Test_Feature_Matching_Initializer : public Feature_Matching_Initializer{
+public:
+  Test_Feature_Matching_Initializer(Schema * schema):
+    Feature_Matching_Initializer(schema){};
+  const Image_Features & prev_features()const{return prev_features_;}
+  const Image_Features & def_features()const{return def_features_;}
+  const std::vector<scalar_t> & u()const{return u_;}
+  const std::vector<scalar_t> & v()const{return v_;}
+};
+
 int main(int argc, char *argv[]) {
 
   DICe::initialize(argc, argv);
@@ -99,6 +114,141 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  *outStream << "testing the conversion of an image to an opencv Mat" << std::endl;
+  cv::Mat left_mat = opencv_32FC1(left_img);
+  if(left_mat.cols!=left_img->width()||left_mat.rows!=left_img->height()){
+    errorFlag++;
+    *outStream << "Error, the Mat dimensions do not match the image" << std::endl;
+  }
+  bool mat_values_error = false;
+  for(int_t y=0;y<left_img->height();++y){
+    for(int_t x=0;x<left_img->width();++x){
+      if(std::abs(left_mat.at<float>(y,x) - (*left_img)(x,y)) > 1.0E-4)
+        mat_values_error = true;
+    }
+  }
+  if(mat_values_error){
+    errorFlag++;
+    *outStream << "Error, the Mat intensity values do not match the image" << std::endl;
+  }
+  cv::Mat left_mat_coarse = opencv_32FC1(left_img,2);
+  if(left_mat_coarse.cols!=(left_img->width()+3)/4||left_mat_coarse.rows!=(left_img->height()+3)/4){
+    errorFlag++;
+    *outStream << "Error, the downsampled Mat dimensions are wrong: " << left_mat_coarse.cols << " x " << left_mat_coarse.rows << std::endl;
+  }
+
+  *outStream << "testing feature detection restricted to a region" << std::endl;
+  Image_Features all_features;
+  detect_features(left_img,all_features,tol);
+  const Extents roi(left_img->width()/4,left_img->height()/4,left_img->width()/2,left_img->height()/2);
+  Image_Features roi_features;
+  detect_features(left_img,roi_features,tol,roi);
+  *outStream << "features in the whole image " << all_features.keypoints_.size() << " in the region " << roi_features.keypoints_.size() << std::endl;
+  if(roi_features.offset_x_!=roi.origin_x_||roi_features.offset_y_!=roi.origin_y_){
+    errorFlag++;
+    *outStream << "Error, the region features have the wrong offsets " << roi_features.offset_x_ << " " << roi_features.offset_y_ << std::endl;
+  }
+  if(roi_features.empty()||roi_features.keypoints_.size()>=all_features.keypoints_.size()||
+      roi_features.descriptors_.rows!=(int)roi_features.keypoints_.size()){
+    errorFlag++;
+    *outStream << "Error, the region should have fewer features than the whole image (and one descriptor per feature)" << std::endl;
+  }
+  for(size_t i=0;i<roi_features.keypoints_.size();++i){
+    const scalar_t x = roi_features.keypoints_[i].pt.x + roi_features.offset_x_;
+    const scalar_t y = roi_features.keypoints_[i].pt.y + roi_features.offset_y_;
+    if(x<roi.origin_x_||x>roi.origin_x_+roi.width_||y<roi.origin_y_||y>roi.origin_y_+roi.height_){
+      errorFlag++;
+      *outStream << "Error, feature (" << x << "," << y << ") is outside of the detection region" << std::endl;
+      break;
+    }
+  }
+
+  *outStream << "testing approximate (LSH) matching against brute force on the whole image" << std::endl;
+  Image_Features all_right_features;
+  detect_features(right_img,all_right_features,tol);
+  std::vector<scalar_t> bf_left_x;
+  std::vector<scalar_t> bf_left_y;
+  std::vector<scalar_t> bf_right_x;
+  std::vector<scalar_t> bf_right_y;
+  match_features(all_features,all_right_features,bf_left_x,bf_left_y,bf_right_x,bf_right_y,-1);
+  // a threshold of zero forces the approximate matcher for any number of features
+  std::vector<scalar_t> lsh_left_x;
+  std::vector<scalar_t> lsh_left_y;
+  std::vector<scalar_t> lsh_right_x;
+  std::vector<scalar_t> lsh_right_y;
+  match_features(all_features,all_right_features,lsh_left_x,lsh_left_y,lsh_right_x,lsh_right_y,0);
+  *outStream << "keypoints " << all_features.keypoints_.size() << " brute force matches " << bf_left_x.size() << " LSH matches " << lsh_left_x.size() << std::endl;
+  if((int_t)bf_left_x.size()!=num_matches){
+    errorFlag++;
+    *outStream << "Error, brute force matching of the detected features should give the same matches as the image based matching" << std::endl;
+  }
+  // the approximate search can miss a few neighbors, but the matches it finds must be the same correct matches
+  if(lsh_left_x.size()<0.9*bf_left_x.size()){
+    errorFlag++;
+    *outStream << "Error, the LSH matcher found too few matches" << std::endl;
+  }
+  int_t num_lsh_errors = 0;
+  for(size_t i=0;i<lsh_left_x.size();++i){
+    if(std::abs(lsh_right_x[i] - lsh_left_x[i] - 160) > errorTol || std::abs(lsh_right_y[i] - lsh_left_y[i] - 140) > errorTol)
+      num_lsh_errors++;
+  }
+  if(num_lsh_errors>0){
+    errorFlag++;
+    *outStream << "Error, " << num_lsh_errors << " LSH matches do not have the correct displacement" << std::endl;
+  }
+
+  *outStream << "testing the reuse of the cached features by the feature matching initializer" << std::endl;
+  // subsets in the middle of the image
+  std::vector<scalar_t> subset_xs;
+  std::vector<scalar_t> subset_ys;
+  for(int_t y=left_img->height()/3;y<=2*left_img->height()/3;y+=50){
+    for(int_t x=left_img->width()/3;x<=2*left_img->width()/3;x+=50){
+      subset_xs.push_back(x);
+      subset_ys.push_back(y);
+    }
+  }
+  Teuchos::ArrayRCP<scalar_t> coords_x(subset_xs.size(),0.0);
+  Teuchos::ArrayRCP<scalar_t> coords_y(subset_ys.size(),0.0);
+  for(size_t i=0;i<subset_xs.size();++i){
+    coords_x[i] = subset_xs[i];
+    coords_y[i] = subset_ys[i];
+  }
+  Teuchos::RCP<Schema> schema = Teuchos::rcp(new Schema(coords_x,coords_y,31,Teuchos::null,Teuchos::null,Teuchos::null));
+  schema->set_ref_image(left_img);
+  schema->set_def_image(right_img);
+  Test_Feature_Matching_Initializer initializer(schema.get());
+  initializer.pre_execution_tasks();
+  scalar_t max_error = 0.0;
+  for(size_t i=0;i<initializer.u().size();++i)
+    max_error = std::max(max_error,std::max(std::abs(initializer.u()[i]-160),std::abs(initializer.v()[i]-140)));
+  *outStream << "frame 1 matches " << initializer.u().size() << " max displacement error " << max_error << std::endl;
+  if(initializer.u().empty()||max_error > errorTol){
+    errorFlag++;
+    *outStream << "Error, the initializer displacements are wrong for frame 1" << std::endl;
+  }
+  // holding a reference to the cached descriptors means that detecting them again would allocate a new buffer
+  const cv::Mat cached_descriptors = initializer.prev_features().descriptors_;
+  if(cached_descriptors.empty()){
+    errorFlag++;
+    *outStream << "Error, the features of frame 1 should be cached" << std::endl;
+  }
+  // the same image again, so the displacements from frame 1 to frame 2 are zero
+  schema->set_def_image(right_img);
+  initializer.pre_execution_tasks();
+  max_error = 0.0;
+  for(size_t i=0;i<initializer.u().size();++i)
+    max_error = std::max(max_error,std::max(std::abs(initializer.u()[i]),std::abs(initializer.v()[i])));
+  *outStream << "frame 2 matches " << initializer.u().size() << " max displacement error " << max_error << std::endl;
+  if(initializer.u().empty()||max_error > errorTol){
+    errorFlag++;
+    *outStream << "Error, the initializer displacements are wrong for frame 2" << std::endl;
+  }
+  // after frame 2 the features used as the previous frame's have been swapped out
+  if(initializer.def_features().descriptors_.data!=cached_descriptors.data){
+    errorFlag++;
+    *outStream << "Error, the features of frame 1 were detected again instead of being reused in frame 2" << std::endl;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -0,0 +1,85 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_BinaryToText.cpp
+    \brief Utility for converting a binary results file to the text output files
+*/
+
+#include <DICe.h>
+#include <DICe_BinaryOutput.h>
+
+#include <Teuchos_RCP.hpp>
+
+#include <cassert>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  /// usage ./DICe_BinaryToText <binary_file_name> [output_folder]
+
+  DICe::initialize(argc, argv);
+
+  Teuchos::RCP<std::ostream> outStream = Teuchos::rcp(&std::cout, false);
+
+  if(argc>=2){
+    std::string help = argv[1];
+    if(help=="-h"||argc>3){
+      std::cout << " DICe_BinaryToText (writes the text output files for a binary results file) " << std::endl;
+      std::cout << " Syntax: DICe_BinaryToText <binary_file_name> [output_folder (with trailing slash)]" << std::endl;
+      exit(0);
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(argc!=2&&argc!=3,std::runtime_error,"Error, wrong number of input arguments");
+
+  const std::string fileName = argv[1];
+  const std::string outputFolder = argc==3 ? argv[2] : "";
+  *outStream << "Binary file name: " << fileName << std::endl;
+  *outStream << "Output folder:    " << (outputFolder.empty() ? "./" : outputFolder) << std::endl;
+
+  DICe::convert_binary_output_to_text(fileName,outputFolder);
+
+  *outStream << "\nText files written successfully\n" << std::endl;
+
+  DICe::finalize();
+
+  return 0;
+}
@@ -39,6 +39,7 @@
 // ************************************************************************
 // @HEADER
 
+
 /*! \file  DICe_CineToTiff.cpp
     \brief Utility for exporting cine files to tiff files
 */
@@ -47,17 +48,256 @@
 #include <DICe_Parser.h>
 #include <DICe_Image.h>
 #include <DICe_Cine.h>
+#ifdef DICE_ENABLE_NETCDF
+#include <DICe_NetCDF.h>
+#endif
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_oblackholestream.hpp>
 
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 using namespace DICe;
 
+/// \class Cine_Transcoder
+/// \brief Converts a range of cine frames on a pool of threads
+///
+/// One thread decodes the frames from the cine file in order, the encoder threads
+/// rotate them and (if file names are given) write each one to its own file. The frames are
+/// handed back to the caller in order by next() so that a stack file can be written sequentially.
+/// At most two frames per encoder thread are held in memory at a time. The threads create Teuchos::RCPs,
+/// which is not safe if the RCP node tracing of a Teuchos debug build is active, in that case no threads
+/// are started and next() decodes, rotates and writes each frame on the calling thread.
+class Cine_Transcoder{
+public:
+  /// \brief constructor, starts the threads
+  /// \param cine_reader the reader for the cine file (only used by the decoding thread)
+  /// \param start_frame the first frame to convert
+  /// \param end_frame the last frame to convert (inclusive)
+  /// \param rotation the rotation to apply to each frame
+  /// \param file_names the output file name for each frame (empty if the frames are only returned by next())
+  /// \param num_threads the number of encoder threads
+  Cine_Transcoder(Teuchos::RCP<cine::Cine_Reader> cine_reader,
+    const int_t start_frame,
+    const int_t end_frame,
+    const Rotation_Value rotation,
+    const std::vector<std::string> & file_names,
+    const int_t num_threads):
+    cine_reader_(cine_reader.get()),
+    start_frame_(start_frame),
+    rotation_(rotation),
+    file_names_(file_names),
+    max_ahead_(2*num_threads),
+    frames_(end_frame-start_frame+1),
+    next_to_encode_(0),
+    next_to_consume_(0),
+    shutdown_(false){
+    TEUCHOS_TEST_FOR_EXCEPTION(cine_reader==Teuchos::null,std::runtime_error,"");
+    TEUCHOS_TEST_FOR_EXCEPTION(end_frame<start_frame,std::runtime_error,"Error, invalid frame range");
+    TEUCHOS_TEST_FOR_EXCEPTION(!file_names.empty()&&(int_t)file_names.size()!=num_frames(),std::runtime_error,"");
+    TEUCHOS_TEST_FOR_EXCEPTION(num_threads<=0,std::runtime_error,"Error, invalid number of threads " << num_threads);
+    // the node tracing adds every new RCP to a global table without a lock
+    if(Teuchos::RCPNodeTracer::isTracingActiveRCPNodes()){
+      DEBUG_MSG("Cine_Transcoder::Cine_Transcoder(): RCP node tracing is active, converting the frames on the calling thread");
+      return;
+    }
+    threads_.push_back(std::thread(&Cine_Transcoder::decode_loop,this));
+    for(int_t i=0;i<num_threads;++i)
+      threads_.push_back(std::thread(&Cine_Transcoder::encode_loop,this));
+  }
+
+  /// destructor, stops and joins the threads
+  ~Cine_Transcoder(){
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      shutdown_ = true;
+      cond_.notify_all();
+    }
+    for(size_t i=0;i<threads_.size();++i)
+      threads_[i].join();
+  }
+
+  /// returns the number of frames to convert
+  int_t num_frames()const{
+    return frames_.size();
+  }
+
+  /// returns the next frame in order (after rotation), waits for it if it has not been encoded yet
+  Teuchos::RCP<Image> next(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    TEUCHOS_TEST_FOR_EXCEPTION(next_to_consume_>=num_frames(),std::runtime_error,"Error, all the frames have been converted");
+    if(threads_.empty()){
+      // no threads (see the constructor), convert the frame here
+      const int_t frame_id = next_to_consume_++;
+      return encode_frame(frame_id,decode_frame(frame_id));
+    }
+    const int_t frame_id = next_to_consume_;
+    cond_.wait(lock,[this,frame_id]{return frames_[frame_id].encoded||!error_msg_.empty();});
+    TEUCHOS_TEST_FOR_EXCEPTION(!frames_[frame_id].encoded,std::runtime_error,
+      "Error, converting the cine frames failed for " << error_msg_);
+    Teuchos::RCP<Image> image = frames_[frame_id].image;
+    // release the frame so the memory can be reclaimed
+    frames_[frame_id] = Frame();
+    next_to_consume_++;
+    cond_.notify_all();
+    return image;
+  }
+
+private:
+  /// state of a frame in the pipeline
+  struct Frame{
+    Frame():decoded(false),encoded(false){};
+    bool decoded;
+    bool encoded;
+    /// intensities read from the cine file
+    Teuchos::ArrayRCP<intensity_t> intensities;
+    /// the rotated image (only kept if the frames are not written to file by the encoders)
+    Teuchos::RCP<Image> image;
+  };
+
+  /// read the intensities of a frame from the cine file
+  Teuchos::ArrayRCP<intensity_t> decode_frame(const int_t frame_id){
+    const int_t width = cine_reader_->width();
+    const int_t height = cine_reader_->height();
+    Teuchos::ArrayRCP<intensity_t> intensities(width*height,0.0);
+    cine_reader_->get_frame(0,0,width,height,intensities.getRawPtr(),true,
+      start_frame_+frame_id-cine_reader_->first_image_number(),false,true);
+    return intensities;
+  }
+
+  /// rotate a frame and write it to file, returns the rotated image (null if it was written to file)
+  Teuchos::RCP<Image> encode_frame(const int_t frame_id,
+    Teuchos::ArrayRCP<intensity_t> intensities){
+    Teuchos::RCP<Image> image = Teuchos::rcp(new Image(cine_reader_->width(),cine_reader_->height(),intensities));
+    intensities = Teuchos::null;
+    if(rotation_!=ZERO_DEGREES)
+      image = image->apply_rotation(rotation_);
+    if(!file_names_.empty()){
+      image->write(file_names_[frame_id]);
+      image = Teuchos::null;
+    }
+    return image;
+  }
+
+  /// loop run by the decoding thread
+  void decode_loop(){
+    for(int_t frame_id=0;frame_id<num_frames();++frame_id){
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock,[this,frame_id]{return shutdown_||!error_msg_.empty()||frame_id<next_to_consume_+max_ahead_;});
+        if(shutdown_||!error_msg_.empty()) return;
+      }
+      Teuchos::ArrayRCP<intensity_t> intensities;
+      try{
+        intensities = decode_frame(frame_id);
+      }
+      catch(std::exception & e){
+        set_error(frame_id,e.what());
+        return;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      frames_[frame_id].intensities = intensities;
+      frames_[frame_id].decoded = true;
+      // drop this thread's reference while holding the lock, an encoder takes over the intensities from here
+      intensities = Teuchos::null;
+      cond_.notify_all();
+    }
+  }
+
+  /// loop run by each encoder thread
+  void encode_loop(){
+    while(true){
+      int_t frame_id = -1;
+      Teuchos::ArrayRCP<intensity_t> intensities;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock,[this]{return shutdown_||!error_msg_.empty()||next_to_encode_>=num_frames()||
+          frames_[next_to_encode_].decoded;});
+        if(shutdown_||!error_msg_.empty()||next_to_encode_>=num_frames()) break;
+        frame_id = next_to_encode_++;
+        intensities = frames_[frame_id].intensities;
+        frames_[frame_id].intensities = Teuchos::null;
+      }
+      Teuchos::RCP<Image> image;
+      try{
+        image = encode_frame(frame_id,intensities);
+        intensities = Teuchos::null;
+      }
+      catch(std::exception & e){
+        set_error(frame_id,e.what());
+        break;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      frames_[frame_id].image = image;
+      frames_[frame_id].encoded = true;
+      // drop this thread's reference while holding the lock, the caller takes over the image from here
+      image = Teuchos::null;
+      cond_.notify_all();
+    }
+  }
+
+  /// record an error from one of the threads, the caller throws it from next()
+  void set_error(const int_t frame_id,
+    const std::string & what){
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::stringstream msg;
+    msg << "frame " << start_frame_+frame_id << ": " << what;
+    error_msg_ = msg.str();
+    cond_.notify_all();
+  }
+
+  /// the cine reader (held by the caller for the life of the transcoder)
+  cine::Cine_Reader * cine_reader_;
+  /// the first frame to convert
+  int_t start_frame_;
+  /// the rotation to apply
+  Rotation_Value rotation_;
+  /// output file name for each frame
+  std::vector<std::string> file_names_;
+  /// maximum number of frames decoded ahead of the one being consumed
+  int_t max_ahead_;
+  /// the frames in the pipeline
+  std::vector<Frame> frames_;
+  /// next frame to be encoded
+  int_t next_to_encode_;
+  /// next frame to be handed out
+  int_t next_to_consume_;
+  /// true when the threads should exit
+  bool shutdown_;
+  /// error message set by a thread if converting a frame failed
+  std::string error_msg_;
+  /// guards the shared state above
+  std::mutex mutex_;
+  /// signals a decoded frame, an encoded frame or a consumed frame
+  std::condition_variable cond_;
+  /// the decoding thread and the encoder threads
+  std::vector<std::thread> threads_;
+};
+
+/// parses a base 10 integer, returns false if the whole string is not a valid integer
+bool parse_integer(const std::string & str,
+  int_t & value){
+  if(str.empty()) return false;
+  char * end = NULL;
+  errno = 0;
+  const long parsed = std::strtol(str.c_str(),&end,10);
+  if(errno!=0||*end!='\0'||parsed<std::numeric_limits<int_t>::min()||parsed>std::numeric_limits<int_t>::max()) return false;
+  value = static_cast<int_t>(parsed);
+  return true;
+}
+
 int main(int argc, char *argv[]) {
 
-  /// usage ./DICe_CineToTiff <cine_file_name> <start_index> <end_index> <output_prefix>
+  /// usage ./DICe_CineToTiff <cine_file_name> <start_index> <end_index> <output_prefix> [output_suffix] [rotation] [--threads=<n>]
 
   DICe::initialize(argc, argv);
 
@@ -66,19 +306,27 @@ int main(int argc, char *argv[]) {
   std::string delimiter = " ,\r";
 
   // if the output prefix has an extension and the frame range is one frame, then the output prefix is used as the full filename
+  // if the output prefix ends in .raw or .nc all the frames are written to a single stack file
   if(argc==2){
     std::string help = argv[1];
     if(help=="-h"){
       std::cout << " DICe_CineToTiff (exports cine images to tiffs) " << std::endl;
       std::cout << " Syntax: DICe_CineToTiff <cine_file_name> <start_index (zero based)> "
-          "<end_index (zero based)> <output_prefix> [rotation, (90,180,or270, other values ignored)]" << std::endl;
+          "<end_index (zero based)> <output_prefix> [output_suffix] [rotation, (90,180,or270, other values ignored)] [--threads=<num_encoder_threads>]" << std::endl;
+      std::cout << " The suffix and rotation are positional, use \"\" for the suffix to rotate without a suffix" << std::endl;
+      std::cout << " If the output prefix ends in .raw, the frames are written to a single raw binary stack (native byte order):" << std::endl;
+      std::cout << "   char[4] \"DRAW\", uint32 version (1), uint32 width, uint32 height, uint32 bytes per value (1), uint32 num frames," << std::endl;
+      std::cout << "   then the 8 bit intensity values (uint8) row by row, frame by frame" << std::endl;
+#ifdef DICE_ENABLE_NETCDF
+      std::cout << " If the output prefix ends in .nc, the frames are written to a single NetCDF file as time steps of the variable \"data\"" << std::endl;
+#endif
       exit(0);
     }
   }
 
   if(argc < 5) {
-      printf("four input arguments are required, last two are optional "
-          "<cine_file_name> <start_index> <end_index> <output_prefix> [output_suffix] [rotation]\n");
+      printf("four input arguments are required, last three are optional "
+          "<cine_file_name> <start_index> <end_index> <output_prefix> [output_suffix] [rotation] [--threads=<n>]\n");
       exit(0);
   }
 
@@ -94,17 +342,36 @@ int main(int argc, char *argv[]) {
   *outStream << "Tiff prefix: " << prefix << std::endl;
   std::string suffix = "";
   int_t rotation = 0;
-  if(argc>5){
-    for(int_t i=5;i<argc;++i){
-      if(is_number(argv[i])){
-        rotation = std::stoi(argv[5]);
-        *outStream << "User requested image roation by " << rotation << " degrees" << std::endl;
-      }
-      else{
-        suffix = argv[i];
-        *outStream << "Tiff suffix: " << suffix << std::endl;
+  int_t num_threads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+  const std::string threads_option("--threads=");
+  // the optional suffix and rotation are positional (in that order), the threads option can be anywhere after the prefix
+  std::vector<std::string> positional_args;
+  for(int_t i=5;i<argc;++i){
+    const std::string arg = argv[i];
+    if(arg.compare(0,threads_option.size(),threads_option)==0){
+      if(!parse_integer(arg.substr(threads_option.size()),num_threads)){
+        std::cout << "Error, invalid number of threads: " << arg << std::endl;
+        exit(1);
       }
+      if(num_threads<1) num_threads = 1;
     }
+    else
+      positional_args.push_back(arg);
+  }
+  if(positional_args.size()>2){
+    std::cout << "Error, too many arguments, expected at most [output_suffix] [rotation] after the output prefix" << std::endl;
+    exit(1);
+  }
+  if(positional_args.size()>0){
+    suffix = positional_args[0];
+    *outStream << "Tiff suffix: " << suffix << std::endl;
+  }
+  if(positional_args.size()>1){
+    if(!parse_integer(positional_args[1],rotation)){
+      std::cout << "Error, invalid rotation: " << positional_args[1] << std::endl;
+      exit(1);
+    }
+    *outStream << "User requested image roation by " << rotation << " degrees" << std::endl;
   }
 
   Teuchos::RCP<DICe::cine::Cine_Reader> cine_reader  =  Teuchos::rcp(new DICe::cine::Cine_Reader(fileName,outStream.getRawPtr()));
@@ -128,6 +395,7 @@ int main(int argc, char *argv[]) {
   *outStream << "Start frame:    " << start_frame << std::endl;
   *outStream << "End frame:      " << end_frame << std::endl;
   *outStream << "Output frames:  " << end_frame-start_frame+1 << std::endl;
+  *outStream << "Encoder threads: " << num_threads << std::endl;
   const std::string tif("tif");
   const std::string tiff("tiff");
   bool full_output_name_given = false;
@@ -135,47 +403,107 @@ int main(int argc, char *argv[]) {
     full_output_name_given = true;
     *outStream << "Full output filename given " << std::endl;
   }
+  const std::string raw(".raw");
+  const std::string nc(".nc");
+  const bool raw_stack = prefix.size()>raw.size()&&prefix.compare(prefix.size()-raw.size(),raw.size(),raw)==0;
+  const bool netcdf_stack = prefix.size()>nc.size()&&prefix.compare(prefix.size()-nc.size(),nc.size(),nc)==0;
+#ifndef DICE_ENABLE_NETCDF
+  if(netcdf_stack){
+    std::cout << "Error, NetCDF output requires DICe to be built with NetCDF enabled" << std::endl;
+    exit(1);
+  }
+#endif
+  if(raw_stack||netcdf_stack)
+    *outStream << "Writing all frames to stack file " << prefix << std::endl;
 
-  for(int_t i=start_frame;i<=end_frame;++i){
-    int_t num_digits_total = 0;
-    int_t decrement_total = num_images;
-    int_t num_digits_frame = 0;
-    int_t decrement_subset = i;
-    while (decrement_total){decrement_total /= 10; num_digits_total++;}
-    if(i==0) num_digits_frame = 1;
-    else
-      while (decrement_subset){decrement_subset /= 10; num_digits_frame++;}
-    int_t num_zeros = num_digits_total - num_digits_frame;
-    // determine the file name for this subset
-
-    std::stringstream fName;
-    fName << prefix;
-    if(!full_output_name_given){
-      for(int_t j=0;j<num_zeros;++j)
-        fName << "0";
-      fName << i << suffix << ".tif";
-    }
-    std::stringstream cName;
-    cName << stripped_fileName << "_" << i << ".cine";
-    Teuchos::RCP<DICe::Image> image = Teuchos::rcp(new Image(cName.str().c_str()));//cine_reader->get_frame(i);
-    if(rotation!=0){
-      if(rotation==90){
-        image = image->apply_rotation(NINTY_DEGREES);
-      }else if(rotation==180){
-        image = image->apply_rotation(ONE_HUNDRED_EIGHTY_DEGREES);
-      }else if(rotation==270){
-        image = image->apply_rotation(TWO_HUNDRED_SEVENTY_DEGREES);
+  Rotation_Value rotation_value = ZERO_DEGREES;
+  if(rotation==90){
+    rotation_value = NINTY_DEGREES;
+  }else if(rotation==180){
+    rotation_value = ONE_HUNDRED_EIGHTY_DEGREES;
+  }else if(rotation==270){
+    rotation_value = TWO_HUNDRED_SEVENTY_DEGREES;
+  }
+  else if(rotation!=0){
+    std::cout << "WARNING: user requested invalid rotation: " << rotation << " must be 90, 180 or 270. Skipping image rotation" << std::endl;
+  }
+
+  std::vector<std::string> file_names;
+  if(!raw_stack&&!netcdf_stack){
+    for(int_t i=start_frame;i<=end_frame;++i){
+      int_t num_digits_total = 0;
+      int_t decrement_total = num_images;
+      int_t num_digits_frame = 0;
+      int_t decrement_subset = i;
+      while (decrement_total){decrement_total /= 10; num_digits_total++;}
+      if(i==0) num_digits_frame = 1;
+      else
+        while (decrement_subset){decrement_subset /= 10; num_digits_frame++;}
+      int_t num_zeros = num_digits_total - num_digits_frame;
+      // determine the file name for this subset
+
+      std::stringstream fName;
+      fName << prefix;
+      if(!full_output_name_given){
+        for(int_t j=0;j<num_zeros;++j)
+          fName << "0";
+        fName << i << suffix << ".tif";
       }
-      else{
-        if(i==start_frame)
-          std::cout << "WARNING: user requested invalid rotation: " << rotation << " must be 90, 180 or 270. Skipping image rotation" << std::endl;
+      file_names.push_back(fName.str());
+    }
+  }
+
+  // the frames are decoded, rotated and written by the transcoder threads,
+  // for a stack file they come back here in order and are appended to the file
+  Cine_Transcoder transcoder(cine_reader,start_frame,end_frame,rotation_value,file_names,num_threads);
+  const bool swap_dims = rotation_value==NINTY_DEGREES||rotation_value==TWO_HUNDRED_SEVENTY_DEGREES;
+  const int_t out_width = swap_dims ? image_height : image_width;
+  const int_t out_height = swap_dims ? image_width : image_height;
+  std::ofstream raw_file;
+  std::vector<uint8_t> raw_values;
+  if(raw_stack){
+    raw_file.open(prefix.c_str(),std::ofstream::out|std::ofstream::binary);
+    TEUCHOS_TEST_FOR_EXCEPTION(!raw_file.is_open(),std::runtime_error,"Error, can't open the file: " << prefix);
+    // the frames are converted to 8 bit by the decoder so the values are stored as uint8
+    const char magic[4] = {'D','R','A','W'};
+    raw_file.write(magic,4);
+    const uint32_t header[5] = {1,(uint32_t)out_width,(uint32_t)out_height,(uint32_t)sizeof(uint8_t),(uint32_t)transcoder.num_frames()};
+    raw_file.write(reinterpret_cast<const char*>(&header[0]),5*sizeof(uint32_t));
+    raw_values.resize(out_width*out_height);
+  }
+#ifdef DICE_ENABLE_NETCDF
+  Teuchos::RCP<DICe::netcdf::NetCDF_Writer> netcdf_writer;
+  std::vector<float> netcdf_values;
+  if(netcdf_stack){
+    netcdf_writer = Teuchos::rcp(new DICe::netcdf::NetCDF_Writer(prefix,out_width,out_height,transcoder.num_frames(),std::vector<std::string>(1,"data")));
+    netcdf_values.resize(out_width*out_height);
+  }
+#endif
+  for(int_t frame_id=0;frame_id<transcoder.num_frames();++frame_id){
+    Teuchos::RCP<Image> image = transcoder.next();
+    if(raw_stack){
+      Teuchos::ArrayRCP<const intensity_t> intensities = image->intensity_values();
+      for(int_t i=0;i<out_width*out_height;++i){
+        const double value = std::floor(static_cast<double>(intensities[i])+0.5);
+        raw_values[i] = value<0.0 ? 0 : value>255.0 ? 255 : static_cast<uint8_t>(value);
       }
+      raw_file.write(reinterpret_cast<const char*>(&raw_values[0]),out_width*out_height);
     }
-    image->write(fName.str());
+#ifdef DICE_ENABLE_NETCDF
+    if(netcdf_stack){
+      Teuchos::ArrayRCP<const intensity_t> intensities = image->intensity_values();
+      for(int_t i=0;i<out_width*out_height;++i)
+        netcdf_values[i] = intensities[i];
+      netcdf_writer->write_float_array("data",frame_id,netcdf_values);
+    }
+#endif
+  }
+  if(raw_stack){
+    raw_file.close();
+    TEUCHOS_TEST_FOR_EXCEPTION(raw_file.fail(),std::runtime_error,"Error, writing the file failed: " << prefix);
   }
 
   DICe::finalize();
 
   return 0;
 }
-
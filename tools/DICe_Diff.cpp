@@ -46,6 +46,7 @@
 #include <DICe.h>
 #include <DICe_Image.h>
 #include <DICe_Parser.h>
+#include <DICe_BinaryOutput.h>
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_oblackholestream.hpp>
@@ -56,6 +57,85 @@
 
 using namespace DICe;
 
+/// convert a token to a number (falls back to strtod for tokens that is_number accepts but are not strictly numeric)
+scalar_t token_value(const std::string & token){
+  scalar_t value = 0.0;
+  if(!DICe::parse_number(token.c_str(),token.c_str()+token.size(),value))
+    value = strtod(token.c_str(),NULL);
+  return value;
+}
+
+/// find the first line whose first value is a number and convert that line and all of the lines after it with read_columns()
+/// \param reader the text file
+/// \param first_line [out] index of the first numeric line
+/// \param values [out] values[i] holds column i of the numeric lines
+/// \return false if there is no numeric line or the lines after it are not all numeric with the same number of columns
+bool read_numeric_block(const DICe::Delimited_Text_Reader & reader,
+  int_t & first_line,
+  std::vector<std::vector<scalar_t> > & values){
+  values.clear();
+  for(first_line=0;first_line<reader.num_lines();++first_line){
+    const std::vector<std::string> tokens = reader.tokens(first_line,false);
+    scalar_t value = 0.0;
+    if(tokens.size()>0&&DICe::parse_number(tokens[0].c_str(),tokens[0].c_str()+tokens[0].size(),value)) break;
+  }
+  if(first_line>=reader.num_lines()) return false;
+  const int_t num_columns = reader.num_values(first_line);
+  std::vector<int_t> columns(num_columns);
+  for(int_t i=0;i<num_columns;++i)
+    columns[i] = i;
+  try{
+    reader.read_columns(first_line,columns,values,num_columns);
+  }
+  catch(std::exception &){
+    values.clear();
+    return false;
+  }
+  return true;
+}
+
+/// returns true if the value in file B differs from the gold value in file A
+bool values_differ(const scalar_t & valA,
+  const scalar_t & valB,
+  const scalar_t & relTol,
+  const scalar_t & floor,
+  const bool use_floor){
+  scalar_t diff = std::abs((valA - valB)/valA);
+  const bool tiny = (std::abs(valA) + std::abs(valB) < 1.0E-8);
+  const bool below_floor = std::abs(valA) < floor;
+  if(!below_floor||!use_floor){
+    if(!tiny && diff > relTol){
+      return true;
+    }
+  }
+  return false;
+}
+
+/// print a line that differs with the ids and types of the tokens that were flagged
+void print_line_diff(std::ostream & os,
+  const int_t line,
+  const std::vector<int_t> & badTokenIds,
+  const std::vector<std::string> & badTokenTypes,
+  const std::vector<std::string> & tokensA,
+  const std::vector<std::string> & tokensB){
+  os << "< " << line << " (";
+  for(size_t i=0;i<badTokenIds.size();++i){
+    os << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
+  }
+  os  << "): ";
+  for(size_t i=0;i<tokensA.size();++i)
+    os << tokensA[i] << " ";
+  os << std::endl;
+  os << "> " << line << " (";
+  for(size_t i=0;i<badTokenIds.size();++i){
+    os << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
+  }
+  os  << "): ";
+  for(size_t i=0;i<tokensB.size();++i)
+    os << tokensB[i] << " ";
+  os << std::endl;
+}
+
 int main(int argc, char *argv[]) {
 
   /// usage ./DICe_Diff <infileA> <infileB or base name for parallel> [-t <tol>] [-f <value>] [-v] [-n] [-p <count>]
@@ -85,6 +165,7 @@ int main(int argc, char *argv[]) {
       std::cout << "          -f <value> floor, values below the floor in the gold file will not be tested" << std::endl;
       std::cout << "          -n numerical values only" << std::endl;
       std::cout << "          -p <count> parallel output number of processors" << std::endl;
+      std::cout << " DICe binary results files (.dbin) are compared frame by frame" << std::endl;
       exit(0);
     }
   }
@@ -149,116 +230,82 @@ int main(int argc, char *argv[]) {
   *outStream << "Number of processors:  " << num_procs << std::endl;
 
   if(num_procs > 1){
-    // read all of the number line from A and store in a map
-    std::map<int_t,std::vector<std::string> > fileASolutions;
-    std::fstream dataFileA(fileA.c_str(), std::ios_base::in | std::ios_base::binary);
-    while (!dataFileA.eof())
+    // read all of the numeric lines from A and store the row of each id in a map
+    DICe::Delimited_Text_Reader readerA(fileA,delimiter);
+    int_t first_lineA = 0;
+    std::vector<std::vector<scalar_t> > valuesA;
+    TEUCHOS_TEST_FOR_EXCEPTION(!read_numeric_block(readerA,first_lineA,valuesA),std::runtime_error,
+      "Error, the lines after the header in " << fileA << " must all be numeric with the same number of values to compare parallel files");
+    std::map<int_t,int_t> fileASolutions;
+    for(size_t row=0;row<valuesA[0].size();++row)
     {
-      std::vector<std::string> tokens = DICe::tokenize_line(dataFileA,delimiter);
-      if(tokens.size()==0) continue;
-      if(!DICe::is_number(tokens[0])) continue;
       // check that the first number is an integer (presumed an id)
       // if ids have been omitted this will fail
-      const scalar_t remainder = strtod(tokens[0].c_str(),NULL) - std::floor(strtod(tokens[0].c_str(),NULL));
+      const scalar_t remainder = valuesA[0][row] - std::floor(valuesA[0][row]);
       TEUCHOS_TEST_FOR_EXCEPTION(remainder!=0.0,std::runtime_error,
         "Error, first column in the output file must be the subset or node id "
         "(cannot ommit the id in the output parameters to compare parallel files)");
-      fileASolutions.insert(std::pair<int_t,std::vector<std::string> >(std::strtol(tokens[0].c_str(),NULL,0),tokens));
+      fileASolutions.insert(std::pair<int_t,int_t>(static_cast<int_t>(valuesA[0][row]),row));
     }
-    dataFileA.close();
     // now that the offsets are set up, compare the files one processor chunk at a time
     std::set<int_t> compared_ids;
     for(int_t i=0;i<num_procs;++i){
       std::stringstream name;
       name << fileB << "." << num_procs << "." << i << ".txt";
       // read the number of lines in each file:
-      std::fstream dataFileB(name.str().c_str(), std::ios_base::in | std::ios_base::binary);
-      assert(dataFileB.good());
+      DICe::Delimited_Text_Reader readerB(name.str(),delimiter);
+      int_t first_lineB = 0;
+      std::vector<std::vector<scalar_t> > valuesB;
+      TEUCHOS_TEST_FOR_EXCEPTION(!read_numeric_block(readerB,first_lineB,valuesB),std::runtime_error,
+        "Error, the lines after the header in " << name.str() << " must all be numeric with the same number of values to compare parallel files");
+      if(valuesA.size()!=valuesB.size()){
+        *outStream << "Error, output files are not compatible (read error)" << std::endl;
+        errorFlag++;
+        continue;
+      }
       int_t par_line = 0;
-      while (!dataFileB.eof())
+      for(size_t rowB=0;rowB<valuesB[0].size();++rowB)
       {
         bool line_diff = false;
         std::vector<int_t> badTokenIds;
         std::vector<std::string> badTokenTypes;
-        std::vector<std::string> tokensB = DICe::tokenize_line(dataFileB,delimiter);
-        if(tokensB.size()==0) continue;
-        if(!DICe::is_number(tokensB[0])) continue;
-        const scalar_t remainder = strtod(tokensB[0].c_str(),NULL) - std::floor(strtod(tokensB[0].c_str(),NULL));
+        const scalar_t remainder = valuesB[0][rowB] - std::floor(valuesB[0][rowB]);
         TEUCHOS_TEST_FOR_EXCEPTION(remainder!=0.0,std::runtime_error,
           "Error, first column in the parallel output file must be the subset or node id "
           "(cannot ommit the id in the output parameters to compare parallel files)");
-        const int_t subset_id = std::strtol(tokensB[0].c_str(),NULL,0);
+        const int_t subset_id = static_cast<int_t>(valuesB[0][rowB]);
         // find that row in the saved data:
         TEUCHOS_TEST_FOR_EXCEPTION(fileASolutions.find(subset_id)==fileASolutions.end(),std::runtime_error,
           "Error could not find parallel subset " << subset_id << " in serial file");
-        std::vector<std::string> tokensA = fileASolutions.find(subset_id)->second;
+        const int_t rowA = fileASolutions.find(subset_id)->second;
         compared_ids.insert(subset_id);
-        if(tokensB.size()==0) break;
-        bool read_error = false;
-        assert(tokensA.size()!=0);
-        assert(tokensB.size()!=0);
-        read_error = !DICe::is_number(tokensA[0]);
-        read_error = !DICe::is_number(tokensB[0]);
-        read_error = tokensA.size()!=tokensB.size();
-        if(read_error){
-          *outStream << "Error, output files are not compatible (read error)" << std::endl;
-          errorFlag++;
-          break;
-        }
-        for(size_t i=0;i<tokensA.size();++i){
-          // number
-          if(DICe::is_number(tokensA[i])){
-            assert(DICe::is_number(tokensB[i]));
-            scalar_t valA = strtod(tokensA[i].c_str(),NULL);
-            scalar_t valB = strtod(tokensB[i].c_str(),NULL);
-            scalar_t diff = valA == 0.0 ? std::abs((valA - valB)/valA) : std::abs(valA - valB);
-            const bool tiny = (std::abs(valA) + std::abs(valB) < 1.0E-8);
-            const bool below_floor = std::abs(valA) < floor && valA!=0.0;
-            if(!below_floor||!use_floor){
-              if(!tiny && diff > relTol){
-                line_diff = true;
-                badTokenIds.push_back(i);
-                badTokenTypes.push_back("n");
-              }
-            }
-          }
-          // string
-          else{
-            assert(!DICe::is_number(tokensB[i]));
-            if(tokensA[i]!=tokensB[i] && !numerical_values_only)
+        for(size_t i=0;i<valuesA.size();++i){
+          scalar_t valA = valuesA[i][rowA];
+          scalar_t valB = valuesB[i][rowB];
+          scalar_t diff = valA == 0.0 ? std::abs((valA - valB)/valA) : std::abs(valA - valB);
+          const bool tiny = (std::abs(valA) + std::abs(valB) < 1.0E-8);
+          const bool below_floor = std::abs(valA) < floor && valA!=0.0;
+          if(!below_floor||!use_floor){
+            if(!tiny && diff > relTol){
               line_diff = true;
-            badTokenIds.push_back(i);
-            badTokenTypes.push_back("s");
+              badTokenIds.push_back(i);
+              badTokenTypes.push_back("n");
+            }
           }
-        } // end token iteration
+        } // end value iteration
         if(line_diff){
           errorFlag++;
-          *outStream << "< " << par_line << " (";
-          for(size_t i=0;i<badTokenIds.size();++i){
-            *outStream << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
-          }
-          *outStream  << "): ";
-          for(size_t i=0;i<tokensA.size();++i)
-            *outStream << tokensA[i] << " ";
-          *outStream << std::endl;
-          *outStream << "> " << par_line << " (";
-          for(size_t i=0;i<badTokenIds.size();++i){
-            *outStream << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
-          }
-          *outStream  << "): ";
-          for(size_t i=0;i<tokensB.size();++i)
-            *outStream << tokensB[i] << " ";
-          *outStream << std::endl;
+          // the tokens are only needed to print the lines that differ
+          print_line_diff(*outStream,par_line,badTokenIds,badTokenTypes,readerA.tokens(first_lineA+rowA),readerB.tokens(first_lineB+rowB));
         } // end line diff
         par_line++;
-      } // end dataFileB.eof() loop
+      } // end readerB line loop
       *outStream << "proc " << i << " number of lines compared " << par_line << std::endl;
       assert(par_line>0);
-      dataFileB.close();
     } // end of parallel loop
     // check that all the ids were compared
-    std::map<int_t,std::vector<std::string> >::iterator it=fileASolutions.begin();
-    std::map<int_t,std::vector<std::string> >::iterator it_end=fileASolutions.end();
+    std::map<int_t,int_t>::iterator it=fileASolutions.begin();
+    std::map<int_t,int_t>::iterator it_end=fileASolutions.end();
     bool missing_value = false;
     for(;it!=it_end;++it){
       if(compared_ids.find(it->first)==compared_ids.end())missing_value = true;
@@ -268,31 +315,81 @@ int main(int argc, char *argv[]) {
       errorFlag++;
     }
   }
+  else if(fileA.find(".dbin")!=std::string::npos){
+    // compare two binary results files frame by frame
+    DICe::Binary_Output_Reader readerA(fileA);
+    DICe::Binary_Output_Reader readerB(fileB);
+    const Binary_Output_Info & infoA = readerA.info();
+    const Binary_Output_Info & infoB = readerB.info();
+    if(readerA.num_frames()!=readerB.num_frames()||infoA.field_names!=infoB.field_names||infoA.row_ids!=infoB.row_ids){
+      *outStream << "Error, binary files are not compatible A: " << readerA.num_frames() << " frames " << infoA.field_names.size()
+          << " fields " << infoA.row_ids.size() << " rows B: " << readerB.num_frames() << " frames " << infoB.field_names.size()
+          << " fields " << infoB.row_ids.size() << " rows" << std::endl;
+      errorFlag++;
+    }
+    else{
+      const int_t num_rows = infoA.row_ids.size();
+      std::vector<scalar_t> valuesA;
+      std::vector<scalar_t> valuesB;
+      for(int_t frame=0;frame<readerA.num_frames();++frame){
+        if(readerA.frame_id(frame)!=readerB.frame_id(frame)){
+          *outStream << "Error, frame " << frame << " has id " << readerA.frame_id(frame) << " in A and " << readerB.frame_id(frame) << " in B" << std::endl;
+          errorFlag++;
+          continue;
+        }
+        readerA.read_frame(frame,valuesA);
+        readerB.read_frame(frame,valuesB);
+        for(size_t i=0;i<valuesA.size();++i){
+          const scalar_t valA = valuesA[i];
+          const scalar_t valB = valuesB[i];
+          scalar_t diff = std::abs((valA - valB)/valA);
+          const bool tiny = (std::abs(valA) + std::abs(valB) < 1.0E-8);
+          const bool below_floor = std::abs(valA) < floor;
+          if(!below_floor||!use_floor){
+            if(!tiny && diff > relTol){
+              errorFlag++;
+              *outStream << "< frame " << readerA.frame_id(frame) << " row " << infoA.row_ids[i%num_rows] << " " << infoA.field_names[i/num_rows] << ": " << valA << std::endl;
+              *outStream << "> frame " << readerB.frame_id(frame) << " row " << infoB.row_ids[i%num_rows] << " " << infoB.field_names[i/num_rows] << ": " << valB << std::endl;
+            }
+          }
+        }
+      }
+      *outStream << "number of frames compared " << readerA.num_frames() << std::endl;
+    }
+  }
   else{
     // read the two files line by line and compare both
     // (white space is ignored)
-    std::fstream dataFileA(fileA.c_str(), std::ios_base::in | std::ios_base::binary);
-    assert(dataFileA.good());
-    std::fstream dataFileB(fileB.c_str(), std::ios_base::in | std::ios_base::binary);
-    assert(dataFileB.good());
+    DICe::Delimited_Text_Reader readerA(fileA,delimiter);
+    DICe::Delimited_Text_Reader readerB(fileB,delimiter);
+
+    // if both files are a header followed by numeric lines with the same shape (as DICe writes them),
+    // only the header lines are compared as tokens and the numeric lines are converted with read_columns(),
+    // otherwise every line is compared as tokens
+    int_t first_lineA = 0;
+    int_t first_lineB = 0;
+    std::vector<std::vector<scalar_t> > valuesA;
+    std::vector<std::vector<scalar_t> > valuesB;
+    const bool numeric_block = read_numeric_block(readerA,first_lineA,valuesA)
+        && read_numeric_block(readerB,first_lineB,valuesB)
+        && first_lineA==first_lineB && readerA.num_lines()==readerB.num_lines() && valuesA.size()==valuesB.size();
+    const int_t num_token_lines = numeric_block ? first_lineA : readerA.num_lines();
 
     // read each line of the file
-    int_t line = 0;
-    while (!dataFileA.eof())
+    for(int_t line=0;line<num_token_lines;++line)
     {
       bool line_diff = false;
       std::vector<int_t> badTokenIds;
       std::vector<std::string> badTokenTypes;
-      if(dataFileB.eof()) {
+      if(line>=readerB.num_lines()) {
         *outStream << "Error, File A has more lines than FileB " << std::endl;
         errorFlag++;
         break;
       }
-      std::vector<std::string> tokensA = DICe::tokenize_line(dataFileA,delimiter);
-      std::vector<std::string> tokensB = DICe::tokenize_line(dataFileB,delimiter);
+      std::vector<std::string> tokensA = readerA.tokens(line);
+      std::vector<std::string> tokensB = readerB.tokens(line);
       if(tokensA.size()>=2){
         if(tokensA[1].find(masthead)!=std::string::npos){ // skip the masthead
-          line++;
           continue;
         }
       }
@@ -305,17 +402,10 @@ int main(int argc, char *argv[]) {
         // number
         if(DICe::is_number(tokensA[i])){
           assert(DICe::is_number(tokensB[i]));
-          scalar_t valA = strtod(tokensA[i].c_str(),NULL);
-          scalar_t valB = strtod(tokensB[i].c_str(),NULL);
-          scalar_t diff = std::abs((valA - valB)/valA);
-          const bool tiny = (std::abs(valA) + std::abs(valB) < 1.0E-8);
-          const bool below_floor = std::abs(valA) < floor;
-          if(!below_floor||!use_floor){
-            if(!tiny && diff > relTol){
-              line_diff = true;
-              badTokenIds.push_back(i);
-              badTokenTypes.push_back("n");
-            }
+          if(values_differ(token_value(tokensA[i]),token_value(tokensB[i]),relTol,floor,use_floor)){
+            line_diff = true;
+            badTokenIds.push_back(i);
+            badTokenTypes.push_back("n");
           }
         }
         // string
@@ -329,27 +419,27 @@ int main(int argc, char *argv[]) {
       }
       if(line_diff){
         errorFlag++;
-        *outStream << "< " << line << " (";
-        for(size_t i=0;i<badTokenIds.size();++i){
-          *outStream << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
+        print_line_diff(*outStream,line,badTokenIds,badTokenTypes,tokensA,tokensB);
+      }
+    }
+    if(numeric_block){
+      for(size_t row=0;row<valuesA[0].size();++row){
+        std::vector<int_t> badTokenIds;
+        std::vector<std::string> badTokenTypes;
+        for(size_t i=0;i<valuesA.size();++i){
+          if(values_differ(valuesA[i][row],valuesB[i][row],relTol,floor,use_floor)){
+            badTokenIds.push_back(i);
+            badTokenTypes.push_back("n");
+          }
         }
-        *outStream  << "): ";
-        for(size_t i=0;i<tokensA.size();++i)
-          *outStream << tokensA[i] << " ";
-        *outStream << std::endl;
-        *outStream << "> " << line << " (";
-        for(size_t i=0;i<badTokenIds.size();++i){
-          *outStream << badTokenIds[i] << "[" << badTokenTypes[i] << "] ";
+        if(!badTokenIds.empty()){
+          errorFlag++;
+          // the tokens are only needed to print the lines that differ
+          const int_t line = first_lineA + row;
+          print_line_diff(*outStream,line,badTokenIds,badTokenTypes,readerA.tokens(line),readerB.tokens(line));
         }
-        *outStream  << "): ";
-        for(size_t i=0;i<tokensB.size();++i)
-          *outStream << tokensB[i] << " ";
-        *outStream << std::endl;
       }
-      line++;
     }
-    dataFileA.close();
-    dataFileB.close();
   } // end serial comparison
   DICe::finalize();
 
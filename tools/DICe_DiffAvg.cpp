@@ -40,6 +40,8 @@
 // @HEADER
 
 #include <DICe.h>
+#include <DICe_Parser.h>
+#include <DICe_BinaryOutput.h>
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_ParameterList.hpp>
@@ -99,6 +101,8 @@ int main(int argc, char *argv[]) {
     outStream = Teuchos::rcp(&std::cout, false);
   const double rel_tol = params->get<double>("relative_tolerance",1.0E-6);
   const double compare_factor = params->get<double>("compare_factor",1.0);
+  // for a DICe binary results file the columns are the field indices and the values are taken from this frame (default is the last frame)
+  const int_t frame_index = params->get<int_t>("frame_index",-1);
 
   params->print(*outStream);
 
@@ -115,44 +119,37 @@ int main(int argc, char *argv[]) {
   *outStream << "Data column: " << data_col << std::endl;
   *outStream << "Command coord column: " << command_coord_col << std::endl;
   *outStream << "Command data column: " << command_data_col << std::endl;
-  vector <vector <string> > results;
-  ifstream file(input_file.c_str());
-  assert(file.good());
-  // get rid of the header rows:
-  string s;
-  for(int_t i=0;i<num_header_rows;++i){
-    getline(file,s);
+  std::vector<scalar_t> result_coords;
+  std::vector<scalar_t> result_values;
+  if(input_file.find(".dbin")!=std::string::npos){
+    DICe::Binary_Output_Reader reader(input_file);
+    assert(reader.num_frames()>0);
+    const int_t frame = frame_index < 0 ? reader.num_frames() - 1 : frame_index;
+    reader.read_field(frame,coord_col,result_coords);
+    reader.read_field(frame,data_col,result_values);
+    *outStream << "Number of columns in data: " << reader.info().field_names.size() << std::endl;
   }
-  // read the data
-  while (file)
-  {
-    if (!getline( file, s )) break;
-    istringstream ss( s );
-    vector <string> record;
-    while (ss)
-    {
-      string s;
-      if (!getline( ss, s, ',' )) break;
-      record.push_back( s );
-    }
-    results.push_back( record );
-  }
-  if (!file.eof())
-  {
-    cerr << "EOF Error Ocurred !\n";
+  else{
+    // comma separated, every line (including blank ones) counts as a header row and empty fields keep their column
+    DICe::Delimited_Text_Reader reader(input_file,",",false,false);
+    assert(reader.num_lines()>num_header_rows);
+    std::vector<int_t> columns(2);
+    columns[0] = coord_col;
+    columns[1] = data_col;
+    std::vector<std::vector<scalar_t> > values;
+    reader.read_columns(num_header_rows,columns,values);
+    result_coords.swap(values[0]);
+    result_values.swap(values[1]);
+    *outStream << "Number of columns in data: " << reader.num_values(num_header_rows) << std::endl;
   }
-  *outStream << "Number of columns in data: " << results[0].size() << std::endl;
-  *outStream << "Number of rows in data: " << results.size() << std::endl;
-  file.close();
+  *outStream << "Number of rows in data: " << result_coords.size() << std::endl;
 
 
   // sort the data according to either x or y:
   std::map<int_t,std::vector<scalar_t> > sortedMap;
-  for(size_t row=0;row<results.size();++row){
-    scalar_t coordReal = strtod(results[row][coord_col].c_str(),NULL);
-    int_t coord = static_cast<int_t>(coordReal);
-    //int_t coord = strtol(results[row][coord_col].c_str(),NULL,0);
-    scalar_t value = strtod(results[row][data_col].c_str(),NULL);
+  for(size_t row=0;row<result_coords.size();++row){
+    int_t coord = static_cast<int_t>(result_coords[row]);
+    scalar_t value = result_values[row];
     if(sortedMap.find(coord)==sortedMap.end()){
       std::vector<scalar_t> tmp_vec;
       sortedMap.insert(std::pair<int_t,std::vector<scalar_t> >(coord,tmp_vec));
@@ -204,46 +201,25 @@ int main(int argc, char *argv[]) {
 
   // command data
 
-  vector <vector <string> > command;
-  ifstream command_file(command_file_name.c_str());
-  assert(command_file.good());
-  // get rid of the header rows:
-  for(int_t i=0;i<command_num_header_rows;++i){
-    getline(command_file,s);
-  }
-  // read the data
-  while (command_file)
-  {
-    if (!getline( command_file, s )) break;
-    istringstream ss( s );
-    vector <string> record;
-    while (ss)
-    {
-      string s;
-      if (!getline( ss, s, ',' )) break;
-      record.push_back( s );
-    }
-    command.push_back( record );
-  }
-  if (!command_file.eof())
-  {
-    cerr << "Command EOF Error Ocurred !\n";
-  }
-  *outStream << "Number of columns in command: " << command[0].size() << std::endl;
-  *outStream << "Number of rows in command: " << command.size() << std::endl;
-  if(command[0].size()!=command[command.size()-1].size()){
+  DICe::Delimited_Text_Reader command_reader(command_file_name,",",false,false);
+  assert(command_reader.num_lines()>command_num_header_rows);
+  *outStream << "Number of columns in command: " << command_reader.num_values(command_num_header_rows) << std::endl;
+  *outStream << "Number of rows in command: " << command_reader.num_lines() - command_num_header_rows << std::endl;
+  if(command_reader.num_values(command_num_header_rows)!=command_reader.num_values(command_reader.num_lines()-1)){
     cerr << "The last row does not have the right number of columns" << std::endl;
     assert(false);
   }
-  command_file.close();
+  std::vector<int_t> command_columns(2);
+  command_columns[0] = command_coord_col;
+  command_columns[1] = command_data_col;
+  std::vector<std::vector<scalar_t> > command_values_read;
+  command_reader.read_columns(command_num_header_rows,command_columns,command_values_read);
 
   // sort the data according to either x or y:
   std::map<int_t,scalar_t> commandMap;
-  for(size_t row=0;row<command.size();++row){
-    scalar_t coordReal = strtod(command[row][command_coord_col].c_str(),NULL);
-    int_t coord = static_cast<int_t>(coordReal);
-    //int_t coord = strtol(command[row][command_coord_col].c_str(),NULL,0);
-    scalar_t value = strtod(command[row][command_data_col].c_str(),NULL);
+  for(size_t row=0;row<command_values_read[0].size();++row){
+    int_t coord = static_cast<int_t>(command_values_read[0][row]);
+    scalar_t value = command_values_read[1][row];
     commandMap.insert(std::pair<int_t,scalar_t >(coord,value));
   }
   *outStream << " The command map has " << commandMap.size() << " entries" << std::endl;